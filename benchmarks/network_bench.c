@@ -0,0 +1,227 @@
+/*
+ * TCP streaming throughput benchmark.
+ *
+ * Streams generated packet containers (one special event and a polarity
+ * packet of varying size each) from a network server to several clients
+ * over the loopback interface, each client running in its own thread.
+ * Clients check that every container arrives complete and in order, so
+ * this also serves as a loopback test of server and client. The producer
+ * is throttled to the clients' pace, so that no container is dropped.
+ *
+ * Usage: network_bench [clients] [scale]
+ * Clients defaults to 2, the optional scale multiplies the default
+ * stream lengths (default 1).
+ */
+
+#include "network.h"
+#include "events/special.h"
+#include "events/polarity.h"
+#include "c11threads_posix.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define BENCH_QUEUE_SIZE 256
+#define BENCH_DEFAULT_EVENTS (64 * 1024 * 1024)
+#define BENCH_MAX_CLIENTS 64
+
+struct bench_client {
+	thrd_t thread;
+	uint16_t port;
+	int32_t expectedEventsPerContainer;
+	uint64_t expectedContainers;
+	// Results.
+	uint64_t containers;
+	uint64_t events;
+	bool valid;
+};
+
+static inline int64_t benchTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((I64T(now.tv_sec) * 1000000000LL) + I64T(now.tv_nsec));
+}
+
+static caerEventPacketContainer benchContainer(int32_t events, int32_t *timestamp) {
+	caerEventPacketContainer container = caerEventPacketContainerAllocate(POLARITY_EVENT + 1);
+	caerSpecialEventPacket special = caerSpecialEventPacketAllocate(1, 1, 0);
+	caerPolarityEventPacket polarity = caerPolarityEventPacketAllocate(events, 1, 0);
+
+	if (container == NULL || special == NULL || polarity == NULL) {
+		fprintf(stderr, "Failed to allocate benchmark container.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	caerSpecialEvent specialEvent = caerSpecialEventPacketGetEvent(special, 0);
+	caerSpecialEventSetTimestamp(specialEvent, *timestamp);
+	caerSpecialEventSetType(specialEvent, TIMESTAMP_WRAP);
+	caerSpecialEventValidate(specialEvent, special);
+
+	for (int32_t i = 0; i < events; i++) {
+		caerPolarityEvent event = caerPolarityEventPacketGetEvent(polarity, i);
+		caerPolarityEventSetTimestamp(event, (*timestamp)++);
+		caerPolarityEventSetX(event, U16T(i % 240));
+		caerPolarityEventSetY(event, U16T(i % 180));
+		caerPolarityEventSetPolarity(event, (i & 0x01));
+		caerPolarityEventValidate(event, polarity);
+	}
+
+	caerEventPacketContainerSetEventPacket(container, SPECIAL_EVENT, (caerEventPacketHeader) special);
+	caerEventPacketContainerSetEventPacket(container, POLARITY_EVENT, (caerEventPacketHeader) polarity);
+
+	return (container);
+}
+
+static int benchClientThread(void *inPtr) {
+	struct bench_client *bench = inPtr;
+
+	caerNetworkClient client = caerNetworkClientOpen("127.0.0.1", bench->port);
+	if (client == NULL) {
+		return (EXIT_FAILURE);
+	}
+
+	int32_t timestamp = 0;
+	bench->valid = true;
+
+	caerEventPacketContainer container;
+	while ((container = caerNetworkClientReceive(client)) != NULL) {
+		caerEventPacketHeader special = caerEventPacketContainerGetEventPacket(container, SPECIAL_EVENT);
+		caerEventPacketHeader polarity = caerEventPacketContainerGetEventPacket(container, POLARITY_EVENT);
+
+		// Every container must come back as sent: both packets, events in sequence.
+		if (special == NULL || polarity == NULL
+			|| caerEventPacketHeaderGetEventNumber(polarity) != bench->expectedEventsPerContainer
+			|| caerSpecialEventGetTimestamp(caerSpecialEventPacketGetEvent((caerSpecialEventPacket) special, 0))
+				!= timestamp
+			|| caerPolarityEventGetTimestamp(caerPolarityEventPacketGetEvent((caerPolarityEventPacket) polarity,
+				bench->expectedEventsPerContainer - 1)) != (timestamp + bench->expectedEventsPerContainer - 1)) {
+			bench->valid = false;
+		}
+
+		timestamp += bench->expectedEventsPerContainer;
+
+		bench->containers++;
+		bench->events += U64T(caerEventPacketContainerGetEventsNumber(container));
+
+		caerEventPacketContainerFree(container);
+	}
+
+	caerNetworkClientClose(client);
+
+	if (bench->containers != bench->expectedContainers) {
+		bench->valid = false;
+	}
+
+	return (EXIT_SUCCESS);
+}
+
+static bool networkBench(uint32_t clients, int32_t eventsPerContainer, size_t totalEvents) {
+	caerNetworkServer server = caerNetworkServerOpen("127.0.0.1", 0, 1, "Network Benchmark", clients,
+		BENCH_QUEUE_SIZE, CAER_NETWORK_CLIENT_DROP_NEWEST);
+	if (server == NULL) {
+		return (false);
+	}
+
+	uint64_t containers = totalEvents / (size_t) eventsPerContainer;
+	struct bench_client benchClients[BENCH_MAX_CLIENTS];
+
+	for (uint32_t i = 0; i < clients; i++) {
+		memset(&benchClients[i], 0, sizeof(benchClients[i]));
+		benchClients[i].port = caerNetworkServerGetPort(server);
+		benchClients[i].expectedEventsPerContainer = eventsPerContainer;
+		benchClients[i].expectedContainers = containers;
+
+		thrd_create(&benchClients[i].thread, &benchClientThread, &benchClients[i]);
+	}
+
+	struct caer_network_server_stats stats;
+
+	// Wait for all clients to be connected, so they all get the whole stream.
+	do {
+		caerNetworkServerStatsGet(server, &stats);
+		thrd_yield();
+	}
+	while (stats.clientsConnected < clients);
+
+	int32_t timestamp = 0;
+	int64_t start = benchTime();
+
+	for (uint64_t sent = 0; sent < containers; sent++) {
+		// Keep at most half a queue in flight per client, so nothing is dropped.
+		do {
+			caerNetworkServerStatsGet(server, &stats);
+
+			if ((sent * clients) - stats.containersSent < (uint64_t) (clients * (BENCH_QUEUE_SIZE / 2))) {
+				break;
+			}
+
+			struct timespec throttle = { .tv_sec = 0, .tv_nsec = 20000 };
+			thrd_sleep(&throttle, NULL);
+		}
+		while (true);
+
+		caerNetworkServerSend(server, benchContainer(eventsPerContainer, &timestamp));
+	}
+
+	// Wait for everything to be sent, then closing disconnects the clients.
+	do {
+		caerNetworkServerStatsGet(server, &stats);
+		thrd_yield();
+	}
+	while (stats.containersSent + stats.containersDropped < containers * clients);
+
+	int64_t nanoseconds = benchTime() - start;
+
+	caerNetworkServerClose(server);
+
+	bool valid = (stats.containersDropped == 0);
+
+	for (uint32_t i = 0; i < clients; i++) {
+		thrd_join(benchClients[i].thread, NULL);
+		valid = valid && benchClients[i].valid;
+	}
+
+	printf("%7" PRIu32 " %10" PRIi32 " %10" PRIu64 " %10.2f %10.2f %10.2f %8.1f %s\n", clients, eventsPerContainer,
+		containers, ((double) (containers * (uint64_t) eventsPerContainer) * 1000) / (double) nanoseconds,
+		((double) stats.bytesSent * 1000) / (double) nanoseconds, (double) stats.bytesSent / (double) stats.sendCalls,
+		((double) (containers * clients) * 1000000000) / (double) nanoseconds, (valid) ? ("ok") : ("FAILED"));
+
+	return (valid);
+}
+
+int main(int argc, char *argv[]) {
+	uint32_t clients = 2;
+	size_t scale = 1;
+
+	if (argc > 1) {
+		clients = (uint32_t) strtoul(argv[1], NULL, 10);
+	}
+
+	if (argc > 2) {
+		scale = strtoul(argv[2], NULL, 10);
+	}
+
+	if (clients == 0 || clients > BENCH_MAX_CLIENTS || scale == 0) {
+		fprintf(stderr, "Usage: %s [clients (1-%d)] [scale]\n", argv[0], BENCH_MAX_CLIENTS);
+		return (EXIT_FAILURE);
+	}
+
+	// Anything logged at error level or above is a real problem.
+	caerLogLevelSet(CAER_LOG_ERROR);
+
+	size_t totalEvents = BENCH_DEFAULT_EVENTS * scale;
+	bool valid = true;
+
+	printf("%7s %10s %10s %10s %10s %10s %8s\n", "Clients", "Events/C", "Containers", "Mev/s", "MB/s", "B/send",
+		"C/s");
+
+	valid &= networkBench(clients, 64, totalEvents / 16);
+	valid &= networkBench(clients, 1024, totalEvents / 4);
+	valid &= networkBench(clients, 16384, totalEvents);
+	valid &= networkBench(clients, 262144, totalEvents);
+
+	return ((valid) ? (EXIT_SUCCESS) : (EXIT_FAILURE));
+}
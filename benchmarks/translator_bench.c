@@ -0,0 +1,488 @@
+/*
+ * Translator throughput benchmark.
+ *
+ * Feeds generated DAVIS (16 bit words) and DVS128 (32 bit words) USB data
+ * through the event translators, in transfer-sized chunks, without any device
+ * attached. Committed containers are drained and freed between chunks, like
+ * a consumer would. Only the time spent inside the translators is measured.
+ *
+ * Usage: translator_bench [scale]
+ * The optional scale multiplies the default stream lengths (default 1).
+ */
+
+#include "davis_common.h"
+#include "dvs128.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_TRANSFER_SIZE 8192
+#define BENCH_DRAIN_MAX 64
+#define BENCH_DEFAULT_STEPS (1024 * 1024)
+
+#define DAVIS_BENCH_SIZE_X 240
+#define DAVIS_BENCH_SIZE_Y 180
+#define DAVIS_BENCH_TS_WRAP 0x8000
+#define DAVIS_BENCH_FRAME_INTERVAL 20000 // 50 fps, in µs.
+
+#define DVS128_BENCH_TS_WRAP 0x4000
+
+static char davisBenchName[] = "DAVIS Benchmark";
+static char dvs128BenchName[] = "DVS128 Benchmark";
+
+// Count allocations done by the library by interposing the glibc allocator.
+// Everything here runs on one thread, so a plain counter is enough.
+#if defined(__GLIBC__)
+	#define BENCH_COUNT_ALLOCATIONS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static size_t benchAllocations = 0;
+
+void *malloc(size_t size) {
+	benchAllocations++;
+	return (__libc_malloc(size));
+}
+
+void *calloc(size_t nmemb, size_t size) {
+	benchAllocations++;
+	return (__libc_calloc(nmemb, size));
+}
+
+void *realloc(void *ptr, size_t size) {
+	benchAllocations++;
+	return (__libc_realloc(ptr, size));
+}
+#else
+	#define BENCH_COUNT_ALLOCATIONS 0
+
+static size_t benchAllocations = 0;
+#endif
+
+struct bench_stream {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	size_t words;
+	// Generator state.
+	uint64_t random;
+	int64_t time; // Device time in µs, since start.
+	int64_t lastWrap; // Device time of last emitted wrap.
+};
+
+struct bench_result {
+	size_t words;
+	uint64_t allocations;
+	uint64_t containers;
+	int64_t nanoseconds;
+};
+
+static inline uint32_t benchRandom(struct bench_stream *stream) {
+	// xorshift64, good enough for addresses.
+	stream->random ^= stream->random << 13;
+	stream->random ^= stream->random >> 7;
+	stream->random ^= stream->random << 17;
+
+	return (U32T(stream->random >> 32));
+}
+
+static void benchStreamInit(struct bench_stream *stream, size_t capacity) {
+	stream->data = malloc(capacity);
+	if (stream->data == NULL) {
+		fprintf(stderr, "Failed to allocate %zu bytes for generated stream.\n", capacity);
+		exit(EXIT_FAILURE);
+	}
+
+	stream->size = 0;
+	stream->capacity = capacity;
+	stream->words = 0;
+	stream->random = 0x9E3779B97F4A7C15ULL;
+	stream->time = 0;
+	stream->lastWrap = 0;
+}
+
+static void benchStreamFree(struct bench_stream *stream) {
+	free(stream->data);
+	stream->data = NULL;
+}
+
+static inline void benchStreamReserve(struct bench_stream *stream, size_t bytes) {
+	if ((stream->size + bytes) <= stream->capacity) {
+		return;
+	}
+
+	size_t newCapacity = stream->capacity * 2;
+	while ((stream->size + bytes) > newCapacity) {
+		newCapacity *= 2;
+	}
+
+	uint8_t *newData = realloc(stream->data, newCapacity);
+	if (newData == NULL) {
+		fprintf(stderr, "Failed to grow generated stream to %zu bytes.\n", newCapacity);
+		exit(EXIT_FAILURE);
+	}
+
+	stream->data = newData;
+	stream->capacity = newCapacity;
+}
+
+static inline void benchPush16(struct bench_stream *stream, uint16_t word) {
+	benchStreamReserve(stream, 2);
+
+	// USB is little-endian.
+	stream->data[stream->size++] = U8T(word & 0xFF);
+	stream->data[stream->size++] = U8T(word >> 8);
+	stream->words++;
+}
+
+static inline void benchPush32(struct bench_stream *stream, uint16_t address, uint16_t timestamp) {
+	benchStreamReserve(stream, 4);
+
+	// Address then timestamp, both little-endian.
+	stream->data[stream->size++] = U8T(address & 0xFF);
+	stream->data[stream->size++] = U8T(address >> 8);
+	stream->data[stream->size++] = U8T(timestamp & 0xFF);
+	stream->data[stream->size++] = U8T(timestamp >> 8);
+	stream->words++;
+}
+
+// DAVIS: advance device time and emit wrap and timestamp words.
+static void davisBenchTime(struct bench_stream *stream, int64_t advance) {
+	stream->time += advance;
+
+	while ((stream->time - stream->lastWrap) >= DAVIS_BENCH_TS_WRAP) {
+		stream->lastWrap += DAVIS_BENCH_TS_WRAP;
+		benchPush16(stream, U16T((7 << 12) | 1)); // Timestamp wrap, multiplier one.
+	}
+
+	// The wrap itself already sets the timestamp to the wrap point.
+	if (stream->time == stream->lastWrap && stream->time != 0) {
+		return;
+	}
+
+	benchPush16(stream, U16T(0x8000 | ((stream->time - stream->lastWrap) & 0x7FFF)));
+}
+
+static inline void davisBenchSpecial(struct bench_stream *stream, uint16_t type) {
+	benchPush16(stream, U16T((0 << 12) | type));
+}
+
+static inline void davisBenchPolarity(struct bench_stream *stream) {
+	uint32_t rnd = benchRandom(stream);
+
+	benchPush16(stream, U16T((1 << 12) | ((rnd & 0xFFFF) % DAVIS_BENCH_SIZE_Y)));
+	benchPush16(stream, U16T(((2 + ((rnd >> 31) & 0x01)) << 12) | ((rnd >> 16) % DAVIS_BENCH_SIZE_X)));
+}
+
+static inline void davisBenchRowOnly(struct bench_stream *stream) {
+	benchPush16(stream, U16T((1 << 12) | (benchRandom(stream) % DAVIS_BENCH_SIZE_Y)));
+}
+
+static void davisBenchIMU(struct bench_stream *stream) {
+	davisBenchSpecial(stream, 5); // IMU start.
+	davisBenchSpecial(stream, 16); // IMU scale config, lowest accel and gyro scales.
+
+	// 14 bytes of accel, temperature and gyro data.
+	for (size_t i = 0; i < 14; i++) {
+		benchPush16(stream, U16T((5 << 12) | (0 << 8) | (benchRandom(stream) & 0xFF)));
+	}
+
+	davisBenchSpecial(stream, 7); // IMU end.
+}
+
+// One APS column: reset or signal read, one ADC sample per row.
+static void davisBenchColumn(struct bench_stream *stream, bool signal) {
+	davisBenchSpecial(stream, (signal) ? (12) : (11));
+
+	for (size_t i = 0; i < DAVIS_BENCH_SIZE_Y; i++) {
+		benchPush16(stream, U16T((4 << 12) | ((signal) ? (200 + (benchRandom(stream) & 0x1FF)) : (800))));
+	}
+
+	davisBenchSpecial(stream, 13);
+}
+
+enum davis_bench_mix {
+	DAVIS_BENCH_DVS, DAVIS_BENCH_DVS_APS, DAVIS_BENCH_IMU, DAVIS_BENCH_ROW_ONLY,
+};
+
+static void davisBenchGenerate(struct bench_stream *stream, enum davis_bench_mix mix, size_t steps) {
+	// Frame readout state: -1 no frame, else current column over both reads.
+	int32_t apsColumn = -1;
+	int64_t nextFrame = 0;
+
+	for (size_t step = 0; step < steps; step++) {
+		davisBenchTime(stream, 1);
+
+		switch (mix) {
+			case DAVIS_BENCH_DVS:
+				for (size_t i = 0; i < 4; i++) {
+					davisBenchPolarity(stream);
+				}
+				break;
+
+			case DAVIS_BENCH_DVS_APS:
+				for (size_t i = 0; i < 4; i++) {
+					davisBenchPolarity(stream);
+				}
+
+				// One APS column per µs while a frame is being read out.
+				if (apsColumn < 0 && stream->time >= nextFrame) {
+					davisBenchSpecial(stream, 8); // GS frame start.
+					apsColumn = 0;
+					nextFrame += DAVIS_BENCH_FRAME_INTERVAL;
+				}
+				else if (apsColumn >= 0) {
+					davisBenchColumn(stream, (apsColumn >= DAVIS_BENCH_SIZE_X));
+					apsColumn++;
+
+					if (apsColumn == (2 * DAVIS_BENCH_SIZE_X)) {
+						davisBenchSpecial(stream, 10); // Frame end.
+						apsColumn = -1;
+					}
+				}
+				break;
+
+			case DAVIS_BENCH_IMU:
+				davisBenchPolarity(stream);
+				davisBenchIMU(stream);
+				break;
+
+			case DAVIS_BENCH_ROW_ONLY:
+				for (size_t i = 0; i < 8; i++) {
+					davisBenchRowOnly(stream);
+				}
+				break;
+		}
+	}
+}
+
+enum dvs128_bench_mix {
+	DVS128_BENCH_DVS, DVS128_BENCH_SYNC,
+};
+
+static void dvs128BenchGenerate(struct bench_stream *stream, enum dvs128_bench_mix mix, size_t steps) {
+	for (size_t step = 0; step < steps; step++) {
+		stream->time++;
+
+		if ((stream->time - stream->lastWrap) >= DVS128_BENCH_TS_WRAP) {
+			stream->lastWrap += DVS128_BENCH_TS_WRAP;
+			benchPush32(stream, 0, 0x8000); // Wrap bit in timestamp MSB.
+		}
+
+		uint16_t timestamp = U16T((stream->time - stream->lastWrap) & 0x3FFF);
+
+		for (size_t i = 0; i < 4; i++) {
+			uint32_t rnd = benchRandom(stream);
+			uint16_t address = U16T(((rnd & 0x7F) << 8) | (((rnd >> 8) & 0x7F) << 1) | ((rnd >> 16) & 0x01));
+
+			if (mix == DVS128_BENCH_SYNC && (i & 0x01) != 0) {
+				address = 0x8000; // Sync event.
+			}
+
+			benchPush32(stream, address, timestamp);
+		}
+	}
+}
+
+static inline int64_t benchTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((I64T(now.tv_sec) * 1000000000LL) + I64T(now.tv_nsec));
+}
+
+static size_t benchDrain(dataExchange exchange) {
+	caerEventPacketContainer containers[BENCH_DRAIN_MAX];
+	size_t total = 0;
+	size_t count;
+
+	while ((count = dataExchangeGetMany(exchange, containers, BENCH_DRAIN_MAX)) != 0) {
+		for (size_t i = 0; i < count; i++) {
+			caerEventPacketContainerFree(containers[i]);
+		}
+
+		total += count;
+	}
+
+	return (total);
+}
+
+static void benchRun(struct bench_result *result, struct bench_stream *stream, dataExchange exchange,
+	void (*translate)(void *handle, uint8_t *buffer, size_t bytesSent), void *handle) {
+	memset(result, 0, sizeof(*result));
+
+	for (size_t offset = 0; offset < stream->size; offset += BENCH_TRANSFER_SIZE) {
+		size_t length = stream->size - offset;
+		if (length > BENCH_TRANSFER_SIZE) {
+			length = BENCH_TRANSFER_SIZE;
+		}
+
+		size_t allocationsStart = benchAllocations;
+		int64_t start = benchTime();
+
+		(*translate)(handle, stream->data + offset, length);
+
+		result->nanoseconds += benchTime() - start;
+		result->allocations += benchAllocations - allocationsStart;
+
+		result->containers += benchDrain(exchange);
+	}
+
+	result->words = stream->words;
+}
+
+static void benchPrint(const char *device, const char *mix, const struct bench_result *result,
+	const struct caer_device_stats *stats) {
+	double nanoseconds = (double) result->nanoseconds;
+	uint64_t events = stats->specialEvents + stats->polarityEvents + stats->frameEvents + stats->imu6Events;
+
+	printf("%-7s %-10s %10zu %10" PRIu64 " %10" PRIu64 " %9.2f %8.2f", device, mix, result->words, events,
+		result->containers, ((double) events * 1000) / nanoseconds, nanoseconds / (double) result->words);
+
+	if (BENCH_COUNT_ALLOCATIONS) {
+		printf(" %12.0f\n", ((double) result->allocations * 1000000000) / nanoseconds);
+	}
+	else {
+		printf(" %12s\n", "n/a");
+	}
+}
+
+static void davisBenchTranslate(void *handle, uint8_t *buffer, size_t bytesSent) {
+	davisEventTranslator(handle, buffer, bytesSent);
+}
+
+static void dvs128BenchTranslate(void *handle, uint8_t *buffer, size_t bytesSent) {
+	dvs128EventTranslator(handle, buffer, bytesSent);
+}
+
+static void davisBench(const char *name, enum davis_bench_mix mix, size_t steps) {
+	struct bench_stream stream;
+	benchStreamInit(&stream, steps * 32);
+	davisBenchGenerate(&stream, mix, steps);
+
+	davisHandle handle = calloc(1, sizeof(*handle));
+	if (handle == NULL) {
+		fprintf(stderr, "Failed to allocate DAVIS handle.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	davisState state = &handle->state;
+
+	// Mimic a DAVIS240C, as davisCommonOpen() and davisCommonDataStart() would set it up.
+	handle->deviceType = CAER_DEVICE_DAVIS_FX2;
+	handle->info.deviceID = 1;
+	handle->info.deviceString = davisBenchName;
+	handle->info.chipID = DAVIS_CHIP_DAVIS240C;
+	handle->info.apsColorFilter = MONO;
+
+	dataExchangeSettingsInit(&state->dataExchange);
+	atomic_store_explicit(&state->maxPacketContainerPacketSize, 8192, memory_order_relaxed);
+	atomic_store_explicit(&state->maxPacketContainerInterval, 10000, memory_order_relaxed);
+
+	state->dvsSizeX = DAVIS_BENCH_SIZE_X;
+	state->dvsSizeY = DAVIS_BENCH_SIZE_Y;
+	state->apsSizeX = DAVIS_BENCH_SIZE_X;
+	state->apsSizeY = DAVIS_BENCH_SIZE_Y;
+	state->apsROISizeX[0] = DAVIS_BENCH_SIZE_X;
+	state->apsROISizeY[0] = DAVIS_BENCH_SIZE_Y;
+	state->apsGlobalShutter = true;
+	state->apsResetRead = true;
+	state->imuAccelScale = 16384.0f;
+	state->imuGyroScale = 131.0f;
+
+	if (!davisCommonDataMemoryInit(handle)) {
+		exit(EXIT_FAILURE);
+	}
+
+	atomic_store(&state->dataAcquisitionThreadRun, true);
+
+	struct bench_result result;
+	benchRun(&result, &stream, &state->dataExchange, &davisBenchTranslate, handle);
+
+	struct caer_device_stats stats;
+	davisCommonStatsGet((caerDeviceHandle) handle, &stats);
+	benchPrint("DAVIS", name, &result, &stats);
+
+	atomic_store(&state->dataAcquisitionThreadRun, false);
+	dataExchangeBufferEmpty(&state->dataExchange);
+	davisCommonDataMemoryFree(handle);
+	free(handle);
+
+	benchStreamFree(&stream);
+}
+
+static void dvs128Bench(const char *name, enum dvs128_bench_mix mix, size_t steps) {
+	struct bench_stream stream;
+	benchStreamInit(&stream, steps * 16);
+	dvs128BenchGenerate(&stream, mix, steps);
+
+	dvs128Handle handle = calloc(1, sizeof(*handle));
+	if (handle == NULL) {
+		fprintf(stderr, "Failed to allocate DVS128 handle.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	dvs128State state = &handle->state;
+
+	// Mimic dvs128Open() and dvs128DataStart().
+	handle->deviceType = CAER_DEVICE_DVS128;
+	handle->info.deviceID = 1;
+	handle->info.deviceString = dvs128BenchName;
+
+	dataExchangeSettingsInit(&state->dataExchange);
+	atomic_store_explicit(&state->maxPacketContainerPacketSize, 4096, memory_order_relaxed);
+	atomic_store_explicit(&state->maxPacketContainerInterval, 10000, memory_order_relaxed);
+
+	if (!dvs128DataMemoryInit(handle)) {
+		exit(EXIT_FAILURE);
+	}
+
+	atomic_store(&state->dataAcquisitionThreadRun, true);
+
+	struct bench_result result;
+	benchRun(&result, &stream, &state->dataExchange, &dvs128BenchTranslate, handle);
+
+	struct caer_device_stats stats;
+	dvs128StatsGet((caerDeviceHandle) handle, &stats);
+	benchPrint("DVS128", name, &result, &stats);
+
+	atomic_store(&state->dataAcquisitionThreadRun, false);
+	dataExchangeBufferEmpty(&state->dataExchange);
+	dvs128DataMemoryFree(handle);
+	free(handle);
+
+	benchStreamFree(&stream);
+}
+
+int main(int argc, char *argv[]) {
+	size_t scale = 1;
+
+	if (argc > 1) {
+		scale = strtoul(argv[1], NULL, 10);
+		if (scale == 0) {
+			fprintf(stderr, "Usage: %s [scale]\n", argv[0]);
+			return (EXIT_FAILURE);
+		}
+	}
+
+	// Generated streams are valid, anything logged at error level or above is a real problem.
+	caerLogLevelSet(CAER_LOG_ERROR);
+
+	size_t steps = BENCH_DEFAULT_STEPS * scale;
+
+	printf("%-7s %-10s %10s %10s %10s %9s %8s %12s\n", "Device", "Mix", "Words", "Events", "Containers", "Mev/s",
+		"ns/word", "Allocs/s");
+
+	davisBench("dvs", DAVIS_BENCH_DVS, steps);
+	davisBench("dvs+aps50", DAVIS_BENCH_DVS_APS, steps);
+	davisBench("imu", DAVIS_BENCH_IMU, steps);
+	davisBench("row-only", DAVIS_BENCH_ROW_ONLY, steps);
+
+	dvs128Bench("dvs", DVS128_BENCH_DVS, steps);
+	dvs128Bench("sync", DVS128_BENCH_SYNC, steps);
+
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,278 @@
+/**
+ * @file aedat.h
+ *
+ * Reading and writing of AEDAT 3.x recordings: a text header, followed by
+ * event packets stored as they are in memory, each being the 28 bytes
+ * packet header followed by its events. Recordings can also be written
+ * compressed, with each packet encoded by the event codec (see event_codec.h).
+ * To replay a recording through the device API, see devices/replay.h instead.
+ */
+
+#ifndef LIBCAER_AEDAT_H_
+#define LIBCAER_AEDAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "events/packetContainer.h"
+
+/**
+ * Writer flag: compress event packets with caerEventCodecEncode() before
+ * writing them. Recordings become several times smaller, at the cost of
+ * encoding time in the writer thread. Compressed recordings can be replayed
+ * with caerDeviceOpenFile(), but not read in place by caerAEDATReaderOpen().
+ */
+#define CAER_AEDAT_WRITER_COMPRESS 0x01
+
+/**
+ * Reference to an open AEDAT 3.x file writer.
+ */
+typedef struct caer_aedat_writer *caerAEDATWriter;
+
+/**
+ * AEDAT 3.x file writer statistics. All counts are cumulative since
+ * caerAEDATWriterOpen().
+ */
+struct caer_aedat_writer_stats {
+	/// Packet containers accepted by caerAEDATWriterWrite().
+	uint64_t containersQueued;
+	/// Packet containers refused by caerAEDATWriterWrite() because the queue was full.
+	uint64_t containersRejected;
+	/// Packet containers fully written to the file.
+	uint64_t containersWritten;
+	/// Event packets written to the file.
+	uint64_t packetsWritten;
+	/// Bytes written to the file, including the text header (after compression, if enabled).
+	uint64_t bytesWritten;
+	/// Number of write system calls issued.
+	uint64_t writeCalls;
+};
+
+/**
+ * Create a new AEDAT 3.1 file (truncating any existing one) and start its
+ * writer thread. Containers passed to caerAEDATWriterWrite() are queued and
+ * written out in large batches by that thread, directly from the packets'
+ * memory, without intermediate copies (unless compressing).
+ * For uncompressed recordings, a timestamp index is written alongside, to
+ * '<fileName>.idx', so that caerAEDATReaderIndexFind() can locate packets
+ * by time without scanning.
+ *
+ * @param fileName path of the file to create.
+ * @param sourceID ID of the source of the recorded events, for the header.
+ * @param sourceDescription description of that source (for example a device's
+ *                          'deviceString' information), or NULL to not record it.
+ * @param queueSize maximum number of packet containers waiting to be written.
+ *                  Must be a power of two; 1 is rounded up to 2.
+ * @param flags bitwise OR of CAER_AEDAT_WRITER_* flags, or zero.
+ *
+ * @return a valid writer, or NULL on error.
+ */
+caerAEDATWriter caerAEDATWriterOpen(const char *fileName, int16_t sourceID, const char *sourceDescription,
+	uint32_t queueSize, uint32_t flags);
+
+/**
+ * Queue a packet container to be written. On success, the writer takes
+ * ownership of the container (and its packets) and frees it once written;
+ * the capacity of its packets is reduced to their event number, like
+ * AEDAT 3.x requires. On failure, ownership stays with the caller.
+ * Only one thread may call this on the same writer.
+ *
+ * @param writer a valid writer.
+ * @param container the packet container to write.
+ *
+ * @return true if the container was queued, false if the queue is full
+ *         (the writer can't keep up, retry later or drop it), or if the
+ *         writer failed to write to the file previously.
+ */
+bool caerAEDATWriterWrite(caerAEDATWriter writer, caerEventPacketContainer container);
+
+/**
+ * Get the writer statistics. See 'struct caer_aedat_writer_stats'.
+ *
+ * @param writer a valid writer.
+ * @param stats structure to fill with the current statistics.
+ *
+ * @return true on success, false on invalid arguments.
+ */
+bool caerAEDATWriterStatsGet(caerAEDATWriter writer, struct caer_aedat_writer_stats *stats);
+
+/**
+ * Write all queued containers, stop the writer thread, close the file
+ * and free the writer.
+ *
+ * @param writer a valid writer. Invalid after this call.
+ *
+ * @return true if everything was written successfully, false on errors.
+ */
+bool caerAEDATWriterClose(caerAEDATWriter writer);
+
+/**
+ * Reader flag: hint that the recording will be scanned from start to
+ * end, so the kernel reads ahead aggressively and can drop pages that
+ * have already been passed (madvise(MADV_SEQUENTIAL)).
+ */
+#define CAER_AEDAT_READER_SEQUENTIAL 0x01
+/**
+ * Reader flag: ask for the mapping to be backed by huge pages where the
+ * system supports that for files (madvise(MADV_HUGEPAGE)), to reduce TLB
+ * misses when scanning. Only a hint, ignored if not available.
+ */
+#define CAER_AEDAT_READER_HUGEPAGES 0x02
+
+/**
+ * Timestamp index entry, describing one event packet of a recording.
+ */
+struct caer_aedat_index_entry {
+	/// File offset of the event packet, for caerAEDATReaderPacketAt().
+	uint64_t offset;
+	/// 64 bit timestamp of the first event in the packet (TSOverflow taken into account).
+	int64_t firstTimestamp;
+	/// 64 bit timestamp of the last event in the packet (TSOverflow taken into account).
+	int64_t lastTimestamp;
+	/// Event type of the packet.
+	int16_t eventType;
+	/// Event source of the packet.
+	int16_t eventSource;
+	/// Number of events in the packet.
+	int32_t eventNumber;
+};
+
+/**
+ * Reference to an open AEDAT 3.x file reader.
+ */
+typedef struct caer_aedat_reader *caerAEDATReader;
+
+/**
+ * AEDAT 3.x file reader information.
+ */
+struct caer_aedat_reader_info {
+	/// AEDAT format minor version (AEDAT 3.x).
+	int8_t formatVersionMinor;
+	/// Size of the whole file in bytes.
+	uint64_t fileSize;
+	/// Offset of the first event packet, right after the text header.
+	uint64_t dataOffset;
+};
+
+/**
+ * Position in an AEDAT 3.x file and the packets to select while iterating.
+ * Initialize with caerAEDATReaderIteratorInit(). Any number of iterators
+ * can be used on the same reader, also concurrently from different threads.
+ */
+struct caer_aedat_reader_iterator {
+	/// File offset of the next event packet to examine.
+	uint64_t offset;
+	/// Only return packets of this event type, -1 for all types.
+	int16_t eventType;
+	/// Only return packets from this event source, -1 for all sources.
+	int16_t eventSource;
+};
+
+/**
+ * Open an AEDAT 3.x file for reading, by mapping it into memory.
+ * Event packets are then accessed in place, without reading or copying
+ * them, so scanning a recording is only limited by memory bandwidth
+ * and, for files not yet in the page cache, by the storage device.
+ *
+ * @param fileName path of the file to open.
+ * @param flags bitwise OR of CAER_AEDAT_READER_* hints, or zero.
+ *
+ * @return a valid reader, or NULL on error (file not found, not an
+ *         AEDAT 3.x recording, or compressed recording).
+ */
+caerAEDATReader caerAEDATReaderOpen(const char *fileName, uint32_t flags);
+
+/**
+ * Return information on the opened file, such as its format version.
+ *
+ * @param reader a valid reader.
+ *
+ * @return a copy of the information structure if successful,
+ *         an empty structure (all zeros) on failure.
+ */
+struct caer_aedat_reader_info caerAEDATReaderInfoGet(caerAEDATReader reader);
+
+/**
+ * Initialize an iterator to the first event packet of the file.
+ *
+ * @param reader a valid reader.
+ * @param iterator the iterator to initialize.
+ * @param eventType only return packets of this event type, -1 for all types.
+ * @param eventSource only return packets from this event source, -1 for all sources.
+ */
+void caerAEDATReaderIteratorInit(caerAEDATReader reader, struct caer_aedat_reader_iterator *iterator,
+	int16_t eventType, int16_t eventSource);
+
+/**
+ * Get the next event packet matching the iterator's selection, and advance
+ * the iterator past it. The returned packet points directly into the file
+ * mapping: it is read-only, must not be freed, and stays valid until
+ * caerAEDATReaderClose(). Use caerCopyEventPacket() to get a modifiable copy.
+ *
+ * @param reader a valid reader.
+ * @param iterator an initialized iterator.
+ *
+ * @return the next matching event packet, or NULL at the end of the file
+ *         or if the rest of the file is truncated or corrupted.
+ */
+caerEventPacketHeader caerAEDATReaderIteratorNext(caerAEDATReader reader, struct caer_aedat_reader_iterator *iterator);
+
+/**
+ * Get the event packet at the given file offset, as found in a
+ * 'struct caer_aedat_index_entry'. Like with caerAEDATReaderIteratorNext(),
+ * the packet points directly into the file mapping and is read-only.
+ *
+ * @param reader a valid reader.
+ * @param offset file offset of an event packet.
+ *
+ * @return the event packet, or NULL if there is no valid packet there.
+ */
+caerEventPacketHeader caerAEDATReaderPacketAt(caerAEDATReader reader, uint64_t offset);
+
+/**
+ * Load the timestamp index of the recording, needed by caerAEDATReaderIndexFind().
+ * The '<fileName>.idx' index written by caerAEDATWriterOpen() is used if present
+ * and matching the recording; otherwise the index is built by scanning all event
+ * packet headers once. Calling this again after success does nothing.
+ *
+ * @param reader a valid reader.
+ *
+ * @return true on success, false on errors (out of memory, corrupted recording).
+ */
+bool caerAEDATReaderIndexLoad(caerAEDATReader reader);
+
+/**
+ * Find the event packets of a type and source containing events in the
+ * timestamp range [startTimestamp, endTimestamp], in O(log n).
+ * Within each type and source, timestamps are expected to be non-decreasing
+ * through the recording, as they are between timestamp resets.
+ *
+ * @param reader a valid reader, with its index loaded by caerAEDATReaderIndexLoad().
+ * @param eventType event type of the packets to find.
+ * @param eventSource event source of the packets to find.
+ * @param startTimestamp start of the timestamp range (64 bit, inclusive).
+ * @param endTimestamp end of the timestamp range (64 bit, inclusive).
+ * @param entries set to the index entry of the first packet found, followed by
+ *                the others in file order. Valid until caerAEDATReaderClose().
+ *
+ * @return the number of packets found, zero if none or on error.
+ */
+size_t caerAEDATReaderIndexFind(caerAEDATReader reader, int16_t eventType, int16_t eventSource,
+	int64_t startTimestamp, int64_t endTimestamp, const struct caer_aedat_index_entry **entries);
+
+/**
+ * Unmap the file and free the reader. All packets returned by it
+ * become invalid.
+ *
+ * @param reader a valid reader. Invalid after this call.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerAEDATReaderClose(caerAEDATReader reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCAER_AEDAT_H_ */
@@ -0,0 +1,94 @@
+/**
+ * @file replay.h
+ *
+ * File replay device specific configuration defines and information structures.
+ * A replay device opens an AEDAT 3.x recording and delivers its event packets
+ * like a live device would, through caerDeviceDataStart()/caerDeviceDataGet().
+ */
+
+#ifndef LIBCAER_DEVICES_REPLAY_H_
+#define LIBCAER_DEVICES_REPLAY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "usb.h"
+
+/**
+ * Device type definition for AEDAT 3.x file replay.
+ * Open these devices with caerDeviceOpenFile(), not caerDeviceOpen().
+ */
+#define CAER_DEVICE_FILE_REPLAY 3
+
+/**
+ * Module address: host-side file replay configuration.
+ */
+#define CAER_HOST_CONFIG_REPLAY -5
+
+/**
+ * Parameter address for module CAER_HOST_CONFIG_REPLAY:
+ * pace the replay against the recorded timestamps, delivering
+ * packet containers at the rate at which they were recorded.
+ * If disabled, containers are delivered as fast as the consumer
+ * takes them. Default is enabled. Takes effect immediately.
+ */
+#define CAER_HOST_CONFIG_REPLAY_REAL_TIME 0
+/**
+ * Parameter address for module CAER_HOST_CONFIG_REPLAY:
+ * only replay event packets that were recorded from this source
+ * ID. Zero replays all sources. Default is zero. Takes effect
+ * on the next caerDeviceDataStart().
+ * Replayed packets always carry the replay device's own ID as
+ * their source, like events from any other device.
+ */
+#define CAER_HOST_CONFIG_REPLAY_SOURCE_ID 1
+
+/**
+ * File replay device-related information.
+ */
+struct caer_replay_info {
+	/// Unique device identifier. Also 'source' for events.
+	int16_t deviceID;
+	/// Device information string, for logging purposes.
+	char *deviceString;
+	/// Path of the recording being replayed.
+	char *fileName;
+	/// AEDAT format minor version (AEDAT 3.x).
+	int8_t formatVersionMinor;
+};
+
+/**
+ * Open an AEDAT 3.x recording as a device, assign an ID to it and return a handle
+ * for further usage. The recording is replayed from the start on each call to
+ * caerDeviceDataStart(). When its end is reached, data acquisition stops as if
+ * the device had been disconnected, calling the data shutdown notification.
+ * By default the CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_BLOCK_PRODUCER policy is
+ * used, with which a replay waits for the consumer and never drops containers.
+ *
+ * @param deviceID a unique ID to identify the device from others. Will be used as the
+ *                 source for EventPackets being generate from its data.
+ * @param fileName path of the AEDAT 3.x file to replay.
+ *
+ * @return a valid device handle that can be used with the other libcaer functions,
+ *         or NULL on error. Always check for this!
+ */
+caerDeviceHandle caerDeviceOpenFile(uint16_t deviceID, const char *fileName);
+
+/**
+ * Return basic information on the replay device, such as its ID and the
+ * file being replayed. See the 'struct caer_replay_info' documentation
+ * for more details.
+ *
+ * @param handle a valid device handle.
+ *
+ * @return a copy of the device information structure if successful,
+ *         an empty structure (all zeros) on failure.
+ */
+struct caer_replay_info caerReplayInfoGet(caerDeviceHandle handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCAER_DEVICES_REPLAY_H_ */
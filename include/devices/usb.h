@@ -33,6 +33,11 @@ typedef struct caer_device_handle *caerDeviceHandle;
  * Module address: host-side event packets generation configuration.
  */
 #define CAER_HOST_CONFIG_PACKETS -3
+/**
+ * Module address: host-side simulated device configuration.
+ * Only available on devices opened with caerDeviceOpenSimulated().
+ */
+#define CAER_HOST_CONFIG_SIMULATION -4
 
 /**
  * Parameter address for module CAER_HOST_CONFIG_USB:
@@ -53,9 +58,14 @@ typedef struct caer_device_handle *caerDeviceHandle;
  * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
  * set size of elements that can be held by the thread-safe FIFO
  * buffer between the USB data transfer thread and the main thread.
- * The default values are usually fine, only change them if you're
- * running into lots of dropped/missing packets; you can turn on
- * the INFO log level to see when this is the case.
+ * Must be a power of two; a size of 1 is rounded up to 2, the smallest
+ * the FIFO buffer supports. The default values are usually fine, only
+ * change them if you're running into lots of dropped/missing packets;
+ * you can turn on the INFO log level to see when this is the case.
+ * This can be changed while data transfer is running: the USB data
+ * transfer thread switches to a new FIFO buffer of the requested size,
+ * while caerDeviceDataGet() first drains the old one, so no data is
+ * lost or reordered.
  */
 #define CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE     0
 /**
@@ -88,6 +98,158 @@ typedef struct caer_device_handle *caerDeviceHandle;
  * need precise control over which ones are running at any time.
  */
  #define CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS  3
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * what to do when the thread-safe FIFO buffer between the USB data
+ * transfer thread and the main thread is full, and a new EventPacketContainer
+ * is ready to be made available. See the CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_*
+ * defines for the possible values. The default is
+ * CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_NEWEST.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_POLICY             4
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * maximum time in microseconds the USB data transfer thread waits
+ * for space in the FIFO buffer, when using the
+ * CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_BLOCK_PRODUCER policy.
+ * The container is dropped if no space is made in time.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_BLOCK_TIMEOUT      5
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * maximum memory in KiB that containers in the overflow list may
+ * occupy, when using the CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_SPILL
+ * policy. Containers that would exceed this limit are dropped.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_SPILL_MAX_MEMORY   6
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of EventPacketContainers that were dropped
+ * because the FIFO buffer was full, since the device was opened.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_DROPPED_CONTAINERS 7
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of EventPacketContainers that could not be
+ * put into the FIFO buffer right away, but were delivered later
+ * thanks to the active full-buffer policy, since the device was opened.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_DELAYED_CONTAINERS 8
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of older EventPacketContainers that were
+ * removed from the FIFO buffer to make space for newer ones,
+ * when using the CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_OLDEST
+ * policy, since the device was opened.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_EVICTED_CONTAINERS 9
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, current number of EventPacketContainers waiting
+ * in the FIFO buffer to be consumed with caerDeviceDataGet().
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_OCCUPANCY          10
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, maximum number of EventPacketContainers the FIFO
+ * buffer currently in use can hold. Zero if data transfer is
+ * not running (see caerDeviceDataStart()).
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_CAPACITY           11
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * highest FIFO buffer occupancy seen since the device was opened,
+ * or since the last reset. Setting this parameter to any value
+ * resets it to the current occupancy. Compare with
+ * CAER_HOST_CONFIG_DATAEXCHANGE_CAPACITY to detect when the
+ * consumer is getting close to losing data.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_HIGH_WATERMARK     12
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of EventPacketContainers put into the FIFO
+ * buffer since the device was opened (wraps around at 2^32).
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_PUT_CONTAINERS     13
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of EventPacketContainers taken out of the FIFO
+ * buffer since the device was opened (wraps around at 2^32). This
+ * includes containers discarded by caerDeviceDataStop().
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_GET_CONTAINERS     14
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * when caerDeviceDataGet() is blocking and no data is available,
+ * first busy-wait for this many iterations, using the CPU's pause
+ * instruction, before going to the next phase. Gives the lowest
+ * delivery latency at the cost of a busy CPU core. Default is 0.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_SPIN_COUNT    15
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * after the spin phase, yield the CPU to other threads for this
+ * many iterations, before parking the calling thread until the
+ * USB data transfer thread signals new data. Default is 0.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_YIELD_COUNT   16
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * maximum time in µs a parked caerDeviceDataGet() call sleeps
+ * before checking for data again, even if it wasn't woken up.
+ * Default is 1000 µs (1 ms).
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_PARK_TIMEOUT  17
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of blocking waits for data that entered the
+ * spin phase (wraps around at 2^32).
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_SPIN_PHASES   18
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of blocking waits for data that entered the
+ * yield phase (wraps around at 2^32).
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_YIELD_PHASES  19
+/**
+ * Parameter address for module CAER_HOST_CONFIG_DATAEXCHANGE:
+ * read-only, number of blocking waits for data that had to
+ * park the calling thread (wraps around at 2^32).
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_PARK_PHASES   20
+
+/**
+ * Value for CAER_HOST_CONFIG_DATAEXCHANGE_POLICY:
+ * drop the new container if the FIFO buffer is full.
+ * Lowest overhead, never stalls the USB data transfer thread.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_NEWEST    0
+/**
+ * Value for CAER_HOST_CONFIG_DATAEXCHANGE_POLICY:
+ * wait up to CAER_HOST_CONFIG_DATAEXCHANGE_BLOCK_TIMEOUT for the
+ * FIFO buffer to have space, stalling USB data transfers meanwhile,
+ * so that the device buffers up data instead. Drops on timeout.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_BLOCK_PRODUCER 1
+/**
+ * Value for CAER_HOST_CONFIG_DATAEXCHANGE_POLICY:
+ * move containers that don't fit into the FIFO buffer to an unbounded
+ * overflow list, from which they are forwarded in order as soon as
+ * space is available. Its memory usage is limited by
+ * CAER_HOST_CONFIG_DATAEXCHANGE_SPILL_MAX_MEMORY.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_SPILL          2
+/**
+ * Value for CAER_HOST_CONFIG_DATAEXCHANGE_POLICY:
+ * remove the oldest container still in the FIFO buffer to make space
+ * for the new one, so that the consumer always gets the freshest data
+ * and its latency stays bounded under overload. Evicted containers are
+ * freed and signaled with the 'dataNotifyDecrease' call-back, from the
+ * USB data transfer thread.
+ * Note that this may also evict timestamp reset notifications.
+ */
+#define CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_OLDEST    3
 
 /**
  * Parameter address for module CAER_HOST_CONFIG_PACKETS:
@@ -105,6 +267,20 @@ typedef struct caer_device_handle *caerDeviceHandle;
  */
 #define CAER_HOST_CONFIG_PACKETS_MAX_CONTAINER_INTERVAL    1
 
+/**
+ * Parameter address for module CAER_HOST_CONFIG_SIMULATION:
+ * rate at which the simulated device generates polarity events,
+ * in events per second. Zero means as fast as the host can
+ * consume them. Default is 1000000 (1 Mev/s).
+ */
+#define CAER_HOST_CONFIG_SIMULATION_EVENT_RATE       0
+/**
+ * Parameter address for module CAER_HOST_CONFIG_SIMULATION:
+ * read-only, number of polarity events the simulated device
+ * generated since it was opened (wraps around at 2^32).
+ */
+#define CAER_HOST_CONFIG_SIMULATION_GENERATED_EVENTS 1
+
 /**
  * Open a specified USB device, assign an ID to it and return a handle for further usage.
  * Various means can be employed to limit the selection of the device.
@@ -113,6 +289,7 @@ typedef struct caer_device_handle *caerDeviceHandle;
  *                 source for EventPackets being generate from its data.
  * @param deviceType type of the device to open. Currently supported are:
  *                   CAER_DEVICE_DVS128, CAER_DEVICE_DAVIS_FX2, CAER_DEVICE_DAVIS_FX3
+ *                   (recordings are opened with caerDeviceOpenFile() instead)
  * @param busNumberRestrict restrict the search for viable devices to only this USB bus number.
  * @param devAddressRestrict restrict the search for viable devices to only this USB device address.
  * @param serialNumberRestrict restrict the search for viable devices to only devices which do
@@ -133,6 +310,24 @@ caerDeviceHandle caerDeviceOpen(uint16_t deviceID, uint16_t deviceType, uint8_t
  */
 bool caerDeviceClose(caerDeviceHandle *handle);
 
+/**
+ * Open an in-process simulation of a USB device, for testing and load testing
+ * without hardware. It answers configuration requests like the real device
+ * and, while data transfer is running, produces a synthetic stream of polarity
+ * events that goes through the same transfer call-back, event translation and
+ * data exchange as real data. See the CAER_HOST_CONFIG_SIMULATION module for
+ * its settings. Close it with caerDeviceClose() as usual.
+ *
+ * @param deviceID a unique ID to identify the device from others. Will be used as the
+ *                 source for EventPackets being generate from its data.
+ * @param deviceType type of the device to simulate. Currently supported are:
+ *                   CAER_DEVICE_DVS128, CAER_DEVICE_DAVIS_FX2, CAER_DEVICE_DAVIS_FX3
+ *
+ * @return a valid device handle that can be used with the other libcaer functions,
+ *         or NULL on error. Always check for this!
+ */
+caerDeviceHandle caerDeviceOpenSimulated(uint16_t deviceID, uint16_t deviceType);
+
 /**
  * Send a set of good default configuration settings to the device.
  * This avoids users having to set every configuration option each time,
@@ -181,6 +376,130 @@ bool caerDeviceConfigSet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramA
  */
 bool caerDeviceConfigGet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t *param);
 
+/**
+ * Completion call-back for caerDeviceConfigSetAsync() and caerDeviceConfigGetAsync().
+ * It is called from the USB data transfer thread, so it must return quickly, and
+ * must not call any configuration function on the same device.
+ *
+ * @param userPtr the pointer given together with the call-back.
+ * @param success whether the request was successful.
+ * @param modAddr the module address of the request.
+ * @param paramAddr the parameter address of the request.
+ * @param param the value that was set, or the value that was read (zero on failure).
+ */
+typedef void (*caerDeviceConfigCallback)(void *userPtr, bool success, int8_t modAddr, uint8_t paramAddr,
+	uint32_t param);
+
+/**
+ * Set a configuration parameter to a given value, without waiting for the device.
+ * The request is sent as an asynchronous USB control transfer, handled by the
+ * USB data transfer thread, which calls the call-back once the device has it.
+ * Requests are sent in the order they are made. If data transfer is not running,
+ * or the request doesn't need to go to the device (host-side configuration,
+ * invalid parameters), it is executed right away and the call-back is called
+ * from the calling thread, before this function returns.
+ * Devices without asynchronous configuration support always do the latter.
+ *
+ * @param handle a valid device handle.
+ * @param modAddr a module address, see caerDeviceConfigSet().
+ * @param paramAddr a parameter address, see caerDeviceConfigSet().
+ * @param param a configuration parameter's new value.
+ * @param callback function to call once the request is completed. Must not be NULL.
+ * @param userPtr pointer passed to the call-back.
+ *
+ * @return true if the request was accepted, and the call-back will be called
+ *         exactly once (also if the request itself fails); false on invalid
+ *         arguments, and the call-back will not be called.
+ */
+bool caerDeviceConfigSetAsync(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param,
+	caerDeviceConfigCallback callback, void *userPtr);
+
+/**
+ * Get the value of a configuration parameter, without waiting for the device.
+ * Values known by the host are returned right away, through the call-back from
+ * the calling thread, before this function returns. Others are read with an
+ * asynchronous USB control transfer, and the call-back is called from the USB
+ * data transfer thread. If data transfer is not running, the value is read
+ * synchronously. Devices without asynchronous configuration support always
+ * read synchronously.
+ *
+ * @param handle a valid device handle.
+ * @param modAddr a module address, see caerDeviceConfigGet().
+ * @param paramAddr a parameter address, see caerDeviceConfigGet().
+ * @param callback function to call with the value. Must not be NULL.
+ * @param userPtr pointer passed to the call-back.
+ *
+ * @return true if the request was accepted, and the call-back will be called
+ *         exactly once (also if the request itself fails); false on invalid
+ *         arguments or lack of memory, and the call-back will not be called.
+ */
+bool caerDeviceConfigGetAsync(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr,
+	caerDeviceConfigCallback callback, void *userPtr);
+
+/**
+ * Reference to a configuration transaction: a list of configuration
+ * parameter changes, applied to a device together with
+ * caerDeviceConfigTransactionCommit(). Transactions are not tied to a
+ * device, and can be committed any number of times, to any device.
+ */
+typedef struct caer_device_config_transaction *caerDeviceConfigTransaction;
+
+/**
+ * Allocate a new, empty configuration transaction.
+ *
+ * @return a valid transaction, or NULL on lack of memory.
+ */
+caerDeviceConfigTransaction caerDeviceConfigTransactionAllocate(void);
+
+/**
+ * Add a configuration parameter change to a transaction. Changes are
+ * applied in the order they are added; adding the same parameter twice
+ * applies both changes, in order.
+ *
+ * @param transaction a valid transaction.
+ * @param modAddr a module address, see caerDeviceConfigSet().
+ * @param paramAddr a parameter address, see caerDeviceConfigSet().
+ * @param param a configuration parameter's new value.
+ *
+ * @return true on success, false on invalid arguments or lack of memory.
+ */
+bool caerDeviceConfigTransactionAdd(caerDeviceConfigTransaction transaction, int8_t modAddr, uint8_t paramAddr,
+	uint32_t param);
+
+/**
+ * Remove all changes from a transaction, so it can be reused.
+ *
+ * @param transaction a valid transaction.
+ */
+void caerDeviceConfigTransactionClear(caerDeviceConfigTransaction transaction);
+
+/**
+ * Free a transaction.
+ *
+ * @param transaction a valid transaction, or NULL. Invalid after this call.
+ */
+void caerDeviceConfigTransactionFree(caerDeviceConfigTransaction transaction);
+
+/**
+ * Apply all changes of a transaction to a device, like calling caerDeviceConfigSet()
+ * for each of them, but sending them in as few USB transfers as the device allows:
+ * DAVIS devices get all register writes together, DVS128 devices all bias changes
+ * at once. Optionally, event generation is paused for the duration, so that no
+ * events from intermediate, partially updated configurations are produced: the
+ * DVS and APS (where present) are stopped before the changes are applied, and
+ * restored to their previous state after. If the transaction itself changes
+ * whether they run, that is applied last instead.
+ * The transaction is not modified, and stays owned by the caller.
+ *
+ * @param handle a valid device handle.
+ * @param transaction a valid transaction.
+ * @param pause whether to pause event generation while applying the changes.
+ *
+ * @return true if all changes were applied successfully, false on invalid
+ *         arguments or if any change failed (the others are still applied).
+ */
+bool caerDeviceConfigTransactionCommit(caerDeviceHandle handle, caerDeviceConfigTransaction transaction, bool pause);
+
 /**
  * Start getting data from the device, setting up the USB data transfer thread
  * and starting the data producers (see CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS).
@@ -235,6 +554,163 @@ bool caerDeviceDataStop(caerDeviceHandle handle);
  */
 caerEventPacketContainer caerDeviceDataGet(caerDeviceHandle handle);
 
+/**
+ * Get up to 'maxContainers' event packet containers at once, which contain events
+ * of various types generated by the device, from the USB data transfer thread for
+ * further processing. This is more efficient than calling caerDeviceDataGet()
+ * repeatedly, as the FIFO buffer is updated only once for all retrieved containers,
+ * and only one aggregated notification is sent (see caerDeviceDataNotifyDecreaseManySet()).
+ * The returned data structures are allocated in memory and will need to be freed,
+ * exactly like for caerDeviceDataGet().
+ * This function can be made blocking with the CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING
+ * configuration parameter, in which case it waits until at least one container
+ * is available. By default it is non-blocking.
+ *
+ * @param handle a valid device handle.
+ * @param containers array of at least 'maxContainers' elements, in which to store
+ *                   the retrieved event packet containers, in order of arrival.
+ * @param maxContainers maximum number of containers to retrieve.
+ *
+ * @return the number of containers stored in 'containers'. Zero will be returned
+ *         on errors, or when there is no container available in non-blocking mode.
+ */
+size_t caerDeviceDataGetMany(caerDeviceHandle handle, caerEventPacketContainer *containers, size_t maxContainers);
+
+/**
+ * Set an aggregated data-consumed notification, called once per caerDeviceDataGetMany()
+ * call with the number of containers that were consumed from the FIFO buffer.
+ * If not set (NULL, the default), caerDeviceDataGetMany() will instead call the
+ * 'dataNotifyDecrease' function given to caerDeviceDataStart() once per container.
+ * The 'dataNotifyUserPtr' given to caerDeviceDataStart() will be passed as parameter.
+ *
+ * @param handle a valid device handle.
+ * @param dataNotifyDecreaseMany function pointer, called every time a batch of data
+ *                               has been consumed from the FIFO buffer inside
+ *                               caerDeviceDataGetMany(). Can be NULL to disable.
+ *
+ * @return true if the notification was set successfully, false on errors.
+ */
+bool caerDeviceDataNotifyDecreaseManySet(caerDeviceHandle handle,
+	void (*dataNotifyDecreaseMany)(void *ptr, size_t count));
+
+/**
+ * Latency stage: from the completion of the first USB transfer carrying data
+ * for a container, to that container being committed to the FIFO buffer.
+ */
+#define CAER_DEVICE_LATENCY_TRANSFER_TO_COMMIT 0
+/**
+ * Latency stage: from a container being committed to the FIFO buffer,
+ * to it being handed out by caerDeviceDataGet()/caerDeviceDataGetMany().
+ */
+#define CAER_DEVICE_LATENCY_COMMIT_TO_GET      1
+/**
+ * Latency stage: gap between the device time of a container's newest event
+ * and the host time its USB transfer completed. As device and host clocks
+ * have an unknown offset, this is relative to the smallest gap seen since
+ * the last reset (or device timestamp reset), and thus shows the additional
+ * delay (USB and device buffering) over the best observed case.
+ */
+#define CAER_DEVICE_LATENCY_DEVICE_TO_HOST     2
+
+/**
+ * Latency statistics for one stage of the data path, from a histogram
+ * with ~3% value precision. All values are in nanoseconds.
+ */
+struct caer_latency_stats {
+	/// Number of samples recorded.
+	uint64_t count;
+	/// Smallest recorded value.
+	uint64_t min;
+	/// Largest recorded value.
+	uint64_t max;
+	/// Average of all recorded values.
+	uint64_t mean;
+	/// 50th percentile (median).
+	uint64_t p50;
+	/// 90th percentile.
+	uint64_t p90;
+	/// 99th percentile.
+	uint64_t p99;
+	/// 99.9th percentile.
+	uint64_t p999;
+};
+
+/**
+ * Get the latency statistics for one stage of the data path of a device.
+ * Samples are recorded for every container, from caerDeviceOpen() or the
+ * last caerDeviceLatencyStatsReset() call on. This is lock-free and can be
+ * called from any thread at any time, also while data transfer is running.
+ *
+ * @param handle a valid device handle.
+ * @param stage the data path stage, one of the CAER_DEVICE_LATENCY_* defines.
+ * @param stats pointer to a structure in which to store the statistics.
+ *
+ * @return true on success, false on errors (invalid stage).
+ */
+bool caerDeviceLatencyStatsGet(caerDeviceHandle handle, uint8_t stage, struct caer_latency_stats *stats);
+
+/**
+ * Reset the latency statistics for all stages of the data path of a device.
+ * Samples recorded concurrently to a reset may be partially kept.
+ *
+ * @param handle a valid device handle.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerDeviceLatencyStatsReset(caerDeviceHandle handle);
+
+/**
+ * Device performance counters, maintained by the USB data transfer
+ * thread. All counts are cumulative since caerDeviceOpen().
+ */
+struct caer_device_stats {
+	/// Bytes received from the device via USB data transfers.
+	uint64_t bytesReceived;
+	/// USB data transfers that completed successfully.
+	uint64_t usbTransfersCompleted;
+	/// USB data transfers that completed with an error (not counting cancellations).
+	uint64_t usbTransfersFailed;
+	/// USB data transfers that were submitted again after completion.
+	uint64_t usbTransfersResubmitted;
+	/// Special events decoded.
+	uint64_t specialEvents;
+	/// Polarity events decoded.
+	uint64_t polarityEvents;
+	/// Frame events decoded.
+	uint64_t frameEvents;
+	/// IMU 6-axes events decoded.
+	uint64_t imu6Events;
+	/// Invalid, unknown or out-of-range data words received from the device.
+	uint64_t invalidEvents;
+	/// Number of times an event packet had to be grown to hold more events.
+	uint64_t packetGrows;
+	/// EventPacketContainers committed to the FIFO buffer. Containers waiting in
+	/// the overflow list (CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_SPILL) are only
+	/// counted once they are moved into the FIFO buffer.
+	uint64_t containersCommitted;
+	/// Empty EventPacketContainers discarded instead of being committed.
+	uint64_t containersEmptyDiscarded;
+	/// EventPacketContainers dropped because they couldn't be committed.
+	uint64_t containersDropped;
+	/// Timestamp reset events received from the device.
+	uint64_t timestampResets;
+	/// Timestamp big wraps (32 bit overflows), see the TIMESTAMP_WRAP special event.
+	uint64_t timestampBigWraps;
+};
+
+/**
+ * Get the current performance counters of a device. This is lock-free
+ * and can be called from any thread at any time, also while data transfer
+ * is running. Each counter is read atomically, but the counters aren't
+ * a consistent snapshot with regards to each other.
+ *
+ * @param handle a valid device handle.
+ * @param stats pointer to a structure in which to store the counters.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerDeviceStatsGet(caerDeviceHandle handle, struct caer_device_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,90 @@
+/**
+ * @file event_codec.h
+ *
+ * Lossless compression of event packets, for smaller recordings and
+ * network streams. Polarity and special event packets are compressed
+ * (delta-coded timestamps and addresses, as variable-length integers,
+ * and bit-packed flags). Frame event packets are compressed frame by
+ * frame: common low zero bits of the pixels (from the ADC depth) are
+ * dropped, each pixel is predicted from its left, upper and upper-left
+ * neighbours with the LOCO-I (JPEG-LS) median edge detector, and the
+ * prediction residuals are bit-packed in blocks of 16 sharing one bit
+ * width; frames that don't get smaller, like noise, are stored as they
+ * are. Other event types are stored as they are.
+ * Decoding always gives back exactly the original packet.
+ *
+ * An encoded packet is self-describing: the 28 bytes packet header,
+ * followed by the coding method (1 byte), the payload length
+ * (4 bytes, little-endian) and the payload.
+ */
+
+#ifndef LIBCAER_EVENT_CODEC_H_
+#define LIBCAER_EVENT_CODEC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "events/common.h"
+
+/**
+ * Size of the encoded packet header: the event packet header,
+ * followed by the coding method and the payload length.
+ */
+#define CAER_EVENT_CODEC_HEADER_SIZE (CAER_EVENT_PACKET_HEADER_SIZE + 1 + 4)
+
+/**
+ * Maximum size an event packet can have once encoded, to allocate
+ * buffers for caerEventCodecEncode(). Only the packet's events
+ * (its event number, not its capacity) are encoded.
+ *
+ * @param packet a valid event packet.
+ *
+ * @return the maximum size of the encoded packet in bytes, zero on error.
+ */
+size_t caerEventCodecEncodeBound(caerEventPacketHeader packet);
+
+/**
+ * Encode an event packet into a buffer.
+ *
+ * @param packet a valid event packet.
+ * @param buffer the buffer to encode into.
+ * @param bufferSize size of the buffer, at least caerEventCodecEncodeBound().
+ *
+ * @return the size of the encoded packet in bytes, zero on error.
+ */
+size_t caerEventCodecEncode(caerEventPacketHeader packet, uint8_t *buffer, size_t bufferSize);
+
+/**
+ * Get the size of the encoded packet at the start of a buffer, to find
+ * packet boundaries in a stream of encoded packets.
+ *
+ * @param buffer buffer holding at least CAER_EVENT_CODEC_HEADER_SIZE bytes.
+ * @param bufferSize size of the buffer.
+ *
+ * @return the size of the encoded packet in bytes, zero if the buffer
+ *         is too small to hold its header.
+ */
+size_t caerEventCodecEncodedSize(const uint8_t *buffer, size_t bufferSize);
+
+/**
+ * Decode the encoded packet at the start of a buffer into a newly allocated
+ * event packet, which is exactly the packet that was encoded, with its capacity
+ * reduced to its event number. The buffer content is fully validated.
+ *
+ * @param buffer the buffer holding an encoded packet.
+ * @param bufferSize size of the buffer.
+ * @param usedSize set to the size of the decoded packet's encoding in the buffer,
+ *                 which is where the next encoded packet starts in a stream.
+ *                 Can be NULL.
+ *
+ * @return a new event packet, to be freed with free(), or NULL on error
+ *         (invalid or truncated encoding, out of memory).
+ */
+caerEventPacketHeader caerEventCodecDecode(const uint8_t *buffer, size_t bufferSize, size_t *usedSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCAER_EVENT_CODEC_H_ */
@@ -33,6 +33,10 @@ extern "C" {
  * EventPacketContainer data structure definition.
  * Signed integers are used for compatibility with languages that
  * do not have unsigned ones, such as Java.
+ * Containers must be allocated with caerEventPacketContainerAllocate():
+ * the library keeps private data (the host timestamps) in the same
+ * memory block, so caerEventPacketContainerFree() and the host timestamp
+ * accessors don't work on containers allocated in any other way.
  */
 struct caer_event_packet_container {
 	/// Smallest event timestamp contained in this packet container.
@@ -71,6 +75,7 @@ caerEventPacketContainer caerEventPacketContainerAllocate(int32_t eventPacketsNu
  * freeing all of its contained EventPackets and their memory.
  * If you don't want the contained EventPackets to be freed, make
  * sure that you set their reference to NULL before calling this.
+ * Only containers from caerEventPacketContainerAllocate() can be freed.
 
  * @param container the container to be freed.
  */
@@ -229,6 +234,74 @@ static inline int64_t caerEventPacketContainerGetHighestEventTimestamp(caerEvent
 	return (container->highestEventTimestamp);
 }
 
+/**
+ * Get the host time at which the first USB transfer carrying data for
+ * this event packet container completed.
+ * Host times are taken from CLOCK_MONOTONIC, so they can only be compared
+ * with each other, within the same system, not with event timestamps.
+ *
+ * @param container a valid EventPacketContainer handle, allocated with
+ *                  caerEventPacketContainerAllocate(). If NULL, -1 is returned.
+ *
+ * @return the host transfer time (in ns) or -1 if not initialized.
+ */
+int64_t caerEventPacketContainerGetHostTransferTimestamp(caerEventPacketContainer container);
+
+/**
+ * Set the host time at which the first USB transfer carrying data for
+ * this event packet container completed. This should never be used
+ * directly, the device data acquisition sets this for you.
+ *
+ * @param container a valid EventPacketContainer handle, allocated with
+ *                  caerEventPacketContainerAllocate(). If NULL, nothing happens.
+ * @param hostTransferTimestamp the host transfer time (in ns, CLOCK_MONOTONIC).
+ */
+void caerEventPacketContainerSetHostTransferTimestamp(caerEventPacketContainer container, int64_t hostTransferTimestamp);
+
+/**
+ * Get the host time at which this event packet container was committed
+ * to the data exchange buffer, making it available to caerDeviceDataGet().
+ *
+ * @param container a valid EventPacketContainer handle, allocated with
+ *                  caerEventPacketContainerAllocate(). If NULL, -1 is returned.
+ *
+ * @return the host commit time (in ns) or -1 if not initialized.
+ */
+int64_t caerEventPacketContainerGetHostCommitTimestamp(caerEventPacketContainer container);
+
+/**
+ * Set the host time at which this event packet container was committed
+ * to the data exchange buffer. This should never be used directly,
+ * the device data acquisition sets this for you.
+ *
+ * @param container a valid EventPacketContainer handle, allocated with
+ *                  caerEventPacketContainerAllocate(). If NULL, nothing happens.
+ * @param hostCommitTimestamp the host commit time (in ns, CLOCK_MONOTONIC).
+ */
+void caerEventPacketContainerSetHostCommitTimestamp(caerEventPacketContainer container, int64_t hostCommitTimestamp);
+
+/**
+ * Get the host time at which this event packet container was handed
+ * out to the user by caerDeviceDataGet() or caerDeviceDataGetMany().
+ *
+ * @param container a valid EventPacketContainer handle, allocated with
+ *                  caerEventPacketContainerAllocate(). If NULL, -1 is returned.
+ *
+ * @return the host get time (in ns) or -1 if not initialized.
+ */
+int64_t caerEventPacketContainerGetHostGetTimestamp(caerEventPacketContainer container);
+
+/**
+ * Set the host time at which this event packet container was handed
+ * out to the user. This should never be used directly,
+ * caerDeviceDataGet() sets this for you.
+ *
+ * @param container a valid EventPacketContainer handle, allocated with
+ *                  caerEventPacketContainerAllocate(). If NULL, nothing happens.
+ * @param hostGetTimestamp the host get time (in ns, CLOCK_MONOTONIC).
+ */
+void caerEventPacketContainerSetHostGetTimestamp(caerEventPacketContainer container, int64_t hostGetTimestamp);
+
 /**
  * Get the number of events contained in this event packet container.
  *
@@ -331,6 +404,12 @@ static inline caerEventPacketContainer caerEventPacketContainerCopyAllEvents(cae
 		return (NULL);
 	}
 
+	// Keep host-side timing information, it's still about the same data.
+	caerEventPacketContainerSetHostTransferTimestamp(newContainer,
+		caerEventPacketContainerGetHostTransferTimestamp(container));
+	caerEventPacketContainerSetHostCommitTimestamp(newContainer, caerEventPacketContainerGetHostCommitTimestamp(container));
+	caerEventPacketContainerSetHostGetTimestamp(newContainer, caerEventPacketContainerGetHostGetTimestamp(container));
+
 	CAER_EVENT_PACKET_CONTAINER_ITERATOR_START(container)
 		caerEventPacketContainerSetEventPacket(newContainer, caerEventPacketContainerIteratorCounter,
 			(caerEventPacketHeader) caerCopyEventPacketOnlyEvents((void *) caerEventPacketContainerIteratorElement));
@@ -359,6 +438,12 @@ static inline caerEventPacketContainer caerEventPacketContainerCopyValidEvents(c
 		return (NULL);
 	}
 
+	// Keep host-side timing information, it's still about the same data.
+	caerEventPacketContainerSetHostTransferTimestamp(newContainer,
+		caerEventPacketContainerGetHostTransferTimestamp(container));
+	caerEventPacketContainerSetHostCommitTimestamp(newContainer, caerEventPacketContainerGetHostCommitTimestamp(container));
+	caerEventPacketContainerSetHostGetTimestamp(newContainer, caerEventPacketContainerGetHostGetTimestamp(container));
+
 	CAER_EVENT_PACKET_CONTAINER_ITERATOR_START(container)
 		caerEventPacketContainerSetEventPacket(newContainer, caerEventPacketContainerIteratorCounter,
 			(caerEventPacketHeader) caerCopyEventPacketOnlyValidEvents((void *) caerEventPacketContainerIteratorElement));
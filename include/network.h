@@ -0,0 +1,178 @@
+/**
+ * @file network.h
+ *
+ * Streaming of packet containers over TCP, in AEDAT 3.1 framing: every
+ * client first receives an AEDAT 3.1 text header, followed by event packets
+ * exactly as they are stored in a RAW recording (see aedat.h), so any
+ * AEDAT 3.x reader can consume the stream too.
+ * The packets of a container are sent in the order of their index in the
+ * container, followed by an empty special event packet marking the end of
+ * the container, which the header announces with a '#Packet-Container-End'
+ * line. The receiving client uses these to rebuild the containers exactly,
+ * with each packet at the index of its event type. On streams without them,
+ * it starts a new container whenever the event type doesn't increase from
+ * the previous packet, which merges back-to-back containers of a single
+ * event type (for example polarity-only ones).
+ */
+
+#ifndef LIBCAER_NETWORK_H_
+#define LIBCAER_NETWORK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "events/packetContainer.h"
+
+/**
+ * What the server does when a client's send queue is full, because that
+ * client (or its network link) can't keep up. Other clients are never affected.
+ */
+enum caer_network_client_policy {
+	/// Skip containers for that client until its queue has space again.
+	CAER_NETWORK_CLIENT_DROP_NEWEST = 0,
+	/// Disconnect that client, so it never sees a stream with gaps.
+	CAER_NETWORK_CLIENT_DISCONNECT = 1,
+};
+
+/**
+ * Reference to a running TCP streaming server.
+ */
+typedef struct caer_network_server *caerNetworkServer;
+
+/**
+ * TCP streaming server statistics. All counts are cumulative since
+ * caerNetworkServerOpen(), container counts are summed over all clients.
+ */
+struct caer_network_server_stats {
+	/// Clients currently connected.
+	uint32_t clientsConnected;
+	/// Clients accepted.
+	uint64_t clientsAccepted;
+	/// Clients refused, because the maximum number of clients was reached.
+	uint64_t clientsRefused;
+	/// Clients disconnected by the server, on errors or by policy.
+	uint64_t clientsDropped;
+	/// Packet containers fully sent to a client.
+	uint64_t containersSent;
+	/// Packet containers not sent to a client, because its queue was full.
+	uint64_t containersDropped;
+	/// Bytes sent to clients, including the text headers.
+	uint64_t bytesSent;
+	/// Number of send system calls issued.
+	uint64_t sendCalls;
+};
+
+/**
+ * Start a TCP streaming server, listening on the given address and port,
+ * with its own thread serving all clients. Each client gets its own send
+ * queue; containers are sent directly from the packets' memory, gathering
+ * many packets (and containers) into each send system call, without copies.
+ *
+ * @param address local address to listen on (for example "127.0.0.1"),
+ *                or NULL to listen on all interfaces.
+ * @param port TCP port to listen on, zero to let the system pick a free one
+ *             (see caerNetworkServerGetPort()).
+ * @param sourceID ID of the source of the streamed events, for the header.
+ * @param sourceDescription description of that source (for example a device's
+ *                          'deviceString' information), or NULL to not send it.
+ * @param maxClients maximum number of clients connected at the same time.
+ * @param clientQueueSize maximum number of packet containers waiting to be sent,
+ *                        per client. Must be a power of two; 1 is rounded up to 2.
+ * @param policy what to do when a client's queue is full.
+ *
+ * @return a valid server, or NULL on error.
+ */
+caerNetworkServer caerNetworkServerOpen(const char *address, uint16_t port, int16_t sourceID,
+	const char *sourceDescription, uint32_t maxClients, uint32_t clientQueueSize,
+	enum caer_network_client_policy policy);
+
+/**
+ * Get the TCP port the server is listening on.
+ *
+ * @param server a valid server.
+ *
+ * @return the port, zero on invalid arguments.
+ */
+uint16_t caerNetworkServerGetPort(caerNetworkServer server);
+
+/**
+ * Send a packet container to all currently connected clients. The server
+ * always takes ownership of the container (and its packets), and frees it
+ * once it was sent to, or dropped for, all clients; the capacity of its
+ * packets is reduced to their event number, like AEDAT 3.x requires.
+ * Only one thread may call this on the same server.
+ *
+ * @param server a valid server.
+ * @param container the packet container to send.
+ *
+ * @return true on success (even if no client is connected, or the container
+ *         was dropped for some clients), false on invalid arguments or
+ *         if out of memory.
+ */
+bool caerNetworkServerSend(caerNetworkServer server, caerEventPacketContainer container);
+
+/**
+ * Get the server statistics. See 'struct caer_network_server_stats'.
+ *
+ * @param server a valid server.
+ * @param stats structure to fill with the current statistics.
+ *
+ * @return true on success, false on invalid arguments.
+ */
+bool caerNetworkServerStatsGet(caerNetworkServer server, struct caer_network_server_stats *stats);
+
+/**
+ * Stop the server thread, disconnect all clients (discarding what they
+ * still had queued), close the listening socket and free the server.
+ *
+ * @param server a valid server. Invalid after this call.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerNetworkServerClose(caerNetworkServer server);
+
+/**
+ * Reference to a TCP streaming client, connected to a server.
+ */
+typedef struct caer_network_client *caerNetworkClient;
+
+/**
+ * Connect to a TCP streaming server (or any source of an AEDAT 3.x RAW
+ * stream over TCP) and read its text header.
+ *
+ * @param host name or address of the server.
+ * @param port TCP port of the server.
+ *
+ * @return a valid client, or NULL on error (connection refused,
+ *         not an AEDAT 3.x stream or not RAW format).
+ */
+caerNetworkClient caerNetworkClientOpen(const char *host, uint16_t port);
+
+/**
+ * Receive the next packet container, blocking until it is complete.
+ * Containers have one slot per known event type, each packet being at
+ * the index of its event type; packets of unknown types are skipped.
+ * The capacity of all packets is equal to their event number.
+ *
+ * @param client a valid client.
+ *
+ * @return a packet container, to be freed with caerEventPacketContainerFree(),
+ *         or NULL when the server closed the connection or on errors.
+ */
+caerEventPacketContainer caerNetworkClientReceive(caerNetworkClient client);
+
+/**
+ * Close the connection and free the client.
+ *
+ * @param client a valid client. Invalid after this call.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerNetworkClientClose(caerNetworkClient client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCAER_NETWORK_H_ */
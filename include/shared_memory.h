@@ -0,0 +1,178 @@
+/**
+ * @file shared_memory.h
+ *
+ * Transport of event packets between processes on the same host through
+ * POSIX shared memory, without copies and without system calls on the data
+ * path (except for waking up waiting consumers).
+ * A producer creates a named shared memory segment holding a ring of slots,
+ * each carrying the event packets of one container; any number of consumer
+ * processes map it read-only and access the packets in place.
+ * The producer never waits for consumers: a consumer that falls behind by
+ * more than the number of slots loses the oldest ones, and is told so.
+ */
+
+#ifndef LIBCAER_SHARED_MEMORY_H_
+#define LIBCAER_SHARED_MEMORY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "events/packetContainer.h"
+
+/**
+ * Maximum number of event packets in one slot.
+ */
+#define CAER_SHARED_MEMORY_SLOT_PACKETS_MAX 16
+
+/**
+ * Reference to the producer side of a shared memory ring.
+ */
+typedef struct caer_shared_memory_producer *caerSharedMemoryProducer;
+
+/**
+ * Create a shared memory segment with a ring of slots, replacing any
+ * existing segment of the same name, and map it for writing.
+ *
+ * @param name name of the segment, starting with '/' (see shm_open()).
+ * @param slotCount number of slots in the ring. Must be a power of two.
+ * @param slotSize maximum size in bytes of the event packets in a slot,
+ *                 including their headers.
+ *
+ * @return a valid producer, or NULL on error.
+ */
+caerSharedMemoryProducer caerSharedMemoryProducerOpen(const char *name, uint32_t slotCount, size_t slotSize);
+
+/**
+ * Allocate an empty event packet directly in the shared memory, in the slot
+ * being filled (starting a new one if needed), so it can be filled in place.
+ * Its header is initialized like by the caer*EventPacketAllocate() functions,
+ * with an event number of zero; the event size must match the type.
+ * The packet becomes visible to consumers with caerSharedMemoryProducerCommit(),
+ * and must not be freed nor modified after that.
+ * Only one thread may use the producer at a time.
+ *
+ * @param producer a valid producer.
+ * @param eventCapacity maximum number of events the packet can hold.
+ * @param eventType type of the events.
+ * @param eventSize size of one event in bytes.
+ * @param eventTSOffset offset of the timestamp in an event, in bytes.
+ * @param eventSource source of the events.
+ * @param tsOverflow current timestamp overflow counter.
+ *
+ * @return a new event packet in the shared memory, or NULL if the slot
+ *         can't hold it (not enough space or too many packets, commit
+ *         what's there and try again).
+ */
+caerEventPacketHeader caerSharedMemoryProducerPacketAllocate(caerSharedMemoryProducer producer,
+	int32_t eventCapacity, int16_t eventType, int32_t eventSize, int32_t eventTSOffset, int16_t eventSource,
+	int32_t tsOverflow);
+
+/**
+ * Publish the slot being filled to all consumers, and wake up those waiting.
+ * Does nothing if no packet was allocated since the last commit.
+ *
+ * @param producer a valid producer.
+ *
+ * @return true on success, false on invalid arguments.
+ */
+bool caerSharedMemoryProducerCommit(caerSharedMemoryProducer producer);
+
+/**
+ * Write all event packets of a container into one slot and publish it.
+ * This copies the packets once, for containers that already exist
+ * (for example coming from a device); to avoid that copy, build packets
+ * in place with caerSharedMemoryProducerPacketAllocate() instead.
+ * The container stays owned by the caller.
+ *
+ * @param producer a valid producer, with no slot being filled.
+ * @param container the packet container to write.
+ *
+ * @return true on success, false on invalid arguments or if the packets
+ *         don't fit in a slot.
+ */
+bool caerSharedMemoryProducerWrite(caerSharedMemoryProducer producer, caerEventPacketContainer container);
+
+/**
+ * Unmap and remove the shared memory segment, and free the producer.
+ * Consumers keep their mapping, but won't see new slots anymore.
+ *
+ * @param producer a valid producer. Invalid after this call.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerSharedMemoryProducerClose(caerSharedMemoryProducer producer);
+
+/**
+ * Reference to the consumer side of a shared memory ring.
+ */
+typedef struct caer_shared_memory_consumer *caerSharedMemoryConsumer;
+
+/**
+ * A slot as seen by a consumer, filled by caerSharedMemoryConsumerNext().
+ */
+struct caer_shared_memory_view {
+	/// Number of the slot since the producer started, increasing by one per slot.
+	uint64_t sequence;
+	/// Slots the consumer missed right before this one, because it fell behind.
+	uint64_t slotsLost;
+	/// Number of event packets in the slot.
+	int32_t packetsNumber;
+	/// The event packets, pointing directly into the read-only shared memory.
+	/// They must not be modified nor freed.
+	caerEventPacketHeader packets[CAER_SHARED_MEMORY_SLOT_PACKETS_MAX];
+};
+
+/**
+ * Map an existing shared memory segment read-only. The consumer starts
+ * with the next slot the producer publishes.
+ *
+ * @param name name of the segment, as given to caerSharedMemoryProducerOpen().
+ *
+ * @return a valid consumer, or NULL on error (no such segment or invalid content).
+ */
+caerSharedMemoryConsumer caerSharedMemoryConsumerOpen(const char *name);
+
+/**
+ * Get the next slot, waiting for the producer to publish it if needed.
+ * The packets in the view are accessed in place. Since the producer never
+ * waits, it may reuse the slot while it's being read, if the consumer falls
+ * behind by the whole ring: call caerSharedMemoryConsumerValid() once done
+ * with the packets, to know if what was read is trustworthy.
+ *
+ * @param consumer a valid consumer.
+ * @param view the view to fill.
+ * @param timeout maximum time to wait, in µs, zero to not wait.
+ *
+ * @return true if a slot was returned, false on timeout or invalid arguments.
+ */
+bool caerSharedMemoryConsumerNext(caerSharedMemoryConsumer consumer, struct caer_shared_memory_view *view,
+	uint32_t timeout);
+
+/**
+ * Check that the slot in a view was not reused by the producer since
+ * caerSharedMemoryConsumerNext() returned it.
+ *
+ * @param consumer a valid consumer.
+ * @param view a view filled by caerSharedMemoryConsumerNext().
+ *
+ * @return true if all data read from the view's packets up to now is valid,
+ *         false if it may have been overwritten and must be discarded.
+ */
+bool caerSharedMemoryConsumerValid(caerSharedMemoryConsumer consumer, const struct caer_shared_memory_view *view);
+
+/**
+ * Unmap the shared memory segment and free the consumer. All packets
+ * of the views it returned become invalid.
+ *
+ * @param consumer a valid consumer. Invalid after this call.
+ *
+ * @return true on success, false on errors.
+ */
+bool caerSharedMemoryConsumerClose(caerSharedMemoryConsumer consumer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCAER_SHARED_MEMORY_H_ */
@@ -0,0 +1,51 @@
+#ifndef LIBCAER_SRC_AEDAT_FORMAT_H_
+#define LIBCAER_SRC_AEDAT_FORMAT_H_
+
+// Values of the AEDAT 3.x '#Format:' header line. RAW stores event packets
+// as they are in memory, EventCodec as encoded by caerEventCodecEncode().
+#define AEDAT_FORMAT_LINE "#Format: "
+#define AEDAT_FORMAT_RAW "RAW"
+#define AEDAT_FORMAT_EVENT_CODEC "EventCodec"
+
+// Header line of network streams that end every packet container with an
+// empty event packet, so clients don't have to guess container boundaries.
+#define AEDAT_CONTAINER_END_LINE "#Packet-Container-End: Empty-Packet"
+
+#define AEDAT_HEADER_MAX 1024
+
+#include "libcaer.h"
+#include <time.h>
+
+// Build an AEDAT 3.1 text header, for recordings and network streams, with an
+// optional additional line (without line ending). Returns its length, at most AEDAT_HEADER_MAX - 1.
+static inline size_t aedatHeaderBuild(char header[AEDAT_HEADER_MAX], const char *format, int16_t sourceID,
+	const char *sourceDescription, const char *extraLine) {
+	size_t headerLength = 0;
+
+	time_t currentTimeEpoch = time(NULL);
+	struct tm currentTime;
+	localtime_r(&currentTimeEpoch, &currentTime);
+
+	char currentTimeString[64];
+	strftime(currentTimeString, 64, "%Y-%m-%d %H:%M:%S (TZ%z)", &currentTime);
+
+	headerLength += (size_t) snprintf(header + headerLength, AEDAT_HEADER_MAX - headerLength,
+		"#!AER-DAT3.1\r\n" AEDAT_FORMAT_LINE "%s\r\n", format);
+
+	if (sourceDescription != NULL) {
+		headerLength += (size_t) snprintf(header + headerLength, AEDAT_HEADER_MAX - headerLength,
+			"#Source %" PRIi16 ": %.512s\r\n", sourceID, sourceDescription);
+	}
+
+	if (extraLine != NULL) {
+		headerLength += (size_t) snprintf(header + headerLength, AEDAT_HEADER_MAX - headerLength, "%.128s\r\n",
+			extraLine);
+	}
+
+	headerLength += (size_t) snprintf(header + headerLength, AEDAT_HEADER_MAX - headerLength,
+		"#Start-Time: %s\r\n#!END-HEADER\r\n", currentTimeString);
+
+	return (headerLength);
+}
+
+#endif /* LIBCAER_SRC_AEDAT_FORMAT_H_ */
@@ -0,0 +1,59 @@
+#ifndef LIBCAER_SRC_AEDAT_INDEX_H_
+#define LIBCAER_SRC_AEDAT_INDEX_H_
+
+#include "aedat.h"
+
+// Sidecar timestamp index, '<recording>.idx': a 16 bytes header (magic
+// and format version), followed by one entry per event packet of the
+// recording, in file order, all integers little-endian.
+#define AEDAT_INDEX_SUFFIX ".idx"
+#define AEDAT_INDEX_MAGIC "CAERAEDATIDX"
+#define AEDAT_INDEX_MAGIC_LENGTH 12
+#define AEDAT_INDEX_VERSION 1
+#define AEDAT_INDEX_HEADER_SIZE 16
+
+struct aedat_index_file_entry {
+	uint64_t offset;
+	int64_t firstTimestamp;
+	int64_t lastTimestamp;
+	int16_t eventType;
+	int16_t eventSource;
+	int32_t eventNumber;
+}__attribute__((__packed__));
+
+#define AEDAT_INDEX_ENTRY_SIZE sizeof(struct aedat_index_file_entry)
+
+// The packet must hold at least one event, with a valid timestamp offset.
+static inline void aedatIndexEntryFromPacket(struct caer_aedat_index_entry *entry, caerEventPacketHeader packet,
+	uint64_t offset) {
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+
+	entry->offset = offset;
+	entry->firstTimestamp = caerGenericEventGetTimestamp64(caerGenericEventGetEvent(packet, 0), packet);
+	entry->lastTimestamp = caerGenericEventGetTimestamp64(caerGenericEventGetEvent(packet, eventNumber - 1), packet);
+	entry->eventType = caerEventPacketHeaderGetEventType(packet);
+	entry->eventSource = caerEventPacketHeaderGetEventSource(packet);
+	entry->eventNumber = eventNumber;
+}
+
+static inline void aedatIndexEntryToFile(struct aedat_index_file_entry *fileEntry,
+	const struct caer_aedat_index_entry *entry) {
+	fileEntry->offset = htole64(entry->offset);
+	fileEntry->firstTimestamp = I64T(htole64(U64T(entry->firstTimestamp)));
+	fileEntry->lastTimestamp = I64T(htole64(U64T(entry->lastTimestamp)));
+	fileEntry->eventType = I16T(htole16(U16T(entry->eventType)));
+	fileEntry->eventSource = I16T(htole16(U16T(entry->eventSource)));
+	fileEntry->eventNumber = I32T(htole32(U32T(entry->eventNumber)));
+}
+
+static inline void aedatIndexEntryFromFile(struct caer_aedat_index_entry *entry,
+	const struct aedat_index_file_entry *fileEntry) {
+	entry->offset = le64toh(fileEntry->offset);
+	entry->firstTimestamp = I64T(le64toh(U64T(fileEntry->firstTimestamp)));
+	entry->lastTimestamp = I64T(le64toh(U64T(fileEntry->lastTimestamp)));
+	entry->eventType = I16T(le16toh(U16T(fileEntry->eventType)));
+	entry->eventSource = I16T(le16toh(U16T(fileEntry->eventSource)));
+	entry->eventNumber = I32T(le32toh(U32T(fileEntry->eventNumber)));
+}
+
+#endif /* LIBCAER_SRC_AEDAT_INDEX_H_ */
@@ -0,0 +1,499 @@
+#include "aedat_index.h"
+#include "aedat_format.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct caer_aedat_reader {
+	uint8_t *fileMap; // Mapped read-only.
+	size_t fileSize;
+	size_t dataOffset;
+	int8_t formatVersionMinor;
+	char *fileName;
+	// Timestamp index, sorted by event type, then source, then file offset.
+	struct caer_aedat_index_entry *index;
+	size_t indexSize;
+};
+
+static bool aedatReaderParseHeader(caerAEDATReader reader, const char *fileName);
+static uint64_t aedatReaderPacketSize(caerAEDATReader reader, uint64_t offset);
+static bool aedatReaderIndexLoadFile(caerAEDATReader reader);
+static bool aedatReaderIndexBuild(caerAEDATReader reader);
+static int aedatReaderIndexCompare(const void *a, const void *b);
+
+caerAEDATReader caerAEDATReaderOpen(const char *fileName, uint32_t flags) {
+	if (fileName == NULL) {
+		return (NULL);
+	}
+
+	int fileDescriptor = open(fileName, O_RDONLY);
+	if (fileDescriptor < 0) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open file '%s'. Error: %d.", fileName, errno);
+		return (NULL);
+	}
+
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size <= 0
+		|| (uintmax_t) fileStat.st_size > (uintmax_t) SIZE_MAX) {
+		close(fileDescriptor);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "File '%s' is empty or can't be mapped.", fileName);
+		return (NULL);
+	}
+
+	caerAEDATReader reader = calloc(1, sizeof(*reader));
+	if (reader == NULL) {
+		close(fileDescriptor);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for AEDAT reader.");
+		return (NULL);
+	}
+
+	reader->fileName = strdup(fileName);
+	if (reader->fileName == NULL) {
+		free(reader);
+		close(fileDescriptor);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for AEDAT reader.");
+		return (NULL);
+	}
+
+	reader->fileSize = (size_t) fileStat.st_size;
+
+	// Read-only private mapping: packets are handed out in place, and
+	// nothing is accounted as committed memory, even for huge files.
+	void *fileMap = mmap(NULL, reader->fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+	// The mapping keeps its own reference to the file.
+	close(fileDescriptor);
+
+	if (fileMap == MAP_FAILED) {
+		free(reader->fileName);
+		free(reader);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to map file '%s'. Error: %d.", fileName, errno);
+		return (NULL);
+	}
+
+	reader->fileMap = fileMap;
+
+	// Access pattern hints, failures only cost performance.
+	if (flags & CAER_AEDAT_READER_SEQUENTIAL) {
+		madvise(fileMap, reader->fileSize, MADV_SEQUENTIAL);
+	}
+
+#if defined(MADV_HUGEPAGE)
+	if (flags & CAER_AEDAT_READER_HUGEPAGES) {
+		madvise(fileMap, reader->fileSize, MADV_HUGEPAGE);
+	}
+#endif
+
+	if (!aedatReaderParseHeader(reader, fileName)) {
+		munmap(fileMap, reader->fileSize);
+		free(reader->fileName);
+		free(reader);
+
+		return (NULL);
+	}
+
+	return (reader);
+}
+
+struct caer_aedat_reader_info caerAEDATReaderInfoGet(caerAEDATReader reader) {
+	// Check if the pointer is valid.
+	if (reader == NULL) {
+		struct caer_aedat_reader_info emptyInfo = { 0, 0, 0 };
+		return (emptyInfo);
+	}
+
+	struct caer_aedat_reader_info info = { reader->formatVersionMinor, U64T(reader->fileSize),
+		U64T(reader->dataOffset) };
+	return (info);
+}
+
+void caerAEDATReaderIteratorInit(caerAEDATReader reader, struct caer_aedat_reader_iterator *iterator,
+	int16_t eventType, int16_t eventSource) {
+	if (reader == NULL || iterator == NULL) {
+		return;
+	}
+
+	iterator->offset = U64T(reader->dataOffset);
+	iterator->eventType = eventType;
+	iterator->eventSource = eventSource;
+}
+
+caerEventPacketHeader caerAEDATReaderIteratorNext(caerAEDATReader reader, struct caer_aedat_reader_iterator *iterator) {
+	if (reader == NULL || iterator == NULL) {
+		return (NULL);
+	}
+
+	while (iterator->offset < reader->fileSize) {
+		uint64_t packetSize = aedatReaderPacketSize(reader, iterator->offset);
+		if (packetSize == 0) {
+			caerLog(CAER_LOG_ERROR, __func__, "Invalid or truncated event packet at offset %" PRIu64 ", stopping.",
+				iterator->offset);
+			iterator->offset = U64T(reader->fileSize);
+			return (NULL);
+		}
+
+		// Packed structure, valid at any alignment.
+		caerEventPacketHeader packet = (caerEventPacketHeader) (reader->fileMap + iterator->offset);
+
+		iterator->offset += packetSize;
+
+		if ((iterator->eventType < 0 || caerEventPacketHeaderGetEventType(packet) == iterator->eventType)
+			&& (iterator->eventSource < 0 || caerEventPacketHeaderGetEventSource(packet) == iterator->eventSource)) {
+			return (packet);
+		}
+	}
+
+	return (NULL);
+}
+
+caerEventPacketHeader caerAEDATReaderPacketAt(caerAEDATReader reader, uint64_t offset) {
+	if (reader == NULL || offset < reader->dataOffset || aedatReaderPacketSize(reader, offset) == 0) {
+		return (NULL);
+	}
+
+	return ((caerEventPacketHeader) (reader->fileMap + offset));
+}
+
+bool caerAEDATReaderIndexLoad(caerAEDATReader reader) {
+	if (reader == NULL) {
+		return (false);
+	}
+
+	if (reader->index != NULL) {
+		return (true);
+	}
+
+	if (!aedatReaderIndexLoadFile(reader) && !aedatReaderIndexBuild(reader)) {
+		return (false);
+	}
+
+	if (reader->index == NULL) {
+		// Valid, but empty recording: keep a non-NULL index to mark it loaded.
+		reader->index = malloc(sizeof(*reader->index));
+		if (reader->index == NULL) {
+			return (false);
+		}
+	}
+
+	// Per type and source, file order is timestamp order. The writer and
+	// the scan both produce entries in file order, so offsets are unique.
+	qsort(reader->index, reader->indexSize, sizeof(struct caer_aedat_index_entry), &aedatReaderIndexCompare);
+
+	return (true);
+}
+
+size_t caerAEDATReaderIndexFind(caerAEDATReader reader, int16_t eventType, int16_t eventSource,
+	int64_t startTimestamp, int64_t endTimestamp, const struct caer_aedat_index_entry **entries) {
+	if (reader == NULL || reader->index == NULL || entries == NULL || startTimestamp > endTimestamp) {
+		return (0);
+	}
+
+	// First entry of this type and source whose last event is not before the range.
+	size_t low = 0;
+	size_t high = reader->indexSize;
+
+	while (low < high) {
+		size_t middle = low + ((high - low) / 2);
+		const struct caer_aedat_index_entry *entry = &reader->index[middle];
+
+		if (entry->eventType < eventType || (entry->eventType == eventType && entry->eventSource < eventSource)
+			|| (entry->eventType == eventType && entry->eventSource == eventSource
+				&& entry->lastTimestamp < startTimestamp)) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	size_t first = low;
+
+	// First entry after that whose first event is after the range, or that has another type or source.
+	high = reader->indexSize;
+
+	while (low < high) {
+		size_t middle = low + ((high - low) / 2);
+		const struct caer_aedat_index_entry *entry = &reader->index[middle];
+
+		if (entry->eventType == eventType && entry->eventSource == eventSource
+			&& entry->firstTimestamp <= endTimestamp) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	*entries = &reader->index[first];
+
+	return (low - first);
+}
+
+bool caerAEDATReaderClose(caerAEDATReader reader) {
+	if (reader == NULL) {
+		return (false);
+	}
+
+	bool success = true;
+
+	if (munmap(reader->fileMap, reader->fileSize) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to unmap AEDAT file. Error: %d.", errno);
+		success = false;
+	}
+
+	free(reader->index);
+	free(reader->fileName);
+	free(reader);
+
+	return (success);
+}
+
+static bool aedatReaderParseHeader(caerAEDATReader reader, const char *fileName) {
+	const char *fileData = (const char *) reader->fileMap;
+	size_t position = 0;
+	bool firstLine = true;
+
+	// The AEDAT 3.x header is a sequence of text lines starting with '#',
+	// the first giving the format version, the last being '#!END-HEADER'.
+	while (position < reader->fileSize && fileData[position] == '#') {
+		const char *line = fileData + position;
+		const char *lineEnd = memchr(line, '\n', reader->fileSize - position);
+		if (lineEnd == NULL) {
+			break;
+		}
+
+		size_t lineLength = (size_t) (lineEnd - line) + 1;
+		position += lineLength;
+
+		if (firstLine) {
+			firstLine = false;
+
+			if (lineLength < 12 || strncmp(line, "#!AER-DAT3.", 11) != 0 || line[11] < '0' || line[11] > '9') {
+				break;
+			}
+
+			reader->formatVersionMinor = I8T(line[11] - '0');
+			continue;
+		}
+
+		size_t formatLineLength = strlen(AEDAT_FORMAT_LINE);
+
+		if (lineLength > formatLineLength && strncmp(line, AEDAT_FORMAT_LINE, formatLineLength) == 0) {
+			const char *format = line + formatLineLength;
+			size_t formatLength = strcspn(format, "\r\n");
+
+			// Only raw packets can be used in place, compressed ones have to be
+			// decoded, which the replay device does.
+			if (formatLength != strlen(AEDAT_FORMAT_RAW) || strncmp(format, AEDAT_FORMAT_RAW, formatLength) != 0) {
+				caerLog(CAER_LOG_CRITICAL, __func__,
+					"File '%s' has format '%.*s', only '" AEDAT_FORMAT_RAW "' recordings can be read in place.",
+					fileName, (int) formatLength, format);
+				return (false);
+			}
+
+			continue;
+		}
+
+		if (lineLength >= 12 && strncmp(line, "#!END-HEADER", 12) == 0) {
+			reader->dataOffset = position;
+			return (true);
+		}
+	}
+
+	caerLog(CAER_LOG_CRITICAL, __func__, "File '%s' has no valid AEDAT 3.x header.", fileName);
+	return (false);
+}
+
+// Returns the full size of the event packet at 'offset', or zero if
+// there is no valid packet that fits into the file at that position.
+static uint64_t aedatReaderPacketSize(caerAEDATReader reader, uint64_t offset) {
+	if (offset > reader->fileSize || (reader->fileSize - offset) < CAER_EVENT_PACKET_HEADER_SIZE) {
+		return (0);
+	}
+
+	caerEventPacketHeader packet = (caerEventPacketHeader) (reader->fileMap + offset);
+
+	// Event data follows the header, capacity times the event size.
+	// Both are positive 32 bit integers, so this can't overflow.
+	int32_t eventSize = caerEventPacketHeaderGetEventSize(packet);
+	int32_t eventCapacity = caerEventPacketHeaderGetEventCapacity(packet);
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+	int32_t eventTSOffset = caerEventPacketHeaderGetEventTSOffset(packet);
+
+	// The 32 bit timestamp must lie within the event, it's read for indexing.
+	if (eventSize <= 0 || eventCapacity < 0 || eventNumber < 0 || eventNumber > eventCapacity
+		|| eventTSOffset < 0 || eventTSOffset > eventSize - I32T(sizeof(int32_t))) {
+		return (0);
+	}
+
+	uint64_t packetSize = CAER_EVENT_PACKET_HEADER_SIZE + (U64T(eventCapacity) * U64T(eventSize));
+
+	if (packetSize > (reader->fileSize - offset)) {
+		return (0);
+	}
+
+	return (packetSize);
+}
+
+static bool aedatReaderIndexLoadFile(caerAEDATReader reader) {
+	size_t indexFileNameLength = strlen(reader->fileName) + strlen(AEDAT_INDEX_SUFFIX) + 1;
+	char *indexFileName = malloc(indexFileNameLength);
+	if (indexFileName == NULL) {
+		return (false);
+	}
+
+	snprintf(indexFileName, indexFileNameLength, "%s%s", reader->fileName, AEDAT_INDEX_SUFFIX);
+
+	FILE *indexFile = fopen(indexFileName, "rb");
+	free(indexFileName);
+
+	if (indexFile == NULL) {
+		return (false);
+	}
+
+	uint8_t indexHeader[AEDAT_INDEX_HEADER_SIZE];
+	uint32_t indexVersion;
+
+	if (fread(indexHeader, 1, AEDAT_INDEX_HEADER_SIZE, indexFile) != AEDAT_INDEX_HEADER_SIZE
+		|| memcmp(indexHeader, AEDAT_INDEX_MAGIC, AEDAT_INDEX_MAGIC_LENGTH) != 0) {
+		fclose(indexFile);
+		return (false);
+	}
+
+	memcpy(&indexVersion, indexHeader + AEDAT_INDEX_MAGIC_LENGTH, sizeof(indexVersion));
+	if (le32toh(indexVersion) != AEDAT_INDEX_VERSION) {
+		fclose(indexFile);
+		return (false);
+	}
+
+	struct caer_aedat_index_entry *index = NULL;
+	size_t indexSize = 0;
+	size_t indexCapacity = 0;
+	struct aedat_index_file_entry fileEntry;
+
+	while (fread(&fileEntry, 1, AEDAT_INDEX_ENTRY_SIZE, indexFile) == AEDAT_INDEX_ENTRY_SIZE) {
+		if (indexSize == indexCapacity) {
+			indexCapacity = (indexCapacity == 0) ? (1024) : (indexCapacity * 2);
+
+			struct caer_aedat_index_entry *newIndex = realloc(index, indexCapacity * sizeof(*index));
+			if (newIndex == NULL) {
+				free(index);
+				fclose(indexFile);
+				return (false);
+			}
+
+			index = newIndex;
+		}
+
+		aedatIndexEntryFromFile(&index[indexSize++], &fileEntry);
+	}
+
+	fclose(indexFile);
+
+	// The index must describe this very recording: its entries are in file
+	// order, so check that the last one ends the file, and matches the packet
+	// there. Incomplete or stale indexes are rebuilt by a scan instead.
+	uint64_t fileEnd = U64T(reader->dataOffset);
+
+	if (indexSize > 0) {
+		const struct caer_aedat_index_entry *lastEntry = &index[indexSize - 1];
+		caerEventPacketHeader lastPacket = caerAEDATReaderPacketAt(reader, lastEntry->offset);
+
+		if (lastPacket != NULL && caerEventPacketHeaderGetEventType(lastPacket) == lastEntry->eventType
+			&& caerEventPacketHeaderGetEventSource(lastPacket) == lastEntry->eventSource
+			&& caerEventPacketHeaderGetEventNumber(lastPacket) == lastEntry->eventNumber) {
+			fileEnd = lastEntry->offset + aedatReaderPacketSize(reader, lastEntry->offset);
+		}
+		else {
+			fileEnd = 0;
+		}
+	}
+
+	if (fileEnd != U64T(reader->fileSize)) {
+		caerLog(CAER_LOG_INFO, __func__, "Index of '%s' doesn't match the recording, rebuilding it.",
+			reader->fileName);
+		free(index);
+		return (false);
+	}
+
+	reader->index = index;
+	reader->indexSize = indexSize;
+
+	return (true);
+}
+
+static bool aedatReaderIndexBuild(caerAEDATReader reader) {
+	struct caer_aedat_index_entry *index = NULL;
+	size_t indexSize = 0;
+	size_t indexCapacity = 0;
+
+	struct caer_aedat_reader_iterator iterator;
+	caerAEDATReaderIteratorInit(reader, &iterator, -1, -1);
+
+	uint64_t offset = iterator.offset;
+	caerEventPacketHeader packet;
+
+	while ((packet = caerAEDATReaderIteratorNext(reader, &iterator)) != NULL) {
+		uint64_t packetOffset = offset;
+		offset = iterator.offset;
+
+		// Empty packets have no timestamps to index.
+		if (caerEventPacketHeaderGetEventNumber(packet) == 0) {
+			continue;
+		}
+
+		if (indexSize == indexCapacity) {
+			indexCapacity = (indexCapacity == 0) ? (1024) : (indexCapacity * 2);
+
+			struct caer_aedat_index_entry *newIndex = realloc(index, indexCapacity * sizeof(*index));
+			if (newIndex == NULL) {
+				free(index);
+
+				caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for index of '%s'.",
+					reader->fileName);
+				return (false);
+			}
+
+			index = newIndex;
+		}
+
+		aedatIndexEntryFromPacket(&index[indexSize++], packet, packetOffset);
+	}
+
+	if (iterator.offset != offset) {
+		// Iteration stopped early, on a corrupted packet.
+		free(index);
+
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to index '%s', recording is corrupted.", reader->fileName);
+		return (false);
+	}
+
+	reader->index = index;
+	reader->indexSize = indexSize;
+
+	return (true);
+}
+
+static int aedatReaderIndexCompare(const void *a, const void *b) {
+	const struct caer_aedat_index_entry *entryA = a;
+	const struct caer_aedat_index_entry *entryB = b;
+
+	if (entryA->eventType != entryB->eventType) {
+		return ((entryA->eventType < entryB->eventType) ? (-1) : (1));
+	}
+
+	if (entryA->eventSource != entryB->eventSource) {
+		return ((entryA->eventSource < entryB->eventSource) ? (-1) : (1));
+	}
+
+	if (entryA->offset != entryB->offset) {
+		return ((entryA->offset < entryB->offset) ? (-1) : (1));
+	}
+
+	return (0);
+}
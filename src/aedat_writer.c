@@ -0,0 +1,552 @@
+#include "aedat_index.h"
+#include "aedat_format.h"
+#include "event_codec.h"
+#include "ringbuffer/ringbuffer.h"
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#ifdef HAVE_PTHREADS
+	#include "c11threads_posix.h"
+#endif
+
+#if defined(IOV_MAX) && IOV_MAX < 1024
+	#define AEDAT_WRITER_IOV_MAX IOV_MAX
+#else
+	#define AEDAT_WRITER_IOV_MAX 1024
+#endif
+
+// Write out a batch once it reaches this size, so that the file system
+// gets few, large writes, even if containers keep coming in.
+#define AEDAT_WRITER_BATCH_BYTES (8 * 1024 * 1024)
+#define AEDAT_WRITER_BATCH_CONTAINERS 1024
+
+#define AEDAT_WRITER_PARK_TIMEOUT 10000 // in µs.
+
+#define AEDAT_WRITER_THREAD_NAME "AEDAT Writer"
+
+struct caer_aedat_writer {
+	int fileDescriptor;
+	int indexFileDescriptor; // -1 if no index is written.
+	RingBuffer queue;
+	// Writer Thread
+	thrd_t writerThread;
+	atomic_bool running;
+	atomic_bool failed;
+	// Parking of the idle writer thread, woken up by caerAEDATWriterWrite().
+	mtx_t waitLock;
+	cnd_t waitCond;
+	atomic_bool waitParked;
+	// Current batch, only accessed by the writer thread. The containers
+	// are kept until their memory, pointed to by 'iov', has been written.
+	struct iovec iov[AEDAT_WRITER_IOV_MAX];
+	int iovCount;
+	size_t batchBytes;
+	caerEventPacketContainer batchContainers[AEDAT_WRITER_BATCH_CONTAINERS];
+	size_t batchContainersCount;
+	// Index entries for the packets in 'iov', and file offset of the next packet.
+	struct aedat_index_file_entry indexEntries[AEDAT_WRITER_IOV_MAX];
+	uint64_t fileOffset;
+	// Compression: the 'iov' then point into this buffer, holding the
+	// encoded packets of the current batch.
+	bool compress;
+	uint8_t *codecBuffer;
+	size_t codecBufferSize;
+	size_t codecBufferUsed;
+	// Statistics, all updated with relaxed atomics.
+	atomic_uint_fast64_t containersQueued;
+	atomic_uint_fast64_t containersRejected;
+	atomic_uint_fast64_t containersWritten;
+	atomic_uint_fast64_t packetsWritten;
+	atomic_uint_fast64_t bytesWritten;
+	atomic_uint_fast64_t writeCalls;
+};
+
+static bool aedatWriteAll(int fileDescriptor, const void *data, size_t dataLength);
+static bool aedatWriteHeader(caerAEDATWriter writer, int16_t sourceID, const char *sourceDescription);
+static void aedatWriterIndexOpen(caerAEDATWriter writer, const char *fileName);
+static void aedatWriterIndexClose(caerAEDATWriter writer);
+static void aedatWriterAdd(caerAEDATWriter writer, caerEventPacketContainer container);
+static void aedatWriterFlush(caerAEDATWriter writer);
+static uint8_t *aedatWriterEncode(caerAEDATWriter writer, caerEventPacketHeader packet, size_t *encodedSize);
+static void aedatWriterPark(caerAEDATWriter writer);
+static void aedatWriterWakeUp(caerAEDATWriter writer);
+static int aedatWriterThread(void *inPtr);
+
+caerAEDATWriter caerAEDATWriterOpen(const char *fileName, int16_t sourceID, const char *sourceDescription,
+	uint32_t queueSize, uint32_t flags) {
+	if (fileName == NULL) {
+		return (NULL);
+	}
+
+	caerAEDATWriter writer = calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for AEDAT writer.");
+		return (NULL);
+	}
+
+	writer->compress = (flags & CAER_AEDAT_WRITER_COMPRESS);
+
+	writer->queue = ringBufferInit(queueSize);
+	if (writer->queue == NULL) {
+		free(writer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__,
+			"Failed to allocate AEDAT writer queue of size %" PRIu32 " (must be a power of two).", queueSize);
+		return (NULL);
+	}
+
+	if (mtx_init(&writer->waitLock, mtx_plain) != thrd_success) {
+		ringBufferFree(writer->queue);
+		free(writer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize AEDAT writer lock.");
+		return (NULL);
+	}
+
+	if (cnd_init(&writer->waitCond) != thrd_success) {
+		mtx_destroy(&writer->waitLock);
+		ringBufferFree(writer->queue);
+		free(writer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize AEDAT writer condition.");
+		return (NULL);
+	}
+
+	writer->fileDescriptor = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (writer->fileDescriptor < 0) {
+		cnd_destroy(&writer->waitCond);
+		mtx_destroy(&writer->waitLock);
+		ringBufferFree(writer->queue);
+		free(writer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to create file '%s'. Error: %d.", fileName, errno);
+		return (NULL);
+	}
+
+	if (!aedatWriteHeader(writer, sourceID, sourceDescription)) {
+		close(writer->fileDescriptor);
+		cnd_destroy(&writer->waitCond);
+		mtx_destroy(&writer->waitLock);
+		ringBufferFree(writer->queue);
+		free(writer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to write header to file '%s'. Error: %d.", fileName, errno);
+		return (NULL);
+	}
+
+	// The index serves the in-place reader, which only reads raw recordings.
+	if (writer->compress) {
+		writer->indexFileDescriptor = -1;
+	}
+	else {
+		aedatWriterIndexOpen(writer, fileName);
+	}
+
+	atomic_store(&writer->running, true);
+
+	if ((errno = thrd_create(&writer->writerThread, &aedatWriterThread, writer)) != thrd_success) {
+		aedatWriterIndexClose(writer);
+		close(writer->fileDescriptor);
+		cnd_destroy(&writer->waitCond);
+		mtx_destroy(&writer->waitLock);
+		ringBufferFree(writer->queue);
+		free(writer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to start AEDAT writer thread. Error: %d.", errno);
+		return (NULL);
+	}
+
+	return (writer);
+}
+
+bool caerAEDATWriterWrite(caerAEDATWriter writer, caerEventPacketContainer container) {
+	if (writer == NULL || container == NULL) {
+		return (false);
+	}
+
+	if (atomic_load_explicit(&writer->failed, memory_order_relaxed)) {
+		return (false);
+	}
+
+	if (!ringBufferPut(writer->queue, container)) {
+		// Queue full: the writer is behind, let the caller decide what to do.
+		atomic_fetch_add_explicit(&writer->containersRejected, 1, memory_order_relaxed);
+		return (false);
+	}
+
+	atomic_fetch_add_explicit(&writer->containersQueued, 1, memory_order_relaxed);
+
+	aedatWriterWakeUp(writer);
+
+	return (true);
+}
+
+bool caerAEDATWriterStatsGet(caerAEDATWriter writer, struct caer_aedat_writer_stats *stats) {
+	if (writer == NULL || stats == NULL) {
+		return (false);
+	}
+
+	stats->containersQueued = atomic_load_explicit(&writer->containersQueued, memory_order_relaxed);
+	stats->containersRejected = atomic_load_explicit(&writer->containersRejected, memory_order_relaxed);
+	stats->containersWritten = atomic_load_explicit(&writer->containersWritten, memory_order_relaxed);
+	stats->packetsWritten = atomic_load_explicit(&writer->packetsWritten, memory_order_relaxed);
+	stats->bytesWritten = atomic_load_explicit(&writer->bytesWritten, memory_order_relaxed);
+	stats->writeCalls = atomic_load_explicit(&writer->writeCalls, memory_order_relaxed);
+
+	return (true);
+}
+
+bool caerAEDATWriterClose(caerAEDATWriter writer) {
+	if (writer == NULL) {
+		return (false);
+	}
+
+	// The writer thread drains the queue before exiting.
+	atomic_store(&writer->running, false);
+
+	aedatWriterWakeUp(writer);
+
+	if ((errno = thrd_join(writer->writerThread, NULL)) != thrd_success) {
+		// This should never happen!
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to join AEDAT writer thread. Error: %d.", errno);
+		return (false);
+	}
+
+	bool success = !atomic_load(&writer->failed);
+
+	aedatWriterIndexClose(writer);
+
+	if (close(writer->fileDescriptor) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to close AEDAT file. Error: %d.", errno);
+		success = false;
+	}
+
+	cnd_destroy(&writer->waitCond);
+	mtx_destroy(&writer->waitLock);
+	ringBufferFree(writer->queue);
+	free(writer->codecBuffer);
+	free(writer);
+
+	return (success);
+}
+
+static bool aedatWriteHeader(caerAEDATWriter writer, int16_t sourceID, const char *sourceDescription) {
+	char header[AEDAT_HEADER_MAX];
+	size_t headerLength = aedatHeaderBuild(header, (writer->compress) ? (AEDAT_FORMAT_EVENT_CODEC) : (AEDAT_FORMAT_RAW),
+		sourceID, sourceDescription, NULL);
+
+	if (!aedatWriteAll(writer->fileDescriptor, header, headerLength)) {
+		return (false);
+	}
+
+	writer->fileOffset = headerLength;
+
+	atomic_fetch_add_explicit(&writer->bytesWritten, headerLength, memory_order_relaxed);
+	atomic_fetch_add_explicit(&writer->writeCalls, 1, memory_order_relaxed);
+
+	return (true);
+}
+
+static bool aedatWriteAll(int fileDescriptor, const void *data, size_t dataLength) {
+	size_t written = 0;
+
+	while (written < dataLength) {
+		ssize_t result = write(fileDescriptor, ((const uint8_t *) data) + written, dataLength - written);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return (false);
+		}
+
+		written += (size_t) result;
+	}
+
+	return (true);
+}
+
+static void aedatWriterIndexOpen(caerAEDATWriter writer, const char *fileName) {
+	writer->indexFileDescriptor = -1;
+
+	size_t indexFileNameLength = strlen(fileName) + strlen(AEDAT_INDEX_SUFFIX) + 1;
+	char *indexFileName = malloc(indexFileNameLength);
+	if (indexFileName == NULL) {
+		caerLog(CAER_LOG_WARNING, __func__, "Failed to allocate memory for index file name, no index written.");
+		return;
+	}
+
+	snprintf(indexFileName, indexFileNameLength, "%s%s", fileName, AEDAT_INDEX_SUFFIX);
+
+	int indexFileDescriptor = open(indexFileName, O_WRONLY | O_CREAT | O_TRUNC,
+		S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (indexFileDescriptor < 0) {
+		caerLog(CAER_LOG_WARNING, __func__, "Failed to create index file '%s', no index written. Error: %d.",
+			indexFileName, errno);
+		free(indexFileName);
+		return;
+	}
+
+	uint8_t indexHeader[AEDAT_INDEX_HEADER_SIZE];
+	memcpy(indexHeader, AEDAT_INDEX_MAGIC, AEDAT_INDEX_MAGIC_LENGTH);
+
+	uint32_t indexVersion = htole32(AEDAT_INDEX_VERSION);
+	memcpy(indexHeader + AEDAT_INDEX_MAGIC_LENGTH, &indexVersion, sizeof(indexVersion));
+
+	if (!aedatWriteAll(indexFileDescriptor, indexHeader, AEDAT_INDEX_HEADER_SIZE)) {
+		caerLog(CAER_LOG_WARNING, __func__, "Failed to write index file '%s', no index written. Error: %d.",
+			indexFileName, errno);
+		close(indexFileDescriptor);
+		free(indexFileName);
+		return;
+	}
+
+	free(indexFileName);
+
+	writer->indexFileDescriptor = indexFileDescriptor;
+}
+
+static void aedatWriterIndexClose(caerAEDATWriter writer) {
+	if (writer->indexFileDescriptor >= 0) {
+		close(writer->indexFileDescriptor);
+		writer->indexFileDescriptor = -1;
+	}
+}
+
+static void aedatWriterAdd(caerAEDATWriter writer, caerEventPacketContainer container) {
+	if (atomic_load_explicit(&writer->failed, memory_order_relaxed)) {
+		// Nothing can be written anymore, just drain the queue.
+		caerEventPacketContainerFree(container);
+		return;
+	}
+
+	for (int32_t i = 0; i < caerEventPacketContainerGetEventPacketsNumber(container); i++) {
+		caerEventPacketHeader packet = caerEventPacketContainerGetEventPacket(container, i);
+		if (packet == NULL) {
+			continue;
+		}
+
+		int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+		if (eventNumber == 0) {
+			continue;
+		}
+
+		// Readers reject packets whose timestamp isn't within the event, so don't write (or index) them.
+		int32_t eventTSOffset = caerEventPacketHeaderGetEventTSOffset(packet);
+		if (eventTSOffset < 0 || eventTSOffset > caerEventPacketHeaderGetEventSize(packet) - I32T(sizeof(int32_t))) {
+			caerLog(CAER_LOG_ERROR, __func__, "Skipping event packet with invalid timestamp offset %" PRIi32 ".",
+				eventTSOffset);
+			continue;
+		}
+
+		if (writer->iovCount == AEDAT_WRITER_IOV_MAX) {
+			aedatWriterFlush(writer);
+		}
+
+		// On disk, the capacity is always equal to the number of events.
+		caerEventPacketHeaderSetEventCapacity(packet, eventNumber);
+
+		size_t packetBytes = CAER_EVENT_PACKET_HEADER_SIZE
+			+ ((size_t) eventNumber * (size_t) caerEventPacketHeaderGetEventSize(packet));
+
+		if (writer->compress) {
+			uint8_t *encodedPacket = aedatWriterEncode(writer, packet, &packetBytes);
+			if (encodedPacket == NULL) {
+				// Out of memory, already logged. Nothing can be written anymore.
+				atomic_store(&writer->failed, true);
+				break;
+			}
+
+			writer->iov[writer->iovCount].iov_base = encodedPacket;
+		}
+		else {
+			writer->iov[writer->iovCount].iov_base = packet;
+		}
+
+		writer->iov[writer->iovCount].iov_len = packetBytes;
+
+		if (writer->indexFileDescriptor >= 0) {
+			struct caer_aedat_index_entry indexEntry;
+			aedatIndexEntryFromPacket(&indexEntry, packet, writer->fileOffset);
+			aedatIndexEntryToFile(&writer->indexEntries[writer->iovCount], &indexEntry);
+		}
+
+		writer->iovCount++;
+
+		writer->batchBytes += packetBytes;
+		writer->fileOffset += packetBytes;
+	}
+
+	// Keep the container alive until all its packets are written.
+	writer->batchContainers[writer->batchContainersCount++] = container;
+
+	if (writer->batchContainersCount == AEDAT_WRITER_BATCH_CONTAINERS
+		|| writer->batchBytes >= AEDAT_WRITER_BATCH_BYTES) {
+		aedatWriterFlush(writer);
+	}
+}
+
+static void aedatWriterFlush(caerAEDATWriter writer) {
+	struct iovec *iov = writer->iov;
+	int iovCount = writer->iovCount;
+
+	while (iovCount > 0 && !atomic_load_explicit(&writer->failed, memory_order_relaxed)) {
+		ssize_t written = writev(writer->fileDescriptor, iov, iovCount);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			caerLog(CAER_LOG_ERROR, AEDAT_WRITER_THREAD_NAME, "Failed to write to AEDAT file. Error: %d.", errno);
+			atomic_store(&writer->failed, true);
+			break;
+		}
+
+		atomic_fetch_add_explicit(&writer->writeCalls, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&writer->bytesWritten, U64T(written), memory_order_relaxed);
+
+		// Skip what's done, and continue a partial write where it stopped.
+		size_t remaining = (size_t) written;
+
+		while (iovCount > 0 && remaining >= iov->iov_len) {
+			remaining -= iov->iov_len;
+			iov++;
+			iovCount--;
+		}
+
+		if (iovCount > 0) {
+			iov->iov_base = ((uint8_t *) iov->iov_base) + remaining;
+			iov->iov_len -= remaining;
+		}
+	}
+
+	if (!atomic_load_explicit(&writer->failed, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&writer->packetsWritten, U64T(writer->iovCount), memory_order_relaxed);
+
+		// Index entries only after their packets are in the file. A stale
+		// or incomplete index is detected and ignored by the reader.
+		if (writer->indexFileDescriptor >= 0
+			&& !aedatWriteAll(writer->indexFileDescriptor, writer->indexEntries,
+				(size_t) writer->iovCount * AEDAT_INDEX_ENTRY_SIZE)) {
+			caerLog(CAER_LOG_WARNING, AEDAT_WRITER_THREAD_NAME,
+				"Failed to write to index file, stopping index. Error: %d.", errno);
+			aedatWriterIndexClose(writer);
+		}
+	}
+
+	// A container whose packets didn't all fit into the I/O vector is only
+	// added to the batch after its last packet, so it's never freed early.
+	for (size_t i = 0; i < writer->batchContainersCount; i++) {
+		caerEventPacketContainerFree(writer->batchContainers[i]);
+	}
+
+	if (!atomic_load_explicit(&writer->failed, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&writer->containersWritten, writer->batchContainersCount, memory_order_relaxed);
+	}
+
+	writer->iovCount = 0;
+	writer->batchBytes = 0;
+	writer->batchContainersCount = 0;
+	writer->codecBufferUsed = 0;
+}
+
+static uint8_t *aedatWriterEncode(caerAEDATWriter writer, caerEventPacketHeader packet, size_t *encodedSize) {
+	size_t bound = caerEventCodecEncodeBound(packet);
+
+	if (bound > (writer->codecBufferSize - writer->codecBufferUsed)) {
+		// The batch's I/O vector points into the buffer: write it out
+		// before the buffer can be reused or moved.
+		aedatWriterFlush(writer);
+
+		if (bound > writer->codecBufferSize) {
+			size_t newSize = (bound > AEDAT_WRITER_BATCH_BYTES) ? (bound) : (AEDAT_WRITER_BATCH_BYTES);
+
+			uint8_t *newBuffer = realloc(writer->codecBuffer, newSize);
+			if (newBuffer == NULL) {
+				caerLog(CAER_LOG_CRITICAL, AEDAT_WRITER_THREAD_NAME,
+					"Failed to allocate memory for compression buffer of %zu bytes.", newSize);
+				return (NULL);
+			}
+
+			writer->codecBuffer = newBuffer;
+			writer->codecBufferSize = newSize;
+		}
+	}
+
+	uint8_t *encodedPacket = writer->codecBuffer + writer->codecBufferUsed;
+
+	*encodedSize = caerEventCodecEncode(packet, encodedPacket, bound);
+	writer->codecBufferUsed += *encodedSize;
+
+	return (encodedPacket);
+}
+
+static void aedatWriterPark(caerAEDATWriter writer) {
+	// cnd_timedwait() takes an absolute TIME_UTC time point.
+	struct timespec timePoint;
+	clock_gettime(CLOCK_REALTIME, &timePoint);
+
+	timePoint.tv_nsec += AEDAT_WRITER_PARK_TIMEOUT * 1000;
+
+	if (timePoint.tv_nsec >= 1000000000) {
+		timePoint.tv_sec++;
+		timePoint.tv_nsec -= 1000000000;
+	}
+
+	mtx_lock(&writer->waitLock);
+
+	// Same protocol as the data exchange: announce, fence, re-check, wait.
+	atomic_store_explicit(&writer->waitParked, true, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (ringBufferLook(writer->queue) == NULL && atomic_load_explicit(&writer->running, memory_order_relaxed)) {
+		cnd_timedwait(&writer->waitCond, &writer->waitLock, &timePoint);
+	}
+
+	atomic_store_explicit(&writer->waitParked, false, memory_order_relaxed);
+
+	mtx_unlock(&writer->waitLock);
+}
+
+static void aedatWriterWakeUp(caerAEDATWriter writer) {
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load_explicit(&writer->waitParked, memory_order_relaxed)) {
+		mtx_lock(&writer->waitLock);
+		cnd_signal(&writer->waitCond);
+		mtx_unlock(&writer->waitLock);
+	}
+}
+
+static int aedatWriterThread(void *inPtr) {
+	caerAEDATWriter writer = inPtr;
+
+	thrd_set_name(AEDAT_WRITER_THREAD_NAME);
+
+	while (true) {
+		caerEventPacketContainer container = ringBufferGet(writer->queue);
+
+		if (container == NULL) {
+			// Nothing more queued right now: write out the current batch.
+			aedatWriterFlush(writer);
+
+			if (atomic_load_explicit(&writer->running, memory_order_relaxed)) {
+				aedatWriterPark(writer);
+				continue;
+			}
+
+			// Shutdown requested, the producer is done: one last look.
+			container = ringBufferGet(writer->queue);
+			if (container == NULL) {
+				break;
+			}
+		}
+
+		aedatWriterAdd(writer, container);
+	}
+
+	return (EXIT_SUCCESS);
+}
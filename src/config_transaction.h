@@ -0,0 +1,20 @@
+#ifndef LIBCAER_SRC_CONFIG_TRANSACTION_H_
+#define LIBCAER_SRC_CONFIG_TRANSACTION_H_
+
+#include "devices/usb.h"
+
+// One staged configuration change, see caerDeviceConfigTransactionAdd().
+struct caer_device_config_update {
+	int8_t modAddr;
+	uint8_t paramAddr;
+	uint32_t param;
+};
+
+// Changes are kept in the order they were added, and applied in that order.
+struct caer_device_config_transaction {
+	size_t updatesNumber;
+	size_t updatesCapacity;
+	struct caer_device_config_update *updates;
+};
+
+#endif /* LIBCAER_SRC_CONFIG_TRANSACTION_H_ */
@@ -0,0 +1,911 @@
+#include "data_exchange.h"
+#include "events/special.h"
+#include "probes.h"
+
+static size_t dataExchangeContainerMemory(caerEventPacketContainer container);
+static bool dataExchangeSpillAppend(dataExchange exchange, caerEventPacketContainer container, bool ignoreLimit);
+static void dataExchangePutDone(dataExchange exchange);
+static uint64_t dataExchangeOccupancy(dataExchange exchange);
+static void dataExchangeEvict(dataExchange exchange, caerEventPacketContainer evicted);
+static void dataExchangeProducerMigrate(dataExchange exchange);
+static bool dataExchangeConsumerMigrate(dataExchange exchange);
+static void dataExchangeWait(dataExchange exchange, uint64_t *waitIteration);
+static void dataExchangePark(dataExchange exchange);
+static void dataExchangeWakeUp(dataExchange exchange);
+
+// Container timing, taken before it's handed over to the consumer.
+struct data_exchange_commit {
+	int64_t transferTimestamp;
+	int64_t commitTimestamp;
+	int64_t deviceTimestamp;
+	bool timestampReset;
+};
+
+static void dataExchangeCommitPrepare(caerEventPacketContainer container, struct data_exchange_commit *commit);
+static void dataExchangeCommitLatency(dataExchange exchange, struct data_exchange_commit *commit);
+
+// The commit time must be set before the put, as right after it the consumer owns the container.
+// Retry loops prepare once and then only repeat dataExchangeRingPutPrepared().
+static inline bool dataExchangeRingPutPrepared(dataExchange exchange, caerEventPacketContainer container,
+	struct data_exchange_commit *commit) {
+	if (!ringBufferPut(exchange->producerBuffer, container)) {
+		return (false);
+	}
+
+	dataExchangeCommitLatency(exchange, commit);
+	return (true);
+}
+
+static inline bool dataExchangeRingPut(dataExchange exchange, caerEventPacketContainer container) {
+	struct data_exchange_commit commit;
+	dataExchangeCommitPrepare(container, &commit);
+
+	return (dataExchangeRingPutPrepared(exchange, container, &commit));
+}
+
+static inline bool dataExchangeRingPutEvict(dataExchange exchange, caerEventPacketContainer container,
+	void **evicted) {
+	struct data_exchange_commit commit;
+	dataExchangeCommitPrepare(container, &commit);
+
+	if (!ringBufferPutEvict(exchange->producerBuffer, container, evicted)) {
+		return (false);
+	}
+
+	dataExchangeCommitLatency(exchange, &commit);
+	return (true);
+}
+
+// Hint to the CPU that we're busy-waiting.
+static inline void cpuRelax(void) {
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#else
+	atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+static inline uint64_t monotonicTimeMicros(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((U64T(now.tv_sec) * 1000000LLU) + U64T(now.tv_nsec / 1000));
+}
+
+void dataExchangeSettingsInit(dataExchange exchange) {
+	atomic_store_explicit(&exchange->bufferSize, 64, memory_order_relaxed);
+	atomic_store_explicit(&exchange->blocking, false, memory_order_relaxed);
+	atomic_store_explicit(&exchange->startProducers, true, memory_order_relaxed);
+	atomic_store_explicit(&exchange->stopProducers, true, memory_order_relaxed);
+	atomic_store_explicit(&exchange->policy, CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_NEWEST, memory_order_relaxed);
+	atomic_store_explicit(&exchange->blockTimeout, 100000, memory_order_relaxed); // 100 ms.
+	atomic_store_explicit(&exchange->spillMaxMemory, 256 * 1024, memory_order_relaxed); // 256 MiB.
+	atomic_store_explicit(&exchange->waitSpinCount, 0, memory_order_relaxed);
+	atomic_store_explicit(&exchange->waitYieldCount, 0, memory_order_relaxed);
+	atomic_store_explicit(&exchange->waitParkTimeout, 1000, memory_order_relaxed); // 1 ms.
+
+	dataExchangeLatencyStatsReset(exchange);
+	exchange->deviceToHostLastTimestamp = -1;
+}
+
+bool dataExchangeConfigSet(dataExchange exchange, uint8_t paramAddr, uint32_t param) {
+	switch (paramAddr) {
+		case CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE:
+			// Must be a power of two.
+			if (param == 0 || (param & (param - 1)) != 0) {
+				return (false);
+			}
+
+			atomic_store(&exchange->bufferSize, param);
+
+			// Notify data acquisition thread to switch to a new ring-buffer,
+			// if running. Else this takes effect on the next DataStart() call.
+			atomic_store(&exchange->bufferResize, true);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING:
+			atomic_store(&exchange->blocking, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS:
+			atomic_store(&exchange->startProducers, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS:
+			atomic_store(&exchange->stopProducers, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_POLICY:
+			if (param > CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_OLDEST) {
+				return (false);
+			}
+
+			atomic_store(&exchange->policy, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCK_TIMEOUT:
+			atomic_store(&exchange->blockTimeout, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_SPILL_MAX_MEMORY:
+			atomic_store(&exchange->spillMaxMemory, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_SPIN_COUNT:
+			atomic_store(&exchange->waitSpinCount, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_YIELD_COUNT:
+			atomic_store(&exchange->waitYieldCount, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_PARK_TIMEOUT:
+			if (param == 0) {
+				return (false);
+			}
+
+			atomic_store(&exchange->waitParkTimeout, param);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_HIGH_WATERMARK:
+			// Any write resets the high-watermark to the current occupancy.
+			atomic_store_explicit(&exchange->highWatermark, dataExchangeOccupancy(exchange), memory_order_relaxed);
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+bool dataExchangeConfigGet(dataExchange exchange, uint8_t paramAddr, uint32_t *param) {
+	switch (paramAddr) {
+		case CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE:
+			*param = U32T(atomic_load(&exchange->bufferSize));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING:
+			*param = atomic_load(&exchange->blocking);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS:
+			*param = atomic_load(&exchange->startProducers);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS:
+			*param = atomic_load(&exchange->stopProducers);
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_POLICY:
+			*param = U32T(atomic_load(&exchange->policy));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCK_TIMEOUT:
+			*param = U32T(atomic_load(&exchange->blockTimeout));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_SPILL_MAX_MEMORY:
+			*param = U32T(atomic_load(&exchange->spillMaxMemory));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_DROPPED_CONTAINERS:
+			*param = U32T(atomic_load_explicit(&exchange->droppedContainers, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_DELAYED_CONTAINERS:
+			*param = U32T(atomic_load_explicit(&exchange->delayedContainers, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_EVICTED_CONTAINERS:
+			*param = U32T(atomic_load_explicit(&exchange->evictedContainers, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_OCCUPANCY:
+			*param = U32T(dataExchangeOccupancy(exchange));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_CAPACITY:
+			*param = U32T(atomic_load_explicit(&exchange->capacity, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_HIGH_WATERMARK:
+			*param = U32T(atomic_load_explicit(&exchange->highWatermark, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_PUT_CONTAINERS:
+			*param = U32T(atomic_load_explicit(&exchange->putContainers, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_GET_CONTAINERS:
+			*param = U32T(atomic_load_explicit(&exchange->getContainers, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_SPIN_COUNT:
+			*param = U32T(atomic_load(&exchange->waitSpinCount));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_YIELD_COUNT:
+			*param = U32T(atomic_load(&exchange->waitYieldCount));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_PARK_TIMEOUT:
+			*param = U32T(atomic_load(&exchange->waitParkTimeout));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_SPIN_PHASES:
+			*param = U32T(atomic_load_explicit(&exchange->waitSpinPhases, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_YIELD_PHASES:
+			*param = U32T(atomic_load_explicit(&exchange->waitYieldPhases, memory_order_relaxed));
+			break;
+
+		case CAER_HOST_CONFIG_DATAEXCHANGE_WAIT_PARK_PHASES:
+			*param = U32T(atomic_load_explicit(&exchange->waitParkPhases, memory_order_relaxed));
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+bool dataExchangeLatencyStatsGet(dataExchange exchange, uint8_t stage, struct caer_latency_stats *stats) {
+	switch (stage) {
+		case CAER_DEVICE_LATENCY_TRANSFER_TO_COMMIT:
+			latencyHistogramStats(&exchange->latencyTransferToCommit, stats);
+			break;
+
+		case CAER_DEVICE_LATENCY_COMMIT_TO_GET:
+			latencyHistogramStats(&exchange->latencyCommitToGet, stats);
+			break;
+
+		case CAER_DEVICE_LATENCY_DEVICE_TO_HOST:
+			latencyHistogramStats(&exchange->latencyDeviceToHost, stats);
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+void dataExchangeLatencyStatsReset(dataExchange exchange) {
+	latencyHistogramReset(&exchange->latencyTransferToCommit);
+	latencyHistogramReset(&exchange->latencyCommitToGet);
+	latencyHistogramReset(&exchange->latencyDeviceToHost);
+
+	// The producer will pick up a new baseline with the next container.
+	atomic_store_explicit(&exchange->deviceToHostBaseline, INT64_MAX, memory_order_relaxed);
+}
+
+bool dataExchangeBufferInit(dataExchange exchange) {
+	// Any pending resize is taken care of right here.
+	atomic_store(&exchange->bufferResize, false);
+
+	exchange->buffer = ringBufferInit(atomic_load(&exchange->bufferSize));
+	if (exchange->buffer == NULL) {
+		return (false);
+	}
+
+	if (mtx_init(&exchange->waitLock, mtx_plain) != thrd_success) {
+		ringBufferFree(exchange->buffer);
+		exchange->buffer = NULL;
+		return (false);
+	}
+
+	if (cnd_init(&exchange->waitCond) != thrd_success) {
+		mtx_destroy(&exchange->waitLock);
+		ringBufferFree(exchange->buffer);
+		exchange->buffer = NULL;
+		return (false);
+	}
+
+	atomic_store(&exchange->waitParked, false);
+
+	exchange->producerBuffer = exchange->buffer;
+	atomic_store(&exchange->migrationBuffer, (uintptr_t) NULL);
+
+	exchange->spillHead = NULL;
+	exchange->spillTail = NULL;
+	exchange->spillMemory = 0;
+
+	atomic_store_explicit(&exchange->capacity, ringBufferSize(exchange->buffer), memory_order_relaxed);
+
+	return (true);
+}
+
+void dataExchangeBufferEmpty(dataExchange exchange) {
+	if (exchange->buffer == NULL) {
+		return;
+	}
+
+	// Drain the current ring-buffer, and the new one too if a resize was in progress.
+	do {
+		caerEventPacketContainer container;
+		while ((container = ringBufferGet(exchange->buffer)) != NULL) {
+			atomic_fetch_add_explicit(&exchange->getContainers, 1, memory_order_relaxed);
+
+			// Notify data-not-available call-back.
+			if (exchange->notifyDecrease != NULL) {
+				exchange->notifyDecrease(exchange->notifyUserPtr);
+			}
+
+			// Free container, which will free its subordinate packets too.
+			caerEventPacketContainerFree(container);
+		}
+	}
+	while (dataExchangeConsumerMigrate(exchange));
+
+	// Spilled containers were never announced, so no notification needed.
+	while (exchange->spillHead != NULL) {
+		struct data_exchange_spill *spill = exchange->spillHead;
+		exchange->spillHead = spill->next;
+
+		caerEventPacketContainerFree(spill->container);
+		free(spill);
+	}
+
+	exchange->spillTail = NULL;
+	exchange->spillMemory = 0;
+}
+
+void dataExchangeBufferFree(dataExchange exchange) {
+	atomic_store_explicit(&exchange->capacity, 0, memory_order_relaxed);
+
+	RingBuffer migrationBuffer = (RingBuffer) atomic_exchange(&exchange->migrationBuffer, (uintptr_t) NULL);
+	if (migrationBuffer != NULL) {
+		ringBufferFree(migrationBuffer);
+	}
+
+	if (exchange->buffer != NULL) {
+		ringBufferFree(exchange->buffer);
+		exchange->buffer = NULL;
+
+		cnd_destroy(&exchange->waitCond);
+		mtx_destroy(&exchange->waitLock);
+	}
+
+	exchange->producerBuffer = NULL;
+}
+
+bool dataExchangePut(dataExchange exchange, caerEventPacketContainer container, atomic_bool *running) {
+	dataExchangeProducerMigrate(exchange);
+
+	// Previously spilled containers must go first, to keep ordering.
+	if (exchange->spillHead != NULL) {
+		dataExchangeSpillFlush(exchange);
+	}
+
+	if (exchange->spillHead == NULL && dataExchangeRingPut(exchange, container)) {
+		dataExchangePutDone(exchange);
+		return (true);
+	}
+
+	uint_fast32_t policy = atomic_load_explicit(&exchange->policy, memory_order_relaxed);
+
+	// If anything is still spilled (policy changed at run-time), we have
+	// to continue spilling until that clears up, to not reorder data.
+	if (policy == CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_SPILL || exchange->spillHead != NULL) {
+		if (!dataExchangeSpillAppend(exchange, container, false)) {
+			atomic_fetch_add_explicit(&exchange->droppedContainers, 1, memory_order_relaxed);
+			return (false);
+		}
+
+		atomic_fetch_add_explicit(&exchange->delayedContainers, 1, memory_order_relaxed);
+		return (true);
+	}
+
+	if (policy == CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_OLDEST) {
+		void *evicted = NULL;
+
+		if (dataExchangeRingPutEvict(exchange, container, &evicted)) {
+			if (evicted != NULL) {
+				dataExchangeEvict(exchange, evicted);
+			}
+
+			dataExchangePutDone(exchange);
+			return (true);
+		}
+	}
+
+	if (policy == CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_BLOCK_PRODUCER) {
+		// Wait for the consumer to make space, up to the configured timeout.
+		// This stalls USB handling, which pushes back on the device's own buffers.
+		uint64_t timeout = U64T(atomic_load_explicit(&exchange->blockTimeout, memory_order_relaxed));
+		uint64_t startTime = monotonicTimeMicros();
+		struct timespec fullSleep = { .tv_sec = 0, .tv_nsec = 10000 };
+
+		// The commit time stays the one of the first attempt, the wait for space
+		// then counts towards the time spent in the ring-buffer.
+		struct data_exchange_commit commit;
+		dataExchangeCommitPrepare(container, &commit);
+
+		do {
+			// Prevent dead-lock if shutdown is requested and nothing is consuming anymore.
+			if (!atomic_load_explicit(running, memory_order_relaxed)) {
+				break;
+			}
+
+			thrd_sleep(&fullSleep, NULL);
+
+			if (dataExchangeRingPutPrepared(exchange, container, &commit)) {
+				atomic_fetch_add_explicit(&exchange->delayedContainers, 1, memory_order_relaxed);
+
+				dataExchangePutDone(exchange);
+				return (true);
+			}
+		}
+		while ((monotonicTimeMicros() - startTime) < timeout);
+	}
+
+	// CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_NEWEST, or timeout: caller drops it.
+	atomic_fetch_add_explicit(&exchange->droppedContainers, 1, memory_order_relaxed);
+	return (false);
+}
+
+bool dataExchangePutForced(dataExchange exchange, caerEventPacketContainer container, atomic_bool *running) {
+	dataExchangeProducerMigrate(exchange);
+
+	// Previously spilled containers must go first, to keep ordering.
+	if (exchange->spillHead != NULL) {
+		dataExchangeSpillFlush(exchange);
+
+		// Still not empty, just queue up behind them, ignoring the memory limit.
+		if (exchange->spillHead != NULL) {
+			if (dataExchangeSpillAppend(exchange, container, true)) {
+				atomic_fetch_add_explicit(&exchange->delayedContainers, 1, memory_order_relaxed);
+				return (true);
+			}
+
+			return (false);
+		}
+	}
+
+	// With the drop-oldest policy, we can always make space right away.
+	if (atomic_load_explicit(&exchange->policy, memory_order_relaxed) == CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_DROP_OLDEST) {
+		void *evicted = NULL;
+
+		if (dataExchangeRingPutEvict(exchange, container, &evicted)) {
+			if (evicted != NULL) {
+				dataExchangeEvict(exchange, evicted);
+			}
+
+			dataExchangePutDone(exchange);
+			return (true);
+		}
+	}
+
+	struct data_exchange_commit commit;
+	dataExchangeCommitPrepare(container, &commit);
+
+	while (!dataExchangeRingPutPrepared(exchange, container, &commit)) {
+		// Prevent dead-lock if shutdown is requested and nothing is consuming
+		// data anymore, but the ring-buffer is full (and would thus never empty),
+		// thus blocking the USB handling thread in this loop.
+		if (!atomic_load_explicit(running, memory_order_relaxed)) {
+			return (false);
+		}
+	}
+
+	dataExchangePutDone(exchange);
+	return (true);
+}
+
+void dataExchangeSpillFlush(dataExchange exchange) {
+	dataExchangeProducerMigrate(exchange);
+
+	while (exchange->spillHead != NULL) {
+		struct data_exchange_spill *spill = exchange->spillHead;
+
+		if (!dataExchangeRingPut(exchange, spill->container)) {
+			// Still full, retry later.
+			return;
+		}
+
+		dataExchangePutDone(exchange);
+
+		exchange->spillHead = spill->next;
+		if (exchange->spillHead == NULL) {
+			exchange->spillTail = NULL;
+		}
+
+		exchange->spillMemory -= spill->memory;
+		free(spill);
+	}
+}
+
+caerEventPacketContainer dataExchangeGet(dataExchange exchange) {
+	caerEventPacketContainer container = NULL;
+	uint64_t waitIteration = 0;
+
+	retry: container = ringBufferGet(exchange->buffer);
+
+	if (container == NULL && dataExchangeConsumerMigrate(exchange)) {
+		goto retry;
+	}
+
+	if (container != NULL) {
+		atomic_fetch_add_explicit(&exchange->getContainers, 1, memory_order_relaxed);
+
+		int64_t getTimestamp = dataExchangeHostTime();
+		caerEventPacketContainerSetHostGetTimestamp(container, getTimestamp);
+
+		CAER_PROBE3(ring_get, (void *) exchange, (size_t) 1, getTimestamp);
+
+		int64_t commitTimestamp = caerEventPacketContainerGetHostCommitTimestamp(container);
+		if (commitTimestamp != -1 && getTimestamp >= commitTimestamp) {
+			latencyHistogramRecord(&exchange->latencyCommitToGet, U64T(getTimestamp - commitTimestamp));
+		}
+
+		// Found an event container, return it and signal this piece of data
+		// is no longer available for later acquisition.
+		if (exchange->notifyDecrease != NULL) {
+			exchange->notifyDecrease(exchange->notifyUserPtr);
+		}
+
+		return (container);
+	}
+
+	// Didn't find any event container, either report this or retry, depending
+	// on blocking setting.
+	if (atomic_load_explicit(&exchange->blocking, memory_order_relaxed)) {
+		// Don't retry right away in a tight loop, back off and wait a little.
+		dataExchangeWait(exchange, &waitIteration);
+		goto retry;
+	}
+
+	// Nothing.
+	return (NULL);
+}
+
+size_t dataExchangeGetMany(dataExchange exchange, caerEventPacketContainer *containers, size_t maxContainers) {
+	size_t count = 0;
+	uint64_t waitIteration = 0;
+
+	retry: count = ringBufferGetMany(exchange->buffer, (void **) containers, maxContainers);
+
+	if (count == 0 && dataExchangeConsumerMigrate(exchange)) {
+		goto retry;
+	}
+
+	if (count != 0) {
+		atomic_fetch_add_explicit(&exchange->getContainers, count, memory_order_relaxed);
+
+		int64_t getTimestamp = dataExchangeHostTime();
+
+		CAER_PROBE3(ring_get, (void *) exchange, count, getTimestamp);
+
+		for (size_t i = 0; i < count; i++) {
+			caerEventPacketContainerSetHostGetTimestamp(containers[i], getTimestamp);
+
+			int64_t commitTimestamp = caerEventPacketContainerGetHostCommitTimestamp(containers[i]);
+			if (commitTimestamp != -1 && getTimestamp >= commitTimestamp) {
+				latencyHistogramRecord(&exchange->latencyCommitToGet, U64T(getTimestamp - commitTimestamp));
+			}
+		}
+
+		// Found event containers, return them and signal these pieces of data
+		// are no longer available for later acquisition, all at once if possible.
+		if (exchange->notifyDecreaseMany != NULL) {
+			exchange->notifyDecreaseMany(exchange->notifyUserPtr, count);
+		}
+		else if (exchange->notifyDecrease != NULL) {
+			for (size_t i = 0; i < count; i++) {
+				exchange->notifyDecrease(exchange->notifyUserPtr);
+			}
+		}
+
+		return (count);
+	}
+
+	// Didn't find any event container, either report this or retry, depending
+	// on blocking setting.
+	if (atomic_load_explicit(&exchange->blocking, memory_order_relaxed)) {
+		// Don't retry right away in a tight loop, back off and wait a little.
+		dataExchangeWait(exchange, &waitIteration);
+		goto retry;
+	}
+
+	// Nothing.
+	return (0);
+}
+
+static size_t dataExchangeContainerMemory(caerEventPacketContainer container) {
+	int32_t packetsNumber = caerEventPacketContainerGetEventPacketsNumber(container);
+
+	size_t memory = sizeof(struct caer_event_packet_container)
+		+ (U64T(packetsNumber) * sizeof(caerEventPacketHeader));
+
+	for (int32_t i = 0; i < packetsNumber; i++) {
+		caerEventPacketHeader packet = caerEventPacketContainerGetEventPacket(container, i);
+		if (packet == NULL) {
+			continue;
+		}
+
+		memory += CAER_EVENT_PACKET_HEADER_SIZE
+			+ (U64T(caerEventPacketHeaderGetEventCapacity(packet)) * U64T(caerEventPacketHeaderGetEventSize(packet)));
+	}
+
+	return (memory);
+}
+
+static bool dataExchangeSpillAppend(dataExchange exchange, caerEventPacketContainer container, bool ignoreLimit) {
+	size_t memory = dataExchangeContainerMemory(container);
+
+	if (!ignoreLimit) {
+		size_t maxMemory = U64T(atomic_load_explicit(&exchange->spillMaxMemory, memory_order_relaxed)) * 1024;
+
+		if ((exchange->spillMemory + memory) > maxMemory) {
+			return (false);
+		}
+	}
+
+	struct data_exchange_spill *spill = malloc(sizeof(*spill));
+	if (spill == NULL) {
+		return (false);
+	}
+
+	spill->container = container;
+	spill->memory = memory;
+	spill->next = NULL;
+
+	if (exchange->spillTail == NULL) {
+		exchange->spillHead = spill;
+	}
+	else {
+		exchange->spillTail->next = spill;
+	}
+
+	exchange->spillTail = spill;
+	exchange->spillMemory += memory;
+
+	return (true);
+}
+
+static void dataExchangePutDone(dataExchange exchange) {
+	// Only the producer updates this counter, no need for an atomic RMW.
+	atomic_store_explicit(&exchange->putContainers,
+		atomic_load_explicit(&exchange->putContainers, memory_order_relaxed) + 1, memory_order_relaxed);
+
+	// Counted here, not when accepted by dataExchangePut(), so containers
+	// waiting in the spill list only count once they really enter the ring.
+	if (exchange->committedContainers != NULL) {
+		atomic_store_explicit(exchange->committedContainers,
+			atomic_load_explicit(exchange->committedContainers, memory_order_relaxed) + 1, memory_order_relaxed);
+	}
+
+	uint64_t occupancy = dataExchangeOccupancy(exchange);
+
+	if (occupancy > atomic_load_explicit(&exchange->highWatermark, memory_order_relaxed)) {
+		atomic_store_explicit(&exchange->highWatermark, occupancy, memory_order_relaxed);
+	}
+
+	dataExchangeWakeUp(exchange);
+
+	if (exchange->notifyIncrease != NULL) {
+		exchange->notifyIncrease(exchange->notifyUserPtr);
+	}
+}
+
+static void dataExchangeEvict(dataExchange exchange, caerEventPacketContainer evicted) {
+	atomic_fetch_add_explicit(&exchange->evictedContainers, 1, memory_order_relaxed);
+
+	// The evicted container was announced as available, so signal it's gone.
+	if (exchange->notifyDecrease != NULL) {
+		exchange->notifyDecrease(exchange->notifyUserPtr);
+	}
+
+	caerEventPacketContainerFree(evicted);
+}
+
+static uint64_t dataExchangeOccupancy(dataExchange exchange) {
+	// Load consumer-side counters first, so the result can't underflow.
+	uint64_t removed = atomic_load_explicit(&exchange->getContainers, memory_order_relaxed)
+		+ atomic_load_explicit(&exchange->evictedContainers, memory_order_relaxed);
+	uint64_t added = atomic_load_explicit(&exchange->putContainers, memory_order_relaxed);
+
+	return ((added > removed) ? (added - removed) : (0));
+}
+
+static void dataExchangeProducerMigrate(dataExchange exchange) {
+	if (!atomic_load_explicit(&exchange->bufferResize, memory_order_relaxed)) {
+		return;
+	}
+
+	// Previous migration still in progress, wait for the consumer to catch up.
+	if (atomic_load_explicit(&exchange->migrationBuffer, memory_order_acquire) != (uintptr_t) NULL) {
+		return;
+	}
+
+	atomic_store_explicit(&exchange->bufferResize, false, memory_order_relaxed);
+
+	size_t newSize = atomic_load_explicit(&exchange->bufferSize, memory_order_relaxed);
+	if (newSize == ringBufferSize(exchange->producerBuffer)) {
+		return;
+	}
+
+	RingBuffer newBuffer = ringBufferInit(newSize);
+	if (newBuffer == NULL) {
+		// Keep using the current one.
+		return;
+	}
+
+	// From now on, only put into the new ring-buffer. The consumer will drain the
+	// old one first, and then switch over, so ordering is preserved.
+	exchange->producerBuffer = newBuffer;
+
+	atomic_store_explicit(&exchange->capacity, ringBufferSize(newBuffer), memory_order_relaxed);
+
+	atomic_store_explicit(&exchange->migrationBuffer, (uintptr_t) newBuffer, memory_order_release);
+}
+
+static bool dataExchangeConsumerMigrate(dataExchange exchange) {
+	RingBuffer newBuffer = (RingBuffer) atomic_load_explicit(&exchange->migrationBuffer, memory_order_acquire);
+	if (newBuffer == NULL) {
+		return (false);
+	}
+
+	// The producer doesn't use the old ring-buffer anymore, but its last puts
+	// there might only be visible now: only switch once it's really empty.
+	if (ringBufferLook(exchange->buffer) == NULL) {
+		ringBufferFree(exchange->buffer);
+		exchange->buffer = newBuffer;
+
+		atomic_store_explicit(&exchange->migrationBuffer, (uintptr_t) NULL, memory_order_release);
+	}
+
+	// Either way, there's something new to look at.
+	return (true);
+}
+
+static void dataExchangeWait(dataExchange exchange, uint64_t *waitIteration) {
+	uint64_t spinCount = U64T(atomic_load_explicit(&exchange->waitSpinCount, memory_order_relaxed));
+	uint64_t yieldCount = U64T(atomic_load_explicit(&exchange->waitYieldCount, memory_order_relaxed));
+	uint64_t iteration = (*waitIteration)++;
+
+	// First phase: busy-wait, lowest latency.
+	if (iteration < spinCount) {
+		if (iteration == 0) {
+			atomic_fetch_add_explicit(&exchange->waitSpinPhases, 1, memory_order_relaxed);
+		}
+
+		cpuRelax();
+		return;
+	}
+
+	// Second phase: let other threads run, but stay ready.
+	if (iteration < (spinCount + yieldCount)) {
+		if (iteration == spinCount) {
+			atomic_fetch_add_explicit(&exchange->waitYieldPhases, 1, memory_order_relaxed);
+		}
+
+		thrd_yield();
+		return;
+	}
+
+	// Last phase: sleep until the producer signals new data.
+	if (iteration == (spinCount + yieldCount)) {
+		atomic_fetch_add_explicit(&exchange->waitParkPhases, 1, memory_order_relaxed);
+	}
+
+	dataExchangePark(exchange);
+}
+
+static void dataExchangePark(dataExchange exchange) {
+	uint64_t timeout = U64T(atomic_load_explicit(&exchange->waitParkTimeout, memory_order_relaxed));
+
+	// cnd_timedwait() takes an absolute TIME_UTC time point.
+	struct timespec timePoint;
+	clock_gettime(CLOCK_REALTIME, &timePoint);
+
+	timePoint.tv_sec += (time_t) (timeout / 1000000);
+	timePoint.tv_nsec += (long) ((timeout % 1000000) * 1000);
+
+	if (timePoint.tv_nsec >= 1000000000) {
+		timePoint.tv_sec++;
+		timePoint.tv_nsec -= 1000000000;
+	}
+
+	mtx_lock(&exchange->waitLock);
+
+	// Announce we're parking, then re-check for data: either we see the producer's
+	// put here, or the producer sees this flag and signals us. Needs the full fence,
+	// pairing with the one in dataExchangeWakeUp(), to not lose a wake-up.
+	atomic_store_explicit(&exchange->waitParked, true, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (ringBufferLook(exchange->buffer) == NULL
+		&& atomic_load_explicit(&exchange->migrationBuffer, memory_order_relaxed) == (uintptr_t) NULL) {
+		cnd_timedwait(&exchange->waitCond, &exchange->waitLock, &timePoint);
+	}
+
+	atomic_store_explicit(&exchange->waitParked, false, memory_order_relaxed);
+
+	mtx_unlock(&exchange->waitLock);
+}
+
+static void dataExchangeWakeUp(dataExchange exchange) {
+	// Only take the lock if the consumer is actually parked, so that the fast
+	// path of the producer is just a fence and a load.
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load_explicit(&exchange->waitParked, memory_order_relaxed)) {
+		mtx_lock(&exchange->waitLock);
+		cnd_signal(&exchange->waitCond);
+		mtx_unlock(&exchange->waitLock);
+	}
+}
+
+static void dataExchangeCommitPrepare(caerEventPacketContainer container, struct data_exchange_commit *commit) {
+	commit->transferTimestamp = caerEventPacketContainerGetHostTransferTimestamp(container);
+	commit->commitTimestamp = dataExchangeHostTime();
+	commit->deviceTimestamp = caerEventPacketContainerGetHighestEventTimestamp(container);
+	commit->timestampReset = false;
+
+	// Timestamp reset notifications come alone in their own container, and carry
+	// a fake timestamp, so they must not be taken into account for the device to
+	// host gap. They also signal that the device time restarts from zero.
+	if (caerEventPacketContainerGetEventsNumber(container) == 1) {
+		caerSpecialEventPacket specialPacket = (caerSpecialEventPacket) caerEventPacketContainerFindEventPacketByType(
+			container, SPECIAL_EVENT);
+
+		if (specialPacket != NULL
+			&& caerSpecialEventGetType(caerSpecialEventPacketGetEvent(specialPacket, 0)) == TIMESTAMP_RESET) {
+			commit->timestampReset = true;
+		}
+	}
+
+	caerEventPacketContainerSetHostCommitTimestamp(container, commit->commitTimestamp);
+}
+
+static void dataExchangeCommitLatency(dataExchange exchange, struct data_exchange_commit *commit) {
+	CAER_PROBE4(ring_put, (void *) exchange, commit->commitTimestamp, commit->transferTimestamp,
+		commit->deviceTimestamp);
+
+	if (commit->transferTimestamp == -1) {
+		return;
+	}
+
+	if (commit->commitTimestamp >= commit->transferTimestamp) {
+		latencyHistogramRecord(&exchange->latencyTransferToCommit,
+			U64T(commit->commitTimestamp - commit->transferTimestamp));
+	}
+
+	// Device time going backwards (reset) invalidates the baseline.
+	if (commit->timestampReset
+		|| (commit->deviceTimestamp != -1 && commit->deviceTimestamp < exchange->deviceToHostLastTimestamp)) {
+		atomic_store_explicit(&exchange->deviceToHostBaseline, INT64_MAX, memory_order_relaxed);
+		exchange->deviceToHostLastTimestamp = -1;
+
+		if (commit->timestampReset) {
+			return;
+		}
+	}
+
+	if (commit->deviceTimestamp == -1) {
+		return;
+	}
+
+	exchange->deviceToHostLastTimestamp = commit->deviceTimestamp;
+
+	// Device timestamps are in µs, host ones in ns.
+	int64_t gap = commit->transferTimestamp - (commit->deviceTimestamp * 1000);
+	int64_t baseline = atomic_load_explicit(&exchange->deviceToHostBaseline, memory_order_relaxed);
+
+	if (gap < baseline) {
+		// New best case, everything else is relative to this.
+		atomic_store_explicit(&exchange->deviceToHostBaseline, gap, memory_order_relaxed);
+		baseline = gap;
+	}
+
+	latencyHistogramRecord(&exchange->latencyDeviceToHost, U64T(gap - baseline));
+}
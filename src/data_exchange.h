@@ -0,0 +1,100 @@
+#ifndef LIBCAER_SRC_DATA_EXCHANGE_H_
+#define LIBCAER_SRC_DATA_EXCHANGE_H_
+
+#include "devices/usb.h"
+#include "ringbuffer/ringbuffer.h"
+#include "latency_histogram.h"
+#include <stdatomic.h>
+
+#ifdef HAVE_PTHREADS
+	#include "c11threads_posix.h"
+#endif
+
+struct data_exchange_spill {
+	caerEventPacketContainer container;
+	size_t memory;
+	struct data_exchange_spill *next;
+};
+
+struct data_exchange {
+	RingBuffer buffer; // Consumer side.
+	RingBuffer producerBuffer; // Producer side, differs from 'buffer' while resizing.
+	atomic_uintptr_t migrationBuffer; // New ring-buffer, published by the producer.
+	atomic_uint_fast32_t bufferSize;
+	atomic_bool bufferResize;
+	atomic_bool blocking;
+	atomic_bool startProducers;
+	atomic_bool stopProducers;
+	atomic_uint_fast32_t policy;
+	atomic_uint_fast32_t blockTimeout; // in µs.
+	atomic_uint_fast32_t spillMaxMemory; // in KiB.
+	atomic_uint_fast32_t waitSpinCount;
+	atomic_uint_fast32_t waitYieldCount;
+	atomic_uint_fast32_t waitParkTimeout; // in µs.
+	void (*notifyIncrease)(void *ptr);
+	void (*notifyDecrease)(void *ptr);
+	void (*notifyDecreaseMany)(void *ptr, size_t count);
+	void *notifyUserPtr;
+	// Device statistics counter of containers that entered the ring-buffer, or NULL.
+	atomic_uint_fast64_t *committedContainers;
+	// Spill list, only ever accessed by the producer (data acquisition thread).
+	struct data_exchange_spill *spillHead;
+	struct data_exchange_spill *spillTail;
+	size_t spillMemory; // in bytes.
+	// Parking of a blocked consumer, woken up by the producer.
+	mtx_t waitLock;
+	cnd_t waitCond;
+	atomic_bool waitParked;
+	// Statistics, all updated with relaxed atomics.
+	atomic_uint_fast32_t droppedContainers;
+	atomic_uint_fast32_t delayedContainers;
+	atomic_uint_fast64_t evictedContainers;
+	atomic_uint_fast64_t putContainers;
+	atomic_uint_fast64_t getContainers;
+	atomic_uint_fast32_t capacity;
+	atomic_uint_fast32_t highWatermark;
+	atomic_uint_fast64_t waitSpinPhases;
+	atomic_uint_fast64_t waitYieldPhases;
+	atomic_uint_fast64_t waitParkPhases;
+	// Latency tracking, see CAER_DEVICE_LATENCY_* stages.
+	struct latency_histogram latencyTransferToCommit;
+	struct latency_histogram latencyCommitToGet;
+	struct latency_histogram latencyDeviceToHost;
+	atomic_int_fast64_t deviceToHostBaseline; // INT64_MAX if not yet known.
+	int64_t deviceToHostLastTimestamp; // Only accessed by the producer.
+};
+
+typedef struct data_exchange *dataExchange;
+
+// Host time for container latency tracking, in ns, from CLOCK_MONOTONIC.
+static inline int64_t dataExchangeHostTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((I64T(now.tv_sec) * 1000000000LL) + I64T(now.tv_nsec));
+}
+
+void dataExchangeSettingsInit(dataExchange exchange);
+bool dataExchangeConfigSet(dataExchange exchange, uint8_t paramAddr, uint32_t param);
+bool dataExchangeConfigGet(dataExchange exchange, uint8_t paramAddr, uint32_t *param);
+bool dataExchangeLatencyStatsGet(dataExchange exchange, uint8_t stage, struct caer_latency_stats *stats);
+void dataExchangeLatencyStatsReset(dataExchange exchange);
+
+bool dataExchangeBufferInit(dataExchange exchange);
+void dataExchangeBufferEmpty(dataExchange exchange);
+void dataExchangeBufferFree(dataExchange exchange);
+
+// Producer side, only call from the data acquisition thread.
+bool dataExchangePut(dataExchange exchange, caerEventPacketContainer container, atomic_bool *running);
+bool dataExchangePutForced(dataExchange exchange, caerEventPacketContainer container, atomic_bool *running);
+void dataExchangeSpillFlush(dataExchange exchange);
+
+static inline bool dataExchangeSpillPending(dataExchange exchange) {
+	return (exchange->spillHead != NULL);
+}
+
+// Consumer side.
+caerEventPacketContainer dataExchangeGet(dataExchange exchange);
+size_t dataExchangeGetMany(dataExchange exchange, caerEventPacketContainer *containers, size_t maxContainers);
+
+#endif /* LIBCAER_SRC_DATA_EXCHANGE_H_ */
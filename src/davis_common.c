@@ -1,18 +1,59 @@
 #include "davis_common.h"
-
-static bool spiConfigSend(libusb_device_handle *devHandle, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param);
-static bool spiConfigReceive(libusb_device_handle *devHandle, uint8_t moduleAddr, uint8_t paramAddr, uint32_t *param);
+#include "probes.h"
+
+static bool spiConfigSend(davisState state, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param);
+static bool spiConfigBatchFlush(davisState state);
+static bool spiConfigReceive(davisState state, uint8_t moduleAddr, uint8_t paramAddr, uint32_t *param);
+static bool spiConfigRead(usbTransport transport, uint8_t moduleAddr, uint8_t paramAddr, uint32_t *param);
+static atomic_uint_fast64_t *spiConfigShadow(davisState state, uint8_t moduleAddr, uint8_t paramAddr);
+static void spiConfigShadowFill(davisState state, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param);
+static void spiConfigShadowInvalidate(davisState state);
+static void spiConfigPrefetch(davisState state, const uint8_t registers[][2], size_t registersLength);
+static void LIBUSB_CALL spiConfigPrefetchCallback(struct libusb_transfer *transfer);
 static libusb_device_handle *davisDeviceOpen(libusb_context *devContext, uint16_t devVID, uint16_t devPID,
 	uint8_t devType, uint8_t busNumber, uint8_t devAddress, const char *serialNumber, uint16_t requiredLogicRevision,
 	uint16_t requiredFirmwareVersion);
 static void davisDeviceClose(libusb_device_handle *devHandle);
+static void davisTransportClose(davisState state);
 static void davisAllocateTransfers(davisHandle handle, uint32_t bufferNum, uint32_t bufferSize);
 static void davisDeallocateTransfers(davisHandle handle);
 static void LIBUSB_CALL davisLibUsbCallback(struct libusb_transfer *transfer);
-static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t bytesSent);
 static int davisDataAcquisitionThread(void *inPtr);
 static void davisDataAcquisitionThreadConfig(davisHandle handle);
 
+// Asynchronous configuration request, see davisCommonConfigSetAsync() and davisCommonConfigGetAsync().
+struct davis_config_request {
+	davisHandle handle;
+	caerDeviceConfigCallback callback;
+	void *callbackPtr;
+	int8_t modAddr;
+	uint8_t paramAddr;
+	uint32_t param;
+	// Gets: register being read from the device.
+	bool read;
+	uint8_t readModuleAddr;
+	uint8_t readParamAddr;
+};
+
+// Reads from the device the current thread doesn't do synchronously, while resolving an
+// asynchronous get: the register needed is noted instead, and the value read provided later.
+struct spi_config_deferred_read {
+	davisState state;
+	bool missed;
+	uint8_t missModuleAddr;
+	uint8_t missParamAddr;
+	bool haveValue;
+	uint8_t valueModuleAddr;
+	uint8_t valueParamAddr;
+	uint32_t value;
+};
+
+static _Thread_local struct spi_config_deferred_read *spiConfigDeferredRead = NULL;
+
+static bool davisConfigRequestGet(struct davis_config_request *request, bool haveValue, uint32_t value,
+	bool *success, uint32_t *param);
+static void LIBUSB_CALL davisConfigRequestCallback(struct libusb_transfer *transfer);
+
 static inline void checkStrictMonotonicTimestamp(davisHandle handle) {
 	if (handle->state.currentTimestamp <= handle->state.lastTimestamp) {
 		caerLog(CAER_LOG_ALERT, handle->info.deviceString,
@@ -104,10 +145,7 @@ static inline float calculateIMUGyroScale(uint8_t imuGyroScale) {
 }
 
 static inline void freeAllDataMemory(davisState state) {
-	if (state->dataExchangeBuffer != NULL) {
-		ringBufferFree(state->dataExchangeBuffer);
-		state->dataExchangeBuffer = NULL;
-	}
+	dataExchangeBufferFree(&state->dataExchange);
 
 	// Since the current event packets aren't necessarily
 	// already assigned to the current packet container, we
@@ -169,14 +207,11 @@ static inline void freeAllDataMemory(davisState state) {
 
 bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID_TYPE, const char *deviceName,
 	uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict, const char *serialNumberRestrict,
-	uint16_t requiredLogicRevision, uint16_t requiredFirmwareVersion) {
+	uint16_t requiredLogicRevision, uint16_t requiredFirmwareVersion, bool simulated) {
 	davisState state = &handle->state;
 
 	// Initialize state variables to default values (if not zero, taken care of by calloc above).
-	atomic_store_explicit(&state->dataExchangeBufferSize, 64, memory_order_relaxed);
-	atomic_store_explicit(&state->dataExchangeBlocking, false, memory_order_relaxed);
-	atomic_store_explicit(&state->dataExchangeStartProducers, true, memory_order_relaxed);
-	atomic_store_explicit(&state->dataExchangeStopProducers, true, memory_order_relaxed);
+	dataExchangeSettingsInit(&state->dataExchange);
 	atomic_store_explicit(&state->usbBufferNumber, 8, memory_order_relaxed);
 	atomic_store_explicit(&state->usbBufferSize, 8192, memory_order_relaxed);
 
@@ -190,51 +225,66 @@ bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID
 	snprintf(state->deviceThreadName, 15 + 1, "%s ID-%" PRIu16, deviceName, deviceID);
 	state->deviceThreadName[15] = '\0';
 
-	// Search for device and open it.
-	// Initialize libusb using a separate context for each device.
-	// This is to correctly support one thread per device.
-	// libusb may create its own threads at this stage, so we temporarly set
-	// a different thread name.
-	char originalThreadName[15 + 1]; // +1 for terminating NUL character.
-	thrd_get_name(originalThreadName, 15);
-	originalThreadName[15] = '\0';
-
-	thrd_set_name(state->deviceThreadName);
-	int res = libusb_init(&state->deviceContext);
+	uint8_t busNumber = 0;
+	uint8_t devAddress = 0;
+	char serialNumber[8 + 1] = { 0 };
 
-	thrd_set_name(originalThreadName);
+	if (simulated) {
+		// No USB device, everything is answered in-process.
+		state->transport.simulation = usbSimulationCreate(handle->deviceType, requiredLogicRevision);
+		if (state->transport.simulation == NULL) {
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to create simulated %s device.", deviceName);
+			return (false);
+		}
 
-	if (res != LIBUSB_SUCCESS) {
-		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize libusb context. Error: %d.", res);
-		return (false);
+		strncpy(serialNumber, "SIM", 8 + 1);
 	}
+	else {
+		// Search for device and open it.
+		// Initialize libusb using a separate context for each device.
+		// This is to correctly support one thread per device.
+		// libusb may create its own threads at this stage, so we temporarly set
+		// a different thread name.
+		char originalThreadName[15 + 1]; // +1 for terminating NUL character.
+		thrd_get_name(originalThreadName, 15);
+		originalThreadName[15] = '\0';
+
+		thrd_set_name(state->deviceThreadName);
+		int res = libusb_init(&state->transport.deviceContext);
+
+		thrd_set_name(originalThreadName);
+
+		if (res != LIBUSB_SUCCESS) {
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize libusb context. Error: %d.", res);
+			return (false);
+		}
 
-	// Try to open a DAVIS device on a specific USB port.
-	state->deviceHandle = davisDeviceOpen(state->deviceContext, VID, PID, DID_TYPE, busNumberRestrict,
-		devAddressRestrict, serialNumberRestrict, requiredLogicRevision, requiredFirmwareVersion);
-	if (state->deviceHandle == NULL) {
-		libusb_exit(state->deviceContext);
+		// Try to open a DAVIS device on a specific USB port.
+		state->transport.deviceHandle = davisDeviceOpen(state->transport.deviceContext, VID, PID, DID_TYPE,
+			busNumberRestrict, devAddressRestrict, serialNumberRestrict, requiredLogicRevision,
+			requiredFirmwareVersion);
+		if (state->transport.deviceHandle == NULL) {
+			libusb_exit(state->transport.deviceContext);
 
-		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open %s device.", deviceName);
-		return (false);
-	}
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open %s device.", deviceName);
+			return (false);
+		}
 
-	// At this point we can get some more precise data on the device and update
-	// the logging string to reflect that and be more informative.
-	uint8_t busNumber = libusb_get_bus_number(libusb_get_device(state->deviceHandle));
-	uint8_t devAddress = libusb_get_device_address(libusb_get_device(state->deviceHandle));
+		// At this point we can get some more precise data on the device and update
+		// the logging string to reflect that and be more informative.
+		busNumber = libusb_get_bus_number(libusb_get_device(state->transport.deviceHandle));
+		devAddress = libusb_get_device_address(libusb_get_device(state->transport.deviceHandle));
 
-	char serialNumber[8 + 1] = { 0 };
-	int getStringDescResult = libusb_get_string_descriptor_ascii(state->deviceHandle, 3, (unsigned char *) serialNumber,
-		8 + 1);
+		int getStringDescResult = libusb_get_string_descriptor_ascii(state->transport.deviceHandle, 3,
+			(unsigned char *) serialNumber, 8 + 1);
 
-	// Check serial number success and length.
-	if (getStringDescResult < 0 || getStringDescResult > 8) {
-		davisDeviceClose(state->deviceHandle);
-		libusb_exit(state->deviceContext);
+		// Check serial number success and length.
+		if (getStringDescResult < 0 || getStringDescResult > 8) {
+			davisTransportClose(state);
 
-		caerLog(CAER_LOG_CRITICAL, __func__, "Unable to get serial number for %s device.", deviceName);
-		return (false);
+			caerLog(CAER_LOG_CRITICAL, __func__, "Unable to get serial number for %s device.", deviceName);
+			return (false);
+		}
 	}
 
 	size_t fullLogStringLength = (size_t) snprintf(NULL, 0, "%s ID-%" PRIu16 " SN-%s [%" PRIu8 ":%" PRIu8 "]",
@@ -242,8 +292,7 @@ bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID
 
 	char *fullLogString = malloc(fullLogStringLength + 1);
 	if (fullLogString == NULL) {
-		davisDeviceClose(state->deviceHandle);
-		libusb_exit(state->deviceContext);
+		davisTransportClose(state);
 
 		caerLog(CAER_LOG_CRITICAL, __func__, "Unable to allocate memory for %s device info string.", deviceName);
 		return (false);
@@ -252,6 +301,14 @@ bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID
 	snprintf(fullLogString, fullLogStringLength + 1, "%s ID-%" PRIu16 " SN-%s [%" PRIu8 ":%" PRIu8 "]", deviceName,
 		deviceID, serialNumber, busNumber, devAddress);
 
+	if (mtx_init(&state->configLock, mtx_plain | mtx_recursive) != thrd_success) {
+		free(fullLogString);
+		davisTransportClose(state);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize configuration lock for %s device.", deviceName);
+		return (false);
+	}
+
 	// Populate info variables based on data from device.
 	uint32_t param32 = 0;
 
@@ -260,45 +317,45 @@ bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID
 	handle->info.deviceUSBBusNumber = busNumber;
 	handle->info.deviceUSBDeviceAddress = devAddress;
 	handle->info.deviceString = fullLogString;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_VERSION, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_VERSION, &param32);
 	handle->info.logicVersion = I16T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_DEVICE_IS_MASTER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_DEVICE_IS_MASTER, &param32);
 	handle->info.deviceIsMaster = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_CLOCK, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_CLOCK, &param32);
 	handle->info.logicClock = I16T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_ADC_CLOCK, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_ADC_CLOCK, &param32);
 	handle->info.adcClock = I16T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_CHIP_IDENTIFIER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_CHIP_IDENTIFIER, &param32);
 	handle->info.chipID = I16T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_HAS_PIXEL_FILTER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_HAS_PIXEL_FILTER, &param32);
 	handle->info.dvsHasPixelFilter = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_HAS_BACKGROUND_ACTIVITY_FILTER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_HAS_BACKGROUND_ACTIVITY_FILTER, &param32);
 	handle->info.dvsHasBackgroundActivityFilter = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_HAS_TEST_EVENT_GENERATOR, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_HAS_TEST_EVENT_GENERATOR, &param32);
 	handle->info.dvsHasTestEventGenerator = param32;
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_COLOR_FILTER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_COLOR_FILTER, &param32);
 	handle->info.apsColorFilter = U8T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_GLOBAL_SHUTTER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_GLOBAL_SHUTTER, &param32);
 	handle->info.apsHasGlobalShutter = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_QUAD_ROI, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_QUAD_ROI, &param32);
 	handle->info.apsHasQuadROI = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_EXTERNAL_ADC, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_EXTERNAL_ADC, &param32);
 	handle->info.apsHasExternalADC = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_INTERNAL_ADC, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_INTERNAL_ADC, &param32);
 	handle->info.apsHasInternalADC = param32;
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, DAVIS_CONFIG_EXTINPUT_HAS_GENERATOR, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_EXTINPUT, DAVIS_CONFIG_EXTINPUT_HAS_GENERATOR, &param32);
 	handle->info.extInputHasGenerator = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, DAVIS_CONFIG_EXTINPUT_HAS_EXTRA_DETECTORS, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_EXTINPUT, DAVIS_CONFIG_EXTINPUT_HAS_EXTRA_DETECTORS, &param32);
 	handle->info.extInputHasExtraDetectors = param32;
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_SIZE_COLUMNS, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_SIZE_COLUMNS, &param32);
 	state->dvsSizeX = I16T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_SIZE_ROWS, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_SIZE_ROWS, &param32);
 	state->dvsSizeY = I16T(param32);
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_ORIENTATION_INFO, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_ORIENTATION_INFO, &param32);
 	state->dvsInvertXY = U16T(param32) & 0x04;
 
 	if (state->dvsInvertXY) {
@@ -310,12 +367,12 @@ bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID
 		handle->info.dvsSizeY = state->dvsSizeY;
 	}
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_SIZE_COLUMNS, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_SIZE_COLUMNS, &param32);
 	state->apsSizeX = I16T(param32);
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_SIZE_ROWS, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_SIZE_ROWS, &param32);
 	state->apsSizeY = I16T(param32);
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_ORIENTATION_INFO, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_ORIENTATION_INFO, &param32);
 	uint16_t apsOrientationInfo = U16T(param32);
 	state->apsInvertXY = apsOrientationInfo & 0x04;
 	state->apsFlipX = apsOrientationInfo & 0x02;
@@ -340,10 +397,9 @@ bool davisCommonClose(davisHandle handle) {
 	davisState state = &handle->state;
 
 	// Finally, close the device fully.
-	davisDeviceClose(state->deviceHandle);
+	davisTransportClose(state);
 
-	// Destroy libusb context.
-	libusb_exit(state->deviceContext);
+	mtx_destroy(&state->configLock);
 
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "Shutdown successful.");
 
@@ -377,6 +433,9 @@ bool davisCommonSendDefaultFPGAConfig(caerDeviceHandle cdh,
 bool (*configSet)(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint32_t param)) {
 	davisHandle handle = (davisHandle) cdh;
 
+	// Send all default settings together, in few transfers.
+	davisCommonConfigBatchBegin(handle);
+
 	(*configSet)(cdh, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_TIMESTAMP_RESET, false);
 	(*configSet)(cdh, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_FORCE_CHIP_BIAS_ENABLE, false);
 	(*configSet)(cdh, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_DROP_DVS_ON_TRANSFER_STALL, true);
@@ -511,7 +570,7 @@ bool (*configSet)(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint3
 
 	(*configSet)(cdh, DAVIS_CONFIG_USB, DAVIS_CONFIG_USB_EARLY_PACKET_DELAY, 8); // in 125µs time-slices (defaults to 1ms)
 
-	return (true);
+	return (davisCommonConfigBatchEnd(handle));
 }
 
 #define CF_N_TYPE(COARSE, FINE) (struct caer_bias_coarsefine) \
@@ -550,6 +609,9 @@ bool davisCommonSendDefaultChipConfig(caerDeviceHandle cdh,
 bool (*configSet)(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint32_t param)) {
 	davisHandle handle = (davisHandle) cdh;
 
+	// Send all default settings together, in few transfers.
+	davisCommonConfigBatchBegin(handle);
+
 	// Default bias configuration.
 	if (IS_DAVIS240(handle->info.chipID)) {
 		(*configSet)(cdh, DAVIS_CONFIG_BIAS, DAVIS240_CONFIG_BIAS_DIFFBN, caerBiasCoarseFineGenerate(CF_N_TYPE(4, 39)));
@@ -772,7 +834,7 @@ bool (*configSet)(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint3
 		(*configSet)(cdh, DAVIS_CONFIG_CHIP, DAVISRGB_CONFIG_CHIP_ADJUSTTX2OVG2HI, false);
 	}
 
-	return (true);
+	return (davisCommonConfigBatchEnd(handle));
 }
 
 bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param) {
@@ -802,27 +864,11 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 			break;
 
 		case CAER_HOST_CONFIG_DATAEXCHANGE:
-			switch (paramAddr) {
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE:
-					atomic_store(&state->dataExchangeBufferSize, param);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING:
-					atomic_store(&state->dataExchangeBlocking, param);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS:
-					atomic_store(&state->dataExchangeStartProducers, param);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS:
-					atomic_store(&state->dataExchangeStopProducers, param);
-					break;
+			return (dataExchangeConfigSet(&state->dataExchange, paramAddr, param));
+			break;
 
-				default:
-					return (false);
-					break;
-			}
+		case CAER_HOST_CONFIG_SIMULATION:
+			return (usbSimulationConfigSet(state->transport.simulation, paramAddr, param));
 			break;
 
 		case CAER_HOST_CONFIG_PACKETS:
@@ -850,33 +896,19 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_MUX_DROP_APS_ON_TRANSFER_STALL:
 				case DAVIS_CONFIG_MUX_DROP_IMU_ON_TRANSFER_STALL:
 				case DAVIS_CONFIG_MUX_DROP_EXTINPUT_ON_TRANSFER_STALL:
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_MUX, paramAddr, param));
+					return (spiConfigSend(state, DAVIS_CONFIG_MUX, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_MUX_TIMESTAMP_RESET: {
 					// Use multi-command VR for more efficient implementation of reset,
 					// that also guarantees returning to the default state.
 					if (param) {
-						uint8_t spiMultiConfig[6 + 6] = { 0 };
-
-						spiMultiConfig[0] = DAVIS_CONFIG_MUX;
-						spiMultiConfig[1] = DAVIS_CONFIG_MUX_TIMESTAMP_RESET;
-						spiMultiConfig[2] = 0x00;
-						spiMultiConfig[3] = 0x00;
-						spiMultiConfig[4] = 0x00;
-						spiMultiConfig[5] = 0x01;
+						davisCommonConfigBatchBegin(handle);
 
-						spiMultiConfig[6] = DAVIS_CONFIG_MUX;
-						spiMultiConfig[7] = DAVIS_CONFIG_MUX_TIMESTAMP_RESET;
-						spiMultiConfig[8] = 0x00;
-						spiMultiConfig[9] = 0x00;
-						spiMultiConfig[10] = 0x00;
-						spiMultiConfig[11] = 0x00;
+						spiConfigSend(state, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_TIMESTAMP_RESET, true);
+						spiConfigSend(state, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_TIMESTAMP_RESET, false);
 
-						return (libusb_control_transfer(state->deviceHandle,
-							LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-							VENDOR_REQUEST_FPGA_CONFIG_MULTIPLE, 2, 0, spiMultiConfig, sizeof(spiMultiConfig), 0)
-							== sizeof(spiMultiConfig));
+						return (davisCommonConfigBatchEnd(handle));
 					}
 					break;
 				}
@@ -897,7 +929,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_DVS_WAIT_ON_TRANSFER_STALL:
 				case DAVIS_CONFIG_DVS_FILTER_ROW_ONLY_EVENTS:
 				case DAVIS_CONFIG_DVS_EXTERNAL_AER_CONTROL:
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+					return (spiConfigSend(state, DAVIS_CONFIG_DVS, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_DVS_FILTER_PIXEL_0_ROW:
@@ -911,10 +943,10 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.dvsHasPixelFilter) {
 						if (handle->state.dvsInvertXY) {
 							// Convert to column if X/Y inverted.
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, U8T(paramAddr + 1), param));
+							return (spiConfigSend(state, DAVIS_CONFIG_DVS, U8T(paramAddr + 1), param));
 						}
 						else {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_DVS, paramAddr, param));
 						}
 					}
 					else {
@@ -933,10 +965,10 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.dvsHasPixelFilter) {
 						if (handle->state.dvsInvertXY) {
 							// Convert to row if X/Y inverted.
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, U8T(paramAddr - 1), param));
+							return (spiConfigSend(state, DAVIS_CONFIG_DVS, U8T(paramAddr - 1), param));
 						}
 						else {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_DVS, paramAddr, param));
 						}
 					}
 					else {
@@ -947,7 +979,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_DVS_FILTER_BACKGROUND_ACTIVITY:
 				case DAVIS_CONFIG_DVS_FILTER_BACKGROUND_ACTIVITY_DELTAT:
 					if (handle->info.dvsHasBackgroundActivityFilter) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_DVS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -956,7 +988,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 
 				case DAVIS_CONFIG_DVS_TEST_EVENT_GENERATOR_ENABLE:
 					if (handle->info.dvsHasTestEventGenerator) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_DVS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -975,7 +1007,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_RESET_READ:
 				case DAVIS_CONFIG_APS_WAIT_ON_TRANSFER_STALL:
 				case DAVIS_CONFIG_APS_ROW_SETTLE:
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+					return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_APS_RESET_SETTLE:
@@ -983,7 +1015,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_NULL_SETTLE:
 					// Not supported on DAVIS RGB APS state machine.
 					if (!IS_DAVISRGB(handle->info.chipID)) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -994,10 +1026,10 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_END_COLUMN_0:
 					if (state->apsInvertXY) {
 						// Convert to row if X/Y inverted.
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
 					}
 					else {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					break;
 
@@ -1005,10 +1037,10 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_END_ROW_0:
 					if (state->apsInvertXY) {
 						// Convert to column if X/Y inverted.
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
 					}
 					else {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					break;
 
@@ -1016,19 +1048,19 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_FRAME_DELAY:
 					// Exposure and Frame Delay are in µs, must be converted to native FPGA cycles
 					// by multiplying with ADC clock value.
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr,
+					return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr,
 						param * U16T(handle->info.adcClock)));
 					break;
 
 				case DAVIS_CONFIG_APS_GLOBAL_SHUTTER:
 					if (handle->info.apsHasGlobalShutter) {
 						// Keep in sync with chip config module GlobalShutter parameter.
-						if (!spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, DAVIS128_CONFIG_CHIP_GLOBAL_SHUTTER,
+						if (!spiConfigSend(state, DAVIS_CONFIG_CHIP, DAVIS128_CONFIG_CHIP_GLOBAL_SHUTTER,
 							param)) {
 							return (false);
 						}
 
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1045,10 +1077,10 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.apsHasQuadROI) {
 						if (state->apsInvertXY) {
 							// Convert to row if X/Y inverted.
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
+							return (spiConfigSend(state, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
 						}
 						else {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 						}
 					}
 					else {
@@ -1065,10 +1097,10 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.apsHasQuadROI) {
 						if (state->apsInvertXY) {
 							// Convert to column if X/Y inverted.
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
+							return (spiConfigSend(state, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
 						}
 						else {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 						}
 					}
 					else {
@@ -1083,7 +1115,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_RAMP_SHORT_RESET:
 				case DAVIS_CONFIG_APS_ADC_TEST_MODE:
 					if (handle->info.apsHasInternalADC) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1098,7 +1130,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVISRGB_CONFIG_APS_GSFDRESET:
 					// Support for DAVISRGB extra timing parameters.
 					if (IS_DAVISRGB(handle->info.chipID)) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1109,26 +1141,12 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					// Use multi-command VR for more efficient implementation of snapshot,
 					// that also guarantees returning to the default state (not running).
 					if (param) {
-						uint8_t spiMultiConfig[6 + 6] = { 0 };
-
-						spiMultiConfig[0] = DAVIS_CONFIG_APS;
-						spiMultiConfig[1] = DAVIS_CONFIG_APS_RUN;
-						spiMultiConfig[2] = 0x00;
-						spiMultiConfig[3] = 0x00;
-						spiMultiConfig[4] = 0x00;
-						spiMultiConfig[5] = 0x01;
+						davisCommonConfigBatchBegin(handle);
 
-						spiMultiConfig[6] = DAVIS_CONFIG_APS;
-						spiMultiConfig[7] = DAVIS_CONFIG_APS_RUN;
-						spiMultiConfig[8] = 0x00;
-						spiMultiConfig[9] = 0x00;
-						spiMultiConfig[10] = 0x00;
-						spiMultiConfig[11] = 0x00;
+						spiConfigSend(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RUN, true);
+						spiConfigSend(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RUN, false);
 
-						return (libusb_control_transfer(state->deviceHandle,
-							LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-							VENDOR_REQUEST_FPGA_CONFIG_MULTIPLE, 2, 0, spiMultiConfig, sizeof(spiMultiConfig), 0)
-							== sizeof(spiMultiConfig));
+						return (davisCommonConfigBatchEnd(handle));
 					}
 					break;
 				}
@@ -1151,7 +1169,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_IMU_DIGITAL_LOW_PASS_FILTER:
 				case DAVIS_CONFIG_IMU_ACCEL_FULL_SCALE:
 				case DAVIS_CONFIG_IMU_GYRO_FULL_SCALE:
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_IMU, paramAddr, param));
+					return (spiConfigSend(state, DAVIS_CONFIG_IMU, paramAddr, param));
 					break;
 
 				default:
@@ -1168,7 +1186,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSES:
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_POLARITY:
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_LENGTH:
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
+					return (spiConfigSend(state, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_EXTINPUT_RUN_GENERATOR:
@@ -1179,7 +1197,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_EXTINPUT_GENERATE_INJECT_ON_RISING_EDGE:
 				case DAVIS_CONFIG_EXTINPUT_GENERATE_INJECT_ON_FALLING_EDGE:
 					if (handle->info.extInputHasGenerator) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1199,7 +1217,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_POLARITY2:
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_LENGTH2:
 					if (handle->info.extInputHasExtraDetectors) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1218,7 +1236,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				if (IS_DAVIS240(handle->info.chipID)) {
 					// DAVIS240 uses the old bias generator with 22 branches, and uses all of them.
 					if (paramAddr < 22) {
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 					}
 				}
 				else if (IS_DAVIS128(handle->info.chipID) || IS_DAVIS208(handle->info.chipID)
@@ -1253,13 +1271,13 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						case DAVIS128_CONFIG_BIAS_BIASBUFFER:
 						case DAVIS128_CONFIG_BIAS_SSP:
 						case DAVIS128_CONFIG_BIAS_SSN:
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							break;
 
 						case DAVIS346_CONFIG_BIAS_ADCTESTVOLTAGE:
 							// Only supported by DAVIS346 and DAVIS640 chips.
 							if (IS_DAVIS346(handle->info.chipID) || IS_DAVIS640(handle->info.chipID)) {
-								return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+								return (spiConfigSend(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							}
 							break;
 
@@ -1269,7 +1287,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						case DAVIS208_CONFIG_BIAS_REFSSBN:
 							// Only supported by DAVIS208 chips.
 							if (IS_DAVIS208(handle->info.chipID)) {
-								return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+								return (spiConfigSend(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							}
 							break;
 
@@ -1315,7 +1333,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						case DAVISRGB_CONFIG_BIAS_BIASBUFFER:
 						case DAVISRGB_CONFIG_BIAS_SSP:
 						case DAVISRGB_CONFIG_BIAS_SSN:
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							break;
 
 						default:
@@ -1341,13 +1359,13 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					case DAVIS128_CONFIG_CHIP_RESETTESTPIXEL:
 					case DAVIS128_CONFIG_CHIP_AERNAROW:
 					case DAVIS128_CONFIG_CHIP_USEAOUT:
-						return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+						return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						break;
 
 					case DAVIS240_CONFIG_CHIP_SPECIALPIXELCONTROL:
 						// Only supported by DAVIS240 A/B chips.
 						if (IS_DAVIS240A(handle->info.chipID) || IS_DAVIS240B(handle->info.chipID)) {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1355,12 +1373,12 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						// Only supported by some chips.
 						if (handle->info.apsHasGlobalShutter) {
 							// Keep in sync with APS module GlobalShutter parameter.
-							if (!spiConfigSend(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_GLOBAL_SHUTTER,
+							if (!spiConfigSend(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_GLOBAL_SHUTTER,
 								param)) {
 								return (false);
 							}
 
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1369,7 +1387,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						if (IS_DAVIS128(
 							handle->info.chipID) || IS_DAVIS208(handle->info.chipID) || IS_DAVIS346(handle->info.chipID)
 							|| IS_DAVIS640(handle->info.chipID) || IS_DAVISRGB(handle->info.chipID)) {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1377,7 +1395,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						// Only supported by some of the new DAVIS chips.
 						if (IS_DAVIS346(
 							handle->info.chipID) || IS_DAVIS640(handle->info.chipID) || IS_DAVISRGB(handle->info.chipID)) {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1386,7 +1404,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					case DAVISRGB_CONFIG_CHIP_ADJUSTTX2OVG2HI: // Also DAVIS208_CONFIG_CHIP_SELECTSENSE.
 						// Only supported by DAVIS208 and DAVISRGB.
 						if (IS_DAVIS208(handle->info.chipID) || IS_DAVISRGB(handle->info.chipID)) {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1394,7 +1412,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					case DAVIS208_CONFIG_CHIP_SELECTHIGHPASS:
 						// Only supported by DAVIS208.
 						if (IS_DAVIS208(handle->info.chipID)) {
-							return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigSend(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1416,7 +1434,7 @@ bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 			switch (paramAddr) {
 				case DAVIS_CONFIG_USB_RUN:
 				case DAVIS_CONFIG_USB_EARLY_PACKET_DELAY:
-					return (spiConfigSend(state->deviceHandle, DAVIS_CONFIG_USB, paramAddr, param));
+					return (spiConfigSend(state, DAVIS_CONFIG_USB, paramAddr, param));
 					break;
 
 				default:
@@ -1454,27 +1472,11 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 			break;
 
 		case CAER_HOST_CONFIG_DATAEXCHANGE:
-			switch (paramAddr) {
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE:
-					*param = U32T(atomic_load(&state->dataExchangeBufferSize));
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING:
-					*param = atomic_load(&state->dataExchangeBlocking);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS:
-					*param = atomic_load(&state->dataExchangeStartProducers);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS:
-					*param = atomic_load(&state->dataExchangeStopProducers);
-					break;
+			return (dataExchangeConfigGet(&state->dataExchange, paramAddr, param));
+			break;
 
-				default:
-					return (false);
-					break;
-			}
+		case CAER_HOST_CONFIG_SIMULATION:
+			return (usbSimulationConfigGet(state->transport.simulation, paramAddr, param));
 			break;
 
 		case CAER_HOST_CONFIG_PACKETS:
@@ -1502,7 +1504,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_MUX_DROP_APS_ON_TRANSFER_STALL:
 				case DAVIS_CONFIG_MUX_DROP_IMU_ON_TRANSFER_STALL:
 				case DAVIS_CONFIG_MUX_DROP_EXTINPUT_ON_TRANSFER_STALL:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_MUX, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_MUX, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_MUX_TIMESTAMP_RESET:
@@ -1532,7 +1534,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_DVS_HAS_PIXEL_FILTER:
 				case DAVIS_CONFIG_DVS_HAS_BACKGROUND_ACTIVITY_FILTER:
 				case DAVIS_CONFIG_DVS_HAS_TEST_EVENT_GENERATOR:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_DVS, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_DVS_FILTER_PIXEL_0_ROW:
@@ -1546,10 +1548,10 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.dvsHasPixelFilter) {
 						if (handle->state.dvsInvertXY) {
 							// Convert to column if X/Y inverted.
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, U8T(paramAddr + 1), param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_DVS, U8T(paramAddr + 1), param));
 						}
 						else {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_DVS, paramAddr, param));
 						}
 					}
 					else {
@@ -1568,10 +1570,10 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.dvsHasPixelFilter) {
 						if (handle->state.dvsInvertXY) {
 							// Convert to row if X/Y inverted.
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, U8T(paramAddr - 1), param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_DVS, U8T(paramAddr - 1), param));
 						}
 						else {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_DVS, paramAddr, param));
 						}
 					}
 					else {
@@ -1582,7 +1584,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_DVS_FILTER_BACKGROUND_ACTIVITY:
 				case DAVIS_CONFIG_DVS_FILTER_BACKGROUND_ACTIVITY_DELTAT:
 					if (handle->info.dvsHasBackgroundActivityFilter) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_DVS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1591,7 +1593,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 
 				case DAVIS_CONFIG_DVS_TEST_EVENT_GENERATOR_ENABLE:
 					if (handle->info.dvsHasTestEventGenerator) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_DVS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_DVS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1618,17 +1620,17 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_HAS_QUAD_ROI:
 				case DAVIS_CONFIG_APS_HAS_EXTERNAL_ADC:
 				case DAVIS_CONFIG_APS_HAS_INTERNAL_ADC:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_APS_START_COLUMN_0:
 				case DAVIS_CONFIG_APS_END_COLUMN_0:
 					if (state->apsInvertXY) {
 						// Convert to row if X/Y inverted.
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
 					}
 					else {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					break;
 
@@ -1636,10 +1638,10 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_END_ROW_0:
 					if (state->apsInvertXY) {
 						// Convert to column if X/Y inverted.
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
 					}
 					else {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					break;
 
@@ -1648,7 +1650,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_NULL_SETTLE:
 					// Not supported on DAVIS RGB APS state machine.
 					if (!IS_DAVISRGB(handle->info.chipID)) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1660,7 +1662,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					// Exposure and Frame Delay are in µs, must be converted from native FPGA cycles
 					// by dividing with ADC clock value.
 					uint32_t cyclesValue = 0;
-					if (!spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, &cyclesValue)) {
+					if (!spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, &cyclesValue)) {
 						return (false);
 					}
 
@@ -1672,7 +1674,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 
 				case DAVIS_CONFIG_APS_GLOBAL_SHUTTER:
 					if (handle->info.apsHasGlobalShutter) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1688,10 +1690,10 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.apsHasQuadROI) {
 						if (state->apsInvertXY) {
 							// Convert to row if X/Y inverted.
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_APS, U8T(paramAddr + 1), param));
 						}
 						else {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 						}
 					}
 					else {
@@ -1708,10 +1710,10 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					if (handle->info.apsHasQuadROI) {
 						if (state->apsInvertXY) {
 							// Convert to column if X/Y inverted.
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_APS, U8T(paramAddr - 1), param));
 						}
 						else {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 						}
 					}
 					else {
@@ -1726,7 +1728,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_APS_RAMP_SHORT_RESET:
 				case DAVIS_CONFIG_APS_ADC_TEST_MODE:
 					if (handle->info.apsHasInternalADC) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1741,7 +1743,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVISRGB_CONFIG_APS_GSFDRESET:
 					// Support for DAVISRGB extra timing parameters.
 					if (IS_DAVISRGB(handle->info.chipID)) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_APS, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1771,7 +1773,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_IMU_DIGITAL_LOW_PASS_FILTER:
 				case DAVIS_CONFIG_IMU_ACCEL_FULL_SCALE:
 				case DAVIS_CONFIG_IMU_GYRO_FULL_SCALE:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_IMU, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_IMU, paramAddr, param));
 					break;
 
 				default:
@@ -1790,7 +1792,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_LENGTH:
 				case DAVIS_CONFIG_EXTINPUT_HAS_GENERATOR:
 				case DAVIS_CONFIG_EXTINPUT_HAS_EXTRA_DETECTORS:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
 					break;
 
 				case DAVIS_CONFIG_EXTINPUT_RUN_GENERATOR:
@@ -1801,7 +1803,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_EXTINPUT_GENERATE_INJECT_ON_RISING_EDGE:
 				case DAVIS_CONFIG_EXTINPUT_GENERATE_INJECT_ON_FALLING_EDGE:
 					if (handle->info.extInputHasGenerator) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1821,7 +1823,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_POLARITY2:
 				case DAVIS_CONFIG_EXTINPUT_DETECT_PULSE_LENGTH2:
 					if (handle->info.extInputHasExtraDetectors) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_EXTINPUT, paramAddr, param));
 					}
 					else {
 						return (false);
@@ -1840,7 +1842,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				if (IS_DAVIS240(handle->info.chipID)) {
 					// DAVIS240 uses the old bias generator with 22 branches, and uses all of them.
 					if (paramAddr < 22) {
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 					}
 				}
 				else if (IS_DAVIS128(handle->info.chipID) || IS_DAVIS208(handle->info.chipID)
@@ -1875,13 +1877,13 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						case DAVIS128_CONFIG_BIAS_BIASBUFFER:
 						case DAVIS128_CONFIG_BIAS_SSP:
 						case DAVIS128_CONFIG_BIAS_SSN:
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							break;
 
 						case DAVIS346_CONFIG_BIAS_ADCTESTVOLTAGE:
 							// Only supported by DAVIS346 and DAVIS640 chips.
 							if (IS_DAVIS346(handle->info.chipID) || IS_DAVIS640(handle->info.chipID)) {
-								return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+								return (spiConfigReceive(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							}
 							break;
 
@@ -1891,7 +1893,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						case DAVIS208_CONFIG_BIAS_REFSSBN:
 							// Only supported by DAVIS208 chips.
 							if (IS_DAVIS208(handle->info.chipID)) {
-								return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+								return (spiConfigReceive(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							}
 							break;
 
@@ -1937,7 +1939,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						case DAVISRGB_CONFIG_BIAS_BIASBUFFER:
 						case DAVISRGB_CONFIG_BIAS_SSP:
 						case DAVISRGB_CONFIG_BIAS_SSN:
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_BIAS, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_BIAS, paramAddr, param));
 							break;
 
 						default:
@@ -1963,20 +1965,20 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					case DAVIS128_CONFIG_CHIP_RESETTESTPIXEL:
 					case DAVIS128_CONFIG_CHIP_AERNAROW:
 					case DAVIS128_CONFIG_CHIP_USEAOUT:
-						return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+						return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						break;
 
 					case DAVIS240_CONFIG_CHIP_SPECIALPIXELCONTROL:
 						// Only supported by DAVIS240 A/B chips.
 						if (IS_DAVIS240A(handle->info.chipID) || IS_DAVIS240B(handle->info.chipID)) {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
 					case DAVIS128_CONFIG_CHIP_GLOBAL_SHUTTER:
 						// Only supported by some chips.
 						if (handle->info.apsHasGlobalShutter) {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1985,7 +1987,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						if (IS_DAVIS128(
 							handle->info.chipID) || IS_DAVIS208(handle->info.chipID) || IS_DAVIS346(handle->info.chipID)
 							|| IS_DAVIS640(handle->info.chipID) || IS_DAVISRGB(handle->info.chipID)) {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -1993,7 +1995,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 						// Only supported by some of the new DAVIS chips.
 						if (IS_DAVIS346(
 							handle->info.chipID) || IS_DAVIS640(handle->info.chipID) || IS_DAVISRGB(handle->info.chipID)) {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -2002,7 +2004,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					case DAVISRGB_CONFIG_CHIP_ADJUSTTX2OVG2HI: // Also DAVIS208_CONFIG_CHIP_SELECTSENSE.
 						// Only supported by DAVIS208 and DAVISRGB.
 						if (IS_DAVIS208(handle->info.chipID) || IS_DAVISRGB(handle->info.chipID)) {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -2010,7 +2012,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 					case DAVIS208_CONFIG_CHIP_SELECTHIGHPASS:
 						// Only supported by DAVIS208.
 						if (IS_DAVIS208(handle->info.chipID)) {
-							return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_CHIP, paramAddr, param));
+							return (spiConfigReceive(state, DAVIS_CONFIG_CHIP, paramAddr, param));
 						}
 						break;
 
@@ -2030,7 +2032,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 				case DAVIS_CONFIG_SYSINFO_DEVICE_IS_MASTER:
 				case DAVIS_CONFIG_SYSINFO_LOGIC_CLOCK:
 				case DAVIS_CONFIG_SYSINFO_ADC_CLOCK:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, paramAddr, param));
 					break;
 
 				default:
@@ -2043,7 +2045,7 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 			switch (paramAddr) {
 				case DAVIS_CONFIG_USB_RUN:
 				case DAVIS_CONFIG_USB_EARLY_PACKET_DELAY:
-					return (spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_USB, paramAddr, param));
+					return (spiConfigReceive(state, DAVIS_CONFIG_USB, paramAddr, param));
 					break;
 
 				default:
@@ -2060,26 +2062,15 @@ bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr,
 	return (true);
 }
 
-bool davisCommonDataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr),
-	void (*dataNotifyDecrease)(void *ptr), void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr),
-	void *dataShutdownUserPtr) {
-	davisHandle handle = (davisHandle) cdh;
+bool davisCommonDataMemoryInit(davisHandle handle) {
 	davisState state = &handle->state;
 
-	// Store new data available/not available anymore call-backs.
-	state->dataNotifyIncrease = dataNotifyIncrease;
-	state->dataNotifyDecrease = dataNotifyDecrease;
-	state->dataNotifyUserPtr = dataNotifyUserPtr;
-	state->dataShutdownNotify = dataShutdownNotify;
-	state->dataShutdownUserPtr = dataShutdownUserPtr;
-
 	// Set wanted time interval to uninitialized. Getting the first TS or TS_RESET
 	// will then set this correctly.
 	state->currentPacketContainerCommitTimestamp = -1;
 
 	// Initialize RingBuffer.
-	state->dataExchangeBuffer = ringBufferInit(atomic_load(&state->dataExchangeBufferSize));
-	if (state->dataExchangeBuffer == NULL) {
+	if (!dataExchangeBufferInit(&state->dataExchange)) {
 		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to initialize data exchange buffer.");
 		return (false);
 	}
@@ -2155,27 +2146,61 @@ bool davisCommonDataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void
 		return (false);
 	}
 
+	return (true);
+}
+
+void davisCommonDataMemoryFree(davisHandle handle) {
+	freeAllDataMemory(&handle->state);
+}
+
+bool davisCommonDataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr),
+	void (*dataNotifyDecrease)(void *ptr), void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr),
+	void *dataShutdownUserPtr) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	// Store new data available/not available anymore call-backs.
+	state->dataExchange.notifyIncrease = dataNotifyIncrease;
+	state->dataExchange.notifyDecrease = dataNotifyDecrease;
+	state->dataExchange.notifyUserPtr = dataNotifyUserPtr;
+	state->dataExchange.committedContainers = &state->stats.containersCommitted;
+	state->dataShutdownNotify = dataShutdownNotify;
+	state->dataShutdownUserPtr = dataShutdownUserPtr;
+
+	if (!davisCommonDataMemoryInit(handle)) {
+		return (false);
+	}
+
+	// Registers needed for event parsing, read all at once instead of one after the other.
+	static const uint8_t parsingRegisters[][2] = { { DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_ACCEL_FULL_SCALE },
+		{ DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_GYRO_FULL_SCALE }, { DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_START_COLUMN_0 },
+		{ DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_COLUMN_0 }, { DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_START_ROW_0 },
+		{ DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_ROW_0 }, { DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_GLOBAL_SHUTTER },
+		{ DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RESET_READ } };
+
+	spiConfigPrefetch(state, parsingRegisters, sizeof(parsingRegisters) / sizeof(parsingRegisters[0]));
+
 	// Default IMU settings (for event parsing).
 	uint32_t param32 = 0;
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_ACCEL_FULL_SCALE, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_ACCEL_FULL_SCALE, &param32);
 	state->imuAccelScale = calculateIMUAccelScale(U8T(param32));
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_GYRO_FULL_SCALE, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_GYRO_FULL_SCALE, &param32);
 	state->imuGyroScale = calculateIMUGyroScale(U8T(param32));
 
 	// Default APS settings (for event parsing).
 	uint32_t param32start = 0;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_START_COLUMN_0, &param32start);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_START_COLUMN_0, &param32start);
 
 	// If StartColumn0 is bigger or equal to APS size X, disable ROI region 0.
 	if (param32start < U32T(state->apsSizeX)) {
-		spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_COLUMN_0, &param32);
+		spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_COLUMN_0, &param32);
 
 		state->apsROISizeX[0] = U16T(param32 + 1 - param32start);
 		state->apsROIPositionX[0] = U16T(param32start);
 
-		spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_START_ROW_0, &param32start);
-		spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_ROW_0, &param32);
+		spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_START_ROW_0, &param32start);
+		spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_ROW_0, &param32);
 
 		state->apsROISizeY[0] = U16T(param32 + 1 - param32start);
 		state->apsROIPositionY[0] = U16T(param32start);
@@ -2186,12 +2211,20 @@ bool davisCommonDataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void
 		state->apsROISizeY[0] = state->apsROIPositionY[0] = 0;
 	}
 
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_GLOBAL_SHUTTER, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_GLOBAL_SHUTTER, &param32);
 	state->apsGlobalShutter = param32;
-	spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RESET_READ, &param32);
+	spiConfigReceive(state, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RESET_READ, &param32);
 	state->apsResetRead = param32;
 
+	if (!threadReadyInit(&state->dataAcquisitionThreadReady)) {
+		freeAllDataMemory(state);
+
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to initialize data acquisition thread start.");
+		return (false);
+	}
+
 	if ((errno = thrd_create(&state->dataAcquisitionThread, &davisDataAcquisitionThread, handle)) != thrd_success) {
+		threadReadyDestroy(&state->dataAcquisitionThreadReady);
 		freeAllDataMemory(state);
 
 		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to start data acquisition thread. Error: %d.",
@@ -2200,9 +2233,8 @@ bool davisCommonDataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void
 	}
 
 	// Wait for the data acquisition thread to be ready.
-	while (!atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
-		;
-	}
+	threadReadyWait(&state->dataAcquisitionThreadReady);
+	threadReadyDestroy(&state->dataAcquisitionThreadReady);
 
 	return (true);
 }
@@ -2212,7 +2244,7 @@ bool davisCommonDataStop(caerDeviceHandle cdh) {
 	davisState state = &handle->state;
 
 	// Stop data acquisition thread.
-	if (atomic_load(&state->dataExchangeStopProducers)) {
+	if (atomic_load(&state->dataExchange.stopProducers)) {
 		// Disable data transfer on USB end-point 2. Reverse order of enabling.
 		davisCommonConfigSet(handle, DAVIS_CONFIG_EXTINPUT, DAVIS_CONFIG_EXTINPUT_RUN_DETECTOR, false);
 		davisCommonConfigSet(handle, DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_RUN, false);
@@ -2234,17 +2266,8 @@ bool davisCommonDataStop(caerDeviceHandle cdh) {
 		return (false);
 	}
 
-	// Empty ringbuffer.
-	caerEventPacketContainer container;
-	while ((container = ringBufferGet(state->dataExchangeBuffer)) != NULL) {
-		// Notify data-not-available call-back.
-		if (state->dataNotifyDecrease != NULL) {
-			state->dataNotifyDecrease(state->dataNotifyUserPtr);
-		}
-
-		// Free container, which will free its subordinate packets too.
-		caerEventPacketContainerFree(container);
-	}
+	// Empty ringbuffer and overflow list.
+	dataExchangeBufferEmpty(&state->dataExchange);
 
 	// Free current, uncommitted packets and ringbuffer.
 	freeAllDataMemory(state);
@@ -2264,36 +2287,379 @@ bool davisCommonDataStop(caerDeviceHandle cdh) {
 caerEventPacketContainer davisCommonDataGet(caerDeviceHandle cdh) {
 	davisHandle handle = (davisHandle) cdh;
 	davisState state = &handle->state;
-	caerEventPacketContainer container = NULL;
 
-	retry: container = ringBufferGet(state->dataExchangeBuffer);
+	return (dataExchangeGet(&state->dataExchange));
+}
+
+// Remember to properly free the returned memory after usage!
+size_t davisCommonDataGetMany(caerDeviceHandle cdh, caerEventPacketContainer *containers, size_t maxContainers) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	return (dataExchangeGetMany(&state->dataExchange, containers, maxContainers));
+}
+
+bool davisCommonDataNotifyDecreaseManySet(caerDeviceHandle cdh, void (*dataNotifyDecreaseMany)(void *ptr, size_t count)) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	state->dataExchange.notifyDecreaseMany = dataNotifyDecreaseMany;
+
+	return (true);
+}
+
+bool davisCommonLatencyStatsGet(caerDeviceHandle cdh, uint8_t stage, struct caer_latency_stats *stats) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	return (dataExchangeLatencyStatsGet(&state->dataExchange, stage, stats));
+}
+
+bool davisCommonLatencyStatsReset(caerDeviceHandle cdh) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	dataExchangeLatencyStatsReset(&state->dataExchange);
+
+	return (true);
+}
+
+bool davisCommonStatsGet(caerDeviceHandle cdh, struct caer_device_stats *stats) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	deviceStatsGet(&state->stats, stats);
+
+	return (true);
+}
+
+void davisCommonConfigBatchBegin(davisHandle handle) {
+	davisState state = &handle->state;
+
+	mtx_lock(&state->configLock);
+
+	if (state->configBatchDepth++ == 0) {
+		state->configBatchLength = 0;
+		state->configBatchFailed = false;
+	}
+}
+
+bool davisCommonConfigBatchEnd(davisHandle handle) {
+	davisState state = &handle->state;
+
+	if (state->configBatchDepth == 0) {
+		return (false);
+	}
+
+	// Inner batch: the outermost one sends everything.
+	if (--state->configBatchDepth == 0) {
+		if (!spiConfigBatchFlush(state)) {
+			state->configBatchFailed = true;
+		}
+
+		if (state->configBatchFailed) {
+			// Unknown which writes reached the device.
+			spiConfigShadowInvalidate(state);
+		}
+	}
+
+	bool success = !state->configBatchFailed;
+
+	mtx_unlock(&state->configLock);
+
+	return (success);
+}
+
+bool davisCommonConfigSetAsync(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint32_t param,
+	caerDeviceConfigCallback callback, void *callbackPtr) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	// Collect the writes this parameter maps to, then send them as one request.
+	davisCommonConfigBatchBegin(handle);
+
+	// Inside an enclosing batch, the writes are sent together with it.
+	bool async = (state->configBatchDepth == 1 && state->configAsyncAccept);
+
+	bool success = davisCommonConfigSet(handle, modAddr, paramAddr, param);
+
+	if (async && success && state->configBatchLength != 0) {
+		struct davis_config_request *request = calloc(1, sizeof(*request));
+
+		if (request != NULL) {
+			request->handle = handle;
+			request->callback = callback;
+			request->callbackPtr = callbackPtr;
+			request->modAddr = modAddr;
+			request->paramAddr = paramAddr;
+			request->param = param;
+
+			uint16_t count = state->configBatchLength;
+			uint16_t length = U16T(count * DAVIS_CONFIG_BATCH_TUPLE_SIZE);
+
+			atomic_fetch_add(&state->configAsyncActive, 1);
+
+			if (usbTransportControlAsync(&state->transport,
+				LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+				VENDOR_REQUEST_FPGA_CONFIG_MULTIPLE, count, 0, state->configBatch, length, 0,
+				&davisConfigRequestCallback, request) == LIBUSB_SUCCESS) {
+				state->configBatchLength = 0;
+
+				davisCommonConfigBatchEnd(handle);
+
+				return (true);
+			}
+
+			atomic_fetch_sub(&state->configAsyncActive, 1);
+			free(request);
+		}
+	}
+
+	// Synchronous fall-back, also for host-side and invalid parameters.
+	success = davisCommonConfigBatchEnd(handle) && success;
+
+	(*callback)(callbackPtr, success, modAddr, paramAddr, param);
+
+	return (true);
+}
+
+bool davisCommonConfigGetAsync(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr,
+	caerDeviceConfigCallback callback, void *callbackPtr) {
+	davisHandle handle = (davisHandle) cdh;
+	davisState state = &handle->state;
+
+	bool success = false;
+	uint32_t param = 0;
+
+	// Held until the register read, if any, is submitted, so data transfer can't stop meanwhile.
+	mtx_lock(&state->configLock);
+
+	if (!state->configAsyncAccept) {
+		mtx_unlock(&state->configLock);
+
+		success = davisCommonConfigGet(handle, modAddr, paramAddr, &param);
+
+		(*callback)(callbackPtr, success, modAddr, paramAddr, (success) ? (param) : (0));
+
+		return (true);
+	}
+
+	struct davis_config_request *request = calloc(1, sizeof(*request));
+	if (request == NULL) {
+		mtx_unlock(&state->configLock);
+
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString,
+			"Failed to allocate memory for asynchronous configuration request.");
+		return (false);
+	}
+
+	request->handle = handle;
+	request->callback = callback;
+	request->callbackPtr = callbackPtr;
+	request->modAddr = modAddr;
+	request->paramAddr = paramAddr;
+	request->read = true;
+
+	bool completed = davisConfigRequestGet(request, false, 0, &success, &param);
+
+	mtx_unlock(&state->configLock);
+
+	if (completed) {
+		(*callback)(callbackPtr, success, modAddr, paramAddr, param);
+		free(request);
+	}
+
+	return (true);
+}
+
+bool davisCommonConfigTransactionCommit(caerDeviceHandle cdh, caerDeviceConfigTransaction transaction, bool pause) {
+	davisHandle handle = (davisHandle) cdh;
+
+	// All register writes are collected and sent together, in order.
+	davisCommonConfigBatchBegin(handle);
+
+	bool success = true;
+	uint32_t dvsRun = 0;
+	uint32_t apsRun = 0;
+
+	if (pause) {
+		// Usually known from the register shadow, without device access.
+		success = davisCommonConfigGet(handle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_RUN, &dvsRun) && success;
+		success = davisCommonConfigGet(handle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RUN, &apsRun) && success;
+
+		if (dvsRun) {
+			success = davisCommonConfigSet(handle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_RUN, false) && success;
+		}
+
+		if (apsRun) {
+			success = davisCommonConfigSet(handle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RUN, false) && success;
+		}
+	}
+
+	for (size_t i = 0; i < transaction->updatesNumber; i++) {
+		struct caer_device_config_update *update = &transaction->updates[i];
+
+		// While paused, changes to whether DVS and APS run take effect at the end.
+		if (pause && update->modAddr == DAVIS_CONFIG_DVS && update->paramAddr == DAVIS_CONFIG_DVS_RUN) {
+			dvsRun = update->param;
+			continue;
+		}
+
+		if (pause && update->modAddr == DAVIS_CONFIG_APS && update->paramAddr == DAVIS_CONFIG_APS_RUN) {
+			apsRun = update->param;
+			continue;
+		}
+
+		success = davisCommonConfigSet(handle, update->modAddr, update->paramAddr, update->param) && success;
+	}
 
-	if (container != NULL) {
-		// Found an event container, return it and signal this piece of data
-		// is no longer available for later acquisition.
-		if (state->dataNotifyDecrease != NULL) {
-			state->dataNotifyDecrease(state->dataNotifyUserPtr);
+	if (pause) {
+		if (dvsRun) {
+			success = davisCommonConfigSet(handle, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_RUN, dvsRun) && success;
 		}
 
-		return (container);
+		if (apsRun) {
+			success = davisCommonConfigSet(handle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RUN, apsRun) && success;
+		}
 	}
 
-	// Didn't find any event container, either report this or retry, depending
-	// on blocking setting.
-	if (atomic_load_explicit(&state->dataExchangeBlocking, memory_order_relaxed)) {
-		// Don't retry right away in a tight loop, back off and wait a little.
-		// If no data is available, sleep for a millisecond to avoid wasting resources.
-		struct timespec noDataSleep = { .tv_sec = 0, .tv_nsec = 1000000 };
-		if (thrd_sleep(&noDataSleep, NULL) == 0) {
-			goto retry;
+	return (davisCommonConfigBatchEnd(handle) && success);
+}
+
+// Resolve a get with the values known without reading from the device, plus the
+// one just read (if any). If that's not enough, submit a read of the register needed.
+// Returns true if the request is completed, with the result in 'success' and 'param'.
+static bool davisConfigRequestGet(struct davis_config_request *request, bool haveValue, uint32_t value,
+	bool *success, uint32_t *param) {
+	davisState state = &request->handle->state;
+
+	struct spi_config_deferred_read deferred = { .state = state, .haveValue = haveValue,
+		.valueModuleAddr = request->readModuleAddr, .valueParamAddr = request->readParamAddr, .value = value };
+
+	*param = 0;
+
+	spiConfigDeferredRead = &deferred;
+	*success = davisCommonConfigGet(request->handle, request->modAddr, request->paramAddr, param);
+	spiConfigDeferredRead = NULL;
+
+	if (!deferred.missed) {
+		if (!*success) {
+			*param = 0;
+		}
+
+		return (true);
+	}
+
+	request->readModuleAddr = deferred.missModuleAddr;
+	request->readParamAddr = deferred.missParamAddr;
+
+	atomic_fetch_add(&state->configAsyncActive, 1);
+
+	if (usbTransportControlAsync(&state->transport,
+		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE, VENDOR_REQUEST_FPGA_CONFIG,
+		request->readModuleAddr, request->readParamAddr, NULL, 4, 0, &davisConfigRequestCallback, request)
+		== LIBUSB_SUCCESS) {
+		return (false);
+	}
+
+	atomic_fetch_sub(&state->configAsyncActive, 1);
+
+	*success = false;
+	*param = 0;
+
+	return (true);
+}
+
+static void LIBUSB_CALL davisConfigRequestCallback(struct libusb_transfer *transfer) {
+	struct davis_config_request *request = transfer->user_data;
+	davisState state = &request->handle->state;
+
+	bool success = (transfer->status == LIBUSB_TRANSFER_COMPLETED
+		&& transfer->actual_length == libusb_le16_to_cpu(libusb_control_transfer_get_setup(transfer)->wLength));
+
+	uint32_t param = request->param;
+
+	if (request->read) {
+		bool completed = true;
+
+		if (success) {
+			uint8_t *data = libusb_control_transfer_get_data(transfer);
+			uint32_t value = U32T(data[0] << 24) | U32T(data[1] << 16) | U32T(data[2] << 8) | U32T(data[3] << 0);
+
+			spiConfigShadowFill(state, request->readModuleAddr, request->readParamAddr, value);
+
+			// This may need yet another register, then the request continues with that read.
+			completed = davisConfigRequestGet(request, true, value, &success, &param);
+		}
+		else {
+			param = 0;
 		}
+
+		if (completed) {
+			(*request->callback)(request->callbackPtr, success, request->modAddr, request->paramAddr, param);
+			free(request);
+		}
+	}
+	else {
+		if (!success) {
+			// Unknown which writes reached the device.
+			spiConfigShadowInvalidate(state);
+		}
+
+		(*request->callback)(request->callbackPtr, success, request->modAddr, request->paramAddr, param);
+		free(request);
 	}
 
-	// Nothing.
-	return (NULL);
+	// The transfer itself is freed by libusb on return.
+	atomic_fetch_sub(&state->configAsyncActive, 1);
+}
+
+static bool spiConfigBatchFlush(davisState state) {
+	if (state->configBatchLength == 0) {
+		return (true);
+	}
+
+	uint16_t length = U16T(state->configBatchLength * DAVIS_CONFIG_BATCH_TUPLE_SIZE);
+	uint16_t count = state->configBatchLength;
+
+	state->configBatchLength = 0;
+
+	return (usbTransportControl(&state->transport,
+		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+		VENDOR_REQUEST_FPGA_CONFIG_MULTIPLE, count, 0, state->configBatch, length, 0) == length);
 }
 
-static bool spiConfigSend(libusb_device_handle *devHandle, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param) {
+static bool spiConfigSend(davisState state, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param) {
+	atomic_uint_fast64_t *shadow = spiConfigShadow(state, moduleAddr, paramAddr);
+
+	mtx_lock(&state->configLock);
+
+	if (state->configBatchDepth != 0) {
+		if (shadow != NULL) {
+			atomic_store_explicit(shadow, DAVIS_CONFIG_SHADOW_VALID | param, memory_order_relaxed);
+		}
+
+		// Batching: append a tuple, send when full. Failures are reported at the end.
+		uint8_t *spiConfig = state->configBatch + (state->configBatchLength * DAVIS_CONFIG_BATCH_TUPLE_SIZE);
+
+		spiConfig[0] = moduleAddr;
+		spiConfig[1] = paramAddr;
+		spiConfig[2] = U8T(param >> 24);
+		spiConfig[3] = U8T(param >> 16);
+		spiConfig[4] = U8T(param >> 8);
+		spiConfig[5] = U8T(param >> 0);
+
+		state->configBatchLength++;
+
+		if (state->configBatchLength == DAVIS_CONFIG_BATCH_MAX && !spiConfigBatchFlush(state)) {
+			state->configBatchFailed = true;
+		}
+
+		mtx_unlock(&state->configLock);
+
+		return (true);
+	}
+
 	uint8_t spiConfig[4] = { 0 };
 
 	spiConfig[0] = U8T(param >> 24);
@@ -2301,15 +2667,167 @@ static bool spiConfigSend(libusb_device_handle *devHandle, uint8_t moduleAddr, u
 	spiConfig[2] = U8T(param >> 8);
 	spiConfig[3] = U8T(param >> 0);
 
-	return (libusb_control_transfer(devHandle,
+	bool success = (usbTransportControl(&state->transport,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		VENDOR_REQUEST_FPGA_CONFIG, moduleAddr, paramAddr, spiConfig, sizeof(spiConfig), 0) == sizeof(spiConfig));
+
+	if (shadow != NULL) {
+		// On failure the device value is unknown: read it again next time.
+		atomic_store_explicit(shadow, (success) ? (DAVIS_CONFIG_SHADOW_VALID | param) : (0), memory_order_relaxed);
+	}
+
+	mtx_unlock(&state->configLock);
+
+	return (success);
 }
 
-static bool spiConfigReceive(libusb_device_handle *devHandle, uint8_t moduleAddr, uint8_t paramAddr, uint32_t *param) {
+static bool spiConfigReceive(davisState state, uint8_t moduleAddr, uint8_t paramAddr, uint32_t *param) {
+	atomic_uint_fast64_t *shadow = spiConfigShadow(state, moduleAddr, paramAddr);
+
+	if (shadow != NULL) {
+		uint_fast64_t shadowValue = atomic_load_explicit(shadow, memory_order_relaxed);
+
+		if ((shadowValue & DAVIS_CONFIG_SHADOW_VALID) != 0) {
+			*param = U32T(shadowValue);
+			return (true);
+		}
+	}
+
+	struct spi_config_deferred_read *deferred = spiConfigDeferredRead;
+
+	if (deferred != NULL && deferred->state == state) {
+		// Asynchronous get: use the value read for it, or note what must be read.
+		if (deferred->haveValue && deferred->valueModuleAddr == moduleAddr && deferred->valueParamAddr == paramAddr) {
+			*param = deferred->value;
+			return (true);
+		}
+
+		if (!deferred->missed) {
+			deferred->missed = true;
+			deferred->missModuleAddr = moduleAddr;
+			deferred->missParamAddr = paramAddr;
+		}
+
+		return (false);
+	}
+
+	if (!spiConfigRead(&state->transport, moduleAddr, paramAddr, param)) {
+		return (false);
+	}
+
+	spiConfigShadowFill(state, moduleAddr, paramAddr, *param);
+
+	return (true);
+}
+
+// Configuration registers kept in the shadow. SYSINFO changes outside of the host's
+// control (master/slave status depends on the synchronization cable), so it's always
+// read from the device; read-only parameters elsewhere are fixed and cached once read.
+static atomic_uint_fast64_t *spiConfigShadow(davisState state, uint8_t moduleAddr, uint8_t paramAddr) {
+	if (moduleAddr >= DAVIS_CONFIG_SHADOW_MODULES || moduleAddr == DAVIS_CONFIG_SYSINFO) {
+		return (NULL);
+	}
+
+	return (&state->configShadow[moduleAddr][paramAddr]);
+}
+
+// Store a value read from the device, unless a write happened meanwhile, that is more recent.
+static void spiConfigShadowFill(davisState state, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param) {
+	atomic_uint_fast64_t *shadow = spiConfigShadow(state, moduleAddr, paramAddr);
+
+	if (shadow != NULL) {
+		uint_fast64_t invalid = 0;
+		atomic_compare_exchange_strong_explicit(shadow, &invalid, DAVIS_CONFIG_SHADOW_VALID | param,
+			memory_order_relaxed, memory_order_relaxed);
+	}
+}
+
+// Pending read of spiConfigPrefetch(), filling the shadow on completion.
+// Owned by its transfer and freed by the call-back.
+struct spi_config_prefetch {
+	davisState state;
+	uint8_t moduleAddr;
+	uint8_t paramAddr;
+};
+
+// Read the given registers not yet in the shadow into it, with all reads in flight
+// at the same time, so later spiConfigReceive() calls find them there. Registers
+// that couldn't be read are simply not filled, spiConfigReceive() then retries.
+// Completions are handled by the calling thread, so the Data Acquisition Thread
+// must not be running. Each read times out on its own; should event handling
+// fail, reads still in flight complete later and only fill the shadow.
+static void spiConfigPrefetch(davisState state, const uint8_t registers[][2], size_t registersLength) {
+	for (size_t i = 0; i < registersLength && i < DAVIS_CONFIG_PREFETCH_MAX; i++) {
+		atomic_uint_fast64_t *shadow = spiConfigShadow(state, registers[i][0], registers[i][1]);
+
+		if (shadow == NULL
+			|| (atomic_load_explicit(shadow, memory_order_relaxed) & DAVIS_CONFIG_SHADOW_VALID) != 0) {
+			continue;
+		}
+
+		struct spi_config_prefetch *prefetch = malloc(sizeof(*prefetch));
+		if (prefetch == NULL) {
+			continue;
+		}
+
+		prefetch->state = state;
+		prefetch->moduleAddr = registers[i][0];
+		prefetch->paramAddr = registers[i][1];
+
+		// Counted before submission, the call-back may run on another thread right away.
+		atomic_fetch_add_explicit(&state->configPrefetchPending, 1, memory_order_relaxed);
+
+		if (usbTransportControlAsync(&state->transport,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE, VENDOR_REQUEST_FPGA_CONFIG,
+			registers[i][0], registers[i][1], NULL, 4, DAVIS_CONFIG_PREFETCH_TIMEOUT, &spiConfigPrefetchCallback,
+			prefetch) != LIBUSB_SUCCESS) {
+			atomic_fetch_sub_explicit(&state->configPrefetchPending, 1, memory_order_relaxed);
+			free(prefetch);
+		}
+	}
+
+	struct timeval te = { .tv_sec = 0, .tv_usec = 100000 };
+
+	while (atomic_load_explicit(&state->configPrefetchPending, memory_order_acquire) > 0) {
+		int result = usbTransportHandleEvents(&state->transport, &te);
+
+		if (result != LIBUSB_SUCCESS && result != LIBUSB_ERROR_INTERRUPTED) {
+			caerLog(CAER_LOG_WARNING, __func__, "Unable to handle USB events while prefetching configuration. Error: %s (%d).",
+				libusb_strerror(result), result);
+			break;
+		}
+	}
+}
+
+static void LIBUSB_CALL spiConfigPrefetchCallback(struct libusb_transfer *transfer) {
+	struct spi_config_prefetch *prefetch = transfer->user_data;
+
+	if (transfer->status == LIBUSB_TRANSFER_COMPLETED && transfer->actual_length == 4) {
+		uint8_t *data = libusb_control_transfer_get_data(transfer);
+		uint32_t value = U32T(data[0] << 24) | U32T(data[1] << 16) | U32T(data[2] << 8) | U32T(data[3] << 0);
+
+		spiConfigShadowFill(prefetch->state, prefetch->moduleAddr, prefetch->paramAddr, value);
+	}
+
+	// Release: the shadow fill above is visible once the waiting thread sees the decrement.
+	atomic_fetch_sub_explicit(&prefetch->state->configPrefetchPending, 1, memory_order_release);
+
+	// The transfer itself is freed by libusb on return.
+	free(prefetch);
+}
+
+static void spiConfigShadowInvalidate(davisState state) {
+	for (size_t i = 0; i < DAVIS_CONFIG_SHADOW_MODULES; i++) {
+		for (size_t j = 0; j < DAVIS_CONFIG_SHADOW_PARAMS; j++) {
+			atomic_store_explicit(&state->configShadow[i][j], 0, memory_order_relaxed);
+		}
+	}
+}
+
+static bool spiConfigRead(usbTransport transport, uint8_t moduleAddr, uint8_t paramAddr, uint32_t *param) {
 	uint8_t spiConfig[4] = { 0 };
 
-	if (libusb_control_transfer(devHandle, LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+	if (usbTransportControl(transport, LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 	VENDOR_REQUEST_FPGA_CONFIG, moduleAddr, paramAddr, spiConfig, sizeof(spiConfig), 0) != sizeof(spiConfig)) {
 		return (false);
 	}
@@ -2431,7 +2949,10 @@ static libusb_device_handle *davisDeviceOpen(libusb_context *devContext, uint16_
 				// Communication with device open, get logic version information.
 				uint32_t param32 = 0;
 
-				spiConfigReceive(devHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_VERSION, &param32);
+				struct usb_transport transport = { .deviceContext = devContext, .deviceHandle = devHandle,
+					.simulation = NULL };
+
+				spiConfigRead(&transport, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_VERSION, &param32);
 				uint16_t logicVersion = U16T(param32);
 
 				// Verify device logic version.
@@ -2465,6 +2986,19 @@ static void davisDeviceClose(libusb_device_handle *devHandle) {
 	libusb_close(devHandle);
 }
 
+static void davisTransportClose(davisState state) {
+	if (state->transport.simulation != NULL) {
+		usbSimulationDestroy(state->transport.simulation);
+		state->transport.simulation = NULL;
+		return;
+	}
+
+	davisDeviceClose(state->transport.deviceHandle);
+
+	// Destroy libusb context.
+	libusb_exit(state->transport.deviceContext);
+}
+
 static void davisAllocateTransfers(davisHandle handle, uint32_t bufferNum, uint32_t bufferSize) {
 	davisState state = &handle->state;
 
@@ -2500,7 +3034,7 @@ static void davisAllocateTransfers(davisHandle handle, uint32_t bufferNum, uint3
 		}
 
 		// Initialize Transfer.
-		state->dataTransfers[i]->dev_handle = state->deviceHandle;
+		state->dataTransfers[i]->dev_handle = state->transport.deviceHandle;
 		state->dataTransfers[i]->endpoint = DAVIS_DATA_ENDPOINT;
 		state->dataTransfers[i]->type = LIBUSB_TRANSFER_TYPE_BULK;
 		state->dataTransfers[i]->callback = &davisLibUsbCallback;
@@ -2508,7 +3042,7 @@ static void davisAllocateTransfers(davisHandle handle, uint32_t bufferNum, uint3
 		state->dataTransfers[i]->timeout = 0;
 		state->dataTransfers[i]->flags = LIBUSB_TRANSFER_FREE_BUFFER;
 
-		if ((errno = libusb_submit_transfer(state->dataTransfers[i])) == LIBUSB_SUCCESS) {
+		if ((errno = usbTransportSubmit(&state->transport, state->dataTransfers[i])) == LIBUSB_SUCCESS) {
 			state->activeDataTransfers++;
 		}
 		else {
@@ -2540,7 +3074,7 @@ static void davisDeallocateTransfers(davisHandle handle) {
 	// Cancel all current transfers first.
 	for (size_t i = 0; i < state->dataTransfersLength; i++) {
 		if (state->dataTransfers[i] != NULL) {
-			errno = libusb_cancel_transfer(state->dataTransfers[i]);
+			errno = usbTransportCancel(&state->transport, state->dataTransfers[i]);
 			if (errno != LIBUSB_SUCCESS && errno != LIBUSB_ERROR_NOT_FOUND) {
 				caerLog(CAER_LOG_CRITICAL, handle->info.deviceString,
 					"Unable to cancel libusb transfer %zu. Error: %s (%d).", i, libusb_strerror(errno), errno);
@@ -2553,7 +3087,7 @@ static void davisDeallocateTransfers(davisHandle handle) {
 	struct timeval te = { .tv_sec = 0, .tv_usec = 100000 };
 
 	while (state->activeDataTransfers > 0) {
-		libusb_handle_events_timeout(state->deviceContext, &te);
+		usbTransportHandleEvents(&state->transport, &te);
 	}
 
 	// The buffers and transfers have been deallocated in the callback.
@@ -2567,14 +3101,25 @@ static void LIBUSB_CALL davisLibUsbCallback(struct libusb_transfer *transfer) {
 	davisHandle handle = transfer->user_data;
 	davisState state = &handle->state;
 
+	CAER_PROBE3(usb_transfer, handle->info.deviceID, (int) transfer->status, transfer->actual_length);
+
 	if (transfer->status == LIBUSB_TRANSFER_COMPLETED) {
+		deviceStatsIncrease(&state->stats.usbTransfersCompleted, 1);
+		deviceStatsIncrease(&state->stats.bytesReceived, U64T(transfer->actual_length));
+
 		// Handle data.
 		davisEventTranslator(handle, transfer->buffer, (size_t) transfer->actual_length);
+
+		CAER_PROBE2(translator_exit, handle->info.deviceID, transfer->actual_length);
+	}
+	else if (transfer->status != LIBUSB_TRANSFER_CANCELLED) {
+		deviceStatsIncrease(&state->stats.usbTransfersFailed, 1);
 	}
 
 	if (transfer->status != LIBUSB_TRANSFER_CANCELLED && transfer->status != LIBUSB_TRANSFER_NO_DEVICE) {
 		// Submit transfer again.
-		if (libusb_submit_transfer(transfer) == LIBUSB_SUCCESS) {
+		if (usbTransportSubmit(&state->transport, transfer) == LIBUSB_SUCCESS) {
+			deviceStatsIncrease(&state->stats.usbTransfersResubmitted, 1);
 			return;
 		}
 	}
@@ -2604,7 +3149,7 @@ static inline void initContainerCommitTimestamp(davisState state) {
 	}
 }
 
-static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t bytesSent) {
+void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t bytesSent) {
 	davisState state = &handle->state;
 
 	// Return right away if not running anymore. This prevents useless work if many
@@ -2615,6 +3160,15 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 		return;
 	}
 
+	// This is called on USB transfer completion, remember when for latency tracking.
+	int64_t transferTimestamp = dataExchangeHostTime();
+
+	CAER_PROBE3(translator_entry, handle->info.deviceID, bytesSent, transferTimestamp);
+
+	if (caerEventPacketContainerGetHostTransferTimestamp(state->currentPacketContainer) == -1) {
+		caerEventPacketContainerSetHostTransferTimestamp(state->currentPacketContainer, transferTimestamp);
+	}
+
 	// Truncate off any extra partial event.
 	if ((bytesSent & 0x01) != 0) {
 		caerLog(CAER_LOG_ALERT, handle->info.deviceString,
@@ -2630,6 +3184,8 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 				caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to allocate event packet container.");
 				return;
 			}
+
+			caerEventPacketContainerSetHostTransferTimestamp(state->currentPacketContainer, transferTimestamp);
 		}
 
 		if (state->currentPolarityPacket == NULL) {
@@ -2652,6 +3208,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			}
 
 			state->currentPolarityPacket = grownPacket;
+			deviceStatsIncrease(&state->stats.packetGrows, 1);
 		}
 
 		if (state->currentSpecialPacket == NULL) {
@@ -2674,6 +3231,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			}
 
 			state->currentSpecialPacket = grownPacket;
+			deviceStatsIncrease(&state->stats.packetGrows, 1);
 		}
 
 		if (state->currentFramePacket == NULL) {
@@ -2697,6 +3255,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			}
 
 			state->currentFramePacket = grownPacket;
+			deviceStatsIncrease(&state->stats.packetGrows, 1);
 		}
 
 		if (state->currentIMU6Packet == NULL) {
@@ -2719,6 +3278,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			}
 
 			state->currentIMU6Packet = grownPacket;
+			deviceStatsIncrease(&state->stats.packetGrows, 1);
 		}
 
 		bool tsReset = false;
@@ -2746,6 +3306,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 					switch (data) {
 						case 0: // Ignore this, but log it.
 							caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Caught special reserved event!");
+							deviceStatsIncrease(&state->stats.invalidEvents, 1);
 							break;
 
 						case 1: { // Timetamp reset
@@ -2757,6 +3318,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 							initContainerCommitTimestamp(state);
 
 							caerLog(CAER_LOG_INFO, handle->info.deviceString, "Timestamp reset event received.");
+							deviceStatsIncrease(&state->stats.timestampResets, 1);
 
 							// Defer timestamp reset event to later, so we commit it
 							// alone, in its own packet.
@@ -3274,6 +3836,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 						default:
 							caerLog(CAER_LOG_ERROR, handle->info.deviceString,
 								"Caught special event that can't be handled: %d.", data);
+							deviceStatsIncrease(&state->stats.invalidEvents, 1);
 							break;
 					}
 					break;
@@ -3283,6 +3846,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 					if (data >= state->dvsSizeY) {
 						caerLog(CAER_LOG_ALERT, handle->info.deviceString,
 							"DVS: Y address out of range (0-%d): %" PRIu16 ".", state->dvsSizeY - 1, data);
+						deviceStatsIncrease(&state->stats.invalidEvents, 1);
 						break; // Skip invalid Y address (don't update lastY).
 					}
 
@@ -3312,6 +3876,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 					if (data >= state->dvsSizeX) {
 						caerLog(CAER_LOG_ALERT, handle->info.deviceString,
 							"DVS: X address out of range (0-%d): %" PRIu16 ".", state->dvsSizeX - 1, data);
+						deviceStatsIncrease(&state->stats.invalidEvents, 1);
 						break; // Skip invalid event.
 					}
 
@@ -3615,6 +4180,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 						default:
 							caerLog(CAER_LOG_ERROR, handle->info.deviceString,
 								"Caught Misc8 event that can't be handled.");
+							deviceStatsIncrease(&state->stats.invalidEvents, 1);
 							break;
 					}
 
@@ -3649,6 +4215,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 
 						// Commit packets to separate before wrap from after cleanly.
 						tsBigWrap = true;
+						deviceStatsIncrease(&state->stats.timestampBigWraps, 1);
 					}
 					else {
 						// Each wrap is 2^15 µs (~32ms), and we have
@@ -3673,6 +4240,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 
 				default:
 					caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Caught event that can't be handled.");
+					deviceStatsIncrease(&state->stats.invalidEvents, 1);
 					break;
 			}
 		}
@@ -3701,6 +4269,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			if (state->currentPolarityPacketPosition > 0) {
 				caerEventPacketContainerSetEventPacket(state->currentPacketContainer, POLARITY_EVENT,
 					(caerEventPacketHeader) state->currentPolarityPacket);
+				deviceStatsIncrease(&state->stats.polarityEvents, U64T(state->currentPolarityPacketPosition));
 
 				state->currentPolarityPacket = NULL;
 				state->currentPolarityPacketPosition = 0;
@@ -3710,6 +4279,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			if (state->currentSpecialPacketPosition > 0) {
 				caerEventPacketContainerSetEventPacket(state->currentPacketContainer, SPECIAL_EVENT,
 					(caerEventPacketHeader) state->currentSpecialPacket);
+				deviceStatsIncrease(&state->stats.specialEvents, U64T(state->currentSpecialPacketPosition));
 
 				state->currentSpecialPacket = NULL;
 				state->currentSpecialPacketPosition = 0;
@@ -3719,6 +4289,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			if (state->currentFramePacketPosition > 0) {
 				caerEventPacketContainerSetEventPacket(state->currentPacketContainer, FRAME_EVENT,
 					(caerEventPacketHeader) state->currentFramePacket);
+				deviceStatsIncrease(&state->stats.frameEvents, U64T(state->currentFramePacketPosition));
 
 				state->currentFramePacket = NULL;
 				state->currentFramePacketPosition = 0;
@@ -3728,6 +4299,7 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			if (state->currentIMU6PacketPosition > 0) {
 				caerEventPacketContainerSetEventPacket(state->currentPacketContainer, IMU6_EVENT,
 					(caerEventPacketHeader) state->currentIMU6Packet);
+				deviceStatsIncrease(&state->stats.imu6Events, U64T(state->currentIMU6PacketPosition));
 
 				state->currentIMU6Packet = NULL;
 				state->currentIMU6PacketPosition = 0;
@@ -3760,23 +4332,29 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 			// Filter out completely empty commits. This can happen when data is turned off,
 			// but the timestamps are still going forward.
 			if (emptyContainerCommit) {
+				deviceStatsIncrease(&state->stats.containersEmptyDiscarded, 1);
+
 				caerEventPacketContainerFree(state->currentPacketContainer);
 				state->currentPacketContainer = NULL;
 			}
 			else {
-				if (!ringBufferPut(state->dataExchangeBuffer, state->currentPacketContainer)) {
+				CAER_PROBE_CONTAINER_CAPTURE(probe, state->currentPacketContainer);
+
+				if (!dataExchangePut(&state->dataExchange, state->currentPacketContainer,
+					&state->dataAcquisitionThreadRun)) {
 					// Failed to forward packet container, just drop it, it doesn't contain
 					// any critical information anyway.
 					caerLog(CAER_LOG_INFO, handle->info.deviceString,
 						"Dropped EventPacket Container because ring-buffer full!");
+					deviceStatsIncrease(&state->stats.containersDropped, 1);
+
+					CAER_PROBE_CONTAINER(container_drop, handle->info.deviceID, probe);
 
 					caerEventPacketContainerFree(state->currentPacketContainer);
 					state->currentPacketContainer = NULL;
 				}
 				else {
-					if (state->dataNotifyIncrease != NULL) {
-						state->dataNotifyIncrease(state->dataNotifyUserPtr);
-					}
+					CAER_PROBE_CONTAINER(container_commit, handle->info.deviceID, probe);
 
 					state->currentPacketContainer = NULL;
 				}
@@ -3797,6 +4375,8 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 					return;
 				}
 
+				caerEventPacketContainerSetHostTransferTimestamp(tsResetContainer, transferTimestamp);
+
 				// Allocate special packet just for this event.
 				caerSpecialEventPacket tsResetPacket = caerSpecialEventPacketAllocate(1, I16T(handle->info.deviceID),
 					state->wrapOverflow);
@@ -3819,18 +4399,15 @@ static void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t byt
 				// Reset MUST be committed, always, else downstream data processing and
 				// outputs get confused if they have no notification of timestamps
 				// jumping back go zero.
-				while (!ringBufferPut(state->dataExchangeBuffer, tsResetContainer)) {
-					// Prevent dead-lock if shutdown is requested and nothing is consuming
-					// data anymore, but the ring-buffer is full (and would thus never empty),
-					// thus blocking the USB handling thread in this loop.
-					if (!atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
-						return;
-					}
-				}
+				// This waits until it succeeds, unless shutdown is requested.
+				deviceStatsIncrease(&state->stats.specialEvents, 1);
+
+				if (!dataExchangePutForced(&state->dataExchange, tsResetContainer,
+					&state->dataAcquisitionThreadRun)) {
+					deviceStatsIncrease(&state->stats.containersDropped, 1);
 
-				// Signal new container as usual.
-				if (state->dataNotifyIncrease != NULL) {
-					state->dataNotifyIncrease(state->dataNotifyUserPtr);
+					caerEventPacketContainerFree(tsResetContainer);
+					return;
 				}
 			}
 		}
@@ -3850,8 +4427,10 @@ static int davisDataAcquisitionThread(void *inPtr) {
 	// Reset configuration update, so as to not re-do work afterwards.
 	atomic_store(&state->dataAcquisitionThreadConfigUpdate, 0);
 
-	if (atomic_load(&state->dataExchangeStartProducers)) {
-		// Enable data transfer on USB end-point 2.
+	if (atomic_load(&state->dataExchange.startProducers)) {
+		// Enable data transfer on USB end-point 2, all in one request.
+		davisCommonConfigBatchBegin(handle);
+
 		davisCommonConfigSet(handle, DAVIS_CONFIG_USB, DAVIS_CONFIG_USB_RUN, true);
 		davisCommonConfigSet(handle, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_RUN, true);
 		davisCommonConfigSet(handle, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_TIMESTAMP_RUN, true);
@@ -3859,14 +4438,22 @@ static int davisDataAcquisitionThread(void *inPtr) {
 		davisCommonConfigSet(handle, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RUN, true);
 		davisCommonConfigSet(handle, DAVIS_CONFIG_IMU, DAVIS_CONFIG_IMU_RUN, true);
 		davisCommonConfigSet(handle, DAVIS_CONFIG_EXTINPUT, DAVIS_CONFIG_EXTINPUT_RUN_DETECTOR, true);
+
+		davisCommonConfigBatchEnd(handle);
 	}
 
 	// Create buffers as specified in config file.
 	davisAllocateTransfers(handle, U32T(atomic_load(&state->usbBufferNumber)),
 		U32T(atomic_load(&state->usbBufferSize)));
 
+	// Asynchronous configuration requests are completed by this thread from now on.
+	mtx_lock(&state->configLock);
+	state->configAsyncAccept = true;
+	mtx_unlock(&state->configLock);
+
 	// Signal data thread ready back to start function.
 	atomic_store(&state->dataAcquisitionThreadRun, true);
+	threadReadySignal(&state->dataAcquisitionThreadReady);
 
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "data acquisition thread ready to process events.");
 
@@ -3880,11 +4467,33 @@ static int davisDataAcquisitionThread(void *inPtr) {
 			davisDataAcquisitionThreadConfig(handle);
 		}
 
-		libusb_handle_events_timeout(state->deviceContext, &te);
+		// If containers are waiting in the overflow list, don't wait long for
+		// new USB data, but retry forwarding them to the consumer quickly.
+		if (dataExchangeSpillPending(&state->dataExchange)) {
+			struct timeval teSpill = { .tv_sec = 0, .tv_usec = 1000 };
+
+			usbTransportHandleEvents(&state->transport, &teSpill);
+
+			dataExchangeSpillFlush(&state->dataExchange);
+		}
+		else {
+			usbTransportHandleEvents(&state->transport, &te);
+		}
 	}
 
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "shutting down data acquisition thread ...");
 
+	// Stop taking asynchronous configuration requests, and complete those in flight.
+	mtx_lock(&state->configLock);
+	state->configAsyncAccept = false;
+	mtx_unlock(&state->configLock);
+
+	struct timeval teConfig = { .tv_sec = 0, .tv_usec = 100000 };
+
+	while (atomic_load(&state->configAsyncActive) > 0) {
+		usbTransportHandleEvents(&state->transport, &teConfig);
+	}
+
 	// Cancel all transfers and handle them.
 	davisDeallocateTransfers(handle);
 
@@ -3919,7 +4528,7 @@ static void davisDataAcquisitionThreadConfig(davisHandle handle) {
 		// inside asynchronous callback.
 		uint32_t param32 = 0;
 
-		spiConfigReceive(state->deviceHandle, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_DEVICE_IS_MASTER, &param32);
+		spiConfigReceive(state, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_DEVICE_IS_MASTER, &param32);
 
 		atomic_thread_fence(memory_order_seq_cst);
 		handle->info.deviceIsMaster = param32;
@@ -2,7 +2,12 @@
 #define LIBCAER_SRC_DAVIS_COMMON_H_
 
 #include "devices/davis.h"
-#include "ringbuffer/ringbuffer.h"
+#include "data_exchange.h"
+#include "device_stats.h"
+#include "usb_transport.h"
+#include "config_transaction.h"
+#include "thread_ready.h"
+#include "visibility.h"
 #include <stdatomic.h>
 #include <libusb.h>
 
@@ -45,28 +50,53 @@
 #define VENDOR_REQUEST_FPGA_CONFIG          0xBF
 #define VENDOR_REQUEST_FPGA_CONFIG_MULTIPLE 0xC2
 
+// Configuration tuples (module, parameter, 32 bit value) per multi-config transfer.
+// 10 tuples of 6 bytes fit into one 64 byte control endpoint packet.
+#define DAVIS_CONFIG_BATCH_TUPLE_SIZE 6
+#define DAVIS_CONFIG_BATCH_MAX 10
+
+// Register reads in flight at the same time when prefetching into the shadow,
+// and how long to wait for each of them (in ms).
+#define DAVIS_CONFIG_PREFETCH_MAX 16
+#define DAVIS_CONFIG_PREFETCH_TIMEOUT 1000
+
+// Host-side copy of the device configuration, for all logic modules up to
+// DAVIS_CONFIG_USB. Entries hold the value and a valid flag.
+#define DAVIS_CONFIG_SHADOW_MODULES (DAVIS_CONFIG_USB + 1)
+#define DAVIS_CONFIG_SHADOW_PARAMS 256
+#define DAVIS_CONFIG_SHADOW_VALID (UINT64_C(1) << 32)
+
 struct davis_state {
 	// Data Acquisition Thread -> Mainloop Exchange
-	RingBuffer dataExchangeBuffer;
-	atomic_uint_fast32_t dataExchangeBufferSize; // Only takes effect on DataStart() calls!
-	atomic_bool dataExchangeBlocking;
-	atomic_bool dataExchangeStartProducers;
-	atomic_bool dataExchangeStopProducers;
-	void (*dataNotifyIncrease)(void *ptr);
-	void (*dataNotifyDecrease)(void *ptr);
-	void *dataNotifyUserPtr;
+	struct data_exchange dataExchange;
 	void (*dataShutdownNotify)(void *ptr);
 	void *dataShutdownUserPtr;
+	// Performance counters, written by the Data Acquisition Thread
+	struct device_stats stats;
 	// USB Device State
 	char deviceThreadName[15 + 1]; // +1 for terminating NUL character.
-	libusb_context *deviceContext;
-	libusb_device_handle *deviceHandle;
+	struct usb_transport transport;
+	// Configuration writes and batches are serialized per device (recursive lock).
+	mtx_t configLock;
+	// Asynchronous configuration requests, completed by the Data Acquisition Thread.
+	bool configAsyncAccept; // Protected by configLock.
+	atomic_uint_fast32_t configAsyncActive;
+	// Batched configuration: tuples collected and sent together.
+	uint8_t configBatch[DAVIS_CONFIG_BATCH_MAX * DAVIS_CONFIG_BATCH_TUPLE_SIZE];
+	uint16_t configBatchLength;
+	uint16_t configBatchDepth;
+	bool configBatchFailed;
+	// Configuration shadow: written through on every write, serves reads.
+	atomic_uint_fast64_t configShadow[DAVIS_CONFIG_SHADOW_MODULES][DAVIS_CONFIG_SHADOW_PARAMS];
+	// Prefetch reads not yet completed, decremented by their call-back.
+	atomic_size_t configPrefetchPending;
 	// USB Transfer Settings
 	atomic_uint_fast32_t usbBufferNumber;
 	atomic_uint_fast32_t usbBufferSize;
 	// Data Acquisition Thread
 	thrd_t dataAcquisitionThread;
 	atomic_bool dataAcquisitionThreadRun;
+	struct thread_ready dataAcquisitionThreadReady;
 	atomic_uint_fast32_t dataAcquisitionThreadConfigUpdate;
 	struct libusb_transfer **dataTransfers;
 	size_t dataTransfersLength;
@@ -145,7 +175,7 @@ typedef struct davis_handle *davisHandle;
 
 bool davisCommonOpen(davisHandle handle, uint16_t VID, uint16_t PID, uint8_t DID_TYPE, const char *deviceName,
 	uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict, const char *serialNumberRestrict,
-	uint16_t requiredLogicRevision, uint16_t requiredFirmwareVersion);
+	uint16_t requiredLogicRevision, uint16_t requiredFirmwareVersion, bool simulated);
 bool davisCommonClose(davisHandle handle);
 
 bool davisCommonSendDefaultFPGAConfig(caerDeviceHandle cdh,
@@ -156,10 +186,35 @@ bool davisCommonSendDefaultChipConfig(caerDeviceHandle cdh,
 bool davisCommonConfigSet(davisHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param);
 bool davisCommonConfigGet(davisHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t *param);
 
+bool davisCommonConfigSetAsync(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param,
+	caerDeviceConfigCallback callback, void *callbackPtr);
+bool davisCommonConfigGetAsync(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr,
+	caerDeviceConfigCallback callback, void *callbackPtr);
+bool davisCommonConfigTransactionCommit(caerDeviceHandle handle, caerDeviceConfigTransaction transaction, bool pause);
+
+// Between Begin and End, configuration writes to the device are collected and
+// sent in as few multi-config transfers as possible, in order. Can be nested,
+// only the outermost End sends. End returns false if any write failed.
+// The calling thread holds the configuration lock from Begin to End.
+// Reads see the written values right away, served from the configuration shadow.
+void davisCommonConfigBatchBegin(davisHandle handle);
+bool davisCommonConfigBatchEnd(davisHandle handle);
+
 bool davisCommonDataStart(caerDeviceHandle handle, void (*dataNotifyIncrease)(void *ptr),
 	void (*dataNotifyDecrease)(void *ptr), void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr),
 	void *dataShutdownUserPtr);
 bool davisCommonDataStop(caerDeviceHandle handle);
 caerEventPacketContainer davisCommonDataGet(caerDeviceHandle handle);
+size_t davisCommonDataGetMany(caerDeviceHandle handle, caerEventPacketContainer *containers, size_t maxContainers);
+bool davisCommonDataNotifyDecreaseManySet(caerDeviceHandle handle, void (*dataNotifyDecreaseMany)(void *ptr, size_t count));
+bool davisCommonLatencyStatsGet(caerDeviceHandle handle, uint8_t stage, struct caer_latency_stats *stats);
+bool davisCommonLatencyStatsReset(caerDeviceHandle handle);
+bool davisCommonStatsGet(caerDeviceHandle handle, struct caer_device_stats *stats);
+
+// Data path without the USB device, also used by the translator benchmarks.
+// The state (sizes, ROI, IMU scales) must be set up before calling these.
+CAER_INTERNAL bool davisCommonDataMemoryInit(davisHandle handle);
+CAER_INTERNAL void davisCommonDataMemoryFree(davisHandle handle);
+CAER_INTERNAL void davisEventTranslator(davisHandle handle, uint8_t *buffer, size_t bytesSent);
 
 #endif /* LIBCAER_SRC_DAVIS_COMMON_H_ */
@@ -1,7 +1,7 @@
 #include "davis_fx2.h"
 
-caerDeviceHandle davisFX2Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
-	const char *serialNumberRestrict) {
+static caerDeviceHandle davisFX2OpenInternal(uint16_t deviceID, uint8_t busNumberRestrict,
+	uint8_t devAddressRestrict, const char *serialNumberRestrict, bool simulated) {
 	caerLog(CAER_LOG_DEBUG, __func__, "Initializing %s.", DAVIS_FX2_DEVICE_NAME);
 
 	davisFX2Handle handle = calloc(1, sizeof(*handle));
@@ -17,7 +17,7 @@ caerDeviceHandle davisFX2Open(uint16_t deviceID, uint8_t busNumberRestrict, uint
 	bool openRetVal = davisCommonOpen((davisHandle) handle, DAVIS_FX2_DEVICE_VID, DAVIS_FX2_DEVICE_PID,
 	DAVIS_FX2_DEVICE_DID_TYPE, DAVIS_FX2_DEVICE_NAME, deviceID, busNumberRestrict, devAddressRestrict,
 		serialNumberRestrict, DAVIS_FX2_REQUIRED_LOGIC_REVISION,
-		DAVIS_FX2_REQUIRED_FIRMWARE_VERSION);
+		DAVIS_FX2_REQUIRED_FIRMWARE_VERSION, simulated);
 	if (!openRetVal) {
 		free(handle);
 
@@ -28,6 +28,15 @@ caerDeviceHandle davisFX2Open(uint16_t deviceID, uint8_t busNumberRestrict, uint
 	return ((caerDeviceHandle) handle);
 }
 
+caerDeviceHandle davisFX2Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
+	const char *serialNumberRestrict) {
+	return (davisFX2OpenInternal(deviceID, busNumberRestrict, devAddressRestrict, serialNumberRestrict, false));
+}
+
+caerDeviceHandle davisFX2OpenSimulated(uint16_t deviceID) {
+	return (davisFX2OpenInternal(deviceID, 0, 0, NULL, true));
+}
+
 bool davisFX2Close(caerDeviceHandle cdh) {
 	caerLog(CAER_LOG_DEBUG, ((davisHandle) cdh)->info.deviceString, "Shutting down ...");
 
@@ -5,8 +5,8 @@ static void deallocateDebugTransfers(davisFX3Handle handle);
 static void LIBUSB_CALL libUsbDebugCallback(struct libusb_transfer *transfer);
 static void debugTranslator(davisFX3Handle handle, uint8_t *buffer, size_t bytesSent);
 
-caerDeviceHandle davisFX3Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
-	const char *serialNumberRestrict) {
+static caerDeviceHandle davisFX3OpenInternal(uint16_t deviceID, uint8_t busNumberRestrict,
+	uint8_t devAddressRestrict, const char *serialNumberRestrict, bool simulated) {
 	caerLog(CAER_LOG_DEBUG, __func__, "Initializing %s.", DAVIS_FX3_DEVICE_NAME);
 
 	davisFX3Handle handle = calloc(1, sizeof(*handle));
@@ -22,7 +22,7 @@ caerDeviceHandle davisFX3Open(uint16_t deviceID, uint8_t busNumberRestrict, uint
 	bool openRetVal = davisCommonOpen((davisHandle) handle, DAVIS_FX3_DEVICE_VID, DAVIS_FX3_DEVICE_PID,
 	DAVIS_FX3_DEVICE_DID_TYPE, DAVIS_FX3_DEVICE_NAME, deviceID, busNumberRestrict, devAddressRestrict,
 		serialNumberRestrict, DAVIS_FX3_REQUIRED_LOGIC_REVISION,
-		DAVIS_FX3_REQUIRED_FIRMWARE_VERSION);
+		DAVIS_FX3_REQUIRED_FIRMWARE_VERSION, simulated);
 	if (!openRetVal) {
 		free(handle);
 
@@ -35,6 +35,15 @@ caerDeviceHandle davisFX3Open(uint16_t deviceID, uint8_t busNumberRestrict, uint
 	return ((caerDeviceHandle) handle);
 }
 
+caerDeviceHandle davisFX3Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
+	const char *serialNumberRestrict) {
+	return (davisFX3OpenInternal(deviceID, busNumberRestrict, devAddressRestrict, serialNumberRestrict, false));
+}
+
+caerDeviceHandle davisFX3OpenSimulated(uint16_t deviceID) {
+	return (davisFX3OpenInternal(deviceID, 0, 0, NULL, true));
+}
+
 bool davisFX3Close(caerDeviceHandle cdh) {
 	caerLog(CAER_LOG_DEBUG, ((davisHandle) cdh)->info.deviceString, "Shutting down ...");
 
@@ -96,7 +105,7 @@ static void allocateDebugTransfers(davisFX3Handle handle) {
 		}
 
 		// Initialize Transfer.
-		handle->debugTransfers[i]->dev_handle = handle->h.state.deviceHandle;
+		handle->debugTransfers[i]->dev_handle = handle->h.state.transport.deviceHandle;
 		handle->debugTransfers[i]->endpoint = DEBUG_ENDPOINT;
 		handle->debugTransfers[i]->type = LIBUSB_TRANSFER_TYPE_INTERRUPT;
 		handle->debugTransfers[i]->callback = &libUsbDebugCallback;
@@ -104,7 +113,7 @@ static void allocateDebugTransfers(davisFX3Handle handle) {
 		handle->debugTransfers[i]->timeout = 0;
 		handle->debugTransfers[i]->flags = LIBUSB_TRANSFER_FREE_BUFFER;
 
-		if ((errno = libusb_submit_transfer(handle->debugTransfers[i])) == LIBUSB_SUCCESS) {
+		if ((errno = usbTransportSubmit(&handle->h.state.transport, handle->debugTransfers[i])) == LIBUSB_SUCCESS) {
 			handle->activeDebugTransfers++;
 		}
 		else {
@@ -131,7 +140,7 @@ static void deallocateDebugTransfers(davisFX3Handle handle) {
 	// Cancel all current transfers first.
 	for (size_t i = 0; i < DEBUG_TRANSFER_NUM; i++) {
 		if (handle->debugTransfers[i] != NULL) {
-			errno = libusb_cancel_transfer(handle->debugTransfers[i]);
+			errno = usbTransportCancel(&handle->h.state.transport, handle->debugTransfers[i]);
 			if (errno != LIBUSB_SUCCESS && errno != LIBUSB_ERROR_NOT_FOUND) {
 				caerLog(CAER_LOG_CRITICAL, handle->h.info.deviceString,
 					"Unable to cancel libusb transfer %zu (debug channel). Error: %s (%d).", i, libusb_strerror(errno),
@@ -145,7 +154,7 @@ static void deallocateDebugTransfers(davisFX3Handle handle) {
 	struct timeval te = { .tv_sec = 0, .tv_usec = 100000 };
 
 	while (handle->activeDebugTransfers > 0) {
-		libusb_handle_events_timeout(handle->h.state.deviceContext, &te);
+		usbTransportHandleEvents(&handle->h.state.transport, &te);
 	}
 }
 
@@ -159,7 +168,7 @@ static void LIBUSB_CALL libUsbDebugCallback(struct libusb_transfer *transfer) {
 
 	if (transfer->status != LIBUSB_TRANSFER_CANCELLED && transfer->status != LIBUSB_TRANSFER_NO_DEVICE) {
 		// Submit transfer again.
-		if (libusb_submit_transfer(transfer) == LIBUSB_SUCCESS) {
+		if (usbTransportSubmit(&handle->h.state.transport, transfer) == LIBUSB_SUCCESS) {
 			return;
 		}
 	}
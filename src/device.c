@@ -1,16 +1,19 @@
 #include "devices/usb.h"
 
+#include "config_transaction.h"
 #include "dvs128.h"
 #include "davis_common.h"
 #include "davis_fx2.h"
 #include "davis_fx3.h"
+#include "file_replay.h"
+#include "probes.h"
 
 /**
  * Number of devices supported by this library.
  */
-#define SUPPORTED_DEVICES_NUMBER 3
+#define SUPPORTED_DEVICES_NUMBER 4
 
-// Supported devices and their functions.
+// Supported devices and their functions. Only USB devices have (simulated) constructors.
 static caerDeviceHandle (*constructors[SUPPORTED_DEVICES_NUMBER])(uint16_t deviceID, uint8_t busNumberRestrict,
 	uint8_t devAddressRestrict, const char *serialNumberRestrict) = {
 		[CAER_DEVICE_DVS128] = &dvs128Open,
@@ -18,30 +21,61 @@ static caerDeviceHandle (*constructors[SUPPORTED_DEVICES_NUMBER])(uint16_t devic
 		[CAER_DEVICE_DAVIS_FX3] = &davisFX3Open
 };
 
+static caerDeviceHandle (*simulatedConstructors[SUPPORTED_DEVICES_NUMBER])(uint16_t deviceID) = {
+	[CAER_DEVICE_DVS128] = &dvs128OpenSimulated,
+	[CAER_DEVICE_DAVIS_FX2] = &davisFX2OpenSimulated,
+	[CAER_DEVICE_DAVIS_FX3] = &davisFX3OpenSimulated
+};
+
 static bool (*destructors[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle) = {
 	[CAER_DEVICE_DVS128] = &dvs128Close,
 	[CAER_DEVICE_DAVIS_FX2] = &davisFX2Close,
-	[CAER_DEVICE_DAVIS_FX3] = &davisFX3Close
+	[CAER_DEVICE_DAVIS_FX3] = &davisFX3Close,
+	[CAER_DEVICE_FILE_REPLAY] = &replayClose
 };
 
 static bool (*defaultConfigSenders[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle) = {
 	[CAER_DEVICE_DVS128] = &dvs128SendDefaultConfig,
 	[CAER_DEVICE_DAVIS_FX2] = &davisFX2SendDefaultConfig,
-	[CAER_DEVICE_DAVIS_FX3] = &davisFX3SendDefaultConfig
+	[CAER_DEVICE_DAVIS_FX3] = &davisFX3SendDefaultConfig,
+	[CAER_DEVICE_FILE_REPLAY] = &replaySendDefaultConfig
 };
 
 static bool (*configSetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr,
 	uint32_t param) = {
 		[CAER_DEVICE_DVS128] = &dvs128ConfigSet,
 		[CAER_DEVICE_DAVIS_FX2] = &davisFX2ConfigSet,
-		[CAER_DEVICE_DAVIS_FX3] = &davisFX3ConfigSet
+		[CAER_DEVICE_DAVIS_FX3] = &davisFX3ConfigSet,
+		[CAER_DEVICE_FILE_REPLAY] = &replayConfigSet
 };
 
 static bool (*configGetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr,
 	uint32_t *param) = {
 		[CAER_DEVICE_DVS128] = &dvs128ConfigGet,
 		[CAER_DEVICE_DAVIS_FX2] = &davisFX2ConfigGet,
-		[CAER_DEVICE_DAVIS_FX3] = &davisFX3ConfigGet
+		[CAER_DEVICE_DAVIS_FX3] = &davisFX3ConfigGet,
+		[CAER_DEVICE_FILE_REPLAY] = &replayConfigGet
+};
+
+// Devices without asynchronous configuration support are NULL here, see caerDeviceConfigSetAsync().
+static bool (*configSettersAsync[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, int8_t modAddr,
+	uint8_t paramAddr, uint32_t param, caerDeviceConfigCallback callback, void *userPtr) = {
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonConfigSetAsync,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonConfigSetAsync
+};
+
+static bool (*configGettersAsync[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, int8_t modAddr,
+	uint8_t paramAddr, caerDeviceConfigCallback callback, void *userPtr) = {
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonConfigGetAsync,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonConfigGetAsync
+};
+
+// Devices without specific transaction support are NULL here, see caerDeviceConfigTransactionCommit().
+static bool (*configTransactionCommitters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle,
+	caerDeviceConfigTransaction transaction, bool pause) = {
+		[CAER_DEVICE_DVS128] = &dvs128ConfigTransactionCommit,
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonConfigTransactionCommit,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonConfigTransactionCommit
 };
 
 static bool (*dataStarters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, void (*dataNotifyIncrease)(void *ptr),
@@ -49,19 +83,60 @@ static bool (*dataStarters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, v
 	void *dataShutdownUserPtr) = {
 		[CAER_DEVICE_DVS128] = &dvs128DataStart,
 		[CAER_DEVICE_DAVIS_FX2] = &davisCommonDataStart,
-		[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataStart
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataStart,
+		[CAER_DEVICE_FILE_REPLAY] = &replayDataStart
 };
 
 static bool (*dataStoppers[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle) = {
 	[CAER_DEVICE_DVS128] = &dvs128DataStop,
 	[CAER_DEVICE_DAVIS_FX2] = &davisCommonDataStop,
-	[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataStop
+	[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataStop,
+	[CAER_DEVICE_FILE_REPLAY] = &replayDataStop
 };
 
 static caerEventPacketContainer (*dataGetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle) = {
 	[CAER_DEVICE_DVS128] = &dvs128DataGet,
 	[CAER_DEVICE_DAVIS_FX2] = &davisCommonDataGet,
-	[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataGet
+	[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataGet,
+	[CAER_DEVICE_FILE_REPLAY] = &replayDataGet
+};
+
+static size_t (*dataGettersMany[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle,
+	caerEventPacketContainer *containers, size_t maxContainers) = {
+		[CAER_DEVICE_DVS128] = &dvs128DataGetMany,
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonDataGetMany,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataGetMany,
+		[CAER_DEVICE_FILE_REPLAY] = &replayDataGetMany
+};
+
+static bool (*dataNotifyDecreaseManySetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle,
+	void (*dataNotifyDecreaseMany)(void *ptr, size_t count)) = {
+		[CAER_DEVICE_DVS128] = &dvs128DataNotifyDecreaseManySet,
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonDataNotifyDecreaseManySet,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonDataNotifyDecreaseManySet,
+		[CAER_DEVICE_FILE_REPLAY] = &replayDataNotifyDecreaseManySet
+};
+
+static bool (*latencyStatsGetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, uint8_t stage,
+	struct caer_latency_stats *stats) = {
+		[CAER_DEVICE_DVS128] = &dvs128LatencyStatsGet,
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonLatencyStatsGet,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonLatencyStatsGet,
+		[CAER_DEVICE_FILE_REPLAY] = &replayLatencyStatsGet
+};
+
+static bool (*latencyStatsResetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle) = {
+		[CAER_DEVICE_DVS128] = &dvs128LatencyStatsReset,
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonLatencyStatsReset,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonLatencyStatsReset,
+		[CAER_DEVICE_FILE_REPLAY] = &replayLatencyStatsReset
+};
+
+static bool (*statsGetters[SUPPORTED_DEVICES_NUMBER])(caerDeviceHandle handle, struct caer_device_stats *stats) = {
+		[CAER_DEVICE_DVS128] = &dvs128StatsGet,
+		[CAER_DEVICE_DAVIS_FX2] = &davisCommonStatsGet,
+		[CAER_DEVICE_DAVIS_FX3] = &davisCommonStatsGet,
+		[CAER_DEVICE_FILE_REPLAY] = &replayStatsGet
 };
 
 struct caer_device_handle {
@@ -77,10 +152,34 @@ caerDeviceHandle caerDeviceOpen(uint16_t deviceID, uint16_t deviceType, uint8_t
 		return (NULL);
 	}
 
+	// Not a USB device (see caerDeviceOpenFile()).
+	if (constructors[deviceType] == NULL) {
+		return (NULL);
+	}
+
 	// Execute main constructor function.
 	return (constructors[deviceType](deviceID, busNumberRestrict, devAddressRestrict, serialNumberRestrict));
 }
 
+caerDeviceHandle caerDeviceOpenSimulated(uint16_t deviceID, uint16_t deviceType) {
+	// Check if device type is supported.
+	if (deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (NULL);
+	}
+
+	// No simulation available for this device type.
+	if (simulatedConstructors[deviceType] == NULL) {
+		return (NULL);
+	}
+
+	// Execute simulated device constructor function.
+	return (simulatedConstructors[deviceType](deviceID));
+}
+
+caerDeviceHandle caerDeviceOpenFile(uint16_t deviceID, const char *fileName) {
+	return (replayOpen(deviceID, fileName));
+}
+
 bool caerDeviceClose(caerDeviceHandle *handlePtr) {
 	// We want a pointer here so we can ensure the reference is set to NULL.
 	// Check if either it, or the memory pointed to, are NULL and abort
@@ -157,6 +256,144 @@ bool caerDeviceConfigGet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramA
 	return (configGetters[handle->deviceType](handle, modAddr, paramAddr, param));
 }
 
+bool caerDeviceConfigSetAsync(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param,
+	caerDeviceConfigCallback callback, void *userPtr) {
+	// Check if the pointers are valid.
+	if (handle == NULL || callback == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	if (configSettersAsync[handle->deviceType] != NULL) {
+		return (configSettersAsync[handle->deviceType](handle, modAddr, paramAddr, param, callback, userPtr));
+	}
+
+	// No asynchronous support: do it right away.
+	bool success = configSetters[handle->deviceType](handle, modAddr, paramAddr, param);
+
+	(*callback)(userPtr, success, modAddr, paramAddr, param);
+
+	return (true);
+}
+
+bool caerDeviceConfigGetAsync(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr,
+	caerDeviceConfigCallback callback, void *userPtr) {
+	// Check if the pointers are valid.
+	if (handle == NULL || callback == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	if (configGettersAsync[handle->deviceType] != NULL) {
+		return (configGettersAsync[handle->deviceType](handle, modAddr, paramAddr, callback, userPtr));
+	}
+
+	// No asynchronous support: do it right away.
+	uint32_t param = 0;
+	bool success = configGetters[handle->deviceType](handle, modAddr, paramAddr, &param);
+
+	(*callback)(userPtr, success, modAddr, paramAddr, (success) ? (param) : (0));
+
+	return (true);
+}
+
+caerDeviceConfigTransaction caerDeviceConfigTransactionAllocate(void) {
+	caerDeviceConfigTransaction transaction = calloc(1, sizeof(*transaction));
+	if (transaction == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for configuration transaction.");
+		return (NULL);
+	}
+
+	return (transaction);
+}
+
+bool caerDeviceConfigTransactionAdd(caerDeviceConfigTransaction transaction, int8_t modAddr, uint8_t paramAddr,
+	uint32_t param) {
+	// Check if the pointer is valid.
+	if (transaction == NULL) {
+		return (false);
+	}
+
+	if (transaction->updatesNumber == transaction->updatesCapacity) {
+		size_t newCapacity = (transaction->updatesCapacity == 0) ? (64) : (transaction->updatesCapacity * 2);
+
+		struct caer_device_config_update *newUpdates = realloc(transaction->updates,
+			newCapacity * sizeof(*newUpdates));
+		if (newUpdates == NULL) {
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to grow configuration transaction to %zu changes.",
+				newCapacity);
+			return (false);
+		}
+
+		transaction->updates = newUpdates;
+		transaction->updatesCapacity = newCapacity;
+	}
+
+	struct caer_device_config_update *update = &transaction->updates[transaction->updatesNumber++];
+
+	update->modAddr = modAddr;
+	update->paramAddr = paramAddr;
+	update->param = param;
+
+	return (true);
+}
+
+void caerDeviceConfigTransactionClear(caerDeviceConfigTransaction transaction) {
+	if (transaction == NULL) {
+		return;
+	}
+
+	transaction->updatesNumber = 0;
+}
+
+void caerDeviceConfigTransactionFree(caerDeviceConfigTransaction transaction) {
+	if (transaction == NULL) {
+		return;
+	}
+
+	free(transaction->updates);
+	free(transaction);
+}
+
+bool caerDeviceConfigTransactionCommit(caerDeviceHandle handle, caerDeviceConfigTransaction transaction, bool pause) {
+	// Check if the pointers are valid.
+	if (handle == NULL || transaction == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	if (configTransactionCommitters[handle->deviceType] != NULL) {
+		return (configTransactionCommitters[handle->deviceType](handle, transaction, pause));
+	}
+
+	// No specific support (and nothing to pause): apply the changes one by one.
+	bool success = true;
+
+	for (size_t i = 0; i < transaction->updatesNumber; i++) {
+		struct caer_device_config_update *update = &transaction->updates[i];
+
+		success = configSetters[handle->deviceType](handle, update->modAddr, update->paramAddr, update->param)
+			&& success;
+	}
+
+	return (success);
+}
+
 bool caerDeviceDataStart(caerDeviceHandle handle, void (*dataNotifyIncrease)(void *ptr),
 	void (*dataNotifyDecrease)(void *ptr), void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr),
 	void *dataShutdownUserPtr) {
@@ -202,5 +439,96 @@ caerEventPacketContainer caerDeviceDataGet(caerDeviceHandle handle) {
 	}
 
 	// Call appropriate function.
-	return (dataGetters[handle->deviceType](handle));
+	caerEventPacketContainer container = dataGetters[handle->deviceType](handle);
+
+	CAER_PROBE3(data_get, handle->deviceType, caerEventPacketContainerGetEventsNumber(container),
+		caerEventPacketContainerGetHostGetTimestamp(container));
+
+	return (container);
+}
+
+size_t caerDeviceDataGetMany(caerDeviceHandle handle, caerEventPacketContainer *containers, size_t maxContainers) {
+	// Check if the pointers are valid.
+	if (handle == NULL || containers == NULL) {
+		return (0);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (0);
+	}
+
+	// Nothing to do.
+	if (maxContainers == 0) {
+		return (0);
+	}
+
+	// Call appropriate function.
+	size_t count = dataGettersMany[handle->deviceType](handle, containers, maxContainers);
+
+	CAER_PROBE3(data_get_many, handle->deviceType, count,
+		(count != 0) ? (caerEventPacketContainerGetHostGetTimestamp(containers[0])) : (-1));
+
+	return (count);
+}
+
+bool caerDeviceDataNotifyDecreaseManySet(caerDeviceHandle handle,
+	void (*dataNotifyDecreaseMany)(void *ptr, size_t count)) {
+	// Check if the pointer is valid.
+	if (handle == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	return (dataNotifyDecreaseManySetters[handle->deviceType](handle, dataNotifyDecreaseMany));
+}
+
+bool caerDeviceLatencyStatsGet(caerDeviceHandle handle, uint8_t stage, struct caer_latency_stats *stats) {
+	// Check if the pointers are valid.
+	if (handle == NULL || stats == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	return (latencyStatsGetters[handle->deviceType](handle, stage, stats));
+}
+
+bool caerDeviceLatencyStatsReset(caerDeviceHandle handle) {
+	// Check if the pointer is valid.
+	if (handle == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	return (latencyStatsResetters[handle->deviceType](handle));
+}
+
+bool caerDeviceStatsGet(caerDeviceHandle handle, struct caer_device_stats *stats) {
+	// Check if the pointers are valid.
+	if (handle == NULL || stats == NULL) {
+		return (false);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType >= SUPPORTED_DEVICES_NUMBER) {
+		return (false);
+	}
+
+	// Call appropriate function.
+	return (statsGetters[handle->deviceType](handle, stats));
 }
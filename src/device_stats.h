@@ -0,0 +1,61 @@
+#ifndef LIBCAER_SRC_DEVICE_STATS_H_
+#define LIBCAER_SRC_DEVICE_STATS_H_
+
+#include "devices/usb.h"
+#include <stdatomic.h>
+
+#if !defined(CACHELINE_SIZE)
+	#define CACHELINE_SIZE 64 // Default (big enough for almost all processors).
+#endif
+
+// Performance counters, only ever written by the data acquisition thread (which
+// also runs the USB transfer callbacks), so plain relaxed loads and stores are
+// enough, no atomic RMW needed. Readers never take a lock. The padding keeps
+// them on their own cache lines, away from any other device state, even if the
+// device handle itself isn't cache line aligned.
+struct device_stats {
+	uint8_t padStart[CACHELINE_SIZE];
+	atomic_uint_fast64_t bytesReceived;
+	atomic_uint_fast64_t usbTransfersCompleted;
+	atomic_uint_fast64_t usbTransfersFailed;
+	atomic_uint_fast64_t usbTransfersResubmitted;
+	atomic_uint_fast64_t specialEvents;
+	atomic_uint_fast64_t polarityEvents;
+	atomic_uint_fast64_t frameEvents;
+	atomic_uint_fast64_t imu6Events;
+	atomic_uint_fast64_t invalidEvents;
+	atomic_uint_fast64_t packetGrows;
+	atomic_uint_fast64_t containersCommitted;
+	atomic_uint_fast64_t containersEmptyDiscarded;
+	atomic_uint_fast64_t containersDropped;
+	atomic_uint_fast64_t timestampResets;
+	atomic_uint_fast64_t timestampBigWraps;
+	uint8_t padEnd[CACHELINE_SIZE];
+};
+
+// Only call from the data acquisition thread.
+static inline void deviceStatsIncrease(atomic_uint_fast64_t *counter, uint64_t value) {
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+static inline void deviceStatsGet(struct device_stats *deviceStats, struct caer_device_stats *stats) {
+	stats->bytesReceived = atomic_load_explicit(&deviceStats->bytesReceived, memory_order_relaxed);
+	stats->usbTransfersCompleted = atomic_load_explicit(&deviceStats->usbTransfersCompleted, memory_order_relaxed);
+	stats->usbTransfersFailed = atomic_load_explicit(&deviceStats->usbTransfersFailed, memory_order_relaxed);
+	stats->usbTransfersResubmitted = atomic_load_explicit(&deviceStats->usbTransfersResubmitted,
+		memory_order_relaxed);
+	stats->specialEvents = atomic_load_explicit(&deviceStats->specialEvents, memory_order_relaxed);
+	stats->polarityEvents = atomic_load_explicit(&deviceStats->polarityEvents, memory_order_relaxed);
+	stats->frameEvents = atomic_load_explicit(&deviceStats->frameEvents, memory_order_relaxed);
+	stats->imu6Events = atomic_load_explicit(&deviceStats->imu6Events, memory_order_relaxed);
+	stats->invalidEvents = atomic_load_explicit(&deviceStats->invalidEvents, memory_order_relaxed);
+	stats->packetGrows = atomic_load_explicit(&deviceStats->packetGrows, memory_order_relaxed);
+	stats->containersCommitted = atomic_load_explicit(&deviceStats->containersCommitted, memory_order_relaxed);
+	stats->containersEmptyDiscarded = atomic_load_explicit(&deviceStats->containersEmptyDiscarded,
+		memory_order_relaxed);
+	stats->containersDropped = atomic_load_explicit(&deviceStats->containersDropped, memory_order_relaxed);
+	stats->timestampResets = atomic_load_explicit(&deviceStats->timestampResets, memory_order_relaxed);
+	stats->timestampBigWraps = atomic_load_explicit(&deviceStats->timestampBigWraps, memory_order_relaxed);
+}
+
+#endif /* LIBCAER_SRC_DEVICE_STATS_H_ */
@@ -1,12 +1,13 @@
 #include "dvs128.h"
+#include "probes.h"
 
 static libusb_device_handle *dvs128DeviceOpen(libusb_context *devContext, uint16_t devVID, uint16_t devPID,
 	uint8_t devType, uint8_t busNumber, uint8_t devAddress, const char *serialNumber, uint16_t requiredFirmwareVersion);
 static void dvs128DeviceClose(libusb_device_handle *devHandle);
+static void dvs128TransportClose(dvs128State state);
 static void dvs128AllocateTransfers(dvs128Handle handle, uint32_t bufferNum, uint32_t bufferSize);
 static void dvs128DeallocateTransfers(dvs128Handle handle);
 static void LIBUSB_CALL dvs128LibUsbCallback(struct libusb_transfer *transfer);
-static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t bytesSent);
 static bool dvs128SendBiases(dvs128State state);
 static int dvs128DataAcquisitionThread(void *inPtr);
 static void dvs128DataAcquisitionThreadConfig(dvs128Handle handle);
@@ -21,10 +22,7 @@ static inline void checkMonotonicTimestamp(dvs128Handle handle) {
 }
 
 static inline void freeAllDataMemory(dvs128State state) {
-	if (state->dataExchangeBuffer != NULL) {
-		ringBufferFree(state->dataExchangeBuffer);
-		state->dataExchangeBuffer = NULL;
-	}
+	dataExchangeBufferFree(&state->dataExchange);
 
 	// Since the current event packets aren't necessarily
 	// already assigned to the current packet container, we
@@ -53,8 +51,8 @@ static inline void freeAllDataMemory(dvs128State state) {
 	}
 }
 
-caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
-	const char *serialNumberRestrict) {
+static caerDeviceHandle dvs128OpenInternal(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
+	const char *serialNumberRestrict, bool simulated) {
 	caerLog(CAER_LOG_DEBUG, __func__, "Initializing %s.", DVS_DEVICE_NAME);
 
 	dvs128Handle handle = calloc(1, sizeof(*handle));
@@ -70,10 +68,7 @@ caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_
 	dvs128State state = &handle->state;
 
 	// Initialize state variables to default values (if not zero, taken care of by calloc above).
-	atomic_store_explicit(&state->dataExchangeBufferSize, 64, memory_order_relaxed);
-	atomic_store_explicit(&state->dataExchangeBlocking, false, memory_order_relaxed);
-	atomic_store_explicit(&state->dataExchangeStartProducers, true, memory_order_relaxed);
-	atomic_store_explicit(&state->dataExchangeStopProducers, true, memory_order_relaxed);
+	dataExchangeSettingsInit(&state->dataExchange);
 	atomic_store_explicit(&state->usbBufferNumber, 8, memory_order_relaxed);
 	atomic_store_explicit(&state->usbBufferSize, 4096, memory_order_relaxed);
 
@@ -89,55 +84,71 @@ caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_
 	snprintf(state->deviceThreadName, 15 + 1, "%s ID-%" PRIu16, DVS_DEVICE_NAME, deviceID);
 	state->deviceThreadName[15] = '\0';
 
-	// Search for device and open it.
-	// Initialize libusb using a separate context for each device.
-	// This is to correctly support one thread per device.
-	// libusb may create its own threads at this stage, so we temporarly set
-	// a different thread name.
-	char originalThreadName[15 + 1]; // +1 for terminating NUL character.
-	thrd_get_name(originalThreadName, 15);
-	originalThreadName[15] = '\0';
+	uint8_t busNumber = 0;
+	uint8_t devAddress = 0;
+	char serialNumber[8 + 1] = { 0 };
 
-	thrd_set_name(state->deviceThreadName);
-	int res = libusb_init(&state->deviceContext);
+	if (simulated) {
+		// No USB device, everything is answered in-process.
+		state->transport.simulation = usbSimulationCreate(CAER_DEVICE_DVS128, 0);
+		if (state->transport.simulation == NULL) {
+			free(handle);
 
-	thrd_set_name(originalThreadName);
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to create simulated %s device.", DVS_DEVICE_NAME);
+			return (NULL);
+		}
 
-	if (res != LIBUSB_SUCCESS) {
-		free(handle);
-		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize libusb context. Error: %d.", res);
-		return (NULL);
+		strncpy(serialNumber, "SIM", 8 + 1);
 	}
+	else {
+		// Search for device and open it.
+		// Initialize libusb using a separate context for each device.
+		// This is to correctly support one thread per device.
+		// libusb may create its own threads at this stage, so we temporarly set
+		// a different thread name.
+		char originalThreadName[15 + 1]; // +1 for terminating NUL character.
+		thrd_get_name(originalThreadName, 15);
+		originalThreadName[15] = '\0';
+
+		thrd_set_name(state->deviceThreadName);
+		int res = libusb_init(&state->transport.deviceContext);
+
+		thrd_set_name(originalThreadName);
+
+		if (res != LIBUSB_SUCCESS) {
+			free(handle);
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize libusb context. Error: %d.", res);
+			return (NULL);
+		}
 
-	// Try to open a DVS128 device on a specific USB port.
-	state->deviceHandle = dvs128DeviceOpen(state->deviceContext, DVS_DEVICE_VID, DVS_DEVICE_PID, DVS_DEVICE_DID_TYPE,
-		busNumberRestrict, devAddressRestrict, serialNumberRestrict,
-		DVS_REQUIRED_FIRMWARE_VERSION);
-	if (state->deviceHandle == NULL) {
-		libusb_exit(state->deviceContext);
-		free(handle);
+		// Try to open a DVS128 device on a specific USB port.
+		state->transport.deviceHandle = dvs128DeviceOpen(state->transport.deviceContext, DVS_DEVICE_VID,
+			DVS_DEVICE_PID, DVS_DEVICE_DID_TYPE, busNumberRestrict, devAddressRestrict, serialNumberRestrict,
+			DVS_REQUIRED_FIRMWARE_VERSION);
+		if (state->transport.deviceHandle == NULL) {
+			libusb_exit(state->transport.deviceContext);
+			free(handle);
 
-		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open %s device.", DVS_DEVICE_NAME);
-		return (NULL);
-	}
+			caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open %s device.", DVS_DEVICE_NAME);
+			return (NULL);
+		}
 
-	// At this point we can get some more precise data on the device and update
-	// the logging string to reflect that and be more informative.
-	uint8_t busNumber = libusb_get_bus_number(libusb_get_device(state->deviceHandle));
-	uint8_t devAddress = libusb_get_device_address(libusb_get_device(state->deviceHandle));
+		// At this point we can get some more precise data on the device and update
+		// the logging string to reflect that and be more informative.
+		busNumber = libusb_get_bus_number(libusb_get_device(state->transport.deviceHandle));
+		devAddress = libusb_get_device_address(libusb_get_device(state->transport.deviceHandle));
 
-	char serialNumber[8 + 1] = { 0 };
-	int getStringDescResult = libusb_get_string_descriptor_ascii(state->deviceHandle, 3, (unsigned char *) serialNumber,
-		8 + 1);
+		int getStringDescResult = libusb_get_string_descriptor_ascii(state->transport.deviceHandle, 3,
+			(unsigned char *) serialNumber, 8 + 1);
 
-	// Check serial number success and length.
-	if (getStringDescResult < 0 || getStringDescResult > 8) {
-		dvs128DeviceClose(state->deviceHandle);
-		libusb_exit(state->deviceContext);
-		free(handle);
+		// Check serial number success and length.
+		if (getStringDescResult < 0 || getStringDescResult > 8) {
+			dvs128TransportClose(state);
+			free(handle);
 
-		caerLog(CAER_LOG_CRITICAL, __func__, "Unable to get serial number for %s device.", DVS_DEVICE_NAME);
-		return (NULL);
+			caerLog(CAER_LOG_CRITICAL, __func__, "Unable to get serial number for %s device.", DVS_DEVICE_NAME);
+			return (NULL);
+		}
 	}
 
 	size_t fullLogStringLength = (size_t) snprintf(NULL, 0, "%s ID-%" PRIu16 " SN-%s [%" PRIu8 ":%" PRIu8 "]",
@@ -145,8 +156,7 @@ caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_
 
 	char *fullLogString = malloc(fullLogStringLength + 1);
 	if (fullLogString == NULL) {
-		dvs128DeviceClose(state->deviceHandle);
-		libusb_exit(state->deviceContext);
+		dvs128TransportClose(state);
 		free(handle);
 
 		caerLog(CAER_LOG_CRITICAL, __func__, "Unable to allocate memory for %s device info string.", DVS_DEVICE_NAME);
@@ -173,6 +183,15 @@ caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_
 	return ((caerDeviceHandle) handle);
 }
 
+caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
+	const char *serialNumberRestrict) {
+	return (dvs128OpenInternal(deviceID, busNumberRestrict, devAddressRestrict, serialNumberRestrict, false));
+}
+
+caerDeviceHandle dvs128OpenSimulated(uint16_t deviceID) {
+	return (dvs128OpenInternal(deviceID, 0, 0, NULL, true));
+}
+
 bool dvs128Close(caerDeviceHandle cdh) {
 	dvs128Handle handle = (dvs128Handle) cdh;
 	dvs128State state = &handle->state;
@@ -180,10 +199,7 @@ bool dvs128Close(caerDeviceHandle cdh) {
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "Shutting down ...");
 
 	// Finally, close the device fully.
-	dvs128DeviceClose(state->deviceHandle);
-
-	// Destroy libusb context.
-	libusb_exit(state->deviceContext);
+	dvs128TransportClose(state);
 
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "Shutdown successful.");
 
@@ -263,27 +279,11 @@ bool dvs128ConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 			break;
 
 		case CAER_HOST_CONFIG_DATAEXCHANGE:
-			switch (paramAddr) {
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE:
-					atomic_store(&state->dataExchangeBufferSize, param);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING:
-					atomic_store(&state->dataExchangeBlocking, param);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS:
-					atomic_store(&state->dataExchangeStartProducers, param);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS:
-					atomic_store(&state->dataExchangeStopProducers, param);
-					break;
+			return (dataExchangeConfigSet(&state->dataExchange, paramAddr, param));
+			break;
 
-				default:
-					return (false);
-					break;
-			}
+		case CAER_HOST_CONFIG_SIMULATION:
+			return (usbSimulationConfigSet(state->transport.simulation, paramAddr, param));
 			break;
 
 		case CAER_HOST_CONFIG_PACKETS:
@@ -306,7 +306,7 @@ bool dvs128ConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 			switch (paramAddr) {
 				case DVS128_CONFIG_DVS_RUN:
 					if (param && !atomic_load(&state->dvsRunning)) {
-						if (libusb_control_transfer(state->deviceHandle,
+						if (usbTransportControl(&state->transport,
 							LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 							VENDOR_REQUEST_START_TRANSFER, 0, 0, NULL, 0, 0) != 0) {
 							return (false);
@@ -315,7 +315,7 @@ bool dvs128ConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 						atomic_store(&state->dvsRunning, true);
 					}
 					else if (!param && atomic_load(&state->dvsRunning)) {
-						if (libusb_control_transfer(state->deviceHandle,
+						if (usbTransportControl(&state->transport,
 							LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 							VENDOR_REQUEST_STOP_TRANSFER, 0, 0, NULL, 0, 0) != 0) {
 							return (false);
@@ -327,7 +327,7 @@ bool dvs128ConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 
 				case DVS128_CONFIG_DVS_TIMESTAMP_RESET:
 					if (param) {
-						if (libusb_control_transfer(state->deviceHandle,
+						if (usbTransportControl(&state->transport,
 							LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 							VENDOR_REQUEST_RESET_TS, 0, 0, NULL, 0, 0) != 0) {
 							return (false);
@@ -337,7 +337,7 @@ bool dvs128ConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 
 				case DVS128_CONFIG_DVS_ARRAY_RESET:
 					if (param) {
-						if (libusb_control_transfer(state->deviceHandle,
+						if (usbTransportControl(&state->transport,
 							LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 							VENDOR_REQUEST_RESET_ARRAY, 0, 0, NULL, 0, 0) != 0) {
 							return (false);
@@ -346,7 +346,7 @@ bool dvs128ConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 					break;
 
 				case DVS128_CONFIG_DVS_TS_MASTER:
-					if (libusb_control_transfer(state->deviceHandle,
+					if (usbTransportControl(&state->transport,
 						LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 						VENDOR_REQUEST_TS_MASTER, (param & 0x01), 0, NULL, 0, 0) != 0) {
 						return (false);
@@ -419,27 +419,11 @@ bool dvs128ConfigGet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 			break;
 
 		case CAER_HOST_CONFIG_DATAEXCHANGE:
-			switch (paramAddr) {
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BUFFER_SIZE:
-					*param = U32T(atomic_load(&state->dataExchangeBufferSize));
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_BLOCKING:
-					*param = atomic_load(&state->dataExchangeBlocking);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_START_PRODUCERS:
-					*param = atomic_load(&state->dataExchangeStartProducers);
-					break;
-
-				case CAER_HOST_CONFIG_DATAEXCHANGE_STOP_PRODUCERS:
-					*param = atomic_load(&state->dataExchangeStopProducers);
-					break;
+			return (dataExchangeConfigGet(&state->dataExchange, paramAddr, param));
+			break;
 
-				default:
-					return (false);
-					break;
-			}
+		case CAER_HOST_CONFIG_SIMULATION:
+			return (usbSimulationConfigGet(state->transport.simulation, paramAddr, param));
 			break;
 
 		case CAER_HOST_CONFIG_PACKETS:
@@ -511,25 +495,63 @@ bool dvs128ConfigGet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, ui
 	return (true);
 }
 
-bool dvs128DataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr), void (*dataNotifyDecrease)(void *ptr),
-	void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr), void *dataShutdownUserPtr) {
+bool dvs128ConfigTransactionCommit(caerDeviceHandle cdh, caerDeviceConfigTransaction transaction, bool pause) {
 	dvs128Handle handle = (dvs128Handle) cdh;
 	dvs128State state = &handle->state;
 
-	// Store new data available/not available anymore call-backs.
-	state->dataNotifyIncrease = dataNotifyIncrease;
-	state->dataNotifyDecrease = dataNotifyDecrease;
-	state->dataNotifyUserPtr = dataNotifyUserPtr;
-	state->dataShutdownNotify = dataShutdownNotify;
-	state->dataShutdownUserPtr = dataShutdownUserPtr;
+	bool success = true;
+	bool dvsRun = atomic_load(&state->dvsRunning);
+	bool biasesChanged = false;
+
+	if (pause && dvsRun) {
+		success = dvs128ConfigSet(cdh, DVS128_CONFIG_DVS, DVS128_CONFIG_DVS_RUN, false) && success;
+	}
+
+	for (size_t i = 0; i < transaction->updatesNumber; i++) {
+		struct caer_device_config_update *update = &transaction->updates[i];
+
+		// While paused, changes to whether the DVS runs take effect at the end.
+		if (pause && update->modAddr == DVS128_CONFIG_DVS && update->paramAddr == DVS128_CONFIG_DVS_RUN) {
+			dvsRun = update->param;
+			continue;
+		}
+
+		// All biases are sent together anyway: collect changes and send them once.
+		if (update->modAddr == DVS128_CONFIG_BIAS && update->paramAddr < BIAS_NUMBER) {
+			caerIntegerToByteArray(update->param, state->biases[update->paramAddr], BIAS_LENGTH);
+			biasesChanged = true;
+			continue;
+		}
+
+		// Anything else goes out in order, after the biases that come before it.
+		if (biasesChanged) {
+			success = dvs128SendBiases(state) && success;
+			biasesChanged = false;
+		}
+
+		success = dvs128ConfigSet(cdh, update->modAddr, update->paramAddr, update->param) && success;
+	}
+
+	if (biasesChanged) {
+		success = dvs128SendBiases(state) && success;
+	}
+
+	if (pause && dvsRun) {
+		success = dvs128ConfigSet(cdh, DVS128_CONFIG_DVS, DVS128_CONFIG_DVS_RUN, true) && success;
+	}
+
+	return (success);
+}
+
+bool dvs128DataMemoryInit(dvs128Handle handle) {
+	dvs128State state = &handle->state;
 
 	// Set wanted time interval to uninitialized. Getting the first TS or TS_RESET
 	// will then set this correctly.
 	state->currentPacketContainerCommitTimestamp = -1;
 
 	// Initialize RingBuffer.
-	state->dataExchangeBuffer = ringBufferInit(atomic_load(&state->dataExchangeBufferSize));
-	if (state->dataExchangeBuffer == NULL) {
+	if (!dataExchangeBufferInit(&state->dataExchange)) {
 		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to initialize data exchange buffer.");
 		return (false);
 	}
@@ -561,7 +583,39 @@ bool dvs128DataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr)
 		return (false);
 	}
 
+	return (true);
+}
+
+void dvs128DataMemoryFree(dvs128Handle handle) {
+	freeAllDataMemory(&handle->state);
+}
+
+bool dvs128DataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr), void (*dataNotifyDecrease)(void *ptr),
+	void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr), void *dataShutdownUserPtr) {
+	dvs128Handle handle = (dvs128Handle) cdh;
+	dvs128State state = &handle->state;
+
+	// Store new data available/not available anymore call-backs.
+	state->dataExchange.notifyIncrease = dataNotifyIncrease;
+	state->dataExchange.notifyDecrease = dataNotifyDecrease;
+	state->dataExchange.notifyUserPtr = dataNotifyUserPtr;
+	state->dataExchange.committedContainers = &state->stats.containersCommitted;
+	state->dataShutdownNotify = dataShutdownNotify;
+	state->dataShutdownUserPtr = dataShutdownUserPtr;
+
+	if (!dvs128DataMemoryInit(handle)) {
+		return (false);
+	}
+
+	if (!threadReadyInit(&state->dataAcquisitionThreadReady)) {
+		freeAllDataMemory(state);
+
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to initialize data acquisition thread start.");
+		return (false);
+	}
+
 	if ((errno = thrd_create(&state->dataAcquisitionThread, &dvs128DataAcquisitionThread, handle)) != thrd_success) {
+		threadReadyDestroy(&state->dataAcquisitionThreadReady);
 		freeAllDataMemory(state);
 
 		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to start data acquisition thread. Error: %d.",
@@ -570,9 +624,8 @@ bool dvs128DataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr)
 	}
 
 	// Wait for the data acquisition thread to be ready.
-	while (!atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
-		;
-	}
+	threadReadyWait(&state->dataAcquisitionThreadReady);
+	threadReadyDestroy(&state->dataAcquisitionThreadReady);
 
 	return (true);
 }
@@ -582,7 +635,7 @@ bool dvs128DataStop(caerDeviceHandle cdh) {
 	dvs128State state = &handle->state;
 
 	// Stop data acquisition thread.
-	if (atomic_load(&state->dataExchangeStopProducers)) {
+	if (atomic_load(&state->dataExchange.stopProducers)) {
 		// Disable data transfer on USB end-point 6.
 		dvs128ConfigSet((caerDeviceHandle) handle, DVS128_CONFIG_DVS, DVS128_CONFIG_DVS_RUN, false);
 	}
@@ -597,17 +650,8 @@ bool dvs128DataStop(caerDeviceHandle cdh) {
 		return (false);
 	}
 
-	// Empty ringbuffer.
-	caerEventPacketContainer container;
-	while ((container = ringBufferGet(state->dataExchangeBuffer)) != NULL) {
-		// Notify data-not-available call-back.
-		if (state->dataNotifyDecrease != NULL) {
-			state->dataNotifyDecrease(state->dataNotifyUserPtr);
-		}
-
-		// Free container, which will free its subordinate packets too.
-		caerEventPacketContainerFree(container);
-	}
+	// Empty ringbuffer and overflow list.
+	dataExchangeBufferEmpty(&state->dataExchange);
 
 	// Free current, uncommitted packets and ringbuffer.
 	freeAllDataMemory(state);
@@ -623,33 +667,50 @@ bool dvs128DataStop(caerDeviceHandle cdh) {
 caerEventPacketContainer dvs128DataGet(caerDeviceHandle cdh) {
 	dvs128Handle handle = (dvs128Handle) cdh;
 	dvs128State state = &handle->state;
-	caerEventPacketContainer container = NULL;
 
-	retry: container = ringBufferGet(state->dataExchangeBuffer);
+	return (dataExchangeGet(&state->dataExchange));
+}
 
-	if (container != NULL) {
-		// Found an event container, return it and signal this piece of data
-		// is no longer available for later acquisition.
-		if (state->dataNotifyDecrease != NULL) {
-			state->dataNotifyDecrease(state->dataNotifyUserPtr);
-		}
+// Remember to properly free the returned memory after usage!
+size_t dvs128DataGetMany(caerDeviceHandle cdh, caerEventPacketContainer *containers, size_t maxContainers) {
+	dvs128Handle handle = (dvs128Handle) cdh;
+	dvs128State state = &handle->state;
 
-		return (container);
-	}
+	return (dataExchangeGetMany(&state->dataExchange, containers, maxContainers));
+}
 
-	// Didn't find any event container, either report this or retry, depending
-	// on blocking setting.
-	if (atomic_load_explicit(&state->dataExchangeBlocking, memory_order_relaxed)) {
-		// Don't retry right away in a tight loop, back off and wait a little.
-		// If no data is available, sleep for a millisecond to avoid wasting resources.
-		struct timespec noDataSleep = { .tv_sec = 0, .tv_nsec = 1000000 };
-		if (thrd_sleep(&noDataSleep, NULL) == 0) {
-			goto retry;
-		}
-	}
+bool dvs128DataNotifyDecreaseManySet(caerDeviceHandle cdh, void (*dataNotifyDecreaseMany)(void *ptr, size_t count)) {
+	dvs128Handle handle = (dvs128Handle) cdh;
+	dvs128State state = &handle->state;
+
+	state->dataExchange.notifyDecreaseMany = dataNotifyDecreaseMany;
+
+	return (true);
+}
+
+bool dvs128LatencyStatsGet(caerDeviceHandle cdh, uint8_t stage, struct caer_latency_stats *stats) {
+	dvs128Handle handle = (dvs128Handle) cdh;
+	dvs128State state = &handle->state;
+
+	return (dataExchangeLatencyStatsGet(&state->dataExchange, stage, stats));
+}
+
+bool dvs128LatencyStatsReset(caerDeviceHandle cdh) {
+	dvs128Handle handle = (dvs128Handle) cdh;
+	dvs128State state = &handle->state;
+
+	dataExchangeLatencyStatsReset(&state->dataExchange);
+
+	return (true);
+}
 
-	// Nothing.
-	return (NULL);
+bool dvs128StatsGet(caerDeviceHandle cdh, struct caer_device_stats *stats) {
+	dvs128Handle handle = (dvs128Handle) cdh;
+	dvs128State state = &handle->state;
+
+	deviceStatsGet(&state->stats, stats);
+
+	return (true);
 }
 
 static libusb_device_handle *dvs128DeviceOpen(libusb_context *devContext, uint16_t devVID, uint16_t devPID,
@@ -776,6 +837,19 @@ static void dvs128DeviceClose(libusb_device_handle *devHandle) {
 	libusb_close(devHandle);
 }
 
+static void dvs128TransportClose(dvs128State state) {
+	if (state->transport.simulation != NULL) {
+		usbSimulationDestroy(state->transport.simulation);
+		state->transport.simulation = NULL;
+		return;
+	}
+
+	dvs128DeviceClose(state->transport.deviceHandle);
+
+	// Destroy libusb context.
+	libusb_exit(state->transport.deviceContext);
+}
+
 static void dvs128AllocateTransfers(dvs128Handle handle, uint32_t bufferNum, uint32_t bufferSize) {
 	dvs128State state = &handle->state;
 
@@ -811,7 +885,7 @@ static void dvs128AllocateTransfers(dvs128Handle handle, uint32_t bufferNum, uin
 		}
 
 		// Initialize Transfer.
-		state->dataTransfers[i]->dev_handle = state->deviceHandle;
+		state->dataTransfers[i]->dev_handle = state->transport.deviceHandle;
 		state->dataTransfers[i]->endpoint = DVS_DATA_ENDPOINT;
 		state->dataTransfers[i]->type = LIBUSB_TRANSFER_TYPE_BULK;
 		state->dataTransfers[i]->callback = &dvs128LibUsbCallback;
@@ -819,7 +893,7 @@ static void dvs128AllocateTransfers(dvs128Handle handle, uint32_t bufferNum, uin
 		state->dataTransfers[i]->timeout = 0;
 		state->dataTransfers[i]->flags = LIBUSB_TRANSFER_FREE_BUFFER;
 
-		if ((errno = libusb_submit_transfer(state->dataTransfers[i])) == LIBUSB_SUCCESS) {
+		if ((errno = usbTransportSubmit(&state->transport, state->dataTransfers[i])) == LIBUSB_SUCCESS) {
 			state->activeDataTransfers++;
 		}
 		else {
@@ -851,7 +925,7 @@ static void dvs128DeallocateTransfers(dvs128Handle handle) {
 	// Cancel all current transfers first.
 	for (size_t i = 0; i < state->dataTransfersLength; i++) {
 		if (state->dataTransfers[i] != NULL) {
-			errno = libusb_cancel_transfer(state->dataTransfers[i]);
+			errno = usbTransportCancel(&state->transport, state->dataTransfers[i]);
 			if (errno != LIBUSB_SUCCESS && errno != LIBUSB_ERROR_NOT_FOUND) {
 				caerLog(CAER_LOG_CRITICAL, handle->info.deviceString,
 					"Unable to cancel libusb transfer %zu. Error: %s (%d).", i, libusb_strerror(errno), errno);
@@ -864,7 +938,7 @@ static void dvs128DeallocateTransfers(dvs128Handle handle) {
 	struct timeval te = { .tv_sec = 0, .tv_usec = 100000 };
 
 	while (state->activeDataTransfers > 0) {
-		libusb_handle_events_timeout(state->deviceContext, &te);
+		usbTransportHandleEvents(&state->transport, &te);
 	}
 
 	// The buffers and transfers have been deallocated in the callback.
@@ -878,14 +952,25 @@ static void LIBUSB_CALL dvs128LibUsbCallback(struct libusb_transfer *transfer) {
 	dvs128Handle handle = transfer->user_data;
 	dvs128State state = &handle->state;
 
+	CAER_PROBE3(usb_transfer, handle->info.deviceID, (int) transfer->status, transfer->actual_length);
+
 	if (transfer->status == LIBUSB_TRANSFER_COMPLETED) {
+		deviceStatsIncrease(&state->stats.usbTransfersCompleted, 1);
+		deviceStatsIncrease(&state->stats.bytesReceived, U64T(transfer->actual_length));
+
 		// Handle data.
 		dvs128EventTranslator(handle, transfer->buffer, (size_t) transfer->actual_length);
+
+		CAER_PROBE2(translator_exit, handle->info.deviceID, transfer->actual_length);
+	}
+	else if (transfer->status != LIBUSB_TRANSFER_CANCELLED) {
+		deviceStatsIncrease(&state->stats.usbTransfersFailed, 1);
 	}
 
 	if (transfer->status != LIBUSB_TRANSFER_CANCELLED && transfer->status != LIBUSB_TRANSFER_NO_DEVICE) {
 		// Submit transfer again.
-		if (libusb_submit_transfer(transfer) == LIBUSB_SUCCESS) {
+		if (usbTransportSubmit(&state->transport, transfer) == LIBUSB_SUCCESS) {
+			deviceStatsIncrease(&state->stats.usbTransfersResubmitted, 1);
 			return;
 		}
 	}
@@ -924,7 +1009,7 @@ static inline void initContainerCommitTimestamp(dvs128State state) {
 	}
 }
 
-static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t bytesSent) {
+void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t bytesSent) {
 	dvs128State state = &handle->state;
 
 	// Return right away if not running anymore. This prevents useless work if many
@@ -935,6 +1020,15 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 		return;
 	}
 
+	// This is called on USB transfer completion, remember when for latency tracking.
+	int64_t transferTimestamp = dataExchangeHostTime();
+
+	CAER_PROBE3(translator_entry, handle->info.deviceID, bytesSent, transferTimestamp);
+
+	if (caerEventPacketContainerGetHostTransferTimestamp(state->currentPacketContainer) == -1) {
+		caerEventPacketContainerSetHostTransferTimestamp(state->currentPacketContainer, transferTimestamp);
+	}
+
 	// Truncate off any extra partial event.
 	if ((bytesSent & 0x03) != 0) {
 		caerLog(CAER_LOG_ALERT, handle->info.deviceString,
@@ -950,6 +1044,8 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 				caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to allocate event packet container.");
 				return;
 			}
+
+			caerEventPacketContainerSetHostTransferTimestamp(state->currentPacketContainer, transferTimestamp);
 		}
 
 		if (state->currentPolarityPacket == NULL) {
@@ -972,6 +1068,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 			}
 
 			state->currentPolarityPacket = grownPacket;
+			deviceStatsIncrease(&state->stats.packetGrows, 1);
 		}
 
 		if (state->currentSpecialPacket == NULL) {
@@ -994,6 +1091,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 			}
 
 			state->currentSpecialPacket = grownPacket;
+			deviceStatsIncrease(&state->stats.packetGrows, 1);
 		}
 
 		bool tsReset = false;
@@ -1020,6 +1118,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 
 				// Commit packets to separate before wrap from after cleanly.
 				tsBigWrap = true;
+				deviceStatsIncrease(&state->stats.timestampBigWraps, 1);
 			}
 			else {
 				// timestamp bit 15 is one -> wrap: now we need to increment
@@ -1048,6 +1147,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 			// alone, in its own packet.
 			// Commit packets when doing a reset to clearly separate them.
 			tsReset = true;
+			deviceStatsIncrease(&state->stats.timestampResets, 1);
 		}
 		else {
 			// address is LSB MSB (USB is LE)
@@ -1087,11 +1187,13 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 				if (x >= DVS_ARRAY_SIZE_X) {
 					caerLog(CAER_LOG_ALERT, handle->info.deviceString, "X address out of range (0-%d): %" PRIu16 ".",
 					DVS_ARRAY_SIZE_X - 1, x);
+					deviceStatsIncrease(&state->stats.invalidEvents, 1);
 					continue; // Skip invalid event.
 				}
 				if (y >= DVS_ARRAY_SIZE_Y) {
 					caerLog(CAER_LOG_ALERT, handle->info.deviceString, "Y address out of range (0-%d): %" PRIu16 ".",
 					DVS_ARRAY_SIZE_Y - 1, y);
+					deviceStatsIncrease(&state->stats.invalidEvents, 1);
 					continue; // Skip invalid event.
 				}
 
@@ -1131,6 +1233,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 			if (state->currentPolarityPacketPosition > 0) {
 				caerEventPacketContainerSetEventPacket(state->currentPacketContainer, POLARITY_EVENT,
 					(caerEventPacketHeader) state->currentPolarityPacket);
+				deviceStatsIncrease(&state->stats.polarityEvents, U64T(state->currentPolarityPacketPosition));
 
 				state->currentPolarityPacket = NULL;
 				state->currentPolarityPacketPosition = 0;
@@ -1140,6 +1243,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 			if (state->currentSpecialPacketPosition > 0) {
 				caerEventPacketContainerSetEventPacket(state->currentPacketContainer, SPECIAL_EVENT,
 					(caerEventPacketHeader) state->currentSpecialPacket);
+				deviceStatsIncrease(&state->stats.specialEvents, U64T(state->currentSpecialPacketPosition));
 
 				state->currentSpecialPacket = NULL;
 				state->currentSpecialPacketPosition = 0;
@@ -1160,23 +1264,29 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 			// Filter out completely empty commits. This can happen when data is turned off,
 			// but the timestamps are still going forward.
 			if (emptyContainerCommit) {
+				deviceStatsIncrease(&state->stats.containersEmptyDiscarded, 1);
+
 				caerEventPacketContainerFree(state->currentPacketContainer);
 				state->currentPacketContainer = NULL;
 			}
 			else {
-				if (!ringBufferPut(state->dataExchangeBuffer, state->currentPacketContainer)) {
+				CAER_PROBE_CONTAINER_CAPTURE(probe, state->currentPacketContainer);
+
+				if (!dataExchangePut(&state->dataExchange, state->currentPacketContainer,
+					&state->dataAcquisitionThreadRun)) {
 					// Failed to forward packet container, just drop it, it doesn't contain
 					// any critical information anyway.
 					caerLog(CAER_LOG_INFO, handle->info.deviceString,
 						"Dropped EventPacket Container because ring-buffer full!");
+					deviceStatsIncrease(&state->stats.containersDropped, 1);
+
+					CAER_PROBE_CONTAINER(container_drop, handle->info.deviceID, probe);
 
 					caerEventPacketContainerFree(state->currentPacketContainer);
 					state->currentPacketContainer = NULL;
 				}
 				else {
-					if (state->dataNotifyIncrease != NULL) {
-						state->dataNotifyIncrease(state->dataNotifyUserPtr);
-					}
+					CAER_PROBE_CONTAINER(container_commit, handle->info.deviceID, probe);
 
 					state->currentPacketContainer = NULL;
 				}
@@ -1197,6 +1307,8 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 					return;
 				}
 
+				caerEventPacketContainerSetHostTransferTimestamp(tsResetContainer, transferTimestamp);
+
 				// Allocate special packet just for this event.
 				caerSpecialEventPacket tsResetPacket = caerSpecialEventPacketAllocate(1, I16T(handle->info.deviceID),
 					state->wrapOverflow);
@@ -1219,18 +1331,15 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 				// Reset MUST be committed, always, else downstream data processing and
 				// outputs get confused if they have no notification of timestamps
 				// jumping back go zero.
-				while (!ringBufferPut(state->dataExchangeBuffer, tsResetContainer)) {
-					// Prevent dead-lock if shutdown is requested and nothing is consuming
-					// data anymore, but the ring-buffer is full (and would thus never empty),
-					// thus blocking the USB handling thread in this loop.
-					if (!atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
-						return;
-					}
-				}
+				// This waits until it succeeds, unless shutdown is requested.
+				deviceStatsIncrease(&state->stats.specialEvents, 1);
 
-				// Signal new container as usual.
-				if (state->dataNotifyIncrease != NULL) {
-					state->dataNotifyIncrease(state->dataNotifyUserPtr);
+				if (!dataExchangePutForced(&state->dataExchange, tsResetContainer,
+					&state->dataAcquisitionThreadRun)) {
+					deviceStatsIncrease(&state->stats.containersDropped, 1);
+
+					caerEventPacketContainerFree(tsResetContainer);
+					return;
 				}
 			}
 		}
@@ -1240,7 +1349,7 @@ static void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t b
 static bool dvs128SendBiases(dvs128State state) {
 	// Biases are already stored in an array with the same format as expected by
 	// the device, we can thus send it directly.
-	return (libusb_control_transfer(state->deviceHandle,
+	return (usbTransportControl(&state->transport,
 		LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
 		VENDOR_REQUEST_SEND_BIASES, 0, 0, (uint8_t *) state->biases, (BIAS_NUMBER * BIAS_LENGTH), 0)
 		== (BIAS_NUMBER * BIAS_LENGTH));
@@ -1259,7 +1368,7 @@ static int dvs128DataAcquisitionThread(void *inPtr) {
 	// Reset configuration update, so as to not re-do work afterwards.
 	atomic_store(&state->dataAcquisitionThreadConfigUpdate, 0);
 
-	if (atomic_load(&state->dataExchangeStartProducers)) {
+	if (atomic_load(&state->dataExchange.startProducers)) {
 		// Enable data transfer on USB end-point 6.
 		dvs128ConfigSet((caerDeviceHandle) handle, DVS128_CONFIG_DVS, DVS128_CONFIG_DVS_RUN, true);
 	}
@@ -1270,6 +1379,7 @@ static int dvs128DataAcquisitionThread(void *inPtr) {
 
 	// Signal data thread ready back to start function.
 	atomic_store(&state->dataAcquisitionThreadRun, true);
+	threadReadySignal(&state->dataAcquisitionThreadReady);
 
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "data acquisition thread ready to process events.");
 
@@ -1283,7 +1393,18 @@ static int dvs128DataAcquisitionThread(void *inPtr) {
 			dvs128DataAcquisitionThreadConfig(handle);
 		}
 
-		libusb_handle_events_timeout(state->deviceContext, &te);
+		// If containers are waiting in the overflow list, don't wait long for
+		// new USB data, but retry forwarding them to the consumer quickly.
+		if (dataExchangeSpillPending(&state->dataExchange)) {
+			struct timeval teSpill = { .tv_sec = 0, .tv_usec = 1000 };
+
+			usbTransportHandleEvents(&state->transport, &teSpill);
+
+			dataExchangeSpillFlush(&state->dataExchange);
+		}
+		else {
+			usbTransportHandleEvents(&state->transport, &te);
+		}
 	}
 
 	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "shutting down data acquisition thread ...");
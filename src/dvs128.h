@@ -2,7 +2,12 @@
 #define LIBCAER_SRC_DVS128_H_
 
 #include "devices/dvs128.h"
-#include "ringbuffer/ringbuffer.h"
+#include "data_exchange.h"
+#include "device_stats.h"
+#include "usb_transport.h"
+#include "config_transaction.h"
+#include "thread_ready.h"
+#include "visibility.h"
 #include <stdatomic.h>
 #include <libusb.h>
 
@@ -41,26 +46,21 @@
 
 struct dvs128_state {
 	// Data Acquisition Thread -> Mainloop Exchange
-	RingBuffer dataExchangeBuffer;
-	atomic_uint_fast32_t dataExchangeBufferSize; // Only takes effect on DataStart() calls!
-	atomic_bool dataExchangeBlocking;
-	atomic_bool dataExchangeStartProducers;
-	atomic_bool dataExchangeStopProducers;
-	void (*dataNotifyIncrease)(void *ptr);
-	void (*dataNotifyDecrease)(void *ptr);
-	void *dataNotifyUserPtr;
+	struct data_exchange dataExchange;
 	void (*dataShutdownNotify)(void *ptr);
 	void *dataShutdownUserPtr;
+	// Performance counters, written by the Data Acquisition Thread
+	struct device_stats stats;
 	// USB Device State
 	char deviceThreadName[15 + 1]; // +1 for terminating NUL character.
-	libusb_context *deviceContext;
-	libusb_device_handle *deviceHandle;
+	struct usb_transport transport;
 	// USB Transfer Settings
 	atomic_uint_fast32_t usbBufferNumber;
 	atomic_uint_fast32_t usbBufferSize;
 	// Data Acquisition Thread
 	thrd_t dataAcquisitionThread;
 	atomic_bool dataAcquisitionThreadRun;
+	struct thread_ready dataAcquisitionThreadReady;
 	atomic_uint_fast32_t dataAcquisitionThreadConfigUpdate;
 	struct libusb_transfer **dataTransfers;
 	size_t dataTransfersLength;
@@ -102,6 +102,7 @@ typedef struct dvs128_handle *dvs128Handle;
 
 caerDeviceHandle dvs128Open(uint16_t deviceID, uint8_t busNumberRestrict, uint8_t devAddressRestrict,
 	const char *serialNumberRestrict);
+caerDeviceHandle dvs128OpenSimulated(uint16_t deviceID);
 bool dvs128Close(caerDeviceHandle handle);
 
 bool dvs128SendDefaultConfig(caerDeviceHandle handle);
@@ -109,11 +110,22 @@ bool dvs128SendDefaultConfig(caerDeviceHandle handle);
 // Positive addresses (including zero) are used for device-side configuration.
 bool dvs128ConfigSet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param);
 bool dvs128ConfigGet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t *param);
+bool dvs128ConfigTransactionCommit(caerDeviceHandle handle, caerDeviceConfigTransaction transaction, bool pause);
 
 bool dvs128DataStart(caerDeviceHandle handle, void (*dataNotifyIncrease)(void *ptr),
 	void (*dataNotifyDecrease)(void *ptr), void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr),
 	void *dataShutdownUserPtr);
 bool dvs128DataStop(caerDeviceHandle handle);
 caerEventPacketContainer dvs128DataGet(caerDeviceHandle handle);
+size_t dvs128DataGetMany(caerDeviceHandle handle, caerEventPacketContainer *containers, size_t maxContainers);
+bool dvs128DataNotifyDecreaseManySet(caerDeviceHandle handle, void (*dataNotifyDecreaseMany)(void *ptr, size_t count));
+bool dvs128LatencyStatsGet(caerDeviceHandle handle, uint8_t stage, struct caer_latency_stats *stats);
+bool dvs128LatencyStatsReset(caerDeviceHandle handle);
+bool dvs128StatsGet(caerDeviceHandle handle, struct caer_device_stats *stats);
+
+// Data path without the USB device, also used by the translator benchmarks.
+CAER_INTERNAL bool dvs128DataMemoryInit(dvs128Handle handle);
+CAER_INTERNAL void dvs128DataMemoryFree(dvs128Handle handle);
+CAER_INTERNAL void dvs128EventTranslator(dvs128Handle handle, uint8_t *buffer, size_t bytesSent);
 
 #endif /* LIBCAER_SRC_DVS128_H_ */
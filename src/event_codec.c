@@ -0,0 +1,835 @@
+#include "event_codec.h"
+#include "events/polarity.h"
+#include "events/special.h"
+#include "events/frame.h"
+
+#define CODEC_METHOD_RAW 0
+#define CODEC_METHOD_DELTA 1
+
+#define CODEC_METHOD_OFFSET CAER_EVENT_PACKET_HEADER_SIZE
+#define CODEC_PAYLOAD_LENGTH_OFFSET (CAER_EVENT_PACKET_HEADER_SIZE + 1)
+
+// Worst case encoded size of one event: polarity events are a token
+// (X delta and two flags, 18 bits), plus, if changed, the Y delta (16
+// bits) and the timestamp delta (33 bits), at 7 bits per byte. Special
+// events are a timestamp delta and their 32 bits of data.
+#define CODEC_POLARITY_EVENT_MAX (3 + 3 + 5)
+#define CODEC_SPECIAL_EVENT_MAX (5 + 5)
+
+// Polarity events have two flag bits (valid mark and polarity), which
+// are bit-packed separately, four events per byte, in front of the rest.
+#define CODEC_POLARITY_FLAGS_MASK 0x03
+#define CODEC_POLARITY_FLAGS_SIZE(N) (((size_t) (N) + 3) / 4)
+
+#define CODEC_TOKEN_Y_CHANGED 0x02
+#define CODEC_TOKEN_TS_CHANGED 0x01
+#define CODEC_TOKEN_X_SHIFT 2
+
+// Frame events are coded one by one: a mode byte, then either the raw
+// event, or the fixed fields followed by the pixels' prediction residuals,
+// in blocks of 16 sharing one bit width, and any trailing unused memory.
+#define CODEC_FRAME_EVENT_RAW 0
+#define CODEC_FRAME_EVENT_PREDICTED 1
+#define CODEC_FRAME_FIXED_SIZE offsetof(struct caer_frame_event, pixels)
+#define CODEC_FRAME_BLOCK_SIZE 16
+#define CODEC_FRAME_WIDTH_MAX 17 // Zig-zag coded difference of two 16 bit values.
+// Mode, shift and unused memory flag; per block, width and residuals.
+#define CODEC_FRAME_EVENT_BOUND(EVENT_SIZE) (3 + (EVENT_SIZE) + ((EVENT_SIZE) / 8) + 64)
+
+static size_t codecPayloadBound(caerEventPacketHeader packet, int32_t eventNumber);
+static size_t codecPolarityEncode(caerPolarityEventPacket packet, int32_t eventNumber, uint8_t *payload);
+static bool codecPolarityDecode(caerPolarityEventPacket packet, int32_t eventNumber, const uint8_t *payload,
+	size_t payloadLength);
+static size_t codecFrameEncode(caerFrameEventPacket packet, int32_t eventNumber, size_t eventSize, uint8_t *payload);
+static bool codecFrameDecode(caerFrameEventPacket packet, int32_t eventNumber, size_t eventSize, const uint8_t *payload,
+	size_t payloadLength);
+static size_t codecSpecialEncode(caerSpecialEventPacket packet, int32_t eventNumber, uint8_t *payload);
+static bool codecSpecialDecode(caerSpecialEventPacket packet, int32_t eventNumber, const uint8_t *payload,
+	size_t payloadLength);
+
+// Variable-length integers: 7 bits per byte, least significant first,
+// the high bit marking that more bytes follow.
+static inline uint8_t *codecVarintPut(uint8_t *out, uint64_t value) {
+	while (value >= 0x80) {
+		*out++ = U8T(value | 0x80);
+		value >>= 7;
+	}
+
+	*out++ = U8T(value);
+
+	return (out);
+}
+
+static inline const uint8_t *codecVarintGet(const uint8_t *in, const uint8_t *end, uint64_t *value) {
+	// Fast path: most deltas fit into a single byte.
+	if (in != end && *in < 0x80) {
+		*value = *in;
+		return (in + 1);
+	}
+
+	uint64_t result = 0;
+
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		if (in == end) {
+			return (NULL);
+		}
+
+		uint8_t byte = *in++;
+		result |= U64T(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			return (in);
+		}
+	}
+
+	return (NULL);
+}
+
+// Map signed to unsigned, so small negative deltas stay small.
+static inline uint64_t codecZigZagEncode(int64_t value) {
+	return ((U64T(value) << 1) ^ U64T(value >> 63));
+}
+
+static inline int64_t codecZigZagDecode(uint64_t value) {
+	return (I64T(value >> 1) ^ -I64T(value & 0x01));
+}
+
+// Decoded deltas are between 32 bit values, so they are always within
+// +/- UINT32_MAX. Larger ones only come from corrupted data, and could
+// overflow when added up, so decoding fails, like on over-long varints.
+static inline bool codecDeltaDecode(uint64_t value, int64_t *delta) {
+	*delta = codecZigZagDecode(value);
+
+	return (*delta >= -I64T(UINT32_MAX) && *delta <= I64T(UINT32_MAX));
+}
+
+static inline bool codecDeltaSupported(caerEventPacketHeader packet) {
+	switch (caerEventPacketHeaderGetEventType(packet)) {
+		case POLARITY_EVENT:
+			return (caerEventPacketHeaderGetEventSize(packet) == sizeof(struct caer_polarity_event)
+				&& caerEventPacketHeaderGetEventTSOffset(packet) == offsetof(struct caer_polarity_event, timestamp));
+
+		case SPECIAL_EVENT:
+			return (caerEventPacketHeaderGetEventSize(packet) == sizeof(struct caer_special_event)
+				&& caerEventPacketHeaderGetEventTSOffset(packet) == offsetof(struct caer_special_event, timestamp));
+
+		case FRAME_EVENT:
+			return (caerEventPacketHeaderGetEventSize(packet) >= I32T(CODEC_FRAME_FIXED_SIZE));
+
+		default:
+			return (false);
+	}
+}
+
+size_t caerEventCodecEncodeBound(caerEventPacketHeader packet) {
+	if (packet == NULL) {
+		return (0);
+	}
+
+	int32_t eventSize = caerEventPacketHeaderGetEventSize(packet);
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+
+	if (eventSize <= 0 || eventNumber < 0) {
+		return (0);
+	}
+
+	size_t rawSize = (size_t) eventNumber * (size_t) eventSize;
+	size_t payloadBound = codecPayloadBound(packet, eventNumber);
+
+	return (CAER_EVENT_CODEC_HEADER_SIZE + ((payloadBound > rawSize) ? (payloadBound) : (rawSize)));
+}
+
+size_t caerEventCodecEncode(caerEventPacketHeader packet, uint8_t *buffer, size_t bufferSize) {
+	size_t bound = caerEventCodecEncodeBound(packet);
+
+	if (bound == 0 || buffer == NULL || bufferSize < bound) {
+		caerLog(CAER_LOG_ERROR, __func__, "Invalid packet or buffer too small (%zu bytes, %zu needed).", bufferSize,
+			bound);
+		return (0);
+	}
+
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+	size_t rawSize = (size_t) eventNumber * (size_t) caerEventPacketHeaderGetEventSize(packet);
+
+	// Only the events in use are encoded, so the capacity shrinks to them.
+	memcpy(buffer, packet, CAER_EVENT_PACKET_HEADER_SIZE);
+	caerEventPacketHeaderSetEventCapacity((caerEventPacketHeader) buffer, eventNumber);
+
+	uint8_t *payload = buffer + CAER_EVENT_CODEC_HEADER_SIZE;
+	size_t payloadLength = rawSize;
+	uint8_t method = CODEC_METHOD_RAW;
+
+	if (eventNumber > 0 && codecDeltaSupported(packet)) {
+		method = CODEC_METHOD_DELTA;
+
+		switch (caerEventPacketHeaderGetEventType(packet)) {
+			case POLARITY_EVENT:
+				payloadLength = codecPolarityEncode((caerPolarityEventPacket) packet, eventNumber, payload);
+				break;
+
+			case SPECIAL_EVENT:
+				payloadLength = codecSpecialEncode((caerSpecialEventPacket) packet, eventNumber, payload);
+				break;
+
+			case FRAME_EVENT:
+				payloadLength = codecFrameEncode((caerFrameEventPacket) packet, eventNumber,
+					(size_t) caerEventPacketHeaderGetEventSize(packet), payload);
+				break;
+		}
+
+		// Incompressible data, such as random addresses and timestamps.
+		if (payloadLength >= rawSize) {
+			method = CODEC_METHOD_RAW;
+			payloadLength = rawSize;
+		}
+	}
+
+	if (method == CODEC_METHOD_RAW) {
+		memcpy(payload, ((uint8_t *) packet) + CAER_EVENT_PACKET_HEADER_SIZE, rawSize);
+	}
+
+	uint32_t payloadLengthLE = htole32(U32T(payloadLength));
+
+	buffer[CODEC_METHOD_OFFSET] = method;
+	memcpy(buffer + CODEC_PAYLOAD_LENGTH_OFFSET, &payloadLengthLE, sizeof(payloadLengthLE));
+
+	return (CAER_EVENT_CODEC_HEADER_SIZE + payloadLength);
+}
+
+size_t caerEventCodecEncodedSize(const uint8_t *buffer, size_t bufferSize) {
+	if (buffer == NULL || bufferSize < CAER_EVENT_CODEC_HEADER_SIZE) {
+		return (0);
+	}
+
+	uint32_t payloadLength;
+	memcpy(&payloadLength, buffer + CODEC_PAYLOAD_LENGTH_OFFSET, sizeof(payloadLength));
+
+	return (CAER_EVENT_CODEC_HEADER_SIZE + le32toh(payloadLength));
+}
+
+caerEventPacketHeader caerEventCodecDecode(const uint8_t *buffer, size_t bufferSize, size_t *usedSize) {
+	size_t encodedSize = caerEventCodecEncodedSize(buffer, bufferSize);
+
+	if (encodedSize == 0 || encodedSize > bufferSize) {
+		caerLog(CAER_LOG_ERROR, __func__, "Truncated encoded packet.");
+		return (NULL);
+	}
+
+	struct caer_event_packet_header header;
+	memcpy(&header, buffer, CAER_EVENT_PACKET_HEADER_SIZE);
+
+	int32_t eventSize = caerEventPacketHeaderGetEventSize(&header);
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(&header);
+
+	if (eventSize <= 0 || eventNumber < 0
+		|| (size_t) eventNumber > (SIZE_MAX - CAER_EVENT_PACKET_HEADER_SIZE) / (size_t) eventSize) {
+		caerLog(CAER_LOG_ERROR, __func__, "Invalid encoded packet header.");
+		return (NULL);
+	}
+
+	size_t rawSize = (size_t) eventNumber * (size_t) eventSize;
+	const uint8_t *payload = buffer + CAER_EVENT_CODEC_HEADER_SIZE;
+	size_t payloadLength = encodedSize - CAER_EVENT_CODEC_HEADER_SIZE;
+	uint8_t method = buffer[CODEC_METHOD_OFFSET];
+
+	if ((method == CODEC_METHOD_RAW && payloadLength != rawSize)
+		|| (method == CODEC_METHOD_DELTA && (eventNumber == 0 || !codecDeltaSupported(&header)))
+		|| (method != CODEC_METHOD_RAW && method != CODEC_METHOD_DELTA)) {
+		caerLog(CAER_LOG_ERROR, __func__, "Invalid encoded packet coding method %" PRIu8 ".", method);
+		return (NULL);
+	}
+
+	caerEventPacketHeader packet = malloc(CAER_EVENT_PACKET_HEADER_SIZE + rawSize);
+	if (packet == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for decoded packet of %zu bytes.", rawSize);
+		return (NULL);
+	}
+
+	memcpy(packet, &header, CAER_EVENT_PACKET_HEADER_SIZE);
+	caerEventPacketHeaderSetEventCapacity(packet, eventNumber);
+
+	bool decoded = true;
+
+	if (method == CODEC_METHOD_RAW) {
+		memcpy(((uint8_t *) packet) + CAER_EVENT_PACKET_HEADER_SIZE, payload, rawSize);
+	}
+	else {
+		switch (caerEventPacketHeaderGetEventType(packet)) {
+			case POLARITY_EVENT:
+				decoded = codecPolarityDecode((caerPolarityEventPacket) packet, eventNumber, payload, payloadLength);
+				break;
+
+			case SPECIAL_EVENT:
+				decoded = codecSpecialDecode((caerSpecialEventPacket) packet, eventNumber, payload, payloadLength);
+				break;
+
+			case FRAME_EVENT:
+				decoded = codecFrameDecode((caerFrameEventPacket) packet, eventNumber, (size_t) eventSize, payload,
+					payloadLength);
+				break;
+		}
+	}
+
+	if (!decoded) {
+		free(packet);
+
+		caerLog(CAER_LOG_ERROR, __func__, "Corrupted encoded packet payload.");
+		return (NULL);
+	}
+
+	if (usedSize != NULL) {
+		*usedSize = encodedSize;
+	}
+
+	return (packet);
+}
+
+static size_t codecPayloadBound(caerEventPacketHeader packet, int32_t eventNumber) {
+	if (!codecDeltaSupported(packet)) {
+		return (0);
+	}
+
+	switch (caerEventPacketHeaderGetEventType(packet)) {
+		case POLARITY_EVENT:
+			return (CODEC_POLARITY_FLAGS_SIZE(eventNumber) + ((size_t) eventNumber * CODEC_POLARITY_EVENT_MAX));
+
+		case SPECIAL_EVENT:
+			return ((size_t) eventNumber * CODEC_SPECIAL_EVENT_MAX);
+
+		case FRAME_EVENT:
+			return ((size_t) eventNumber
+				* CODEC_FRAME_EVENT_BOUND((size_t) caerEventPacketHeaderGetEventSize(packet)));
+
+		default:
+			return (0);
+	}
+}
+
+// Polarity events come in bursts from the same row and timestamp, so
+// the common case is one byte per event: the X delta with both flags
+// clear, meaning Y and timestamp are unchanged from the previous event.
+static size_t codecPolarityEncode(caerPolarityEventPacket packet, int32_t eventNumber, uint8_t *payload) {
+	uint8_t *flags = payload;
+	uint8_t *out = payload + CODEC_POLARITY_FLAGS_SIZE(eventNumber);
+
+	memset(flags, 0, CODEC_POLARITY_FLAGS_SIZE(eventNumber));
+
+	int32_t lastX = 0;
+	int32_t lastY = 0;
+	int64_t lastTimestamp = 0;
+
+	for (int32_t i = 0; i < eventNumber; i++) {
+		uint32_t data = le32toh(packet->events[i].data);
+		int64_t timestamp = I32T(le32toh(U32T(packet->events[i].timestamp)));
+
+		flags[i >> 2] = U8T(flags[i >> 2] | ((data & CODEC_POLARITY_FLAGS_MASK) << ((i & 0x03) * 2)));
+
+		int32_t x = I32T((data >> X_ADDR_SHIFT) & X_ADDR_MASK);
+		int32_t y = I32T((data >> Y_ADDR_SHIFT) & Y_ADDR_MASK);
+
+		uint64_t token = codecZigZagEncode(x - lastX) << CODEC_TOKEN_X_SHIFT;
+
+		if (y != lastY) {
+			token |= CODEC_TOKEN_Y_CHANGED;
+		}
+
+		if (timestamp != lastTimestamp) {
+			token |= CODEC_TOKEN_TS_CHANGED;
+		}
+
+		out = codecVarintPut(out, token);
+
+		if (y != lastY) {
+			out = codecVarintPut(out, codecZigZagEncode(y - lastY));
+		}
+
+		if (timestamp != lastTimestamp) {
+			out = codecVarintPut(out, codecZigZagEncode(timestamp - lastTimestamp));
+		}
+
+		lastX = x;
+		lastY = y;
+		lastTimestamp = timestamp;
+	}
+
+	return ((size_t) (out - payload));
+}
+
+static bool codecPolarityDecode(caerPolarityEventPacket packet, int32_t eventNumber, const uint8_t *payload,
+	size_t payloadLength) {
+	if (payloadLength < CODEC_POLARITY_FLAGS_SIZE(eventNumber)) {
+		return (false);
+	}
+
+	const uint8_t *flags = payload;
+	const uint8_t *in = payload + CODEC_POLARITY_FLAGS_SIZE(eventNumber);
+	const uint8_t *end = payload + payloadLength;
+
+	int64_t x = 0;
+	int64_t y = 0;
+	int64_t timestamp = 0;
+
+	for (int32_t i = 0; i < eventNumber; i++) {
+		uint64_t token;
+		int64_t delta;
+		if ((in = codecVarintGet(in, end, &token)) == NULL || !codecDeltaDecode(token >> CODEC_TOKEN_X_SHIFT, &delta)) {
+			return (false);
+		}
+
+		x += delta;
+
+		if (token & CODEC_TOKEN_Y_CHANGED) {
+			uint64_t value;
+			if ((in = codecVarintGet(in, end, &value)) == NULL || !codecDeltaDecode(value, &delta)) {
+				return (false);
+			}
+
+			y += delta;
+		}
+
+		if (token & CODEC_TOKEN_TS_CHANGED) {
+			uint64_t value;
+			if ((in = codecVarintGet(in, end, &value)) == NULL || !codecDeltaDecode(value, &delta)) {
+				return (false);
+			}
+
+			timestamp += delta;
+		}
+
+		if (x < 0 || x > X_ADDR_MASK || y < 0 || y > Y_ADDR_MASK || timestamp < INT32_MIN || timestamp > INT32_MAX) {
+			return (false);
+		}
+
+		uint32_t data = U32T((flags[i >> 2] >> ((i & 0x03) * 2)) & CODEC_POLARITY_FLAGS_MASK)
+			| (U32T(y) << Y_ADDR_SHIFT) | (U32T(x) << X_ADDR_SHIFT);
+
+		packet->events[i].data = htole32(data);
+		packet->events[i].timestamp = I32T(htole32(U32T(timestamp)));
+	}
+
+	return (in == end);
+}
+
+static size_t codecSpecialEncode(caerSpecialEventPacket packet, int32_t eventNumber, uint8_t *payload) {
+	uint8_t *out = payload;
+	int64_t lastTimestamp = 0;
+
+	for (int32_t i = 0; i < eventNumber; i++) {
+		uint32_t data = le32toh(packet->events[i].data);
+		int64_t timestamp = I32T(le32toh(U32T(packet->events[i].timestamp)));
+
+		out = codecVarintPut(out, codecZigZagEncode(timestamp - lastTimestamp));
+		out = codecVarintPut(out, data);
+
+		lastTimestamp = timestamp;
+	}
+
+	return ((size_t) (out - payload));
+}
+
+static bool codecSpecialDecode(caerSpecialEventPacket packet, int32_t eventNumber, const uint8_t *payload,
+	size_t payloadLength) {
+	const uint8_t *in = payload;
+	const uint8_t *end = payload + payloadLength;
+	int64_t timestamp = 0;
+
+	for (int32_t i = 0; i < eventNumber; i++) {
+		uint64_t value;
+		int64_t delta;
+		uint64_t data;
+
+		if ((in = codecVarintGet(in, end, &value)) == NULL || !codecDeltaDecode(value, &delta)
+			|| (in = codecVarintGet(in, end, &data)) == NULL) {
+			return (false);
+		}
+
+		timestamp += delta;
+
+		if (data > UINT32_MAX || timestamp < INT32_MIN || timestamp > INT32_MAX) {
+			return (false);
+		}
+
+		packet->events[i].data = htole32(U32T(data));
+		packet->events[i].timestamp = I32T(htole32(U32T(timestamp)));
+	}
+
+	return (in == end);
+}
+
+// Number of pixel values (all channels) of a frame event, or -1 if its
+// size information is invalid or doesn't fit into the event.
+static inline int64_t codecFrameSamples(caerFrameEvent frame, size_t eventSize) {
+	int64_t lengthX = caerFrameEventGetLengthX(frame);
+	int64_t lengthY = caerFrameEventGetLengthY(frame);
+	int64_t channels = caerFrameEventGetChannelNumber(frame);
+
+	int64_t samplesMax = I64T((eventSize - CODEC_FRAME_FIXED_SIZE) / sizeof(uint16_t));
+
+	// Check the lengths first, so their product can't overflow.
+	if (lengthX < 0 || lengthY < 0 || channels == 0 || lengthX > samplesMax || lengthY > samplesMax) {
+		return (-1);
+	}
+
+	int64_t samples = lengthX * lengthY * channels;
+
+	if (samples > samplesMax) {
+		return (-1);
+	}
+
+	return (samples);
+}
+
+// LOCO-I (JPEG-LS) median edge detector: predict a pixel from its left (a),
+// upper (b) and upper-left (c) neighbours, which tracks horizontal and
+// vertical edges.
+static inline int32_t codecFramePredict(int32_t a, int32_t b, int32_t c) {
+	int32_t minAB = (a < b) ? (a) : (b);
+	int32_t maxAB = (a < b) ? (b) : (a);
+
+	return ((c >= maxAB) ? (minAB) : ((c <= minAB) ? (maxAB) : (a + b - c)));
+}
+
+// Prediction residuals of all values, channels being interleaved. The first
+// row is predicted from the left value, the first column from the upper one.
+static void codecFrameResiduals(const int32_t *values, uint32_t *residuals, int32_t lengthX, int32_t lengthY,
+	int32_t channels) {
+	int64_t rowLength = I64T(lengthX) * channels;
+
+	for (int64_t i = 0; i < rowLength; i++) {
+		int32_t prediction = (i < channels) ? (0) : (values[i - channels]);
+		residuals[i] = U32T(codecZigZagEncode(values[i] - prediction));
+	}
+
+	for (int32_t y = 1; y < lengthY; y++) {
+		const int32_t *row = values + (y * rowLength);
+		const int32_t *upperRow = row - rowLength;
+		uint32_t *rowResiduals = residuals + (y * rowLength);
+
+		for (int32_t c = 0; c < channels; c++) {
+			rowResiduals[c] = U32T(codecZigZagEncode(row[c] - upperRow[c]));
+		}
+
+		for (int64_t i = channels; i < rowLength; i++) {
+			int32_t prediction = codecFramePredict(row[i - channels], upperRow[i], upperRow[i - channels]);
+			rowResiduals[i] = U32T(codecZigZagEncode(row[i] - prediction));
+		}
+	}
+}
+
+// Values outside [0, valueMax] only come from corrupted data: flag them, and
+// clamp them, so that the predictions and sums based on them can't overflow.
+static inline int32_t codecFrameValueCheck(int32_t value, int32_t valueMax, bool *outOfRange) {
+	*outOfRange |= (value < 0) | (value > valueMax);
+
+	return ((value < 0) ? (0) : ((value > valueMax) ? (valueMax) : (value)));
+}
+
+// Inverse of codecFrameResiduals(). Returns false if any value falls
+// outside [0, valueMax], which only happens with corrupted data.
+static bool codecFrameReconstruct(int32_t *values, const uint32_t *residuals, int32_t lengthX, int32_t lengthY,
+	int32_t channels, int32_t valueMax) {
+	int64_t rowLength = I64T(lengthX) * channels;
+	bool outOfRange = false;
+
+	for (int64_t i = 0; i < rowLength; i++) {
+		int32_t prediction = (i < channels) ? (0) : (values[i - channels]);
+		values[i] = codecFrameValueCheck(prediction + I32T(codecZigZagDecode(residuals[i])), valueMax, &outOfRange);
+	}
+
+	for (int32_t y = 1; y < lengthY; y++) {
+		int32_t *row = values + (y * rowLength);
+		const int32_t *upperRow = row - rowLength;
+		const uint32_t *rowResiduals = residuals + (y * rowLength);
+
+		for (int32_t c = 0; c < channels; c++) {
+			row[c] = codecFrameValueCheck(upperRow[c] + I32T(codecZigZagDecode(rowResiduals[c])), valueMax,
+				&outOfRange);
+		}
+
+		for (int64_t i = channels; i < rowLength; i++) {
+			int32_t prediction = codecFramePredict(row[i - channels], upperRow[i], upperRow[i - channels]);
+			row[i] = codecFrameValueCheck(prediction + I32T(codecZigZagDecode(rowResiduals[i])), valueMax,
+				&outOfRange);
+		}
+	}
+
+	return (!outOfRange);
+}
+
+// Working memory for one frame: unpacked values and their residuals,
+// the latter padded to a whole number of blocks.
+struct codec_frame_memory {
+	int32_t *values;
+	uint32_t *residuals;
+};
+
+static bool codecFrameMemoryAllocate(struct codec_frame_memory *memory, size_t eventSize) {
+	size_t samplesMax = (eventSize - CODEC_FRAME_FIXED_SIZE) / sizeof(uint16_t);
+
+	memory->values = malloc((samplesMax + CODEC_FRAME_BLOCK_SIZE) * sizeof(int32_t));
+	memory->residuals = malloc((samplesMax + CODEC_FRAME_BLOCK_SIZE) * sizeof(uint32_t));
+
+	if (memory->values == NULL || memory->residuals == NULL) {
+		free(memory->values);
+		free(memory->residuals);
+		return (false);
+	}
+
+	return (true);
+}
+
+static void codecFrameMemoryFree(struct codec_frame_memory *memory) {
+	free(memory->values);
+	free(memory->residuals);
+}
+
+static size_t codecFrameEventEncode(caerFrameEvent frame, size_t eventSize, uint8_t *out,
+	struct codec_frame_memory *memory) {
+	uint8_t *start = out;
+	int64_t samples = codecFrameSamples(frame, eventSize);
+
+	if (samples < 0) {
+		*out++ = CODEC_FRAME_EVENT_RAW;
+		memcpy(out, frame, eventSize);
+		return (1 + eventSize);
+	}
+
+	int32_t *values = memory->values;
+	uint32_t *residuals = memory->residuals;
+
+	// Pixels are normalized to 16 bit, so a 10 bit ADC (APS_ADC_DEPTH)
+	// leaves the lowest 6 bits at zero: find and drop such common zero bits.
+	uint32_t allBits = 0;
+
+	for (int64_t i = 0; i < samples; i++) {
+		values[i] = le16toh(frame->pixels[i]);
+		allBits |= U32T(values[i]);
+	}
+
+	uint8_t shift = 0;
+
+	while (allBits != 0 && shift < 15 && (allBits & (1U << shift)) == 0) {
+		shift++;
+	}
+
+	for (int64_t i = 0; i < samples; i++) {
+		values[i] >>= shift;
+	}
+
+	codecFrameResiduals(values, residuals, caerFrameEventGetLengthX(frame), caerFrameEventGetLengthY(frame),
+		caerFrameEventGetChannelNumber(frame));
+
+	// Unused memory after the pixels, normally zero.
+	const uint8_t *unused = ((uint8_t *) frame) + CODEC_FRAME_FIXED_SIZE + (U64T(samples) * sizeof(uint16_t));
+	size_t unusedSize = eventSize - CODEC_FRAME_FIXED_SIZE - (U64T(samples) * sizeof(uint16_t));
+	bool unusedZero = true;
+
+	for (size_t i = 0; i < unusedSize; i++) {
+		if (unused[i] != 0) {
+			unusedZero = false;
+			break;
+		}
+	}
+
+	*out++ = CODEC_FRAME_EVENT_PREDICTED;
+	*out++ = shift;
+	*out++ = unusedZero;
+
+	memcpy(out, frame, CODEC_FRAME_FIXED_SIZE);
+	out += CODEC_FRAME_FIXED_SIZE;
+
+	// Pad the last block with zero residuals.
+	for (int64_t i = samples; i < ((samples + CODEC_FRAME_BLOCK_SIZE - 1) & ~I64T(CODEC_FRAME_BLOCK_SIZE - 1)); i++) {
+		residuals[i] = 0;
+	}
+
+	for (int64_t blockStart = 0; blockStart < samples; blockStart += CODEC_FRAME_BLOCK_SIZE) {
+		const uint32_t *block = residuals + blockStart;
+		uint32_t blockBits = 0;
+
+		for (size_t j = 0; j < CODEC_FRAME_BLOCK_SIZE; j++) {
+			blockBits |= block[j];
+		}
+
+		uint8_t width = 0;
+
+		while (blockBits != 0) {
+			width++;
+			blockBits >>= 1;
+		}
+
+		*out++ = width;
+
+		// 16 residuals of 'width' bits: always a whole number of bytes.
+		uint64_t accumulator = 0;
+		uint32_t accumulatorBits = 0;
+
+		for (size_t j = 0; j < CODEC_FRAME_BLOCK_SIZE; j++) {
+			accumulator |= U64T(block[j]) << accumulatorBits;
+			accumulatorBits += width;
+
+			while (accumulatorBits >= 8) {
+				*out++ = U8T(accumulator);
+				accumulator >>= 8;
+				accumulatorBits -= 8;
+			}
+		}
+	}
+
+	if (!unusedZero) {
+		memcpy(out, unused, unusedSize);
+		out += unusedSize;
+	}
+
+	// Noise-like content, such as a frame of random pixels.
+	if ((size_t) (out - start) > (1 + eventSize)) {
+		*start = CODEC_FRAME_EVENT_RAW;
+		memcpy(start + 1, frame, eventSize);
+		return (1 + eventSize);
+	}
+
+	return ((size_t) (out - start));
+}
+
+static size_t codecFrameEncode(caerFrameEventPacket packet, int32_t eventNumber, size_t eventSize, uint8_t *payload) {
+	struct codec_frame_memory memory;
+
+	if (!codecFrameMemoryAllocate(&memory, eventSize)) {
+		// Makes the packet be stored raw.
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for frame encoding.");
+		return (SIZE_MAX);
+	}
+
+	uint8_t *out = payload;
+
+	for (int32_t i = 0; i < eventNumber; i++) {
+		out += codecFrameEventEncode(caerFrameEventPacketGetEvent(packet, i), eventSize, out, &memory);
+	}
+
+	codecFrameMemoryFree(&memory);
+
+	return ((size_t) (out - payload));
+}
+
+// Unpack one block of 16 residuals of the given width, which the compiler
+// can fully unroll and vectorize for each width.
+static inline void codecFrameUnpackBlock(const uint8_t *in, uint32_t *block, uint32_t width) {
+	uint64_t accumulator = 0;
+	uint32_t accumulatorBits = 0;
+	uint32_t widthMask = (1U << width) - 1;
+
+	for (size_t j = 0; j < CODEC_FRAME_BLOCK_SIZE; j++) {
+		while (accumulatorBits < width) {
+			accumulator |= U64T(*in++) << accumulatorBits;
+			accumulatorBits += 8;
+		}
+
+		block[j] = U32T(accumulator) & widthMask;
+		accumulator >>= width;
+		accumulatorBits -= width;
+	}
+}
+
+static const uint8_t *codecFrameEventDecode(caerFrameEvent frame, size_t eventSize, const uint8_t *in,
+	const uint8_t *end, struct codec_frame_memory *memory) {
+	if (in == end) {
+		return (NULL);
+	}
+
+	uint8_t mode = *in++;
+
+	if (mode == CODEC_FRAME_EVENT_RAW) {
+		if ((size_t) (end - in) < eventSize) {
+			return (NULL);
+		}
+
+		memcpy(frame, in, eventSize);
+		return (in + eventSize);
+	}
+
+	if (mode != CODEC_FRAME_EVENT_PREDICTED || (size_t) (end - in) < (2 + CODEC_FRAME_FIXED_SIZE)) {
+		return (NULL);
+	}
+
+	uint8_t shift = *in++;
+	uint8_t unusedZero = *in++;
+
+	if (shift > 15 || unusedZero > 1) {
+		return (NULL);
+	}
+
+	memcpy(frame, in, CODEC_FRAME_FIXED_SIZE);
+	in += CODEC_FRAME_FIXED_SIZE;
+
+	int64_t samples = codecFrameSamples(frame, eventSize);
+	if (samples < 0) {
+		return (NULL);
+	}
+
+	int32_t *values = memory->values;
+	uint32_t *residuals = memory->residuals;
+
+	for (int64_t blockStart = 0; blockStart < samples; blockStart += CODEC_FRAME_BLOCK_SIZE) {
+		if (in == end) {
+			return (NULL);
+		}
+
+		uint8_t width = *in++;
+		size_t blockBytes = (size_t) width * (CODEC_FRAME_BLOCK_SIZE / 8);
+
+		if (width > CODEC_FRAME_WIDTH_MAX || (size_t) (end - in) < blockBytes) {
+			return (NULL);
+		}
+
+		codecFrameUnpackBlock(in, residuals + blockStart, width);
+		in += blockBytes;
+	}
+
+	if (!codecFrameReconstruct(values, residuals, caerFrameEventGetLengthX(frame), caerFrameEventGetLengthY(frame),
+		caerFrameEventGetChannelNumber(frame), UINT16_MAX >> shift)) {
+		return (NULL);
+	}
+
+	for (int64_t i = 0; i < samples; i++) {
+		frame->pixels[i] = htole16(U16T(values[i] << shift));
+	}
+
+	uint8_t *unused = ((uint8_t *) frame) + CODEC_FRAME_FIXED_SIZE + (U64T(samples) * sizeof(uint16_t));
+	size_t unusedSize = eventSize - CODEC_FRAME_FIXED_SIZE - (U64T(samples) * sizeof(uint16_t));
+
+	if (unusedZero) {
+		memset(unused, 0, unusedSize);
+	}
+	else {
+		if ((size_t) (end - in) < unusedSize) {
+			return (NULL);
+		}
+
+		memcpy(unused, in, unusedSize);
+		in += unusedSize;
+	}
+
+	return (in);
+}
+
+static bool codecFrameDecode(caerFrameEventPacket packet, int32_t eventNumber, size_t eventSize, const uint8_t *payload,
+	size_t payloadLength) {
+	struct codec_frame_memory memory;
+
+	if (!codecFrameMemoryAllocate(&memory, eventSize)) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for frame decoding.");
+		return (false);
+	}
+
+	const uint8_t *in = payload;
+	const uint8_t *end = payload + payloadLength;
+
+	for (int32_t i = 0; i < eventNumber && in != NULL; i++) {
+		in = codecFrameEventDecode(caerFrameEventPacketGetEvent(packet, i), eventSize, in, end, &memory);
+	}
+
+	codecFrameMemoryFree(&memory);
+
+	return (in == end);
+}
@@ -12,22 +12,41 @@
 #include "events/point3d.h"
 #include "events/point4d.h"
 
+// Host-side timing information, see caerEventPacketContainerGetHost*Timestamp().
+// Kept in front of the container in the same allocation, so that the public
+// container struct, and with it the library ABI, stays unchanged.
+struct caer_event_packet_container_host_times {
+	int64_t transferTimestamp;
+	int64_t commitTimestamp;
+	int64_t getTimestamp;
+};
+
+static inline struct caer_event_packet_container_host_times *containerHostTimes(caerEventPacketContainer container) {
+	return ((struct caer_event_packet_container_host_times *) container - 1);
+}
+
 caerEventPacketContainer caerEventPacketContainerAllocate(int32_t eventPacketsNumber) {
 	if (eventPacketsNumber == 0) {
 		return (NULL);
 	}
 
-	size_t eventPacketContainerSize = sizeof(struct caer_event_packet_container)
-		+ ((size_t) eventPacketsNumber * sizeof(caerEventPacketHeader));
+	size_t eventPacketContainerSize = sizeof(struct caer_event_packet_container_host_times)
+		+ sizeof(struct caer_event_packet_container) + ((size_t) eventPacketsNumber * sizeof(caerEventPacketHeader));
 
-	caerEventPacketContainer packetContainer = calloc(1, eventPacketContainerSize);
-	if (packetContainer == NULL) {
+	struct caer_event_packet_container_host_times *hostTimes = calloc(1, eventPacketContainerSize);
+	if (hostTimes == NULL) {
 		caerLog(CAER_LOG_CRITICAL, "EventPacket Container",
 			"Failed to allocate %zu bytes of memory for Event Packet Container, containing %"
 			PRIi32 " packets. Error: %d.", eventPacketContainerSize, eventPacketsNumber, errno);
 		return (NULL);
 	}
 
+	hostTimes->transferTimestamp = -1;
+	hostTimes->commitTimestamp = -1;
+	hostTimes->getTimestamp = -1;
+
+	caerEventPacketContainer packetContainer = (caerEventPacketContainer) (hostTimes + 1);
+
 	// Fill in header fields. Don't care about endianness here, purely internal
 	// memory construct, never meant for inter-system exchange.
 	packetContainer->eventPacketsNumber = eventPacketsNumber;
@@ -51,7 +70,58 @@ void caerEventPacketContainerFree(caerEventPacketContainer container) {
 		}
 	}
 
-	free(container);
+	free(containerHostTimes(container));
+}
+
+int64_t caerEventPacketContainerGetHostTransferTimestamp(caerEventPacketContainer container) {
+	// Non-existing (empty) containers have no valid timestamps.
+	if (container == NULL) {
+		return (-1);
+	}
+
+	return (containerHostTimes(container)->transferTimestamp);
+}
+
+void caerEventPacketContainerSetHostTransferTimestamp(caerEventPacketContainer container, int64_t hostTransferTimestamp) {
+	if (container == NULL) {
+		return;
+	}
+
+	containerHostTimes(container)->transferTimestamp = hostTransferTimestamp;
+}
+
+int64_t caerEventPacketContainerGetHostCommitTimestamp(caerEventPacketContainer container) {
+	// Non-existing (empty) containers have no valid timestamps.
+	if (container == NULL) {
+		return (-1);
+	}
+
+	return (containerHostTimes(container)->commitTimestamp);
+}
+
+void caerEventPacketContainerSetHostCommitTimestamp(caerEventPacketContainer container, int64_t hostCommitTimestamp) {
+	if (container == NULL) {
+		return;
+	}
+
+	containerHostTimes(container)->commitTimestamp = hostCommitTimestamp;
+}
+
+int64_t caerEventPacketContainerGetHostGetTimestamp(caerEventPacketContainer container) {
+	// Non-existing (empty) containers have no valid timestamps.
+	if (container == NULL) {
+		return (-1);
+	}
+
+	return (containerHostTimes(container)->getTimestamp);
+}
+
+void caerEventPacketContainerSetHostGetTimestamp(caerEventPacketContainer container, int64_t hostGetTimestamp) {
+	if (container == NULL) {
+		return;
+	}
+
+	containerHostTimes(container)->getTimestamp = hostGetTimestamp;
 }
 
 caerSpecialEventPacket caerSpecialEventPacketAllocate(int32_t eventCapacity, int16_t eventSource, int32_t tsOverflow) {
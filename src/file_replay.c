@@ -0,0 +1,750 @@
+#include "file_replay.h"
+#include "aedat_format.h"
+#include "event_codec.h"
+#include "probes.h"
+
+#define REPLAY_FILE_BUFFER_SIZE (1024 * 1024)
+#define REPLAY_PACING_SLEEP_MAX 10000000LL // 10 ms in ns, to react quickly to shutdown.
+
+static bool replayParseHeader(replayHandle handle, const char *fileName);
+static bool replayParseFormat(replayHandle handle, const char *format, const char *fileName);
+static caerEventPacketHeader replayReadPacket(replayHandle handle);
+static caerEventPacketHeader replayReadEncodedPacket(replayHandle handle);
+static bool replayPacketHeaderValid(replayHandle handle, caerEventPacketHeader header);
+static void replayCommitContainer(replayHandle handle);
+static void replayPace(replayState state, int64_t timestamp);
+static int replayDataAcquisitionThread(void *inPtr);
+
+static inline void freeAllDataMemory(replayState state) {
+	dataExchangeBufferFree(&state->dataExchange);
+
+	if (state->currentPacketContainer != NULL) {
+		caerEventPacketContainerFree(state->currentPacketContainer);
+		state->currentPacketContainer = NULL;
+	}
+}
+
+caerDeviceHandle replayOpen(uint16_t deviceID, const char *fileName) {
+	caerLog(CAER_LOG_DEBUG, __func__, "Initializing %s.", REPLAY_DEVICE_NAME);
+
+	if (fileName == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "No file name given for %s device.", REPLAY_DEVICE_NAME);
+		return (NULL);
+	}
+
+	replayHandle handle = calloc(1, sizeof(*handle));
+	if (handle == NULL) {
+		// Failed to allocate memory for device handle!
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for device handle.");
+		return (NULL);
+	}
+
+	// Set main deviceType correctly right away.
+	handle->deviceType = CAER_DEVICE_FILE_REPLAY;
+
+	replayState state = &handle->state;
+
+	// Initialize state variables to default values (if not zero, taken care of by calloc above).
+	dataExchangeSettingsInit(&state->dataExchange);
+
+	// A recording can always wait for the consumer, so don't drop by default.
+	atomic_store_explicit(&state->dataExchange.policy, CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_BLOCK_PRODUCER,
+		memory_order_relaxed);
+
+	atomic_store_explicit(&state->realTime, true, memory_order_relaxed);
+	atomic_store_explicit(&state->sourceID, 0, memory_order_relaxed);
+
+	atomic_thread_fence(memory_order_release);
+
+	// Set device thread name. Maximum length of 15 chars due to Linux limitations.
+	snprintf(state->deviceThreadName, 15 + 1, "%s ID-%" PRIu16, REPLAY_DEVICE_NAME, deviceID);
+	state->deviceThreadName[15] = '\0';
+
+	state->file = fopen(fileName, "rb");
+	if (state->file == NULL) {
+		free(handle);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open file '%s'. Error: %d.", fileName, errno);
+		return (NULL);
+	}
+
+	// Packets are read sequentially, in many small chunks (header, then events).
+	setvbuf(state->file, NULL, _IOFBF, REPLAY_FILE_BUFFER_SIZE);
+
+	if (!replayParseHeader(handle, fileName)) {
+		fclose(state->file);
+		free(handle);
+
+		// Error already logged.
+		return (NULL);
+	}
+
+	size_t fileNameLength = strlen(fileName);
+
+	char *fileNameCopy = malloc(fileNameLength + 1);
+	if (fileNameCopy == NULL) {
+		fclose(state->file);
+		free(handle);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Unable to allocate memory for %s device file name.",
+			REPLAY_DEVICE_NAME);
+		return (NULL);
+	}
+
+	strncpy(fileNameCopy, fileName, fileNameLength + 1);
+
+	size_t fullLogStringLength = (size_t) snprintf(NULL, 0, "%s ID-%" PRIu16 " [%s]", REPLAY_DEVICE_NAME, deviceID,
+		fileName);
+
+	char *fullLogString = malloc(fullLogStringLength + 1);
+	if (fullLogString == NULL) {
+		free(fileNameCopy);
+		fclose(state->file);
+		free(handle);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Unable to allocate memory for %s device info string.",
+			REPLAY_DEVICE_NAME);
+		return (NULL);
+	}
+
+	snprintf(fullLogString, fullLogStringLength + 1, "%s ID-%" PRIu16 " [%s]", REPLAY_DEVICE_NAME, deviceID,
+		fileName);
+
+	handle->info.deviceID = I16T(deviceID);
+	handle->info.deviceString = fullLogString;
+	handle->info.fileName = fileNameCopy;
+
+	caerLog(CAER_LOG_DEBUG, fullLogString, "Initialized device successfully with AEDAT 3.%" PRIi8 " file.",
+		handle->info.formatVersionMinor);
+
+	return ((caerDeviceHandle) handle);
+}
+
+bool replayClose(caerDeviceHandle cdh) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "Shutting down ...");
+
+	fclose(state->file);
+
+	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "Shutdown successful.");
+
+	// Free memory.
+	free(handle->info.fileName);
+	free(handle->info.deviceString);
+	free(handle);
+
+	return (true);
+}
+
+struct caer_replay_info caerReplayInfoGet(caerDeviceHandle cdh) {
+	replayHandle handle = (replayHandle) cdh;
+
+	// Check if the pointer is valid.
+	if (handle == NULL) {
+		struct caer_replay_info emptyInfo = { 0, .deviceString = NULL, .fileName = NULL };
+		return (emptyInfo);
+	}
+
+	// Check if device type is supported.
+	if (handle->deviceType != CAER_DEVICE_FILE_REPLAY) {
+		struct caer_replay_info emptyInfo = { 0, .deviceString = NULL, .fileName = NULL };
+		return (emptyInfo);
+	}
+
+	// Return a copy of the device information.
+	return (handle->info);
+}
+
+bool replaySendDefaultConfig(caerDeviceHandle cdh) {
+	// Nothing to configure on a recording.
+	(void) (cdh);
+
+	return (true);
+}
+
+bool replayConfigSet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint32_t param) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	switch (modAddr) {
+		case CAER_HOST_CONFIG_DATAEXCHANGE:
+			return (dataExchangeConfigSet(&state->dataExchange, paramAddr, param));
+			break;
+
+		case CAER_HOST_CONFIG_REPLAY:
+			switch (paramAddr) {
+				case CAER_HOST_CONFIG_REPLAY_REAL_TIME:
+					atomic_store(&state->realTime, param);
+					break;
+
+				case CAER_HOST_CONFIG_REPLAY_SOURCE_ID:
+					if (param > INT16_MAX) {
+						return (false);
+					}
+
+					atomic_store(&state->sourceID, I32T(param));
+					break;
+
+				default:
+					return (false);
+					break;
+			}
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+bool replayConfigGet(caerDeviceHandle cdh, int8_t modAddr, uint8_t paramAddr, uint32_t *param) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	switch (modAddr) {
+		case CAER_HOST_CONFIG_DATAEXCHANGE:
+			return (dataExchangeConfigGet(&state->dataExchange, paramAddr, param));
+			break;
+
+		case CAER_HOST_CONFIG_REPLAY:
+			switch (paramAddr) {
+				case CAER_HOST_CONFIG_REPLAY_REAL_TIME:
+					*param = atomic_load(&state->realTime);
+					break;
+
+				case CAER_HOST_CONFIG_REPLAY_SOURCE_ID:
+					*param = U32T(atomic_load(&state->sourceID));
+					break;
+
+				default:
+					return (false);
+					break;
+			}
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+bool replayDataStart(caerDeviceHandle cdh, void (*dataNotifyIncrease)(void *ptr), void (*dataNotifyDecrease)(void *ptr),
+	void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr), void *dataShutdownUserPtr) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	// Store new data available/not available anymore call-backs.
+	state->dataExchange.notifyIncrease = dataNotifyIncrease;
+	state->dataExchange.notifyDecrease = dataNotifyDecrease;
+	state->dataExchange.notifyUserPtr = dataNotifyUserPtr;
+	state->dataExchange.committedContainers = &state->stats.containersCommitted;
+	state->dataShutdownNotify = dataShutdownNotify;
+	state->dataShutdownUserPtr = dataShutdownUserPtr;
+
+	// Initialize RingBuffer.
+	if (!dataExchangeBufferInit(&state->dataExchange)) {
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to initialize data exchange buffer.");
+		return (false);
+	}
+
+	// Always replay from the start of the recording.
+	if (fseek(state->file, state->dataOffset, SEEK_SET) != 0) {
+		freeAllDataMemory(state);
+
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to seek to start of recording. Error: %d.",
+		errno);
+		return (false);
+	}
+
+	state->pacingHostTime = -1;
+	state->pacingTimestamp = -1;
+
+	if (!threadReadyInit(&state->dataAcquisitionThreadReady)) {
+		freeAllDataMemory(state);
+
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to initialize data acquisition thread start.");
+		return (false);
+	}
+
+	if ((errno = thrd_create(&state->dataAcquisitionThread, &replayDataAcquisitionThread, handle)) != thrd_success) {
+		threadReadyDestroy(&state->dataAcquisitionThreadReady);
+		freeAllDataMemory(state);
+
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to start data acquisition thread. Error: %d.",
+		errno);
+		return (false);
+	}
+
+	// Wait for the data acquisition thread to be ready.
+	threadReadyWait(&state->dataAcquisitionThreadReady);
+	threadReadyDestroy(&state->dataAcquisitionThreadReady);
+
+	return (true);
+}
+
+bool replayDataStop(caerDeviceHandle cdh) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	atomic_store(&state->dataAcquisitionThreadRun, false);
+
+	// Wait for data acquisition thread to terminate...
+	if ((errno = thrd_join(state->dataAcquisitionThread, NULL)) != thrd_success) {
+		// This should never happen!
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString, "Failed to join data acquisition thread. Error: %d.",
+		errno);
+		return (false);
+	}
+
+	// Empty ringbuffer and overflow list.
+	dataExchangeBufferEmpty(&state->dataExchange);
+
+	// Free current, uncommitted packets and ringbuffer.
+	freeAllDataMemory(state);
+
+	return (true);
+}
+
+// Remember to properly free the returned memory after usage!
+caerEventPacketContainer replayDataGet(caerDeviceHandle cdh) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	return (dataExchangeGet(&state->dataExchange));
+}
+
+// Remember to properly free the returned memory after usage!
+size_t replayDataGetMany(caerDeviceHandle cdh, caerEventPacketContainer *containers, size_t maxContainers) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	return (dataExchangeGetMany(&state->dataExchange, containers, maxContainers));
+}
+
+bool replayDataNotifyDecreaseManySet(caerDeviceHandle cdh, void (*dataNotifyDecreaseMany)(void *ptr, size_t count)) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	state->dataExchange.notifyDecreaseMany = dataNotifyDecreaseMany;
+
+	return (true);
+}
+
+bool replayLatencyStatsGet(caerDeviceHandle cdh, uint8_t stage, struct caer_latency_stats *stats) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	return (dataExchangeLatencyStatsGet(&state->dataExchange, stage, stats));
+}
+
+bool replayLatencyStatsReset(caerDeviceHandle cdh) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	dataExchangeLatencyStatsReset(&state->dataExchange);
+
+	return (true);
+}
+
+bool replayStatsGet(caerDeviceHandle cdh, struct caer_device_stats *stats) {
+	replayHandle handle = (replayHandle) cdh;
+	replayState state = &handle->state;
+
+	deviceStatsGet(&state->stats, stats);
+
+	return (true);
+}
+
+static bool replayParseHeader(replayHandle handle, const char *fileName) {
+	replayState state = &handle->state;
+	char line[REPLAY_HEADER_LINE_MAX];
+	bool lineStart = true;
+	bool firstLine = true;
+
+	// The AEDAT 3.x header is a sequence of text lines starting with '#',
+	// the first giving the format version, the last being '#!END-HEADER'.
+	while (fgets(line, REPLAY_HEADER_LINE_MAX, state->file) != NULL) {
+		bool isLineStart = lineStart;
+		size_t lineLength = strlen(line);
+
+		// Overlong lines are read in pieces, only look at their beginning.
+		lineStart = (lineLength > 0 && line[lineLength - 1] == '\n');
+
+		if (!isLineStart) {
+			continue;
+		}
+
+		if (firstLine) {
+			firstLine = false;
+
+			if (strncmp(line, "#!AER-DAT3.", 11) != 0 || line[11] < '0' || line[11] > '9') {
+				caerLog(CAER_LOG_CRITICAL, __func__, "File '%s' is not an AEDAT 3.x recording.", fileName);
+				return (false);
+			}
+
+			handle->info.formatVersionMinor = I8T(line[11] - '0');
+			continue;
+		}
+
+		if (strncmp(line, AEDAT_FORMAT_LINE, strlen(AEDAT_FORMAT_LINE)) == 0) {
+			if (!replayParseFormat(handle, line + strlen(AEDAT_FORMAT_LINE), fileName)) {
+				return (false);
+			}
+
+			continue;
+		}
+
+		if (strncmp(line, "#!END-HEADER", 12) == 0) {
+			state->dataOffset = ftell(state->file);
+			return (true);
+		}
+
+		if (line[0] != '#') {
+			break;
+		}
+	}
+
+	caerLog(CAER_LOG_CRITICAL, __func__, "File '%s' has no valid AEDAT 3.x header.", fileName);
+	return (false);
+}
+
+static bool replayParseFormat(replayHandle handle, const char *format, const char *fileName) {
+	size_t formatLength = strcspn(format, "\r\n");
+
+	if (formatLength == strlen(AEDAT_FORMAT_RAW) && strncmp(format, AEDAT_FORMAT_RAW, formatLength) == 0) {
+		handle->state.compressed = false;
+		return (true);
+	}
+
+	if (formatLength == strlen(AEDAT_FORMAT_EVENT_CODEC)
+		&& strncmp(format, AEDAT_FORMAT_EVENT_CODEC, formatLength) == 0) {
+		handle->state.compressed = true;
+		return (true);
+	}
+
+	caerLog(CAER_LOG_CRITICAL, __func__, "File '%s' has unsupported format '%.*s'.", fileName, (int) formatLength,
+		format);
+	return (false);
+}
+
+static caerEventPacketHeader replayReadPacket(replayHandle handle) {
+	replayState state = &handle->state;
+
+	if (state->compressed) {
+		return (replayReadEncodedPacket(handle));
+	}
+
+	struct caer_event_packet_header header;
+
+	size_t headerRead = fread(&header, 1, CAER_EVENT_PACKET_HEADER_SIZE, state->file);
+	if (headerRead == 0 && feof(state->file)) {
+		caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "End of recording reached.");
+		return (NULL);
+	}
+
+	if (headerRead != CAER_EVENT_PACKET_HEADER_SIZE) {
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Truncated event packet header, stopping replay.");
+		return (NULL);
+	}
+
+	if (!replayPacketHeaderValid(handle, &header)) {
+		return (NULL);
+	}
+
+	// Event data follows the header, capacity times the event size.
+	size_t dataSize = (size_t) caerEventPacketHeaderGetEventCapacity(&header)
+		* (size_t) caerEventPacketHeaderGetEventSize(&header);
+
+	caerEventPacketHeader packet = malloc(CAER_EVENT_PACKET_HEADER_SIZE + dataSize);
+	if (packet == NULL) {
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString,
+			"Failed to allocate memory for event packet of %zu bytes, stopping replay.", dataSize);
+		return (NULL);
+	}
+
+	memcpy(packet, &header, CAER_EVENT_PACKET_HEADER_SIZE);
+
+	if (fread(((uint8_t *) packet) + CAER_EVENT_PACKET_HEADER_SIZE, 1, dataSize, state->file) != dataSize) {
+		free(packet);
+
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Truncated event packet data, stopping replay.");
+		return (NULL);
+	}
+
+	deviceStatsIncrease(&state->stats.bytesReceived, CAER_EVENT_PACKET_HEADER_SIZE + dataSize);
+
+	return (packet);
+}
+
+static void replayPace(replayState state, int64_t timestamp) {
+	if (!atomic_load_explicit(&state->realTime, memory_order_relaxed) || timestamp < 0) {
+		// Re-synchronize when real-time pacing is enabled again.
+		state->pacingHostTime = -1;
+		return;
+	}
+
+	int64_t now = dataExchangeHostTime();
+
+	// First container, or timestamps jumped back (timestamp reset in the recording).
+	if (state->pacingHostTime < 0 || timestamp < state->pacingTimestamp) {
+		state->pacingHostTime = now;
+		state->pacingTimestamp = timestamp;
+		return;
+	}
+
+	int64_t dueTime = state->pacingHostTime + ((timestamp - state->pacingTimestamp) * 1000);
+
+	while (now < dueTime && atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
+		int64_t sleepTime = dueTime - now;
+		if (sleepTime > REPLAY_PACING_SLEEP_MAX) {
+			sleepTime = REPLAY_PACING_SLEEP_MAX;
+		}
+
+		struct timespec sleep = { .tv_sec = 0, .tv_nsec = sleepTime };
+		thrd_sleep(&sleep, NULL);
+
+		now = dataExchangeHostTime();
+	}
+}
+
+static void replayCommitContainer(replayHandle handle) {
+	replayState state = &handle->state;
+
+	caerEventPacketContainer container = state->currentPacketContainer;
+	if (container == NULL) {
+		return;
+	}
+
+	state->currentPacketContainer = NULL;
+
+	replayPace(state, caerEventPacketContainerGetLowestEventTimestamp(container));
+
+	CAER_PROBE_CONTAINER_CAPTURE(probe, container);
+
+	bool committed = dataExchangePut(&state->dataExchange, container, &state->dataAcquisitionThreadRun);
+
+	// With the blocking policy, keep waiting for the consumer: a recording is never late.
+	while (!committed
+		&& atomic_load_explicit(&state->dataExchange.policy, memory_order_relaxed)
+			== CAER_HOST_CONFIG_DATAEXCHANGE_POLICY_BLOCK_PRODUCER
+		&& atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
+		committed = dataExchangePut(&state->dataExchange, container, &state->dataAcquisitionThreadRun);
+	}
+
+	if (!committed) {
+		caerLog(CAER_LOG_INFO, handle->info.deviceString, "Dropped EventPacket Container because ring-buffer full!");
+		deviceStatsIncrease(&state->stats.containersDropped, 1);
+
+		CAER_PROBE_CONTAINER(container_drop, handle->info.deviceID, probe);
+
+		caerEventPacketContainerFree(container);
+		return;
+	}
+
+	CAER_PROBE_CONTAINER(container_commit, handle->info.deviceID, probe);
+}
+
+static int replayDataAcquisitionThread(void *inPtr) {
+	// inPtr is a pointer to device handle.
+	replayHandle handle = inPtr;
+	replayState state = &handle->state;
+
+	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "Initializing data acquisition thread ...");
+
+	// Set thread name.
+	thrd_set_name(state->deviceThreadName);
+
+	int16_t sourceID = I16T(atomic_load(&state->sourceID));
+
+	// Signal data thread ready back to start function.
+	atomic_store(&state->dataAcquisitionThreadRun, true);
+	threadReadySignal(&state->dataAcquisitionThreadReady);
+
+	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "data acquisition thread ready to process events.");
+
+	while (atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
+		caerEventPacketHeader packet = replayReadPacket(handle);
+		if (packet == NULL) {
+			// End of recording or unrecoverable error, already logged.
+			break;
+		}
+
+		int16_t eventType = caerEventPacketHeaderGetEventType(packet);
+		int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+
+		if ((sourceID != 0 && caerEventPacketHeaderGetEventSource(packet) != sourceID) || eventNumber == 0) {
+			free(packet);
+			continue;
+		}
+
+		if (eventType < 0 || eventType >= REPLAY_EVENT_TYPES) {
+			deviceStatsIncrease(&state->stats.invalidEvents, U64T(eventNumber));
+
+			free(packet);
+			continue;
+		}
+
+		// Replayed events come from this device now.
+		caerEventPacketHeaderSetEventSource(packet, handle->info.deviceID);
+
+		switch (eventType) {
+			case SPECIAL_EVENT:
+				deviceStatsIncrease(&state->stats.specialEvents, U64T(eventNumber));
+				break;
+
+			case POLARITY_EVENT:
+				deviceStatsIncrease(&state->stats.polarityEvents, U64T(eventNumber));
+				break;
+
+			case FRAME_EVENT:
+				deviceStatsIncrease(&state->stats.frameEvents, U64T(eventNumber));
+				break;
+
+			case IMU6_EVENT:
+				deviceStatsIncrease(&state->stats.imu6Events, U64T(eventNumber));
+				break;
+
+			default:
+				break;
+		}
+
+		// Packets recorded together go into the same container, until a
+		// second packet of the same type shows up.
+		if (state->currentPacketContainer != NULL
+			&& caerEventPacketContainerGetEventPacket(state->currentPacketContainer, eventType) != NULL) {
+			replayCommitContainer(handle);
+		}
+
+		if (state->currentPacketContainer == NULL) {
+			state->currentPacketContainer = caerEventPacketContainerAllocate(REPLAY_EVENT_TYPES);
+			if (state->currentPacketContainer == NULL) {
+				free(packet);
+
+				caerLog(CAER_LOG_CRITICAL, handle->info.deviceString,
+					"Failed to allocate event packet container, stopping replay.");
+				break;
+			}
+
+			caerEventPacketContainerSetHostTransferTimestamp(state->currentPacketContainer, dataExchangeHostTime());
+		}
+
+		caerEventPacketContainerSetEventPacket(state->currentPacketContainer, eventType, packet);
+	}
+
+	// Deliver what's left of the recording.
+	replayCommitContainer(handle);
+
+	while (dataExchangeSpillPending(&state->dataExchange)
+		&& atomic_load_explicit(&state->dataAcquisitionThreadRun, memory_order_relaxed)) {
+		dataExchangeSpillFlush(&state->dataExchange);
+
+		struct timespec spillSleep = { .tv_sec = 0, .tv_nsec = 1000000 };
+		thrd_sleep(&spillSleep, NULL);
+	}
+
+	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "shutting down data acquisition thread ...");
+
+	// Ensure shutdown is stored and notified, could be because of the recording ending!
+	atomic_store(&state->dataAcquisitionThreadRun, false);
+
+	if (state->dataShutdownNotify != NULL) {
+		state->dataShutdownNotify(state->dataShutdownUserPtr);
+	}
+
+	caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "data acquisition thread shut down.");
+
+	return (EXIT_SUCCESS);
+}
+
+static caerEventPacketHeader replayReadEncodedPacket(replayHandle handle) {
+	replayState state = &handle->state;
+	uint8_t encodedHeader[CAER_EVENT_CODEC_HEADER_SIZE];
+
+	size_t headerRead = fread(encodedHeader, 1, CAER_EVENT_CODEC_HEADER_SIZE, state->file);
+	if (headerRead == 0 && feof(state->file)) {
+		caerLog(CAER_LOG_DEBUG, handle->info.deviceString, "End of recording reached.");
+		return (NULL);
+	}
+
+	if (headerRead != CAER_EVENT_CODEC_HEADER_SIZE) {
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Truncated encoded packet header, stopping replay.");
+		return (NULL);
+	}
+
+	// The encoded packet starts with the original event packet header.
+	struct caer_event_packet_header header;
+	memcpy(&header, encodedHeader, CAER_EVENT_PACKET_HEADER_SIZE);
+
+	if (!replayPacketHeaderValid(handle, &header)) {
+		return (NULL);
+	}
+
+	// The payload length comes straight from the file: it can't be more than what
+	// the codec produces at most for the packet's events, check before allocating.
+	size_t encodedSize = caerEventCodecEncodedSize(encodedHeader, CAER_EVENT_CODEC_HEADER_SIZE);
+	size_t encodedBound = caerEventCodecEncodeBound(&header);
+
+	if (encodedBound == 0 || encodedSize > encodedBound) {
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString,
+			"Invalid encoded packet length (%zu bytes, at most %zu expected), stopping replay.", encodedSize,
+			encodedBound);
+		return (NULL);
+	}
+
+	uint8_t *encodedPacket = malloc(encodedSize);
+	if (encodedPacket == NULL) {
+		caerLog(CAER_LOG_CRITICAL, handle->info.deviceString,
+			"Failed to allocate memory for encoded packet of %zu bytes, stopping replay.", encodedSize);
+		return (NULL);
+	}
+
+	memcpy(encodedPacket, encodedHeader, CAER_EVENT_CODEC_HEADER_SIZE);
+
+	size_t payloadSize = encodedSize - CAER_EVENT_CODEC_HEADER_SIZE;
+
+	if (fread(encodedPacket + CAER_EVENT_CODEC_HEADER_SIZE, 1, payloadSize, state->file) != payloadSize) {
+		free(encodedPacket);
+
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Truncated encoded packet data, stopping replay.");
+		return (NULL);
+	}
+
+	// Validates the encoding, errors are logged by the codec.
+	caerEventPacketHeader packet = caerEventCodecDecode(encodedPacket, encodedSize, NULL);
+
+	free(encodedPacket);
+
+	if (packet == NULL) {
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString, "Invalid encoded packet, stopping replay.");
+		return (NULL);
+	}
+
+	deviceStatsIncrease(&state->stats.bytesReceived, encodedSize);
+
+	return (packet);
+}
+
+static bool replayPacketHeaderValid(replayHandle handle, caerEventPacketHeader header) {
+	int32_t eventSize = caerEventPacketHeaderGetEventSize(header);
+	int32_t eventCapacity = caerEventPacketHeaderGetEventCapacity(header);
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(header);
+	int32_t eventTSOffset = caerEventPacketHeaderGetEventTSOffset(header);
+
+	// The 32 bit timestamp must lie within the event, it's read when pacing and merging.
+	if (eventSize <= 0 || eventCapacity < 0 || eventNumber < 0 || eventNumber > eventCapacity
+		|| eventTSOffset < 0 || eventTSOffset > eventSize - I32T(sizeof(int32_t))
+		|| (size_t) eventCapacity > (SIZE_MAX - CAER_EVENT_PACKET_HEADER_SIZE) / (size_t) eventSize) {
+		caerLog(CAER_LOG_ERROR, handle->info.deviceString,
+			"Invalid event packet header (size=%" PRIi32 ", capacity=%" PRIi32 ", number=%" PRIi32
+			", timestamp offset=%" PRIi32 "), stopping replay.", eventSize, eventCapacity, eventNumber, eventTSOffset);
+		return (false);
+	}
+
+	return (true);
+}
@@ -0,0 +1,80 @@
+#ifndef LIBCAER_SRC_FILE_REPLAY_H_
+#define LIBCAER_SRC_FILE_REPLAY_H_
+
+#include "devices/replay.h"
+#include "data_exchange.h"
+#include "device_stats.h"
+#include "thread_ready.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+#ifdef HAVE_PTHREADS
+	#include "c11threads_posix.h"
+#endif
+
+#define REPLAY_DEVICE_NAME "Replay"
+
+// Known event types, each gets its own slot in replayed packet containers.
+#define REPLAY_EVENT_TYPES (POINT4D_EVENT + 1)
+
+#define REPLAY_HEADER_LINE_MAX 1024
+
+struct replay_state {
+	// Data Acquisition Thread -> Mainloop Exchange
+	struct data_exchange dataExchange;
+	void (*dataShutdownNotify)(void *ptr);
+	void *dataShutdownUserPtr;
+	// Performance counters, written by the Data Acquisition Thread
+	struct device_stats stats;
+	// File State
+	char deviceThreadName[15 + 1]; // +1 for terminating NUL character.
+	FILE *file;
+	long dataOffset; // Start of the first packet, right after the text header.
+	bool compressed; // Packets are encoded with the event codec.
+	// Replay Settings
+	atomic_bool realTime;
+	atomic_int_fast32_t sourceID;
+	// Data Acquisition Thread
+	thrd_t dataAcquisitionThread;
+	atomic_bool dataAcquisitionThreadRun;
+	struct thread_ready dataAcquisitionThreadReady;
+	// Packet Container state
+	caerEventPacketContainer currentPacketContainer;
+	// Real-time pacing: host time in ns at which the recorded timestamp
+	// (in µs) 'pacingTimestamp' is to be delivered.
+	int64_t pacingHostTime;
+	int64_t pacingTimestamp;
+};
+
+typedef struct replay_state *replayState;
+
+struct replay_handle {
+	uint16_t deviceType;
+	// Information fields
+	struct caer_replay_info info;
+	// State for data management.
+	struct replay_state state;
+};
+
+typedef struct replay_handle *replayHandle;
+
+caerDeviceHandle replayOpen(uint16_t deviceID, const char *fileName);
+bool replayClose(caerDeviceHandle handle);
+
+bool replaySendDefaultConfig(caerDeviceHandle handle);
+// Only host-side configuration (negative addresses) exists for replay devices.
+bool replayConfigSet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t param);
+bool replayConfigGet(caerDeviceHandle handle, int8_t modAddr, uint8_t paramAddr, uint32_t *param);
+
+bool replayDataStart(caerDeviceHandle handle, void (*dataNotifyIncrease)(void *ptr),
+	void (*dataNotifyDecrease)(void *ptr), void *dataNotifyUserPtr, void (*dataShutdownNotify)(void *ptr),
+	void *dataShutdownUserPtr);
+bool replayDataStop(caerDeviceHandle handle);
+caerEventPacketContainer replayDataGet(caerDeviceHandle handle);
+size_t replayDataGetMany(caerDeviceHandle handle, caerEventPacketContainer *containers, size_t maxContainers);
+bool replayDataNotifyDecreaseManySet(caerDeviceHandle handle, void (*dataNotifyDecreaseMany)(void *ptr, size_t count));
+bool replayLatencyStatsGet(caerDeviceHandle handle, uint8_t stage, struct caer_latency_stats *stats);
+bool replayLatencyStatsReset(caerDeviceHandle handle);
+bool replayStatsGet(caerDeviceHandle handle, struct caer_device_stats *stats);
+
+#endif /* LIBCAER_SRC_FILE_REPLAY_H_ */
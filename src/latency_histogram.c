@@ -0,0 +1,86 @@
+#include "latency_histogram.h"
+
+static uint64_t latencyHistogramBucketHighest(size_t bucket);
+static uint64_t latencyHistogramPercentile(const uint64_t *buckets, uint64_t total, uint64_t perMille,
+	uint64_t max);
+
+void latencyHistogramReset(latencyHistogram histogram) {
+	// Not an atomic snapshot: samples recorded concurrently may be partially kept.
+	for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+	atomic_store_explicit(&histogram->sum, 0, memory_order_relaxed);
+	atomic_store_explicit(&histogram->min, UINT64_MAX, memory_order_relaxed);
+	atomic_store_explicit(&histogram->max, 0, memory_order_relaxed);
+}
+
+void latencyHistogramStats(latencyHistogram histogram, struct caer_latency_stats *stats) {
+	uint64_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+	uint64_t total = 0;
+
+	// Percentiles are computed on a copy, so they're consistent with each other.
+	for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		buckets[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+		total += buckets[i];
+	}
+
+	uint64_t count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+	uint64_t sum = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+
+	stats->count = total;
+
+	if (total == 0) {
+		stats->min = 0;
+		stats->max = 0;
+		stats->mean = 0;
+		stats->p50 = 0;
+		stats->p90 = 0;
+		stats->p99 = 0;
+		stats->p999 = 0;
+		return;
+	}
+
+	stats->min = atomic_load_explicit(&histogram->min, memory_order_relaxed);
+	stats->max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	stats->mean = (count != 0) ? (sum / count) : (0);
+
+	stats->p50 = latencyHistogramPercentile(buckets, total, 500, stats->max);
+	stats->p90 = latencyHistogramPercentile(buckets, total, 900, stats->max);
+	stats->p99 = latencyHistogramPercentile(buckets, total, 990, stats->max);
+	stats->p999 = latencyHistogramPercentile(buckets, total, 999, stats->max);
+}
+
+static uint64_t latencyHistogramBucketHighest(size_t bucket) {
+	if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+		return (bucket);
+	}
+
+	size_t shift = (bucket - LATENCY_HISTOGRAM_SUB_BUCKETS) / LATENCY_HISTOGRAM_SUB_BUCKETS;
+	size_t sub = (bucket - LATENCY_HISTOGRAM_SUB_BUCKETS) % LATENCY_HISTOGRAM_SUB_BUCKETS;
+
+	uint64_t lowest = U64T(LATENCY_HISTOGRAM_SUB_BUCKETS + sub) << shift;
+
+	return (lowest + (U64T(1) << shift) - 1);
+}
+
+static uint64_t latencyHistogramPercentile(const uint64_t *buckets, uint64_t total, uint64_t perMille,
+	uint64_t max) {
+	// Rank of the wanted sample, rounded up, so that p50 of 1 sample is that sample.
+	uint64_t rank = ((total * perMille) + 999) / 1000;
+	uint64_t seen = 0;
+
+	for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		seen += buckets[i];
+
+		if (seen >= rank) {
+			// Report the highest value that falls into this bucket, but
+			// never more than what was actually recorded.
+			uint64_t highest = latencyHistogramBucketHighest(i);
+			return ((highest < max) ? (highest) : (max));
+		}
+	}
+
+	return (max);
+}
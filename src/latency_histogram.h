@@ -0,0 +1,66 @@
+#ifndef LIBCAER_SRC_LATENCY_HISTOGRAM_H_
+#define LIBCAER_SRC_LATENCY_HISTOGRAM_H_
+
+#include "devices/usb.h"
+#include <stdatomic.h>
+
+// Log-linear buckets: values below 2^SUB_BITS are exact, above that each
+// power of two is split into 2^SUB_BITS linear sub-buckets (~3% error).
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+// Values of 2^40 ns (~18 minutes) and more all go into the last bucket.
+#define LATENCY_HISTOGRAM_MAX_BITS 40
+#define LATENCY_HISTOGRAM_BUCKETS \
+	(LATENCY_HISTOGRAM_SUB_BUCKETS * (LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BITS + 1))
+
+struct latency_histogram {
+	atomic_uint_fast64_t count;
+	atomic_uint_fast64_t sum;
+	atomic_uint_fast64_t min;
+	atomic_uint_fast64_t max;
+	atomic_uint_fast64_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+};
+
+typedef struct latency_histogram *latencyHistogram;
+
+void latencyHistogramReset(latencyHistogram histogram);
+void latencyHistogramStats(latencyHistogram histogram, struct caer_latency_stats *stats);
+
+static inline size_t latencyHistogramBucket(uint64_t value) {
+	if (value < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+		return ((size_t) value);
+	}
+
+	size_t msb = (size_t) (63 - __builtin_clzll(value));
+	if (msb >= LATENCY_HISTOGRAM_MAX_BITS) {
+		return (LATENCY_HISTOGRAM_BUCKETS - 1);
+	}
+
+	size_t shift = msb - LATENCY_HISTOGRAM_SUB_BITS;
+	size_t sub = (size_t) (value >> shift) - LATENCY_HISTOGRAM_SUB_BUCKETS;
+
+	return (LATENCY_HISTOGRAM_SUB_BUCKETS + (shift * LATENCY_HISTOGRAM_SUB_BUCKETS) + sub);
+}
+
+// Lock-free, can be called concurrently with other recorders, readers and resets.
+static inline void latencyHistogramRecord(latencyHistogram histogram, uint64_t value) {
+	atomic_fetch_add_explicit(&histogram->buckets[latencyHistogramBucket(value)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+
+	uint64_t min = atomic_load_explicit(&histogram->min, memory_order_relaxed);
+	while (value < min
+		&& !atomic_compare_exchange_weak_explicit(&histogram->min, &min, value, memory_order_relaxed,
+			memory_order_relaxed)) {
+		;
+	}
+
+	uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	while (value > max
+		&& !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value, memory_order_relaxed,
+			memory_order_relaxed)) {
+		;
+	}
+}
+
+#endif /* LIBCAER_SRC_LATENCY_HISTOGRAM_H_ */
@@ -0,0 +1,369 @@
+#include "network.h"
+#include "aedat_format.h"
+#include "events/common.h"
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define NETWORK_CLIENT_BUFFER_SIZE (64 * 1024)
+#define NETWORK_CLIENT_HEADER_LINE_MAX 1024
+// Containers have one slot per known event type, like replayed ones.
+#define NETWORK_CLIENT_EVENT_TYPES (POINT4D_EVENT + 1)
+
+struct caer_network_client {
+	int socket;
+	bool connectionClosed;
+	// Whether the server marks the end of each container with an empty packet.
+	bool containerEnds;
+	// Received data not yet consumed. Large packet data bypasses it.
+	uint8_t buffer[NETWORK_CLIENT_BUFFER_SIZE];
+	size_t bufferStart;
+	size_t bufferEnd;
+	// Packet already received that starts the next container.
+	caerEventPacketHeader nextPacket;
+};
+
+static bool networkClientConnect(caerNetworkClient client, const char *host, uint16_t port);
+static bool networkClientFill(caerNetworkClient client, uint8_t *data, size_t dataLength, size_t minLength);
+static bool networkClientRead(caerNetworkClient client, void *data, size_t dataLength);
+static bool networkClientParseHeader(caerNetworkClient client);
+static caerEventPacketHeader networkClientReadPacket(caerNetworkClient client);
+
+caerNetworkClient caerNetworkClientOpen(const char *host, uint16_t port) {
+	if (host == NULL) {
+		return (NULL);
+	}
+
+	caerNetworkClient client = calloc(1, sizeof(*client));
+	if (client == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for network client.");
+		return (NULL);
+	}
+
+	if (!networkClientConnect(client, host, port)) {
+		free(client);
+
+		// Failure already logged.
+		return (NULL);
+	}
+
+	if (!networkClientParseHeader(client)) {
+		close(client->socket);
+		free(client);
+
+		// Failure already logged.
+		return (NULL);
+	}
+
+	return (client);
+}
+
+caerEventPacketContainer caerNetworkClientReceive(caerNetworkClient client) {
+	if (client == NULL) {
+		return (NULL);
+	}
+
+	caerEventPacketContainer container = NULL;
+	int16_t lastEventType = -1;
+
+	while (true) {
+		caerEventPacketHeader packet = client->nextPacket;
+		client->nextPacket = NULL;
+
+		if (packet == NULL) {
+			packet = networkClientReadPacket(client);
+			if (packet == NULL) {
+				// Connection closed or failed: deliver what was received.
+				return (container);
+			}
+		}
+
+		// The server never sends empty packets, except to mark the end of a container.
+		if (client->containerEnds && caerEventPacketHeaderGetEventNumber(packet) == 0) {
+			free(packet);
+
+			if (container != NULL) {
+				return (container);
+			}
+
+			continue;
+		}
+
+		int16_t eventType = caerEventPacketHeaderGetEventType(packet);
+
+		if (eventType < 0 || eventType >= NETWORK_CLIENT_EVENT_TYPES) {
+			free(packet);
+
+			caerLog(CAER_LOG_DEBUG, __func__, "Skipping event packet of unknown type %" PRIi16 ".", eventType);
+			continue;
+		}
+
+		// With explicit container ends, a packet only starts the next container if its
+		// slot is already taken. Otherwise packets are expected in container order, and
+		// a type that doesn't increase starts the next container.
+		if (container != NULL
+			&& ((client->containerEnds) ? (caerEventPacketContainerGetEventPacket(container, eventType) != NULL)
+				: (eventType <= lastEventType))) {
+			client->nextPacket = packet;
+			return (container);
+		}
+
+		if (container == NULL) {
+			container = caerEventPacketContainerAllocate(NETWORK_CLIENT_EVENT_TYPES);
+			if (container == NULL) {
+				free(packet);
+
+				caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate event packet container.");
+				return (NULL);
+			}
+		}
+
+		caerEventPacketContainerSetEventPacket(container, eventType, packet);
+		lastEventType = eventType;
+	}
+}
+
+bool caerNetworkClientClose(caerNetworkClient client) {
+	if (client == NULL) {
+		return (false);
+	}
+
+	bool success = true;
+
+	if (close(client->socket) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to close network client socket. Error: %d.", errno);
+		success = false;
+	}
+
+	free(client->nextPacket);
+	free(client);
+
+	return (success);
+}
+
+static bool networkClientConnect(caerNetworkClient client, const char *host, uint16_t port) {
+	char portString[8];
+	snprintf(portString, 8, "%" PRIu16, port);
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	struct addrinfo *addresses = NULL;
+	int result = getaddrinfo(host, portString, &hints, &addresses);
+	if (result != 0) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to resolve server address '%s'. Error: %s.", host,
+			gai_strerror(result));
+		return (false);
+	}
+
+	client->socket = -1;
+
+	for (struct addrinfo *addr = addresses; addr != NULL; addr = addr->ai_next) {
+		int clientSocket = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+		if (clientSocket < 0) {
+			continue;
+		}
+
+		if (connect(clientSocket, addr->ai_addr, addr->ai_addrlen) != 0) {
+			close(clientSocket);
+			continue;
+		}
+
+		client->socket = clientSocket;
+		break;
+	}
+
+	freeaddrinfo(addresses);
+
+	if (client->socket < 0) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to connect to '%s' port %" PRIu16 ". Error: %d.", host, port,
+			errno);
+		return (false);
+	}
+
+	return (true);
+}
+
+// Receive at least minLength bytes into data, and up to dataLength if already available.
+static bool networkClientFill(caerNetworkClient client, uint8_t *data, size_t dataLength, size_t minLength) {
+	size_t received = 0;
+
+	while (received < minLength) {
+		ssize_t result = recv(client->socket, data + received, dataLength - received, 0);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			caerLog(CAER_LOG_ERROR, __func__, "Failed to receive from server. Error: %d.", errno);
+			return (false);
+		}
+
+		if (result == 0) {
+			client->connectionClosed = true;
+			return (false);
+		}
+
+		received += (size_t) result;
+	}
+
+	if (data == client->buffer) {
+		client->bufferStart = 0;
+		client->bufferEnd = received;
+	}
+
+	return (true);
+}
+
+static bool networkClientRead(caerNetworkClient client, void *data, size_t dataLength) {
+	uint8_t *dest = data;
+
+	// Buffered data first.
+	size_t buffered = client->bufferEnd - client->bufferStart;
+	if (buffered > dataLength) {
+		buffered = dataLength;
+	}
+
+	memcpy(dest, client->buffer + client->bufferStart, buffered);
+	client->bufferStart += buffered;
+
+	dest += buffered;
+	dataLength -= buffered;
+
+	if (dataLength == 0) {
+		return (true);
+	}
+
+	// Large reads go directly to their destination, small ones through the buffer.
+	if (dataLength >= NETWORK_CLIENT_BUFFER_SIZE) {
+		return (networkClientFill(client, dest, dataLength, dataLength));
+	}
+
+	if (!networkClientFill(client, client->buffer, NETWORK_CLIENT_BUFFER_SIZE, dataLength)) {
+		return (false);
+	}
+
+	memcpy(dest, client->buffer, dataLength);
+	client->bufferStart = dataLength;
+
+	return (true);
+}
+
+static bool networkClientParseHeader(caerNetworkClient client) {
+	char line[NETWORK_CLIENT_HEADER_LINE_MAX];
+	bool firstLine = true;
+
+	// The AEDAT 3.x header is a sequence of text lines starting with '#',
+	// the first giving the format version, the last being '#!END-HEADER'.
+	while (true) {
+		size_t lineLength = 0;
+
+		while (true) {
+			char character;
+			if (!networkClientRead(client, &character, 1)) {
+				caerLog(CAER_LOG_CRITICAL, __func__, "Connection closed while reading stream header.");
+				return (false);
+			}
+
+			if (character == '\n') {
+				break;
+			}
+
+			if (lineLength < (NETWORK_CLIENT_HEADER_LINE_MAX - 1)) {
+				line[lineLength++] = character;
+			}
+		}
+
+		line[lineLength] = '\0';
+
+		if (firstLine) {
+			firstLine = false;
+
+			if (strncmp(line, "#!AER-DAT3.", 11) != 0 || line[11] < '0' || line[11] > '9') {
+				caerLog(CAER_LOG_CRITICAL, __func__, "Stream is not in AEDAT 3.x format.");
+				return (false);
+			}
+
+			continue;
+		}
+
+		if (strncmp(line, AEDAT_FORMAT_LINE, strlen(AEDAT_FORMAT_LINE)) == 0) {
+			const char *format = line + strlen(AEDAT_FORMAT_LINE);
+			size_t formatLength = strcspn(format, "\r\n");
+
+			if (formatLength != strlen(AEDAT_FORMAT_RAW) || strncmp(format, AEDAT_FORMAT_RAW, formatLength) != 0) {
+				caerLog(CAER_LOG_CRITICAL, __func__, "Stream has unsupported format '%.*s'.", (int) formatLength,
+					format);
+				return (false);
+			}
+
+			continue;
+		}
+
+		if (strncmp(line, AEDAT_CONTAINER_END_LINE, strlen(AEDAT_CONTAINER_END_LINE)) == 0) {
+			client->containerEnds = true;
+			continue;
+		}
+
+		if (strncmp(line, "#!END-HEADER", 12) == 0) {
+			// AEDAT 3.x defaults to RAW if not specified.
+			return (true);
+		}
+
+		if (line[0] != '#') {
+			caerLog(CAER_LOG_CRITICAL, __func__, "Stream has no valid AEDAT 3.x header.");
+			return (false);
+		}
+	}
+}
+
+static caerEventPacketHeader networkClientReadPacket(caerNetworkClient client) {
+	struct caer_event_packet_header header;
+
+	if (!networkClientRead(client, &header, CAER_EVENT_PACKET_HEADER_SIZE)) {
+		if (client->connectionClosed) {
+			caerLog(CAER_LOG_DEBUG, __func__, "Connection closed by server.");
+		}
+
+		return (NULL);
+	}
+
+	// Event data follows the header, capacity times the event size.
+	int32_t eventSize = caerEventPacketHeaderGetEventSize(&header);
+	int32_t eventCapacity = caerEventPacketHeaderGetEventCapacity(&header);
+	int32_t eventNumber = caerEventPacketHeaderGetEventNumber(&header);
+	int32_t eventTSOffset = caerEventPacketHeaderGetEventTSOffset(&header);
+
+	// The 32 bit timestamp must lie within the event, users read it.
+	if (eventSize <= 0 || eventCapacity < 0 || eventNumber < 0 || eventNumber > eventCapacity
+		|| (size_t) eventCapacity > (SIZE_MAX - CAER_EVENT_PACKET_HEADER_SIZE) / (size_t) eventSize
+		|| eventTSOffset < 0 || eventTSOffset > eventSize - I32T(sizeof(int32_t))) {
+		caerLog(CAER_LOG_ERROR, __func__,
+			"Invalid event packet header (size=%" PRIi32 ", capacity=%" PRIi32 ", number=%" PRIi32
+			", timestamp offset=%" PRIi32 ").", eventSize, eventCapacity, eventNumber, eventTSOffset);
+		return (NULL);
+	}
+
+	size_t dataSize = (size_t) eventCapacity * (size_t) eventSize;
+
+	caerEventPacketHeader packet = malloc(CAER_EVENT_PACKET_HEADER_SIZE + dataSize);
+	if (packet == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for event packet of %zu bytes.", dataSize);
+		return (NULL);
+	}
+
+	memcpy(packet, &header, CAER_EVENT_PACKET_HEADER_SIZE);
+
+	if (!networkClientRead(client, ((uint8_t *) packet) + CAER_EVENT_PACKET_HEADER_SIZE, dataSize)) {
+		free(packet);
+
+		caerLog(CAER_LOG_ERROR, __func__, "Connection lost within event packet data.");
+		return (NULL);
+	}
+
+	return (packet);
+}
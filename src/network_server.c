@@ -0,0 +1,743 @@
+#include "network.h"
+#include "aedat_format.h"
+#include "events/special.h"
+#include "ringbuffer/ringbuffer.h"
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#ifdef HAVE_PTHREADS
+	#include "c11threads_posix.h"
+#endif
+
+#if defined(IOV_MAX) && IOV_MAX < 1024
+	#define NETWORK_SERVER_IOV_MAX IOV_MAX
+#else
+	#define NETWORK_SERVER_IOV_MAX 1024
+#endif
+
+// Containers taken from a client's queue at once, to send them together.
+#define NETWORK_SERVER_BATCH_CONTAINERS 256
+
+#define NETWORK_SERVER_POLL_TIMEOUT 100 // in ms, to notice shutdown.
+#define NETWORK_SERVER_LISTEN_BACKLOG 16
+
+#define NETWORK_SERVER_THREAD_NAME "Network Server"
+
+#ifdef MSG_NOSIGNAL
+	#define NETWORK_SEND_FLAGS (MSG_NOSIGNAL | MSG_DONTWAIT)
+#else
+	#define NETWORK_SEND_FLAGS (MSG_DONTWAIT)
+#endif
+
+// A container shared by all the clients it was queued for, freed
+// by whoever releases the last reference.
+struct network_container {
+	caerEventPacketContainer container;
+	size_t bytes; // Size on the wire.
+	atomic_uint_fast32_t references;
+};
+
+struct network_server_client {
+	int socket;
+	RingBuffer queue;
+	// Set by caerNetworkServerSend() when the policy wants this client gone.
+	atomic_bool disconnect;
+	// Whether the socket's send buffer was full, to wait for it to drain.
+	bool sendBlocked;
+	size_t headerSent;
+	// Containers taken from the queue and being sent, the first
+	// 'batchSent' bytes of the first one are already out.
+	struct network_container *batch[NETWORK_SERVER_BATCH_CONTAINERS];
+	size_t batchCount;
+	size_t batchSent;
+	struct iovec iov[NETWORK_SERVER_IOV_MAX];
+};
+
+struct caer_network_server {
+	int listenSocket;
+	uint16_t port;
+	enum caer_network_client_policy policy;
+	uint32_t clientQueueSize;
+	char header[AEDAT_HEADER_MAX];
+	size_t headerLength;
+	// Empty event packet sent after each container, to mark its end.
+	struct caer_event_packet_header containerEnd;
+	// Wake-up of the server thread by caerNetworkServerSend(), at most
+	// one pending byte in the pipe at any time.
+	int wakeUpPipe[2];
+	atomic_bool wakeUpPending;
+	// Clients are only added and removed by the server thread, with the lock
+	// held, so caerNetworkServerSend() sees a stable list while queueing.
+	mtx_t clientsLock;
+	struct network_server_client **clients;
+	uint32_t clientsCount;
+	uint32_t clientsMax;
+	struct pollfd *pollFds;
+	// Server Thread
+	thrd_t serverThread;
+	atomic_bool running;
+	// Statistics, all updated with relaxed atomics.
+	atomic_uint_fast32_t clientsConnected;
+	atomic_uint_fast64_t clientsAccepted;
+	atomic_uint_fast64_t clientsRefused;
+	atomic_uint_fast64_t clientsDropped;
+	atomic_uint_fast64_t containersSent;
+	atomic_uint_fast64_t containersDropped;
+	atomic_uint_fast64_t bytesSent;
+	atomic_uint_fast64_t sendCalls;
+};
+
+static bool networkServerListen(caerNetworkServer server, const char *address, uint16_t port);
+static void networkServerWakeUp(caerNetworkServer server);
+static void networkServerAccept(caerNetworkServer server);
+static void networkServerRemoveClient(caerNetworkServer server, uint32_t clientIndex, bool dropped);
+static bool networkServerClientSend(caerNetworkServer server, struct network_server_client *client);
+static int networkServerClientIov(caerNetworkServer server, struct network_server_client *client);
+static void networkContainerRelease(struct network_container *netContainer);
+static int networkServerThread(void *inPtr);
+
+caerNetworkServer caerNetworkServerOpen(const char *address, uint16_t port, int16_t sourceID,
+	const char *sourceDescription, uint32_t maxClients, uint32_t clientQueueSize,
+	enum caer_network_client_policy policy) {
+	if (maxClients == 0 || clientQueueSize == 0 || (clientQueueSize & (clientQueueSize - 1)) != 0) {
+		caerLog(CAER_LOG_CRITICAL, __func__,
+			"Invalid network server limits (clients=%" PRIu32 ", queue size=%" PRIu32 ", must be a power of two).",
+			maxClients, clientQueueSize);
+		return (NULL);
+	}
+
+	caerNetworkServer server = calloc(1, sizeof(*server));
+	if (server == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for network server.");
+		return (NULL);
+	}
+
+	server->policy = policy;
+	server->clientQueueSize = clientQueueSize;
+	server->clientsMax = maxClients;
+
+	// The stream looks exactly like a RAW recording, AEDAT 3.x readers just
+	// see an empty special event packet at the end of each container.
+	server->headerLength = aedatHeaderBuild(server->header, AEDAT_FORMAT_RAW, sourceID, sourceDescription,
+		AEDAT_CONTAINER_END_LINE);
+
+	caerEventPacketHeaderSetEventType(&server->containerEnd, SPECIAL_EVENT);
+	caerEventPacketHeaderSetEventSource(&server->containerEnd, sourceID);
+	caerEventPacketHeaderSetEventSize(&server->containerEnd, I32T(sizeof(struct caer_special_event)));
+	caerEventPacketHeaderSetEventTSOffset(&server->containerEnd, offsetof(struct caer_special_event, timestamp));
+
+	// Two fixed entries (listening socket and wake-up pipe), then one per client.
+	server->clients = calloc(maxClients, sizeof(*server->clients));
+	server->pollFds = calloc(2 + (size_t) maxClients, sizeof(*server->pollFds));
+	if (server->clients == NULL || server->pollFds == NULL) {
+		free(server->clients);
+		free(server->pollFds);
+		free(server);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for network server clients.");
+		return (NULL);
+	}
+
+	if (mtx_init(&server->clientsLock, mtx_plain) != thrd_success) {
+		free(server->clients);
+		free(server->pollFds);
+		free(server);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to initialize network server lock.");
+		return (NULL);
+	}
+
+	if (pipe(server->wakeUpPipe) != 0) {
+		mtx_destroy(&server->clientsLock);
+		free(server->clients);
+		free(server->pollFds);
+		free(server);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to create network server wake-up pipe. Error: %d.", errno);
+		return (NULL);
+	}
+
+	fcntl(server->wakeUpPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(server->wakeUpPipe[1], F_SETFL, O_NONBLOCK);
+
+	if (!networkServerListen(server, address, port)) {
+		close(server->wakeUpPipe[0]);
+		close(server->wakeUpPipe[1]);
+		mtx_destroy(&server->clientsLock);
+		free(server->clients);
+		free(server->pollFds);
+		free(server);
+
+		// Failure already logged.
+		return (NULL);
+	}
+
+	atomic_store(&server->running, true);
+
+	if ((errno = thrd_create(&server->serverThread, &networkServerThread, server)) != thrd_success) {
+		close(server->listenSocket);
+		close(server->wakeUpPipe[0]);
+		close(server->wakeUpPipe[1]);
+		mtx_destroy(&server->clientsLock);
+		free(server->clients);
+		free(server->pollFds);
+		free(server);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to start network server thread. Error: %d.", errno);
+		return (NULL);
+	}
+
+	return (server);
+}
+
+uint16_t caerNetworkServerGetPort(caerNetworkServer server) {
+	if (server == NULL) {
+		return (0);
+	}
+
+	return (server->port);
+}
+
+bool caerNetworkServerSend(caerNetworkServer server, caerEventPacketContainer container) {
+	if (server == NULL || container == NULL) {
+		return (false);
+	}
+
+	size_t bytes = 0;
+
+	for (int32_t i = 0; i < caerEventPacketContainerGetEventPacketsNumber(container); i++) {
+		caerEventPacketHeader packet = caerEventPacketContainerGetEventPacket(container, i);
+		if (packet == NULL) {
+			continue;
+		}
+
+		int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+		if (eventNumber == 0) {
+			continue;
+		}
+
+		// On the wire, like on disk, the capacity is always equal to the number of events.
+		caerEventPacketHeaderSetEventCapacity(packet, eventNumber);
+
+		bytes += CAER_EVENT_PACKET_HEADER_SIZE
+			+ ((size_t) eventNumber * (size_t) caerEventPacketHeaderGetEventSize(packet));
+	}
+
+	if (bytes == 0) {
+		// Nothing to send.
+		caerEventPacketContainerFree(container);
+		return (true);
+	}
+
+	bytes += CAER_EVENT_PACKET_HEADER_SIZE; // Container end.
+
+	struct network_container *netContainer = malloc(sizeof(*netContainer));
+	if (netContainer == NULL) {
+		caerEventPacketContainerFree(container);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for network container.");
+		return (false);
+	}
+
+	netContainer->container = container;
+	netContainer->bytes = bytes;
+	// Our own reference, keeps it alive while queueing.
+	atomic_store_explicit(&netContainer->references, 1, memory_order_relaxed);
+
+	uint32_t queued = 0;
+
+	mtx_lock(&server->clientsLock);
+
+	for (uint32_t i = 0; i < server->clientsCount; i++) {
+		struct network_server_client *client = server->clients[i];
+
+		if (atomic_load_explicit(&client->disconnect, memory_order_relaxed)) {
+			continue;
+		}
+
+		atomic_fetch_add_explicit(&netContainer->references, 1, memory_order_relaxed);
+
+		if (!ringBufferPut(client->queue, netContainer)) {
+			// Queue full: this client is behind, the others are not affected.
+			atomic_fetch_sub_explicit(&netContainer->references, 1, memory_order_relaxed);
+			atomic_fetch_add_explicit(&server->containersDropped, 1, memory_order_relaxed);
+
+			if (server->policy == CAER_NETWORK_CLIENT_DISCONNECT) {
+				atomic_store(&client->disconnect, true);
+				queued++; // Wake up the server thread to disconnect it.
+			}
+
+			continue;
+		}
+
+		queued++;
+	}
+
+	mtx_unlock(&server->clientsLock);
+
+	networkContainerRelease(netContainer);
+
+	if (queued > 0) {
+		networkServerWakeUp(server);
+	}
+
+	return (true);
+}
+
+bool caerNetworkServerStatsGet(caerNetworkServer server, struct caer_network_server_stats *stats) {
+	if (server == NULL || stats == NULL) {
+		return (false);
+	}
+
+	stats->clientsConnected = (uint32_t) atomic_load_explicit(&server->clientsConnected, memory_order_relaxed);
+	stats->clientsAccepted = atomic_load_explicit(&server->clientsAccepted, memory_order_relaxed);
+	stats->clientsRefused = atomic_load_explicit(&server->clientsRefused, memory_order_relaxed);
+	stats->clientsDropped = atomic_load_explicit(&server->clientsDropped, memory_order_relaxed);
+	stats->containersSent = atomic_load_explicit(&server->containersSent, memory_order_relaxed);
+	stats->containersDropped = atomic_load_explicit(&server->containersDropped, memory_order_relaxed);
+	stats->bytesSent = atomic_load_explicit(&server->bytesSent, memory_order_relaxed);
+	stats->sendCalls = atomic_load_explicit(&server->sendCalls, memory_order_relaxed);
+
+	return (true);
+}
+
+bool caerNetworkServerClose(caerNetworkServer server) {
+	if (server == NULL) {
+		return (false);
+	}
+
+	// The server thread disconnects all clients before exiting.
+	atomic_store(&server->running, false);
+
+	networkServerWakeUp(server);
+
+	if ((errno = thrd_join(server->serverThread, NULL)) != thrd_success) {
+		// This should never happen!
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to join network server thread. Error: %d.", errno);
+		return (false);
+	}
+
+	bool success = true;
+
+	if (close(server->listenSocket) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to close network server socket. Error: %d.", errno);
+		success = false;
+	}
+
+	close(server->wakeUpPipe[0]);
+	close(server->wakeUpPipe[1]);
+
+	mtx_destroy(&server->clientsLock);
+	free(server->clients);
+	free(server->pollFds);
+	free(server);
+
+	return (success);
+}
+
+static bool networkServerListen(caerNetworkServer server, const char *address, uint16_t port) {
+	char portString[8];
+	snprintf(portString, 8, "%" PRIu16, port);
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+
+	struct addrinfo *addresses = NULL;
+	int result = getaddrinfo(address, portString, &hints, &addresses);
+	if (result != 0) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to resolve listen address '%s'. Error: %s.",
+			(address != NULL) ? (address) : ("*"), gai_strerror(result));
+		return (false);
+	}
+
+	server->listenSocket = -1;
+
+	for (struct addrinfo *addr = addresses; addr != NULL; addr = addr->ai_next) {
+		int listenSocket = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+		if (listenSocket < 0) {
+			continue;
+		}
+
+		int reuseAddress = 1;
+		setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+
+		if (bind(listenSocket, addr->ai_addr, addr->ai_addrlen) != 0
+			|| listen(listenSocket, NETWORK_SERVER_LISTEN_BACKLOG) != 0) {
+			close(listenSocket);
+			continue;
+		}
+
+		server->listenSocket = listenSocket;
+		break;
+	}
+
+	freeaddrinfo(addresses);
+
+	if (server->listenSocket < 0) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to listen on '%s' port %" PRIu16 ". Error: %d.",
+			(address != NULL) ? (address) : ("*"), port, errno);
+		return (false);
+	}
+
+	fcntl(server->listenSocket, F_SETFL, O_NONBLOCK);
+
+	// Find out the actual port, in case the system picked it.
+	struct sockaddr_storage boundAddress;
+	socklen_t boundAddressLength = sizeof(boundAddress);
+
+	if (getsockname(server->listenSocket, (struct sockaddr *) &boundAddress, &boundAddressLength) == 0) {
+		if (boundAddress.ss_family == AF_INET6) {
+			server->port = ntohs(((struct sockaddr_in6 *) &boundAddress)->sin6_port);
+		}
+		else {
+			server->port = ntohs(((struct sockaddr_in *) &boundAddress)->sin_port);
+		}
+	}
+	else {
+		server->port = port;
+	}
+
+	return (true);
+}
+
+static void networkServerWakeUp(caerNetworkServer server) {
+	// Only write to the pipe if the server thread wasn't already notified,
+	// so that streaming doesn't cost a system call per container.
+	if (!atomic_exchange(&server->wakeUpPending, true)) {
+		uint8_t wakeUp = 1;
+
+		if (write(server->wakeUpPipe[1], &wakeUp, 1) < 0) {
+			// Pipe full means a wake-up is pending anyway.
+		}
+	}
+}
+
+static void networkServerAccept(caerNetworkServer server) {
+	while (true) {
+		int clientSocket = accept(server->listenSocket, NULL, NULL);
+		if (clientSocket < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			// EAGAIN: no more pending connections.
+			return;
+		}
+
+		if (server->clientsCount == server->clientsMax) {
+			close(clientSocket);
+
+			atomic_fetch_add_explicit(&server->clientsRefused, 1, memory_order_relaxed);
+			caerLog(CAER_LOG_WARNING, NETWORK_SERVER_THREAD_NAME,
+				"Refused new client, maximum of %" PRIu32 " clients reached.", server->clientsMax);
+			continue;
+		}
+
+		struct network_server_client *client = calloc(1, sizeof(*client));
+		if (client == NULL) {
+			close(clientSocket);
+
+			caerLog(CAER_LOG_CRITICAL, NETWORK_SERVER_THREAD_NAME, "Failed to allocate memory for network client.");
+			continue;
+		}
+
+		client->queue = ringBufferInit(server->clientQueueSize);
+		if (client->queue == NULL) {
+			free(client);
+			close(clientSocket);
+
+			caerLog(CAER_LOG_CRITICAL, NETWORK_SERVER_THREAD_NAME, "Failed to allocate network client queue.");
+			continue;
+		}
+
+		client->socket = clientSocket;
+
+		fcntl(clientSocket, F_SETFL, O_NONBLOCK);
+
+		// Containers are sent as soon as they're queued, don't hold back small ones.
+		int noDelay = 1;
+		setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+#ifdef SO_NOSIGPIPE
+		int noSigPipe = 1;
+		setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+		mtx_lock(&server->clientsLock);
+		server->clients[server->clientsCount++] = client;
+		mtx_unlock(&server->clientsLock);
+
+		atomic_fetch_add_explicit(&server->clientsConnected, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&server->clientsAccepted, 1, memory_order_relaxed);
+		caerLog(CAER_LOG_DEBUG, NETWORK_SERVER_THREAD_NAME, "New client connected.");
+	}
+}
+
+static void networkServerRemoveClient(caerNetworkServer server, uint32_t clientIndex, bool dropped) {
+	struct network_server_client *client = server->clients[clientIndex];
+
+	// Once out of the list, caerNetworkServerSend() can't queue to it anymore.
+	mtx_lock(&server->clientsLock);
+	server->clients[clientIndex] = server->clients[--server->clientsCount];
+	mtx_unlock(&server->clientsLock);
+
+	close(client->socket);
+
+	for (size_t i = 0; i < client->batchCount; i++) {
+		networkContainerRelease(client->batch[i]);
+	}
+
+	struct network_container *netContainer;
+	while ((netContainer = ringBufferGet(client->queue)) != NULL) {
+		networkContainerRelease(netContainer);
+	}
+
+	ringBufferFree(client->queue);
+	free(client);
+
+	atomic_fetch_sub_explicit(&server->clientsConnected, 1, memory_order_relaxed);
+
+	if (dropped) {
+		atomic_fetch_add_explicit(&server->clientsDropped, 1, memory_order_relaxed);
+	}
+}
+
+static bool networkServerClientSend(caerNetworkServer server, struct network_server_client *client) {
+	client->sendBlocked = false;
+
+	while (true) {
+		while (client->batchCount < NETWORK_SERVER_BATCH_CONTAINERS) {
+			struct network_container *netContainer = ringBufferGet(client->queue);
+			if (netContainer == NULL) {
+				break;
+			}
+
+			client->batch[client->batchCount++] = netContainer;
+		}
+
+		if (client->headerSent == server->headerLength && client->batchCount == 0) {
+			// All sent.
+			return (true);
+		}
+
+		struct msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = client->iov;
+		message.msg_iovlen = (size_t) networkServerClientIov(server, client);
+
+		ssize_t sent = sendmsg(client->socket, &message, NETWORK_SEND_FLAGS);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				// Send buffer full, continue once it drains.
+				client->sendBlocked = true;
+				return (true);
+			}
+
+			caerLog(CAER_LOG_INFO, NETWORK_SERVER_THREAD_NAME, "Client disconnected. Error: %d.", errno);
+			return (false);
+		}
+
+		atomic_fetch_add_explicit(&server->sendCalls, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&server->bytesSent, U64T(sent), memory_order_relaxed);
+
+		// Account for what went out: header first, then whole containers.
+		size_t remaining = (size_t) sent;
+
+		size_t headerPart = server->headerLength - client->headerSent;
+		if (headerPart > remaining) {
+			headerPart = remaining;
+		}
+
+		client->headerSent += headerPart;
+		remaining -= headerPart;
+
+		size_t done = 0;
+
+		while (remaining > 0) {
+			size_t containerPart = client->batch[done]->bytes - client->batchSent;
+
+			if (remaining < containerPart) {
+				client->batchSent += remaining;
+				break;
+			}
+
+			remaining -= containerPart;
+			client->batchSent = 0;
+
+			networkContainerRelease(client->batch[done++]);
+		}
+
+		if (done > 0) {
+			client->batchCount -= done;
+			memmove(client->batch, client->batch + done, client->batchCount * sizeof(*client->batch));
+
+			atomic_fetch_add_explicit(&server->containersSent, done, memory_order_relaxed);
+		}
+	}
+}
+
+static int networkServerClientIov(caerNetworkServer server, struct network_server_client *client) {
+	int iovCount = 0;
+
+	if (client->headerSent < server->headerLength) {
+		client->iov[iovCount].iov_base = server->header + client->headerSent;
+		client->iov[iovCount].iov_len = server->headerLength - client->headerSent;
+		iovCount++;
+	}
+
+	// Skip what was already sent of the first container.
+	size_t skip = client->batchSent;
+
+	for (size_t i = 0; i < client->batchCount; i++) {
+		caerEventPacketContainer container = client->batch[i]->container;
+
+		for (int32_t j = 0; j < caerEventPacketContainerGetEventPacketsNumber(container); j++) {
+			caerEventPacketHeader packet = caerEventPacketContainerGetEventPacket(container, j);
+			if (packet == NULL) {
+				continue;
+			}
+
+			int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+			if (eventNumber == 0) {
+				continue;
+			}
+
+			size_t packetBytes = CAER_EVENT_PACKET_HEADER_SIZE
+				+ ((size_t) eventNumber * (size_t) caerEventPacketHeaderGetEventSize(packet));
+
+			if (skip >= packetBytes) {
+				skip -= packetBytes;
+				continue;
+			}
+
+			if (iovCount == NETWORK_SERVER_IOV_MAX) {
+				// The rest goes in the next call.
+				return (iovCount);
+			}
+
+			client->iov[iovCount].iov_base = ((uint8_t *) packet) + skip;
+			client->iov[iovCount].iov_len = packetBytes - skip;
+			iovCount++;
+
+			skip = 0;
+		}
+
+		// The container end can't be skipped entirely: the container would have been fully sent.
+		if (iovCount == NETWORK_SERVER_IOV_MAX) {
+			return (iovCount);
+		}
+
+		client->iov[iovCount].iov_base = ((uint8_t *) &server->containerEnd) + skip;
+		client->iov[iovCount].iov_len = CAER_EVENT_PACKET_HEADER_SIZE - skip;
+		iovCount++;
+
+		skip = 0;
+	}
+
+	return (iovCount);
+}
+
+static void networkContainerRelease(struct network_container *netContainer) {
+	if (atomic_fetch_sub_explicit(&netContainer->references, 1, memory_order_acq_rel) == 1) {
+		caerEventPacketContainerFree(netContainer->container);
+		free(netContainer);
+	}
+}
+
+static int networkServerThread(void *inPtr) {
+	caerNetworkServer server = inPtr;
+
+	thrd_set_name(NETWORK_SERVER_THREAD_NAME);
+
+	while (atomic_load_explicit(&server->running, memory_order_relaxed)) {
+		// Cleared before looking at the queues: containers queued from now on
+		// trigger a new wake-up, so none can be missed while polling.
+		atomic_store(&server->wakeUpPending, false);
+
+		// Send whatever is queued, as far as the sockets take it. Going
+		// backwards, removing a client only moves an already handled one.
+		for (uint32_t i = server->clientsCount; i-- > 0;) {
+			struct network_server_client *client = server->clients[i];
+
+			if (atomic_load_explicit(&client->disconnect, memory_order_relaxed)) {
+				caerLog(CAER_LOG_INFO, NETWORK_SERVER_THREAD_NAME, "Disconnecting client, its queue is full.");
+				networkServerRemoveClient(server, i, true);
+				continue;
+			}
+
+			if (!networkServerClientSend(server, client)) {
+				networkServerRemoveClient(server, i, true);
+			}
+		}
+
+		server->pollFds[0].fd = server->listenSocket;
+		server->pollFds[0].events = POLLIN;
+		server->pollFds[1].fd = server->wakeUpPipe[0];
+		server->pollFds[1].events = POLLIN;
+
+		uint32_t pollClients = server->clientsCount;
+
+		for (uint32_t i = 0; i < pollClients; i++) {
+			// Clients never send anything: readable means they disconnected.
+			server->pollFds[2 + i].fd = server->clients[i]->socket;
+			server->pollFds[2 + i].events = (short) (POLLIN | ((server->clients[i]->sendBlocked) ? (POLLOUT) : (0)));
+		}
+
+		int result = poll(server->pollFds, 2 + pollClients, NETWORK_SERVER_POLL_TIMEOUT);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			caerLog(CAER_LOG_ERROR, NETWORK_SERVER_THREAD_NAME, "Failed to poll sockets. Error: %d.", errno);
+			break;
+		}
+
+		if (server->pollFds[1].revents & POLLIN) {
+			uint8_t wakeUps[64];
+			while (read(server->wakeUpPipe[0], wakeUps, 64) > 0) {
+				// Drain all wake-ups.
+			}
+		}
+
+		for (uint32_t i = pollClients; i-- > 0;) {
+			if ((server->pollFds[2 + i].revents & (POLLIN | POLLERR | POLLHUP)) == 0) {
+				continue;
+			}
+
+			uint8_t discard[256];
+			ssize_t received = recv(server->clients[i]->socket, discard, 256, MSG_DONTWAIT);
+
+			if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+				caerLog(CAER_LOG_DEBUG, NETWORK_SERVER_THREAD_NAME, "Client disconnected.");
+				networkServerRemoveClient(server, i, false);
+			}
+		}
+
+		// Last, so new clients don't shift the poll entries handled above.
+		if (server->pollFds[0].revents & POLLIN) {
+			networkServerAccept(server);
+		}
+	}
+
+	while (server->clientsCount > 0) {
+		networkServerRemoveClient(server, server->clientsCount - 1, false);
+	}
+
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,7 @@
+#include "probes.h"
+
+// Probe semaphores, incremented by tracers attaching to the probe and
+// checked by CAER_PROBE_ENABLED(). Only compiled in with ENABLE_USDT.
+#define CAER_PROBE_SEMAPHORE_DEFINE(name) CAER_PROBE_SEMAPHORE(name) = 0;
+
+CAER_PROBES(CAER_PROBE_SEMAPHORE_DEFINE)
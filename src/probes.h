@@ -0,0 +1,68 @@
+#ifndef LIBCAER_SRC_PROBES_H_
+#define LIBCAER_SRC_PROBES_H_
+
+// Static tracepoints (USDT) for the data acquisition hot paths, under the
+// 'libcaer' provider. Compiled in with the ENABLE_USDT CMake option, they
+// are just a NOP instruction each until a tracer (perf, bpftrace, SystemTap)
+// attaches to them. Otherwise they vanish completely, arguments included.
+// All timestamps are host CLOCK_MONOTONIC times in ns, unless noted.
+#if defined(ENABLE_USDT)
+	// Each probe has a semaphore, set by the tracer while attached, so that
+	// its arguments are only evaluated when someone is actually listening.
+	#define _SDT_HAS_SEMAPHORES 1
+	#include <sys/sdt.h>
+
+	// All probes, their semaphores are defined in probes.c.
+	#define CAER_PROBES(PROBE) \
+		PROBE(usb_transfer) \
+		PROBE(translator_entry) \
+		PROBE(translator_exit) \
+		PROBE(container_commit) \
+		PROBE(container_drop) \
+		PROBE(ring_put) \
+		PROBE(ring_get) \
+		PROBE(data_get) \
+		PROBE(data_get_many)
+
+	#define CAER_PROBE_SEMAPHORE(name) \
+		unsigned short libcaer_##name##_semaphore __attribute__((unused, section(".probes"))) \
+			__attribute__((visibility("hidden")))
+	#define CAER_PROBE_SEMAPHORE_DECLARE(name) extern CAER_PROBE_SEMAPHORE(name);
+
+	CAER_PROBES(CAER_PROBE_SEMAPHORE_DECLARE)
+
+	#define CAER_PROBE_ENABLED(name) __builtin_expect(libcaer_##name##_semaphore != 0, 0)
+
+	#define CAER_PROBE1(name, a1) \
+		do { if (CAER_PROBE_ENABLED(name)) { DTRACE_PROBE1(libcaer, name, a1); } } while (0)
+	#define CAER_PROBE2(name, a1, a2) \
+		do { if (CAER_PROBE_ENABLED(name)) { DTRACE_PROBE2(libcaer, name, a1, a2); } } while (0)
+	#define CAER_PROBE3(name, a1, a2, a3) \
+		do { if (CAER_PROBE_ENABLED(name)) { DTRACE_PROBE3(libcaer, name, a1, a2, a3); } } while (0)
+	#define CAER_PROBE4(name, a1, a2, a3, a4) \
+		do { if (CAER_PROBE_ENABLED(name)) { DTRACE_PROBE4(libcaer, name, a1, a2, a3, a4); } } while (0)
+
+	// Container probe arguments are captured while the producer still owns the
+	// container: once handed over to the consumer, it may be freed at any time.
+	// A tracer attaching in between sees zero events and timestamp -1.
+	#define CAER_PROBE_CONTAINER_CAPTURE(var, container) \
+		int32_t var##EventsNumber = 0; \
+		int64_t var##HighestTimestamp = -1; \
+		if (CAER_PROBE_ENABLED(container_commit) || CAER_PROBE_ENABLED(container_drop)) { \
+			var##EventsNumber = caerEventPacketContainerGetEventsNumber(container); \
+			var##HighestTimestamp = caerEventPacketContainerGetHighestEventTimestamp(container); \
+		} \
+		(void) 0
+	#define CAER_PROBE_CONTAINER(name, deviceID, var) \
+		CAER_PROBE3(name, deviceID, var##EventsNumber, var##HighestTimestamp)
+#else
+	#define CAER_PROBE1(name, a1) ((void) 0)
+	#define CAER_PROBE2(name, a1, a2) ((void) 0)
+	#define CAER_PROBE3(name, a1, a2, a3) ((void) 0)
+	#define CAER_PROBE4(name, a1, a2, a3, a4) ((void) 0)
+
+	#define CAER_PROBE_CONTAINER_CAPTURE(var, container) ((void) 0)
+	#define CAER_PROBE_CONTAINER(name, deviceID, var) ((void) 0)
+#endif
+
+#endif /* LIBCAER_SRC_PROBES_H_ */
@@ -10,6 +10,10 @@
 #include <stdatomic.h>
 #include <stdalign.h> // To get alignas() macro.
 
+#ifdef HAVE_PTHREADS
+	#include "../c11threads_posix.h"
+#endif
+
 // Alignment specification support (with defines for cache line alignment).
 #undef CACHELINE_ALIGNED
 #undef CACHELINE_ALONE
@@ -22,11 +26,24 @@
 #define CACHELINE_ALIGNED alignas(CACHELINE_SIZE)
 #define CACHELINE_ALONE(t, v) CACHELINE_ALIGNED t v; uint8_t PAD_##v[CACHELINE_SIZE - (sizeof(t) & (CACHELINE_SIZE - 1))]
 
+// Put and get positions are free-running counters, the actual place in the
+// elements array is found by masking with (size - 1). Each place carries a
+// sequence number telling which position it is ready for: equal to the
+// position if free for a put, position + 1 if holding that position's element.
+// The get position is atomic, so that the producer can take the oldest element
+// out itself when the buffer is full (see ringBufferPutEvict()). Both sides then
+// claim elements by advancing it with a CAS, while the sequence numbers make
+// sure a place that's claimed but not yet freed is never mistaken for valid.
+struct ring_buffer_element {
+	atomic_size_t sequence;
+	void *elem;
+};
+
 struct ring_buffer {
 	CACHELINE_ALONE(size_t, putPos);
-	CACHELINE_ALONE(size_t, getPos);
+	CACHELINE_ALONE(atomic_size_t, getPos);
 	CACHELINE_ALONE(size_t, size);
-	atomic_uintptr_t elements[];
+	struct ring_buffer_element elements[];
 };
 
 RingBuffer ringBufferInit(size_t size) {
@@ -35,20 +52,27 @@ RingBuffer ringBufferInit(size_t size) {
 		return (NULL);
 	}
 
+	// Sequence numbers need at least two places to tell a free place
+	// apart from a full one, so a size of one is doubled (see ringbuffer.h).
+	if (size == 1) {
+		size = 2;
+	}
+
 	RingBuffer rBuf = portable_aligned_alloc(CACHELINE_SIZE,
-		sizeof(struct ring_buffer) + (size * sizeof(atomic_uintptr_t)));
+		sizeof(struct ring_buffer) + (size * sizeof(struct ring_buffer_element)));
 	if (rBuf == NULL) {
 		return (NULL);
 	}
 
 	// Initialize counter variables.
 	rBuf->putPos = 0;
-	rBuf->getPos = 0;
+	atomic_store_explicit(&rBuf->getPos, 0, memory_order_relaxed);
 	rBuf->size = size;
 
-	// Initialize pointers.
+	// Initialize places, all free for the first round of puts.
 	for (size_t i = 0; i < size; i++) {
-		atomic_store_explicit(&rBuf->elements[i], (uintptr_t) NULL, memory_order_relaxed);
+		atomic_store_explicit(&rBuf->elements[i].sequence, i, memory_order_relaxed);
+		rBuf->elements[i].elem = NULL;
 	}
 
 	atomic_thread_fence(memory_order_release);
@@ -60,6 +84,10 @@ void ringBufferFree(RingBuffer rBuf) {
 	free(rBuf);
 }
 
+size_t ringBufferSize(RingBuffer rBuf) {
+	return (rBuf->size);
+}
+
 bool ringBufferPut(RingBuffer rBuf, void *elem) {
 	if (elem == NULL) {
 		// NULL elements are disallowed (used as place-holders).
@@ -67,15 +95,16 @@ bool ringBufferPut(RingBuffer rBuf, void *elem) {
 		exit(EXIT_FAILURE);
 	}
 
-	void *curr = (void *) atomic_load_explicit(&rBuf->elements[rBuf->putPos], memory_order_acquire);
+	struct ring_buffer_element *place = &rBuf->elements[rBuf->putPos & (rBuf->size - 1)];
 
-	// If the place where we want to put the new element is NULL, it's still
-	// free and we can use it.
-	if (curr == NULL) {
-		atomic_store_explicit(&rBuf->elements[rBuf->putPos], (uintptr_t ) elem, memory_order_release);
+	// If the place where we want to put the new element is ready for our
+	// position, it's free and we can use it.
+	if (atomic_load_explicit(&place->sequence, memory_order_acquire) == rBuf->putPos) {
+		place->elem = elem;
+		atomic_store_explicit(&place->sequence, rBuf->putPos + 1, memory_order_release);
 
 		// Increase local put pointer.
-		rBuf->putPos = ((rBuf->putPos + 1) & (rBuf->size - 1));
+		rBuf->putPos++;
 
 		return (true);
 	}
@@ -84,32 +113,130 @@ bool ringBufferPut(RingBuffer rBuf, void *elem) {
 	return (false);
 }
 
+bool ringBufferPutEvict(RingBuffer rBuf, void *elem, void **evicted) {
+	*evicted = NULL;
+
+	if (ringBufferPut(rBuf, elem)) {
+		return (true);
+	}
+
+	// Buffer is full. Only evict if nobody is taking an element out right now,
+	// meaning the oldest element sits exactly where we want to put the new one.
+	size_t getPos = atomic_load_explicit(&rBuf->getPos, memory_order_relaxed);
+
+	if ((rBuf->putPos - getPos) == rBuf->size) {
+		struct ring_buffer_element *place = &rBuf->elements[getPos & (rBuf->size - 1)];
+
+		// Claim the oldest element, racing against the consumer.
+		if (atomic_load_explicit(&place->sequence, memory_order_acquire) == (getPos + 1)
+			&& atomic_compare_exchange_strong_explicit(&rBuf->getPos, &getPos, getPos + 1, memory_order_relaxed,
+				memory_order_relaxed)) {
+			*evicted = place->elem;
+
+			atomic_store_explicit(&place->sequence, getPos + rBuf->size, memory_order_release);
+		}
+	}
+
+	// Either we freed up the place ourselves, or the consumer is in the middle
+	// of taking the oldest element out and will free it up momentarily.
+	// Yield meanwhile, the consumer may be waiting for this very CPU.
+	while (!ringBufferPut(rBuf, elem)) {
+		thrd_yield();
+	}
+
+	return (true);
+}
+
 void *ringBufferGet(RingBuffer rBuf) {
-	void *curr = (void *) atomic_load_explicit(&rBuf->elements[rBuf->getPos], memory_order_acquire);
+	size_t getPos = atomic_load_explicit(&rBuf->getPos, memory_order_relaxed);
+
+	while (true) {
+		struct ring_buffer_element *place = &rBuf->elements[getPos & (rBuf->size - 1)];
+
+		// If the place where we want to get an element from doesn't hold the
+		// element for our position, the buffer is empty.
+		if (atomic_load_explicit(&place->sequence, memory_order_acquire) != (getPos + 1)) {
+			return (NULL);
+		}
 
-	// If the place where we want to get an element from is not NULL, there
-	// is valid content there, which we return, and reset the place to NULL.
-	if (curr != NULL) {
-		atomic_store_explicit(&rBuf->elements[rBuf->getPos], (uintptr_t) NULL, memory_order_release);
+		// Else, there is valid content there. Claim it, which only fails if
+		// the producer evicted it in the meantime, then free up the place
+		// for the put position one round later.
+		if (atomic_compare_exchange_weak_explicit(&rBuf->getPos, &getPos, getPos + 1, memory_order_relaxed,
+			memory_order_relaxed)) {
+			void *curr = place->elem;
 
-		// Increase local get pointer.
-		rBuf->getPos = ((rBuf->getPos + 1) & (rBuf->size - 1));
+			atomic_store_explicit(&place->sequence, getPos + rBuf->size, memory_order_release);
 
-		return (curr);
+			return (curr);
+		}
+
+		// getPos was updated by the failed CAS, retry with the new position.
 	}
+}
 
-	// Else, buffer is empty.
-	return (NULL);
+size_t ringBufferGetMany(RingBuffer rBuf, void **elems, size_t maxElems) {
+	size_t getPos = atomic_load_explicit(&rBuf->getPos, memory_order_relaxed);
+	size_t count = 0;
+
+	retry: count = 0;
+
+	// Count as many consecutive valid elements as possible, up to maxElems.
+	// Relaxed loads are enough here, a single acquire fence afterwards then
+	// synchronizes with all the producer's release stores at once.
+	while (count < maxElems && count < rBuf->size) {
+		size_t pos = getPos + count;
+
+		if (atomic_load_explicit(&rBuf->elements[pos & (rBuf->size - 1)].sequence, memory_order_relaxed) != (pos + 1)) {
+			break;
+		}
+
+		count++;
+	}
+
+	if (count == 0) {
+		// Buffer is empty.
+		return (0);
+	}
+
+	// Claim all elements at once, updating the get position only once.
+	if (!atomic_compare_exchange_weak_explicit(&rBuf->getPos, &getPos, getPos + count, memory_order_relaxed,
+		memory_order_relaxed)) {
+		// The producer evicted some, getPos was updated by the failed CAS.
+		goto retry;
+	}
+
+	atomic_thread_fence(memory_order_acquire);
+
+	for (size_t i = 0; i < count; i++) {
+		elems[i] = rBuf->elements[(getPos + i) & (rBuf->size - 1)].elem;
+	}
+
+	// Free up all the places we took elements from. One release fence orders
+	// our reads before any of these stores, so that the producer can only see
+	// a place as free after we're done with it.
+	atomic_thread_fence(memory_order_release);
+
+	for (size_t i = 0; i < count; i++) {
+		size_t pos = getPos + i;
+
+		atomic_store_explicit(&rBuf->elements[pos & (rBuf->size - 1)].sequence, pos + rBuf->size,
+			memory_order_relaxed);
+	}
+
+	return (count);
 }
 
 void *ringBufferLook(RingBuffer rBuf) {
-	void *curr = (void *) atomic_load_explicit(&rBuf->elements[rBuf->getPos], memory_order_acquire);
+	size_t getPos = atomic_load_explicit(&rBuf->getPos, memory_order_relaxed);
+
+	struct ring_buffer_element *place = &rBuf->elements[getPos & (rBuf->size - 1)];
 
-	// If the place where we want to get an element from is not NULL, there
-	// is valid content there, which we return, without removing it from the
-	// ring buffer.
-	if (curr != NULL) {
-		return (curr);
+	// If the place where we want to get an element from holds the element
+	// for our position, there is valid content there, which we return,
+	// without removing it from the ring buffer.
+	if (atomic_load_explicit(&place->sequence, memory_order_acquire) == (getPos + 1)) {
+		return (place->elem);
 	}
 
 	// Else, buffer is empty.
@@ -15,10 +15,16 @@
 
 typedef struct ring_buffer *RingBuffer;
 
+// Size must be a power of two. A size of one is doubled to two, as the
+// sequence numbers need two places to tell a free one from a full one,
+// so such a ring-buffer can hold two elements (see ringBufferSize()).
 RingBuffer ringBufferInit(size_t size);
 void ringBufferFree(RingBuffer rBuf);
+size_t ringBufferSize(RingBuffer rBuf);
 bool ringBufferPut(RingBuffer rBuf, void *elem);
+bool ringBufferPutEvict(RingBuffer rBuf, void *elem, void **evicted);
 void *ringBufferGet(RingBuffer rBuf);
+size_t ringBufferGetMany(RingBuffer rBuf, void **elems, size_t maxElems);
 void *ringBufferLook(RingBuffer rBuf);
 
 #endif /* RINGBUFFER_H_ */
@@ -0,0 +1,577 @@
+#include "shared_memory.h"
+#include <stdatomic.h>
+#include <stdalign.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(OS_LINUX) && OS_LINUX == 1
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#define SHM_USE_FUTEX 1
+#else
+	#define SHM_USE_FUTEX 0
+	#define SHM_POLL_INTERVAL 100 // in µs, waiting without futex.
+#endif
+
+// Segment layout: header, then the slot descriptors, then the slot data,
+// each slot's data starting on a cache line.
+#define SHM_MAGIC "CAERSHMRING"
+#define SHM_MAGIC_LENGTH 16
+#define SHM_VERSION 1
+#define SHM_CACHE_LINE 64
+#define SHM_PACKET_ALIGNMENT 8
+
+#define SHM_ALIGN(x, a) (((x) + ((a) - 1)) & ~((size_t) (a) - 1))
+
+struct shm_header {
+	char magic[SHM_MAGIC_LENGTH];
+	uint32_t version;
+	uint32_t slotCount;
+	uint64_t slotSize;
+	uint64_t slotsOffset;
+	uint64_t dataOffset;
+	// Number of slots published. Written by the producer for every slot,
+	// so kept on its own cache line.
+	alignas(SHM_CACHE_LINE) atomic_uint_fast64_t writeSequence;
+	// Futex word, incremented on every publish, consumers wait on it.
+	atomic_uint notify;
+};
+
+struct shm_slot {
+	// Sequence lock: 2n+1 while the producer fills the slot for publish
+	// number n, 2n+2 once it's published.
+	alignas(SHM_CACHE_LINE) atomic_uint_fast64_t sequence;
+	int32_t packetsNumber;
+	uint32_t packetOffsets[CAER_SHARED_MEMORY_SLOT_PACKETS_MAX];
+};
+
+struct caer_shared_memory_producer {
+	char *name;
+	uint8_t *segment;
+	size_t segmentSize;
+	struct shm_header *header;
+	struct shm_slot *slots;
+	uint8_t *data;
+	uint32_t slotMask;
+	size_t slotSize;
+	// Number of the next publish, and the slot being filled, if any.
+	uint64_t sequence;
+	bool slotOpen;
+	size_t slotUsed;
+};
+
+struct caer_shared_memory_consumer {
+	uint8_t *segment; // Mapped read-only.
+	size_t segmentSize;
+	struct shm_header *header;
+	struct shm_slot *slots;
+	uint8_t *data;
+	uint32_t slotMask;
+	size_t slotSize;
+	// Number of the next slot to read, and slots lost since the last one read.
+	uint64_t sequence;
+	uint64_t slotsLost;
+};
+
+static uint8_t *shmProducerReserve(caerSharedMemoryProducer producer, size_t size);
+static bool shmConsumerRead(caerSharedMemoryConsumer consumer, struct caer_shared_memory_view *view);
+static void shmWait(struct shm_header *header, uint32_t notify, int64_t timeout);
+static void shmWakeUp(struct shm_header *header);
+static inline int64_t shmTime(void);
+
+caerSharedMemoryProducer caerSharedMemoryProducerOpen(const char *name, uint32_t slotCount, size_t slotSize) {
+	if (name == NULL || slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || slotSize == 0
+		|| slotSize > UINT32_MAX || slotSize > (SIZE_MAX / 2) / slotCount) {
+		caerLog(CAER_LOG_CRITICAL, __func__,
+			"Invalid shared memory ring (slots=%" PRIu32 ", must be a power of two, slot size=%zu).", slotCount,
+			slotSize);
+		return (NULL);
+	}
+
+	caerSharedMemoryProducer producer = calloc(1, sizeof(*producer));
+	if (producer == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for shared memory producer.");
+		return (NULL);
+	}
+
+	producer->name = strdup(name);
+	if (producer->name == NULL) {
+		free(producer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for shared memory producer.");
+		return (NULL);
+	}
+
+	producer->slotMask = slotCount - 1;
+	producer->slotSize = SHM_ALIGN(slotSize, SHM_CACHE_LINE);
+
+	size_t slotsOffset = SHM_ALIGN(sizeof(struct shm_header), SHM_CACHE_LINE);
+	size_t dataOffset = SHM_ALIGN(slotsOffset + (slotCount * sizeof(struct shm_slot)), SHM_CACHE_LINE);
+	producer->segmentSize = dataOffset + (slotCount * producer->slotSize);
+
+	// Start from a fresh segment, consumers of a previous one keep theirs.
+	shm_unlink(name);
+
+	int fileDescriptor = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fileDescriptor < 0) {
+		free(producer->name);
+		free(producer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to create shared memory segment '%s'. Error: %d.", name, errno);
+		return (NULL);
+	}
+
+	if (ftruncate(fileDescriptor, (off_t) producer->segmentSize) != 0) {
+		// Log first, the clean-up frees the producer and may change errno.
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to size shared memory segment '%s' to %zu bytes. Error: %d.",
+			name, producer->segmentSize, errno);
+
+		close(fileDescriptor);
+		shm_unlink(name);
+		free(producer->name);
+		free(producer);
+
+		return (NULL);
+	}
+
+	producer->segment = mmap(NULL, producer->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+
+	// The mapping stays valid without the descriptor.
+	close(fileDescriptor);
+
+	if (producer->segment == MAP_FAILED) {
+		shm_unlink(name);
+		free(producer->name);
+		free(producer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to map shared memory segment '%s'. Error: %d.", name, errno);
+		return (NULL);
+	}
+
+	producer->header = (struct shm_header *) producer->segment;
+	producer->slots = (struct shm_slot *) (producer->segment + slotsOffset);
+	producer->data = producer->segment + dataOffset;
+
+	// Other processes can only use atomics that don't rely on a lock in this one.
+	if (!atomic_is_lock_free(&producer->header->writeSequence) || !atomic_is_lock_free(&producer->header->notify)) {
+		munmap(producer->segment, producer->segmentSize);
+		shm_unlink(name);
+		free(producer->name);
+		free(producer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Shared memory rings need lock-free atomics, not available.");
+		return (NULL);
+	}
+
+	// A new segment is all zeros: slots have sequence zero, never published.
+	atomic_store(&producer->header->writeSequence, 0);
+	atomic_store(&producer->header->notify, 0);
+
+	producer->header->version = SHM_VERSION;
+	producer->header->slotCount = slotCount;
+	producer->header->slotSize = producer->slotSize;
+	producer->header->slotsOffset = slotsOffset;
+	producer->header->dataOffset = dataOffset;
+
+	// Magic last: consumers only accept the segment once it's set.
+	atomic_thread_fence(memory_order_release);
+	strncpy(producer->header->magic, SHM_MAGIC, SHM_MAGIC_LENGTH);
+
+	return (producer);
+}
+
+caerEventPacketHeader caerSharedMemoryProducerPacketAllocate(caerSharedMemoryProducer producer,
+	int32_t eventCapacity, int16_t eventType, int32_t eventSize, int32_t eventTSOffset, int16_t eventSource,
+	int32_t tsOverflow) {
+	if (producer == NULL || eventCapacity <= 0 || eventSize <= 0
+		|| (size_t) eventCapacity > (producer->slotSize - CAER_EVENT_PACKET_HEADER_SIZE) / (size_t) eventSize) {
+		return (NULL);
+	}
+
+	size_t packetSize = CAER_EVENT_PACKET_HEADER_SIZE + ((size_t) eventCapacity * (size_t) eventSize);
+
+	caerEventPacketHeader packet = (caerEventPacketHeader) shmProducerReserve(producer, packetSize);
+	if (packet == NULL) {
+		return (NULL);
+	}
+
+	// Zero out event memory (all events invalid), like when allocating normally.
+	memset(packet, 0, packetSize);
+
+	caerEventPacketHeaderSetEventType(packet, eventType);
+	caerEventPacketHeaderSetEventSource(packet, eventSource);
+	caerEventPacketHeaderSetEventSize(packet, eventSize);
+	caerEventPacketHeaderSetEventTSOffset(packet, eventTSOffset);
+	caerEventPacketHeaderSetEventTSOverflow(packet, tsOverflow);
+	caerEventPacketHeaderSetEventCapacity(packet, eventCapacity);
+
+	return (packet);
+}
+
+bool caerSharedMemoryProducerCommit(caerSharedMemoryProducer producer) {
+	if (producer == NULL) {
+		return (false);
+	}
+
+	if (!producer->slotOpen) {
+		return (true);
+	}
+
+	struct shm_slot *slot = &producer->slots[producer->sequence & producer->slotMask];
+
+	atomic_store_explicit(&slot->sequence, (2 * producer->sequence) + 2, memory_order_release);
+
+	producer->sequence++;
+	producer->slotOpen = false;
+
+	atomic_store_explicit(&producer->header->writeSequence, producer->sequence, memory_order_release);
+
+	shmWakeUp(producer->header);
+
+	return (true);
+}
+
+bool caerSharedMemoryProducerWrite(caerSharedMemoryProducer producer, caerEventPacketContainer container) {
+	if (producer == NULL || container == NULL || producer->slotOpen) {
+		return (false);
+	}
+
+	for (int32_t i = 0; i < caerEventPacketContainerGetEventPacketsNumber(container); i++) {
+		caerEventPacketHeader packet = caerEventPacketContainerGetEventPacket(container, i);
+		if (packet == NULL) {
+			continue;
+		}
+
+		int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+		if (eventNumber == 0) {
+			continue;
+		}
+
+		size_t packetSize = CAER_EVENT_PACKET_HEADER_SIZE
+			+ ((size_t) eventNumber * (size_t) caerEventPacketHeaderGetEventSize(packet));
+
+		caerEventPacketHeader slotPacket = (caerEventPacketHeader) shmProducerReserve(producer, packetSize);
+		if (slotPacket == NULL) {
+			// Doesn't fit: abandon the slot, it gets refilled by the next publish.
+			producer->slotOpen = false;
+
+			caerLog(CAER_LOG_ERROR, __func__,
+				"Packet container doesn't fit into a shared memory slot of %zu bytes (max. %d packets).",
+				producer->slotSize, CAER_SHARED_MEMORY_SLOT_PACKETS_MAX);
+			return (false);
+		}
+
+		memcpy(slotPacket, packet, packetSize);
+
+		// Only the events are copied, not the unused capacity.
+		caerEventPacketHeaderSetEventCapacity(slotPacket, eventNumber);
+	}
+
+	return (caerSharedMemoryProducerCommit(producer));
+}
+
+bool caerSharedMemoryProducerClose(caerSharedMemoryProducer producer) {
+	if (producer == NULL) {
+		return (false);
+	}
+
+	bool success = true;
+
+	if (munmap(producer->segment, producer->segmentSize) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to unmap shared memory segment. Error: %d.", errno);
+		success = false;
+	}
+
+	if (shm_unlink(producer->name) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to remove shared memory segment '%s'. Error: %d.", producer->name,
+			errno);
+		success = false;
+	}
+
+	free(producer->name);
+	free(producer);
+
+	return (success);
+}
+
+caerSharedMemoryConsumer caerSharedMemoryConsumerOpen(const char *name) {
+	if (name == NULL) {
+		return (NULL);
+	}
+
+	caerSharedMemoryConsumer consumer = calloc(1, sizeof(*consumer));
+	if (consumer == NULL) {
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to allocate memory for shared memory consumer.");
+		return (NULL);
+	}
+
+	int fileDescriptor = shm_open(name, O_RDONLY, 0);
+	if (fileDescriptor < 0) {
+		free(consumer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to open shared memory segment '%s'. Error: %d.", name, errno);
+		return (NULL);
+	}
+
+	struct stat segmentStat;
+	if (fstat(fileDescriptor, &segmentStat) != 0 || (size_t) segmentStat.st_size < sizeof(struct shm_header)) {
+		close(fileDescriptor);
+		free(consumer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Shared memory segment '%s' is too small.", name);
+		return (NULL);
+	}
+
+	consumer->segmentSize = (size_t) segmentStat.st_size;
+	consumer->segment = mmap(NULL, consumer->segmentSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+
+	close(fileDescriptor);
+
+	if (consumer->segment == MAP_FAILED) {
+		free(consumer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Failed to map shared memory segment '%s'. Error: %d.", name, errno);
+		return (NULL);
+	}
+
+	consumer->header = (struct shm_header *) consumer->segment;
+
+	bool valid = (strncmp(consumer->header->magic, SHM_MAGIC, SHM_MAGIC_LENGTH) == 0);
+	atomic_thread_fence(memory_order_acquire);
+
+	uint32_t slotCount = consumer->header->slotCount;
+	uint64_t slotSize = consumer->header->slotSize;
+	uint64_t slotsOffset = consumer->header->slotsOffset;
+	uint64_t dataOffset = consumer->header->dataOffset;
+
+	// Everything the consumer accesses later must be inside the mapping.
+	valid = valid && consumer->header->version == SHM_VERSION && slotCount != 0
+		&& (slotCount & (slotCount - 1)) == 0 && slotSize > CAER_EVENT_PACKET_HEADER_SIZE
+		&& slotsOffset >= sizeof(struct shm_header) && (slotsOffset % SHM_CACHE_LINE) == 0
+		&& slotsOffset + (slotCount * sizeof(struct shm_slot)) <= dataOffset
+		&& dataOffset <= consumer->segmentSize
+		&& slotSize <= (consumer->segmentSize - dataOffset) / slotCount;
+
+	if (!valid) {
+		munmap(consumer->segment, consumer->segmentSize);
+		free(consumer);
+
+		caerLog(CAER_LOG_CRITICAL, __func__, "Shared memory segment '%s' is not a valid event packet ring.", name);
+		return (NULL);
+	}
+
+	consumer->slots = (struct shm_slot *) (consumer->segment + slotsOffset);
+	consumer->data = consumer->segment + dataOffset;
+	consumer->slotMask = slotCount - 1;
+	consumer->slotSize = slotSize;
+
+	// Start with the next publish.
+	consumer->sequence = atomic_load_explicit(&consumer->header->writeSequence, memory_order_acquire);
+
+	return (consumer);
+}
+
+bool caerSharedMemoryConsumerNext(caerSharedMemoryConsumer consumer, struct caer_shared_memory_view *view,
+	uint32_t timeout) {
+	if (consumer == NULL || view == NULL) {
+		return (false);
+	}
+
+	int64_t deadline = shmTime() + (I64T(timeout) * 1000);
+
+	while (true) {
+		// Read before the sequence: a publish after this changes it,
+		// so waiting on it can't miss that publish.
+		uint32_t notify = atomic_load_explicit(&consumer->header->notify, memory_order_acquire);
+		uint64_t written = atomic_load_explicit(&consumer->header->writeSequence, memory_order_acquire);
+
+		if (written > consumer->sequence) {
+			uint64_t slotCount = (uint64_t) consumer->slotMask + 1;
+
+			// Too far behind: the oldest slot still intact is the one after
+			// the slot the producer may be refilling right now.
+			if ((written - consumer->sequence) >= slotCount) {
+				uint64_t skip = written - slotCount + 1 - consumer->sequence;
+
+				consumer->sequence += skip;
+				consumer->slotsLost += skip;
+			}
+
+			if (shmConsumerRead(consumer, view)) {
+				view->slotsLost = consumer->slotsLost;
+
+				consumer->sequence++;
+				consumer->slotsLost = 0;
+
+				return (true);
+			}
+
+			// Overwritten while looking at it.
+			consumer->sequence++;
+			consumer->slotsLost++;
+			continue;
+		}
+
+		int64_t remaining = deadline - shmTime();
+		if (remaining <= 0) {
+			return (false);
+		}
+
+		shmWait(consumer->header, notify, remaining);
+	}
+}
+
+bool caerSharedMemoryConsumerValid(caerSharedMemoryConsumer consumer, const struct caer_shared_memory_view *view) {
+	if (consumer == NULL || view == NULL) {
+		return (false);
+	}
+
+	struct shm_slot *slot = &consumer->slots[view->sequence & consumer->slotMask];
+
+	// All reads of the slot's data happen before checking it wasn't reused.
+	atomic_thread_fence(memory_order_acquire);
+
+	return (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == ((2 * view->sequence) + 2));
+}
+
+bool caerSharedMemoryConsumerClose(caerSharedMemoryConsumer consumer) {
+	if (consumer == NULL) {
+		return (false);
+	}
+
+	bool success = true;
+
+	if (munmap(consumer->segment, consumer->segmentSize) != 0) {
+		caerLog(CAER_LOG_ERROR, __func__, "Failed to unmap shared memory segment. Error: %d.", errno);
+		success = false;
+	}
+
+	free(consumer);
+
+	return (success);
+}
+
+static uint8_t *shmProducerReserve(caerSharedMemoryProducer producer, size_t size) {
+	struct shm_slot *slot = &producer->slots[producer->sequence & producer->slotMask];
+
+	if (!producer->slotOpen) {
+		if (size > producer->slotSize) {
+			return (NULL);
+		}
+
+		// Consumers still reading the slot's previous content see it changed.
+		atomic_store_explicit(&slot->sequence, (2 * producer->sequence) + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+
+		slot->packetsNumber = 0;
+
+		producer->slotOpen = true;
+		producer->slotUsed = 0;
+	}
+
+	size_t offset = SHM_ALIGN(producer->slotUsed, SHM_PACKET_ALIGNMENT);
+
+	if (slot->packetsNumber == CAER_SHARED_MEMORY_SLOT_PACKETS_MAX || offset > producer->slotSize
+		|| size > (producer->slotSize - offset)) {
+		return (NULL);
+	}
+
+	slot->packetOffsets[slot->packetsNumber++] = (uint32_t) offset;
+	producer->slotUsed = offset + size;
+
+	return (producer->data + ((producer->sequence & producer->slotMask) * producer->slotSize) + offset);
+}
+
+static bool shmConsumerRead(caerSharedMemoryConsumer consumer, struct caer_shared_memory_view *view) {
+	struct shm_slot *slot = &consumer->slots[consumer->sequence & consumer->slotMask];
+	uint64_t published = (2 * consumer->sequence) + 2;
+
+	if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != published) {
+		return (false);
+	}
+
+	uint8_t *slotData = consumer->data + ((consumer->sequence & consumer->slotMask) * consumer->slotSize);
+	int32_t packetsNumber = slot->packetsNumber;
+	bool valid = (packetsNumber > 0 && packetsNumber <= CAER_SHARED_MEMORY_SLOT_PACKETS_MAX);
+
+	// Never trust offsets and sizes to stay inside the mapping.
+	for (int32_t i = 0; valid && i < packetsNumber; i++) {
+		size_t offset = slot->packetOffsets[i];
+
+		if (offset > (consumer->slotSize - CAER_EVENT_PACKET_HEADER_SIZE)) {
+			valid = false;
+			break;
+		}
+
+		caerEventPacketHeader packet = (caerEventPacketHeader) (slotData + offset);
+		int32_t eventSize = caerEventPacketHeaderGetEventSize(packet);
+		int32_t eventCapacity = caerEventPacketHeaderGetEventCapacity(packet);
+		int32_t eventNumber = caerEventPacketHeaderGetEventNumber(packet);
+
+		if (eventSize <= 0 || eventCapacity < 0 || eventNumber < 0 || eventNumber > eventCapacity
+			|| (size_t) eventCapacity
+				> (consumer->slotSize - offset - CAER_EVENT_PACKET_HEADER_SIZE) / (size_t) eventSize) {
+			valid = false;
+			break;
+		}
+
+		view->packets[i] = packet;
+	}
+
+	atomic_thread_fence(memory_order_acquire);
+
+	if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != published) {
+		// Reused meanwhile, what was read means nothing.
+		return (false);
+	}
+
+	if (!valid) {
+		caerLog(CAER_LOG_ERROR, __func__, "Invalid shared memory slot %" PRIu64 ", skipping it.", consumer->sequence);
+		return (false);
+	}
+
+	view->sequence = consumer->sequence;
+	view->packetsNumber = packetsNumber;
+
+	return (true);
+}
+
+static void shmWait(struct shm_header *header, uint32_t notify, int64_t timeout) {
+#if SHM_USE_FUTEX == 1
+	// Not a private futex: it's shared between processes.
+	struct timespec waitTime = { .tv_sec = timeout / 1000000000LL, .tv_nsec = timeout % 1000000000LL };
+
+	syscall(SYS_futex, &header->notify, FUTEX_WAIT, notify, &waitTime, NULL, 0);
+#else
+	(void) header;
+	(void) notify;
+
+	if (timeout > (SHM_POLL_INTERVAL * 1000LL)) {
+		timeout = SHM_POLL_INTERVAL * 1000LL;
+	}
+
+	struct timespec waitTime = { .tv_sec = 0, .tv_nsec = timeout };
+	nanosleep(&waitTime, NULL);
+#endif
+}
+
+static void shmWakeUp(struct shm_header *header) {
+	atomic_fetch_add_explicit(&header->notify, 1, memory_order_release);
+
+#if SHM_USE_FUTEX == 1
+	// Consumers map the segment read-only and can't announce they're
+	// waiting, so always wake: without waiters this is cheap.
+	syscall(SYS_futex, &header->notify, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+static inline int64_t shmTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((I64T(now.tv_sec) * 1000000000LL) + I64T(now.tv_nsec));
+}
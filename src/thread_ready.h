@@ -0,0 +1,59 @@
+#ifndef LIBCAER_SRC_THREAD_READY_H_
+#define LIBCAER_SRC_THREAD_READY_H_
+
+#include "libcaer.h"
+
+#ifdef HAVE_PTHREADS
+	#include "c11threads_posix.h"
+#endif
+
+// Start handshake between a device's DataStart() and its data acquisition thread:
+// the thread signals once it's ready (or gave up), DataStart() sleeps until then.
+// Unlike waiting for 'dataAcquisitionThreadRun' to become true, this also works
+// if the thread already stopped again, and doesn't burn a core meanwhile.
+struct thread_ready {
+	mtx_t lock;
+	cnd_t cond;
+	bool ready;
+};
+
+static inline bool threadReadyInit(struct thread_ready *threadReady) {
+	if (mtx_init(&threadReady->lock, mtx_plain) != thrd_success) {
+		return (false);
+	}
+
+	if (cnd_init(&threadReady->cond) != thrd_success) {
+		mtx_destroy(&threadReady->lock);
+		return (false);
+	}
+
+	threadReady->ready = false;
+
+	return (true);
+}
+
+static inline void threadReadyDestroy(struct thread_ready *threadReady) {
+	cnd_destroy(&threadReady->cond);
+	mtx_destroy(&threadReady->lock);
+}
+
+static inline void threadReadySignal(struct thread_ready *threadReady) {
+	mtx_lock(&threadReady->lock);
+
+	threadReady->ready = true;
+	cnd_broadcast(&threadReady->cond);
+
+	mtx_unlock(&threadReady->lock);
+}
+
+static inline void threadReadyWait(struct thread_ready *threadReady) {
+	mtx_lock(&threadReady->lock);
+
+	while (!threadReady->ready) {
+		cnd_wait(&threadReady->cond, &threadReady->lock);
+	}
+
+	mtx_unlock(&threadReady->lock);
+}
+
+#endif /* LIBCAER_SRC_THREAD_READY_H_ */
@@ -0,0 +1,662 @@
+#include "usb_simulation.h"
+#include "davis_common.h"
+#include "dvs128.h"
+
+#define SIMULATION_CONFIG_MODULES 16
+#define SIMULATION_CONFIG_PARAMS 256
+
+#define SIMULATION_DEFAULT_EVENT_RATE 1000000 // 1 Mev/s.
+#define SIMULATION_FLUSH_INTERVAL 1000000LL // 1 ms in ns, like the device-side USB packet timeout.
+#define SIMULATION_IDLE_SLEEP 1000000LL // 1 ms in ns.
+
+// Space to keep free in a buffer before adding another event: worst-case
+// one timestamp wrap, one timestamp and the event itself.
+#define SIMULATION_EVENT_SPACE 16
+
+#define DAVIS_SIMULATION_SIZE_X 240
+#define DAVIS_SIMULATION_SIZE_Y 180
+#define DAVIS_SIMULATION_TS_WRAP 0x8000
+#define DAVIS_SIMULATION_WRAP_MAX 0x0FFF
+
+#define DVS128_SIMULATION_TS_WRAP 0x4000
+
+struct usb_transfer_list {
+	struct libusb_transfer **transfers;
+	size_t length;
+	size_t capacity;
+};
+
+struct usb_simulation {
+	uint16_t deviceType;
+	uint8_t dataEndpoint;
+	size_t eventBytes; // Average bytes per event on the data endpoint.
+	uint16_t sizeX;
+	uint16_t sizeY;
+	// Register model, written and read by configuration control requests.
+	atomic_uint_fast32_t config[SIMULATION_CONFIG_MODULES][SIMULATION_CONFIG_PARAMS];
+	atomic_bool dvsRunning; // DVS128 only, set by start/stop transfer requests.
+	atomic_bool timestampReset; // Pending timestamp reset, sent in-stream next.
+	// Host-side settings.
+	atomic_uint_fast32_t eventRate; // in events/s, 0 is as fast as possible.
+	atomic_uint_fast64_t generatedEvents;
+	// Submitted and cancelled transfers, accessed from any thread.
+	mtx_t transfersLock;
+	struct usb_transfer_list pending;
+	struct usb_transfer_list cancelled;
+	// Event generation, only done while holding the events lock,
+	// like libusb only handles events from one thread at a time.
+	mtx_t eventsLock;
+	bool generating;
+	int64_t startTime; // Host time in ns when generation started.
+	int64_t lastTime; // Host time in ns of the last generated event.
+	int64_t lastFlush; // Host time in ns of the last completed data transfer.
+	int64_t epoch; // Host time in ns of device timestamp zero.
+	int64_t lastTimestamp; // Last device timestamp sent, in µs.
+	int64_t lastWrap; // Device timestamp of the last wrap sent, in µs.
+	uint64_t sentEvents; // Events generated since generation started.
+	uint64_t random;
+};
+
+static inline int64_t simulationHostTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((I64T(now.tv_sec) * 1000000000LL) + I64T(now.tv_nsec));
+}
+
+static inline void simulationSleep(int64_t nanoseconds) {
+	if (nanoseconds <= 0) {
+		return;
+	}
+
+	struct timespec sleepTime = { .tv_sec = nanoseconds / 1000000000LL, .tv_nsec = nanoseconds % 1000000000LL };
+
+	thrd_sleep(&sleepTime, NULL);
+}
+
+static inline uint32_t simulationRandom(usbSimulation simulation) {
+	// xorshift64, good enough for addresses and polarities.
+	simulation->random ^= simulation->random << 13;
+	simulation->random ^= simulation->random >> 7;
+	simulation->random ^= simulation->random << 17;
+
+	return (U32T(simulation->random >> 32));
+}
+
+static bool transferListAdd(struct usb_transfer_list *list, struct libusb_transfer *transfer) {
+	if (list->length == list->capacity) {
+		size_t newCapacity = (list->capacity == 0) ? (16) : (list->capacity * 2);
+
+		struct libusb_transfer **newTransfers = realloc(list->transfers, newCapacity * sizeof(*newTransfers));
+		if (newTransfers == NULL) {
+			return (false);
+		}
+
+		list->transfers = newTransfers;
+		list->capacity = newCapacity;
+	}
+
+	list->transfers[list->length++] = transfer;
+
+	return (true);
+}
+
+static bool transferListRemove(struct usb_transfer_list *list, struct libusb_transfer *transfer) {
+	for (size_t i = 0; i < list->length; i++) {
+		if (list->transfers[i] == transfer) {
+			// Keep submission order.
+			memmove(&list->transfers[i], &list->transfers[i + 1], (list->length - i - 1) * sizeof(*list->transfers));
+			list->length--;
+
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+static void configWrite(usbSimulation simulation, uint8_t moduleAddr, uint8_t paramAddr, uint32_t param) {
+	atomic_store_explicit(&simulation->config[moduleAddr][paramAddr], param, memory_order_relaxed);
+
+	if (moduleAddr == DAVIS_CONFIG_MUX && paramAddr == DAVIS_CONFIG_MUX_TIMESTAMP_RESET && param != 0) {
+		atomic_store(&simulation->timestampReset, true);
+	}
+}
+
+static inline uint32_t configRead(usbSimulation simulation, uint8_t moduleAddr, uint8_t paramAddr) {
+	return (U32T(atomic_load_explicit(&simulation->config[moduleAddr][paramAddr], memory_order_relaxed)));
+}
+
+usbSimulation usbSimulationCreate(uint16_t deviceType, uint16_t logicVersion) {
+	usbSimulation simulation = calloc(1, sizeof(*simulation));
+	if (simulation == NULL) {
+		return (NULL);
+	}
+
+	if (mtx_init(&simulation->transfersLock, mtx_plain) != thrd_success) {
+		free(simulation);
+		return (NULL);
+	}
+
+	if (mtx_init(&simulation->eventsLock, mtx_plain) != thrd_success) {
+		mtx_destroy(&simulation->transfersLock);
+		free(simulation);
+		return (NULL);
+	}
+
+	simulation->deviceType = deviceType;
+	simulation->random = 0x9E3779B97F4A7C15ULL;
+
+	atomic_store(&simulation->eventRate, SIMULATION_DEFAULT_EVENT_RATE);
+
+	if (deviceType == CAER_DEVICE_DVS128) {
+		simulation->dataEndpoint = DVS_DATA_ENDPOINT;
+		simulation->eventBytes = 4;
+		simulation->sizeX = DVS_ARRAY_SIZE_X;
+		simulation->sizeY = DVS_ARRAY_SIZE_Y;
+	}
+	else {
+		simulation->dataEndpoint = DAVIS_DATA_ENDPOINT;
+		simulation->eventBytes = 4;
+		simulation->sizeX = DAVIS_SIMULATION_SIZE_X;
+		simulation->sizeY = DAVIS_SIMULATION_SIZE_Y;
+
+		// Present itself as a DAVIS240C, with global shutter and full-frame ROI.
+		configWrite(simulation, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_VERSION, logicVersion);
+		configWrite(simulation, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_CHIP_IDENTIFIER, DAVIS_CHIP_DAVIS240C);
+		configWrite(simulation, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_DEVICE_IS_MASTER, true);
+		configWrite(simulation, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_LOGIC_CLOCK, 80);
+		configWrite(simulation, DAVIS_CONFIG_SYSINFO, DAVIS_CONFIG_SYSINFO_ADC_CLOCK, 30);
+
+		configWrite(simulation, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_SIZE_COLUMNS, DAVIS_SIMULATION_SIZE_X);
+		configWrite(simulation, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_SIZE_ROWS, DAVIS_SIMULATION_SIZE_Y);
+
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_SIZE_COLUMNS, DAVIS_SIMULATION_SIZE_X);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_SIZE_ROWS, DAVIS_SIMULATION_SIZE_Y);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_COLOR_FILTER, MONO);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_GLOBAL_SHUTTER, true);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_HAS_EXTERNAL_ADC, true);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_GLOBAL_SHUTTER, true);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_RESET_READ, true);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_COLUMN_0, DAVIS_SIMULATION_SIZE_X - 1);
+		configWrite(simulation, DAVIS_CONFIG_APS, DAVIS_CONFIG_APS_END_ROW_0, DAVIS_SIMULATION_SIZE_Y - 1);
+	}
+
+	return (simulation);
+}
+
+void usbSimulationDestroy(usbSimulation simulation) {
+	if (simulation == NULL) {
+		return;
+	}
+
+	mtx_destroy(&simulation->eventsLock);
+	mtx_destroy(&simulation->transfersLock);
+
+	free(simulation->pending.transfers);
+	free(simulation->cancelled.transfers);
+	free(simulation);
+}
+
+bool usbSimulationConfigSet(usbSimulation simulation, uint8_t paramAddr, uint32_t param) {
+	if (simulation == NULL) {
+		// Not a simulated device.
+		return (false);
+	}
+
+	switch (paramAddr) {
+		case CAER_HOST_CONFIG_SIMULATION_EVENT_RATE:
+			atomic_store(&simulation->eventRate, param);
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+bool usbSimulationConfigGet(usbSimulation simulation, uint8_t paramAddr, uint32_t *param) {
+	if (simulation == NULL) {
+		// Not a simulated device.
+		return (false);
+	}
+
+	switch (paramAddr) {
+		case CAER_HOST_CONFIG_SIMULATION_EVENT_RATE:
+			*param = U32T(atomic_load(&simulation->eventRate));
+			break;
+
+		case CAER_HOST_CONFIG_SIMULATION_GENERATED_EVENTS:
+			*param = U32T(atomic_load_explicit(&simulation->generatedEvents, memory_order_relaxed));
+			break;
+
+		default:
+			return (false);
+			break;
+	}
+
+	return (true);
+}
+
+int usbSimulationControlTransfer(usbSimulation simulation, uint8_t requestType, uint8_t request, uint16_t value,
+	uint16_t index, uint8_t *data, uint16_t length) {
+	bool directionIn = ((requestType & LIBUSB_ENDPOINT_IN) != 0);
+
+	if (simulation->deviceType == CAER_DEVICE_DVS128) {
+		if (directionIn) {
+			return (LIBUSB_ERROR_PIPE);
+		}
+
+		switch (request) {
+			case VENDOR_REQUEST_START_TRANSFER:
+				atomic_store(&simulation->dvsRunning, true);
+				break;
+
+			case VENDOR_REQUEST_STOP_TRANSFER:
+				atomic_store(&simulation->dvsRunning, false);
+				break;
+
+			case VENDOR_REQUEST_RESET_TS:
+				atomic_store(&simulation->timestampReset, true);
+				break;
+
+			default:
+				// Biases, array reset and master/slave are accepted and ignored.
+				break;
+		}
+
+		return (length);
+	}
+
+	switch (request) {
+		case VENDOR_REQUEST_FPGA_CONFIG:
+			if (value >= SIMULATION_CONFIG_MODULES || index >= SIMULATION_CONFIG_PARAMS || length != 4) {
+				return (LIBUSB_ERROR_PIPE);
+			}
+
+			if (directionIn) {
+				uint32_t param = configRead(simulation, U8T(value), U8T(index));
+
+				data[0] = U8T(param >> 24);
+				data[1] = U8T(param >> 16);
+				data[2] = U8T(param >> 8);
+				data[3] = U8T(param >> 0);
+			}
+			else {
+				uint32_t param = U32T(data[0] << 24) | U32T(data[1] << 16) | U32T(data[2] << 8) | U32T(data[3] << 0);
+
+				configWrite(simulation, U8T(value), U8T(index), param);
+			}
+
+			return (length);
+
+		case VENDOR_REQUEST_FPGA_CONFIG_MULTIPLE:
+			// 'value' configuration tuples of 6 bytes each: module, parameter, 32 bit big-endian value.
+			if (directionIn || length != (value * 6)) {
+				return (LIBUSB_ERROR_PIPE);
+			}
+
+			for (size_t i = 0; i < value; i++) {
+				uint8_t *tuple = data + (i * 6);
+
+				if (tuple[0] >= SIMULATION_CONFIG_MODULES) {
+					return (LIBUSB_ERROR_PIPE);
+				}
+
+				configWrite(simulation, tuple[0], tuple[1],
+					U32T(tuple[2] << 24) | U32T(tuple[3] << 16) | U32T(tuple[4] << 8) | U32T(tuple[5] << 0));
+			}
+
+			return (length);
+
+		default:
+			if (directionIn) {
+				return (LIBUSB_ERROR_PIPE);
+			}
+
+			// Chip bias/diagnostic shift registers are accepted and ignored.
+			return (length);
+	}
+}
+
+int usbSimulationSubmitTransfer(usbSimulation simulation, struct libusb_transfer *transfer) {
+	if (transfer->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+		// Answered right away, so it stays in order with synchronous requests,
+		// like on the device. Only the completion waits for event handling.
+		struct libusb_control_setup *setup = libusb_control_transfer_get_setup(transfer);
+
+		int result = usbSimulationControlTransfer(simulation, setup->bmRequestType, setup->bRequest,
+			libusb_le16_to_cpu(setup->wValue), libusb_le16_to_cpu(setup->wIndex),
+			libusb_control_transfer_get_data(transfer), libusb_le16_to_cpu(setup->wLength));
+
+		transfer->status = (result >= 0) ? (LIBUSB_TRANSFER_COMPLETED) : (LIBUSB_TRANSFER_STALL);
+		transfer->actual_length = (result >= 0) ? (result) : (0);
+	}
+
+	mtx_lock(&simulation->transfersLock);
+
+	bool added = transferListAdd(&simulation->pending, transfer);
+
+	mtx_unlock(&simulation->transfersLock);
+
+	return ((added) ? (LIBUSB_SUCCESS) : (LIBUSB_ERROR_NO_MEM));
+}
+
+int usbSimulationCancelTransfer(usbSimulation simulation, struct libusb_transfer *transfer) {
+	int retVal = LIBUSB_ERROR_NOT_FOUND;
+
+	mtx_lock(&simulation->transfersLock);
+
+	if (transferListRemove(&simulation->pending, transfer)) {
+		retVal = (transferListAdd(&simulation->cancelled, transfer)) ? (LIBUSB_SUCCESS) : (LIBUSB_ERROR_NO_MEM);
+
+		if (retVal != LIBUSB_SUCCESS) {
+			// Put it back, it's still in flight.
+			transferListAdd(&simulation->pending, transfer);
+		}
+	}
+
+	mtx_unlock(&simulation->transfersLock);
+
+	return (retVal);
+}
+
+static bool simulationActive(usbSimulation simulation) {
+	if (simulation->deviceType == CAER_DEVICE_DVS128) {
+		return (atomic_load_explicit(&simulation->dvsRunning, memory_order_relaxed));
+	}
+
+	return (configRead(simulation, DAVIS_CONFIG_USB, DAVIS_CONFIG_USB_RUN) != 0
+		&& configRead(simulation, DAVIS_CONFIG_MUX, DAVIS_CONFIG_MUX_RUN) != 0
+		&& configRead(simulation, DAVIS_CONFIG_DVS, DAVIS_CONFIG_DVS_RUN) != 0);
+}
+
+static inline void put16(uint8_t *buffer, size_t *position, uint16_t word) {
+	// USB is little-endian.
+	buffer[(*position)++] = U8T(word & 0xFF);
+	buffer[(*position)++] = U8T(word >> 8);
+}
+
+static void davisGenerateEvent(usbSimulation simulation, uint8_t *buffer, size_t *position, int64_t timestamp) {
+	if (timestamp != simulation->lastTimestamp) {
+		bool wrapped = false;
+
+		while ((timestamp - simulation->lastWrap) >= DAVIS_SIMULATION_TS_WRAP) {
+			int64_t wraps = (timestamp - simulation->lastWrap) / DAVIS_SIMULATION_TS_WRAP;
+			if (wraps > DAVIS_SIMULATION_WRAP_MAX) {
+				wraps = DAVIS_SIMULATION_WRAP_MAX;
+			}
+
+			put16(buffer, position, U16T((7 << 12) | wraps));
+			simulation->lastWrap += wraps * DAVIS_SIMULATION_TS_WRAP;
+			wrapped = true;
+		}
+
+		// A wrap already sets the timestamp to the wrap point.
+		if (!wrapped || timestamp != simulation->lastWrap) {
+			put16(buffer, position, U16T(0x8000 | (timestamp - simulation->lastWrap)));
+		}
+
+		simulation->lastTimestamp = timestamp;
+	}
+
+	uint32_t rnd = simulationRandom(simulation);
+
+	// Y address, then X address with polarity.
+	put16(buffer, position, U16T((1 << 12) | ((rnd & 0xFFFF) % simulation->sizeY)));
+	put16(buffer, position, U16T(((2 + ((rnd >> 31) & 0x01)) << 12) | ((rnd >> 16) % simulation->sizeX)));
+}
+
+static void dvs128GenerateEvent(usbSimulation simulation, uint8_t *buffer, size_t *position, int64_t timestamp) {
+	// One wrap per event at most, the rest follows with the next events.
+	if ((timestamp - simulation->lastWrap) >= DVS128_SIMULATION_TS_WRAP) {
+		simulation->lastWrap += DVS128_SIMULATION_TS_WRAP;
+
+		put16(buffer, position, 0);
+		put16(buffer, position, 0x8000);
+
+		if ((timestamp - simulation->lastWrap) >= DVS128_SIMULATION_TS_WRAP) {
+			return;
+		}
+	}
+
+	uint32_t rnd = simulationRandom(simulation);
+
+	// Address: Y (7 bits), X (7 bits), polarity; timestamp: 14 bits.
+	put16(buffer, position,
+		U16T(((rnd % simulation->sizeY) << 8) | (((rnd >> 8) % simulation->sizeX) << 1) | ((rnd >> 31) & 0x01)));
+	put16(buffer, position, U16T(timestamp - simulation->lastWrap));
+}
+
+static void simulationTimestampReset(usbSimulation simulation, uint8_t *buffer, size_t *position, int64_t now) {
+	if (simulation->deviceType == CAER_DEVICE_DVS128) {
+		put16(buffer, position, 0);
+		put16(buffer, position, 0x4000);
+	}
+	else {
+		put16(buffer, position, U16T((0 << 12) | 1));
+	}
+
+	simulation->epoch = now;
+	simulation->lastTimestamp = 0;
+	simulation->lastWrap = 0;
+}
+
+static void simulationFill(usbSimulation simulation, struct libusb_transfer *transfer, uint64_t events, int64_t now) {
+	size_t position = 0;
+	size_t length = (size_t) transfer->length;
+
+	if (atomic_exchange(&simulation->timestampReset, false)) {
+		simulationTimestampReset(simulation, transfer->buffer, &position, now);
+	}
+
+	// Spread the events evenly over the time since the last generated one.
+	int64_t timeStart = simulation->lastTime;
+	int64_t timeSpan = now - timeStart;
+	uint64_t generated = 0;
+
+	while (generated < events && (position + SIMULATION_EVENT_SPACE) <= length) {
+		int64_t eventTime = timeStart + I64T(U64T(timeSpan) * (generated + 1) / events);
+		int64_t timestamp = (eventTime - simulation->epoch) / 1000;
+
+		if (timestamp < simulation->lastTimestamp) {
+			timestamp = simulation->lastTimestamp;
+		}
+
+		if (simulation->deviceType == CAER_DEVICE_DVS128) {
+			dvs128GenerateEvent(simulation, transfer->buffer, &position, timestamp);
+		}
+		else {
+			davisGenerateEvent(simulation, transfer->buffer, &position, timestamp);
+		}
+
+		generated++;
+	}
+
+	simulation->sentEvents += generated;
+	simulation->lastTime = (generated == events) ? (now) : (timeStart + I64T(U64T(timeSpan) * generated / events));
+	atomic_fetch_add_explicit(&simulation->generatedEvents, generated, memory_order_relaxed);
+
+	transfer->actual_length = (int) position;
+	transfer->status = LIBUSB_TRANSFER_COMPLETED;
+}
+
+static struct libusb_transfer *simulationTakeTransfer(struct usb_transfer_list *list, uint8_t endpoint) {
+	for (size_t i = 0; i < list->length; i++) {
+		if (endpoint == 0 || list->transfers[i]->endpoint == endpoint) {
+			struct libusb_transfer *transfer = list->transfers[i];
+			transferListRemove(list, transfer);
+
+			return (transfer);
+		}
+	}
+
+	return (NULL);
+}
+
+static struct libusb_transfer *simulationTakeControlTransfer(struct usb_transfer_list *list) {
+	for (size_t i = 0; i < list->length; i++) {
+		if (list->transfers[i]->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+			struct libusb_transfer *transfer = list->transfers[i];
+			transferListRemove(list, transfer);
+
+			return (transfer);
+		}
+	}
+
+	return (NULL);
+}
+
+static bool simulationHasTransfer(struct usb_transfer_list *list, uint8_t endpoint) {
+	for (size_t i = 0; i < list->length; i++) {
+		if (list->transfers[i]->endpoint == endpoint) {
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+void usbSimulationHandleEvents(usbSimulation simulation, struct timeval *timeout) {
+	int64_t timeoutNs = (I64T(timeout->tv_sec) * 1000000000LL) + (I64T(timeout->tv_usec) * 1000LL);
+	int64_t idleNs = (timeoutNs < SIMULATION_IDLE_SLEEP) ? (timeoutNs) : (SIMULATION_IDLE_SLEEP);
+
+	mtx_lock(&simulation->eventsLock);
+
+	// Cancelled transfers complete first, with their call-back.
+	mtx_lock(&simulation->transfersLock);
+	struct libusb_transfer *cancelled = simulationTakeTransfer(&simulation->cancelled, 0);
+	mtx_unlock(&simulation->transfersLock);
+
+	if (cancelled != NULL) {
+		do {
+			cancelled->status = LIBUSB_TRANSFER_CANCELLED;
+			cancelled->actual_length = 0;
+			(*cancelled->callback)(cancelled);
+
+			mtx_lock(&simulation->transfersLock);
+			cancelled = simulationTakeTransfer(&simulation->cancelled, 0);
+			mtx_unlock(&simulation->transfersLock);
+		}
+		while (cancelled != NULL);
+
+		mtx_unlock(&simulation->eventsLock);
+		return;
+	}
+
+	// Control requests were already answered on submission, complete them.
+	mtx_lock(&simulation->transfersLock);
+	struct libusb_transfer *control = simulationTakeControlTransfer(&simulation->pending);
+	mtx_unlock(&simulation->transfersLock);
+
+	if (control != NULL) {
+		do {
+			(*control->callback)(control);
+
+			if (control->flags & LIBUSB_TRANSFER_FREE_TRANSFER) {
+				libusb_free_transfer(control);
+			}
+
+			mtx_lock(&simulation->transfersLock);
+			control = simulationTakeControlTransfer(&simulation->pending);
+			mtx_unlock(&simulation->transfersLock);
+		}
+		while (control != NULL);
+
+		mtx_unlock(&simulation->eventsLock);
+		return;
+	}
+
+	int64_t now = simulationHostTime();
+
+	if (!simulationActive(simulation)) {
+		simulation->generating = false;
+
+		mtx_unlock(&simulation->eventsLock);
+		simulationSleep(idleNs);
+		return;
+	}
+
+	if (!simulation->generating) {
+		simulation->generating = true;
+		simulation->startTime = now;
+		simulation->lastTime = now;
+		simulation->lastFlush = now;
+		simulation->sentEvents = 0;
+
+		if (simulation->epoch == 0) {
+			simulation->epoch = now;
+			simulation->lastTimestamp = 0;
+			simulation->lastWrap = 0;
+		}
+	}
+
+	mtx_lock(&simulation->transfersLock);
+	bool haveTransfer = simulationHasTransfer(&simulation->pending, simulation->dataEndpoint);
+	size_t transferLength = 0;
+	if (haveTransfer) {
+		// All data transfers have the same size.
+		for (size_t i = 0; i < simulation->pending.length; i++) {
+			if (simulation->pending.transfers[i]->endpoint == simulation->dataEndpoint) {
+				transferLength = (size_t) simulation->pending.transfers[i]->length;
+				break;
+			}
+		}
+	}
+	mtx_unlock(&simulation->transfersLock);
+
+	if (!haveTransfer) {
+		mtx_unlock(&simulation->eventsLock);
+		simulationSleep(idleNs);
+		return;
+	}
+
+	// How many events are due, and how many fit into a buffer.
+	uint64_t capacity = transferLength / simulation->eventBytes;
+	uint32_t eventRate = U32T(atomic_load_explicit(&simulation->eventRate, memory_order_relaxed));
+	uint64_t due = capacity;
+
+	if (eventRate != 0) {
+		uint64_t elapsedUs = U64T(now - simulation->startTime) / 1000;
+		uint64_t target = (elapsedUs * eventRate) / 1000000;
+
+		due = (target > simulation->sentEvents) ? (target - simulation->sentEvents) : (0);
+		if (due > capacity) {
+			due = capacity;
+		}
+
+		// Only send partially filled buffers when the flush interval expires.
+		if (due < capacity && (now - simulation->lastFlush) < SIMULATION_FLUSH_INTERVAL) {
+			int64_t fillNs = I64T(((capacity - due) * 1000000000ULL) / eventRate);
+			int64_t flushNs = SIMULATION_FLUSH_INTERVAL - (now - simulation->lastFlush);
+			int64_t sleepNs = (fillNs < flushNs) ? (fillNs) : (flushNs);
+
+			mtx_unlock(&simulation->eventsLock);
+			simulationSleep((sleepNs < timeoutNs) ? (sleepNs) : (timeoutNs));
+			return;
+		}
+
+		if (due == 0) {
+			// Nothing to send in this interval.
+			simulation->lastFlush = now;
+
+			mtx_unlock(&simulation->eventsLock);
+			return;
+		}
+	}
+
+	mtx_lock(&simulation->transfersLock);
+	struct libusb_transfer *transfer = simulationTakeTransfer(&simulation->pending, simulation->dataEndpoint);
+	mtx_unlock(&simulation->transfersLock);
+
+	if (transfer != NULL) {
+		simulationFill(simulation, transfer, due, now);
+		simulation->lastFlush = now;
+
+		(*transfer->callback)(transfer);
+	}
+
+	mtx_unlock(&simulation->eventsLock);
+}
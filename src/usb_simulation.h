@@ -0,0 +1,30 @@
+#ifndef LIBCAER_SRC_USB_SIMULATION_H_
+#define LIBCAER_SRC_USB_SIMULATION_H_
+
+#include "devices/usb.h"
+#include <libusb.h>
+
+/**
+ * In-process simulated USB device. It answers the vendor control requests
+ * used for configuration from a register model, both synchronous ones and
+ * those submitted as control transfers, and fills the submitted bulk
+ * transfers on the data endpoint with a synthetic polarity event stream at a
+ * configurable rate, completing them through their normal libusb call-back.
+ * Transfers on other endpoints stay pending until cancelled.
+ */
+typedef struct usb_simulation *usbSimulation;
+
+usbSimulation usbSimulationCreate(uint16_t deviceType, uint16_t logicVersion);
+void usbSimulationDestroy(usbSimulation simulation);
+
+bool usbSimulationConfigSet(usbSimulation simulation, uint8_t paramAddr, uint32_t param);
+bool usbSimulationConfigGet(usbSimulation simulation, uint8_t paramAddr, uint32_t *param);
+
+// Same semantics and return values as their libusb counterparts.
+int usbSimulationControlTransfer(usbSimulation simulation, uint8_t requestType, uint8_t request, uint16_t value,
+	uint16_t index, uint8_t *data, uint16_t length);
+int usbSimulationSubmitTransfer(usbSimulation simulation, struct libusb_transfer *transfer);
+int usbSimulationCancelTransfer(usbSimulation simulation, struct libusb_transfer *transfer);
+void usbSimulationHandleEvents(usbSimulation simulation, struct timeval *timeout);
+
+#endif /* LIBCAER_SRC_USB_SIMULATION_H_ */
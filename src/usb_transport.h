@@ -0,0 +1,92 @@
+#ifndef LIBCAER_SRC_USB_TRANSPORT_H_
+#define LIBCAER_SRC_USB_TRANSPORT_H_
+
+#include "usb_simulation.h"
+#include <libusb.h>
+
+/**
+ * Transport to the device: either a real USB device accessed through libusb,
+ * or an in-process simulated device. Everything that talks to an open device
+ * (control requests, data transfers, event handling) goes through here.
+ */
+struct usb_transport {
+	libusb_context *deviceContext;
+	libusb_device_handle *deviceHandle;
+	// Simulated device, used instead of libusb if not NULL.
+	usbSimulation simulation;
+};
+
+typedef struct usb_transport *usbTransport;
+
+static inline int usbTransportControl(usbTransport transport, uint8_t requestType, uint8_t request, uint16_t value,
+	uint16_t index, uint8_t *data, uint16_t length, unsigned int timeout) {
+	if (transport->simulation != NULL) {
+		return (usbSimulationControlTransfer(transport->simulation, requestType, request, value, index, data, length));
+	}
+
+	return (libusb_control_transfer(transport->deviceHandle, requestType, request, value, index, data, length, timeout));
+}
+
+static inline int usbTransportSubmit(usbTransport transport, struct libusb_transfer *transfer) {
+	if (transport->simulation != NULL) {
+		return (usbSimulationSubmitTransfer(transport->simulation, transfer));
+	}
+
+	return (libusb_submit_transfer(transfer));
+}
+
+/**
+ * Submit a control request without waiting for it. Setup and data are copied
+ * into a new transfer, 'callback' is called on completion by the thread handling
+ * events (data at libusb_control_transfer_get_data()), then the transfer is freed.
+ * With a non-zero 'timeout' (in ms), the request completes with status
+ * LIBUSB_TRANSFER_TIMED_OUT if the device doesn't answer in time.
+ */
+static inline int usbTransportControlAsync(usbTransport transport, uint8_t requestType, uint8_t request,
+	uint16_t value, uint16_t index, const uint8_t *data, uint16_t length, unsigned int timeout,
+	libusb_transfer_cb_fn callback, void *userData) {
+	struct libusb_transfer *transfer = libusb_alloc_transfer(0);
+	if (transfer == NULL) {
+		return (LIBUSB_ERROR_NO_MEM);
+	}
+
+	uint8_t *buffer = malloc(LIBUSB_CONTROL_SETUP_SIZE + (size_t) length);
+	if (buffer == NULL) {
+		libusb_free_transfer(transfer);
+		return (LIBUSB_ERROR_NO_MEM);
+	}
+
+	libusb_fill_control_setup(buffer, requestType, request, value, index, length);
+	if (data != NULL) {
+		memcpy(buffer + LIBUSB_CONTROL_SETUP_SIZE, data, length);
+	}
+
+	libusb_fill_control_transfer(transfer, transport->deviceHandle, buffer, callback, userData, timeout);
+	transfer->flags = LIBUSB_TRANSFER_FREE_BUFFER | LIBUSB_TRANSFER_FREE_TRANSFER;
+
+	int result = usbTransportSubmit(transport, transfer);
+	if (result != LIBUSB_SUCCESS) {
+		libusb_free_transfer(transfer);
+	}
+
+	return (result);
+}
+
+static inline int usbTransportCancel(usbTransport transport, struct libusb_transfer *transfer) {
+	if (transport->simulation != NULL) {
+		return (usbSimulationCancelTransfer(transport->simulation, transfer));
+	}
+
+	return (libusb_cancel_transfer(transfer));
+}
+
+static inline int usbTransportHandleEvents(usbTransport transport, struct timeval *timeout) {
+	if (transport->simulation != NULL) {
+		usbSimulationHandleEvents(transport->simulation, timeout);
+		return (LIBUSB_SUCCESS);
+	}
+
+	return (libusb_handle_events_timeout(transport->deviceContext, timeout));
+}
+
+#endif /* LIBCAER_SRC_USB_TRANSPORT_H_ */
@@ -0,0 +1,13 @@
+#ifndef LIBCAER_SRC_VISIBILITY_H_
+#define LIBCAER_SRC_VISIBILITY_H_
+
+// Functions shared between the library's own translation units (and the
+// benchmarks, which link them statically), but not part of its API: they
+// are not exported from the shared library.
+#if defined(__GNUC__) && !defined(_WIN32) && !defined(__CYGWIN__)
+	#define CAER_INTERNAL __attribute__((visibility("hidden")))
+#else
+	#define CAER_INTERNAL
+#endif
+
+#endif /* LIBCAER_SRC_VISIBILITY_H_ */